@@ -0,0 +1,467 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Per-stage benchmark of the AdvancedColorPipeline model.
+//
+//   ACPipelineBench [--sizes 1080p,4k,8k] [--reps 10] [--warmup 2] [--threads 0]
+//                   [--stage name] [--json out.json] [--baseline old.json] [--tolerance 0.10]
+//
+// Every stage runs on a fresh copy of a synthetic frame (copies are not timed).  The
+// median repetition gives ns/pixel, GB/s of plane traffic, and cycles/pixel from the time
+// stamp counter (reference cycles, so they do not follow turbo).  With --baseline, any
+// stage more than --tolerance slower per pixel than in the old JSON fails the run.  A few
+// self-checks of the pipeline and gamut code run first and fail the run if they do not hold.
+
+#include "pch.h"
+
+// The pipeline model is a single translation unit with no header, so it is built into
+// the benchmark directly and every stage and model-state global is reachable from here.
+#include "AdvancedColorPipeline.cpp"
+#include "GamutCoverage.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define BENCH_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+static uint64_t Bench_Cycles()
+{
+#if defined(BENCH_HAS_TSC)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// what a stage expects to find in the frame
+enum BenchInput
+{
+	BenchLinear,			// CCCS, 1.0 = 80 nits, up to 10000 nits
+	BenchPQ,				// Rec.2100 PQ, [0..1]
+};
+
+struct BenchStage
+{
+	const char*                 name;
+	BenchInput                  input;
+	uint32_t                    bytesPerPixel;	// plane traffic: 24 read-modify-write, 12 read-only
+	std::function<void(Image)>  run;
+};
+
+struct BenchResult
+{
+	std::string name;
+	uint32_t    width, height;
+	uint32_t    reps;
+	double      minSeconds;
+	double      medianSeconds;
+	double      nsPerPixel;
+	double      gbPerSecond;
+	double      cyclesPerPixel;
+};
+
+// Horizontal ramp from black to 10000 nits with the hue turning vertically, and a little
+// per-pixel noise so no stage sees long runs of one value.
+static void Bench_Fill(Image image)
+{
+	uint32_t seed = 12345;
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		float hue = 6.2831853f * y / image.height;
+		float3 tint(0.6f + 0.4f * cosf(hue), 0.6f + 0.4f * cosf(hue - 2.0943951f), 0.6f + 0.4f * cosf(hue + 2.0943951f));
+		float* r = image.Row(ChannelR, y);
+		float* g = image.Row(ChannelG, y);
+		float* b = image.Row(ChannelB, y);
+		for (uint32_t x = 0; x < image.width; x++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			float t = (float)x / image.width;
+			float nits = 10000.0f * t * t * t * (0.98f + 0.04f * (seed >> 8) / 16777216.0f);
+			r[x] = tint.r * nits / 80.0f;
+			g[x] = tint.g * nits / 80.0f;
+			b[x] = tint.b * nits / 80.0f;
+		}
+	}
+}
+
+static std::vector<BenchStage> Bench_Stages(PipelineExecutor& executor, const ColorLUT3D& lut)
+{
+	const DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	const DXGI_COLOR_SPACE_TYPE space = DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
+	const float SDRboost = UI_GetSDRBoostSetting();
+	const float brightness = UI_GetGLobalBrightnessSetting();
+
+	return {
+		{ "Image_Apply2084",       BenchLinear, 24, [](Image image) { Image_Apply2084(image); } },
+		{ "Image_Remove2084",      BenchPQ,     24, [](Image image) { Image_Remove2084(image); } },
+		{ "Image_Rec709toRec2100", BenchLinear, 24, [](Image image) { Image_Rec709toRec2100(image); } },
+		{ "Image_Rec2100toRec709", BenchLinear, 24, [](Image image) { Image_Rec2100toRec709(image); } },
+		{ "Image_2020toDCIP3",     BenchLinear, 24, [](Image image) { Image_2020toDCIP3(image); } },
+		{ "Image_Mult",            BenchLinear, 24, [](Image image) { Image_Mult(image, 0.5f); } },
+		{ "Image_ToneMap",         BenchLinear, 24, [](Image image) { Image_ToneMap(image, 10000.0f, 1200.0f); } },
+		{ "Image_Statistics",      BenchLinear, 12, [](Image image) { Image_Statistics(image); } },
+		// CCCS input is already in the compositor's space and would time an empty chain
+		{ "DWM_Present HDR10",     BenchPQ,     24, [=](Image image)
+		{
+			DWM_Present(image, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020, SDRboost);
+		} },
+		{ "GPU_Display",           BenchLinear, 24, [=](Image image) { GPU_Display(image, true, brightness); } },
+		{ "Wire_Quantize",         BenchPQ,     24, [](Image image) { Wire_Quantize(image); } },
+		{ "Wire_Send 4:2:0",       BenchPQ,     24, [](Image image)
+		{
+			ChromaFormat chroma = WireChroma.format;
+			WireChroma.format = Chroma420;
+			Wire_Send(image);
+			WireChroma.format = chroma;
+		} },
+		{ "Scaler_Scale",          BenchPQ,     24, [](Image image) { Scaler_Scale(image); } },
+		{ "Panel_Show 384 zones",  BenchPQ,     24, [](Image image)
+		{
+			LocalDimmingParams backlight = PanelBacklight;
+			PanelBacklight.zonesX = 24;
+			PanelBacklight.zonesY = 16;
+			Panel_Show(image);
+			PanelBacklight = backlight;
+		} },
+		{ "ColorLUT3D",            BenchLinear, 24, [&](Image image) { Image_ApplyLUT(image, lut); } },
+		{ "ACPipeline_Display",    BenchLinear, 24, [=](Image image) { ACPipeline_Display(image, format, space, SDRboost, brightness); } },
+		{ "ACPipeline_Display tiled", BenchLinear, 24, [=, &executor](Image image)
+		{
+			ACPipeline_Display(image, format, space, SDRboost, brightness, &executor);
+		} },
+	};
+}
+
+static BenchResult Bench_Run(const BenchStage& stage, const PipelineImage& source, PipelineImage& work, uint32_t warmup, uint32_t reps)
+{
+	FusedStages toPQ;
+	toPQ.Scale(80.0f / 10000.0f);
+	toPQ.Apply2084();
+
+	std::vector<double> seconds;
+	std::vector<uint64_t> cycles;
+	for (uint32_t i = 0; i < warmup + reps; i++)
+	{
+		work = source;
+		if (stage.input == BenchPQ)
+			toPQ.Run(work);
+
+		auto t0 = std::chrono::steady_clock::now();
+		uint64_t c0 = Bench_Cycles();
+		stage.run(work);
+		uint64_t c1 = Bench_Cycles();
+		auto t1 = std::chrono::steady_clock::now();
+
+		if (i >= warmup)
+		{
+			seconds.push_back(std::chrono::duration<double>(t1 - t0).count());
+			cycles.push_back(c1 - c0);
+		}
+	}
+
+	std::sort(seconds.begin(), seconds.end());
+	std::sort(cycles.begin(), cycles.end());
+	double pixels = (double)source.Width() * source.Height();
+
+	BenchResult result;
+	result.name = stage.name;
+	result.width = source.Width();
+	result.height = source.Height();
+	result.reps = reps;
+	result.minSeconds = seconds.front();
+	result.medianSeconds = seconds[seconds.size() / 2];
+	result.nsPerPixel = result.medianSeconds * 1e9 / pixels;
+	result.gbPerSecond = result.medianSeconds > 0.0 ? pixels * stage.bytesPerPixel / result.medianSeconds * 1e-9 : 0.0;
+	result.cyclesPerPixel = cycles[cycles.size() / 2] / pixels;
+	return result;
+}
+
+// One result per line, so a baseline can be read back without a JSON parser
+static bool Bench_WriteJson(const char* path, const std::vector<BenchResult>& results, uint32_t threads)
+{
+	FILE* f = fopen(path, "w");
+	if (!f)
+		return false;
+	fprintf(f, "{\n  \"simdLevel\": %d, \"threads\": %u,\n  \"results\": [\n", (int)GetSimdLevel(), threads);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+		fprintf(f, "    { \"stage\": \"%s\", \"width\": %u, \"height\": %u, \"reps\": %u, \"nsPerPixel\": %.4f, \"gbPerSecond\": %.3f, "
+			"\"cyclesPerPixel\": %.3f, \"minSeconds\": %.6f, \"medianSeconds\": %.6f }%s\n",
+			r.name.c_str(), r.width, r.height, r.reps, r.nsPerPixel, r.gbPerSecond, r.cyclesPerPixel,
+			r.minSeconds, r.medianSeconds, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	return fclose(f) == 0;
+}
+
+static std::vector<BenchResult> Bench_ReadJson(const char* path)
+{
+	std::vector<BenchResult> results;
+	FILE* f = fopen(path, "r");
+	if (!f)
+		return results;
+	char line[1024];
+	while (fgets(line, sizeof(line), f))
+	{
+		char name[128];
+		BenchResult r = {};
+		if (sscanf(line, " { \"stage\": \"%127[^\"]\", \"width\": %u, \"height\": %u, \"reps\": %u, \"nsPerPixel\": %lf",
+			name, &r.width, &r.height, &r.reps, &r.nsPerPixel) == 5)
+		{
+			r.name = name;
+			results.push_back(r);
+		}
+	}
+	fclose(f);
+	return results;
+}
+
+// Self-checks of the pipeline and gamut code, run before any timing so a broken build does
+// not produce numbers.  They live here rather than in the headers so the app never runs them.
+
+// The hard-coded gamutVolume* constants against the analytic volumes
+static bool Bench_CheckGamutVolumes(float tolerance = 1e-3f)
+{
+	const float luvZeroPlane = 401.0f * 401.0f;			// see gamutVolumeLuv note in ColorSpaces.h
+	struct { float2 r, g, b; float lab, luv; } spaces[] =
+	{
+		{ primaryR_709,   primaryG_709,   primaryB_709,   gamutVolumeLab709,   gamutVolumeLuv709   },
+		{ primaryR_Adobe, primaryG_Adobe, primaryB_Adobe, gamutVolumeLabAdobe, gamutVolumeLuvAdobe },
+		{ primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3, gamutVolumeLabDCIP3, gamutVolumeLuvDCIP3 },
+		{ primaryR_2020,  primaryG_2020,  primaryB_2020,  gamutVolumeLab2020,  0.0f                },	// 2020 u,v exceed the +/-200 box
+	};
+
+	bool ok = true;
+	for (auto& sp : spaces)
+	{
+		float lab = gamutVolumeLabAnalytic(sp.r, sp.g, sp.b, D6500White);
+		float luv = sp.luv > 0.0f ? gamutVolumeLuvAnalytic(sp.r, sp.g, sp.b, D6500White) + luvZeroPlane : 0.0f;
+		if (fabs(lab - sp.lab) > tolerance * sp.lab) ok = false;
+		if (sp.luv > 0.0f && fabs(luv - sp.luv) > tolerance * sp.luv) ok = false;
+	}
+	return ok;
+}
+
+// Batch gamut coverage where exact zero tests go wrong: a panel identical to a reference,
+// in either winding, and panels sharing an edge or vertices with one
+static bool Bench_CheckGamutCoverage(float tolerance = 1e-4f)
+{
+	const float2 refs[GamutRefCount][3] =
+	{
+		{ primaryR_709,   primaryG_709,   primaryB_709   },
+		{ primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3 },
+		{ primaryR_2020,  primaryG_2020,  primaryB_2020  },
+		{ primaryR_Adobe, primaryG_Adobe, primaryB_Adobe },
+		{ primaryR_ACES,  primaryG_ACES,  primaryB_ACES  },
+	};
+
+	GamutCoverageBatch batch;
+	for (int ref = 0; ref < GamutRefCount; ref++)
+	{
+		batch.AddPanel(refs[ref][0], refs[ref][1], refs[ref][2]);
+		batch.AddPanel(refs[ref][0], refs[ref][2], refs[ref][1]);		// clockwise
+	}
+	const size_t sharedEdge = batch.Count();
+	batch.AddPanel(primaryR_709, primaryG_709, float2(0.14f, 0.04f));		// contains 709, shares R-G
+	ComputeGamutCoverageBatch(batch);
+
+	bool ok = true;
+	for (int plane = 0; plane < GamutPlaneCount; plane++)
+	{
+		for (int ref = 0; ref < GamutRefCount; ref++)
+		{
+			for (int k = 0; k < 2; k++)
+			{
+				if (fabs(batch.coverage[plane][ref][2 * ref + k] - 1.0f) > tolerance) ok = false;
+				if (fabs(batch.areaRatio[plane][ref][2 * ref + k] - 1.0f) > tolerance) ok = false;
+			}
+		}
+
+		// 709 shares its red and blue primaries with Adobe RGB and lies inside it
+		const float* inAdobe = batch.coverage[plane][GamutRefAdobe].data();
+		const float* ratioAdobe = batch.areaRatio[plane][GamutRefAdobe].data();
+		if (fabs(inAdobe[2 * GamutRef709] - ratioAdobe[2 * GamutRef709]) > tolerance) ok = false;
+		if (fabs(batch.coverage[plane][GamutRef709][2 * GamutRefAdobe] - 1.0f) > tolerance) ok = false;
+
+		if (fabs(batch.coverage[plane][GamutRef709][sharedEdge] - 1.0f) > tolerance) ok = false;
+	}
+	return ok;
+}
+
+// Folding consecutive clamps against running them one after another, including ranges
+// that don't overlap
+static bool Bench_CheckFusedClamp()
+{
+	const float ranges[][2][2] =
+	{
+		{ { 0.0f, 1.0f }, { 0.25f, 0.75f } },		// nested
+		{ { 0.0f, 0.5f }, { 0.25f, 1.0f } },		// overlapping
+		{ { 0.0f, 1.0f }, { 2.0f,  3.0f } },		// disjoint, second above
+		{ { 2.0f, 3.0f }, { 0.0f,  1.0f } },		// disjoint, second below
+	};
+
+	PipelineImage image(16, 1);
+	ImageView view = image;
+	bool ok = true;
+	for (auto& r : ranges)
+	{
+		FusedStages stages;
+		stages.Clamp(r[0][0], r[0][1]).Clamp(r[1][0], r[1][1]);
+		if (stages.Stages().size() != 1) ok = false;
+
+		for (uint32_t x = 0; x < view.width; x++)
+		{
+			float v = -1.0f + 0.3f * x;
+			view.Set(x, 0, float3(v, v, v));
+		}
+		stages.Run(view);
+		for (uint32_t x = 0; x < view.width; x++)
+		{
+			float v = -1.0f + 0.3f * x;
+			float expected = std::min(std::max(std::min(std::max(v, r[0][0]), r[0][1]), r[1][0]), r[1][1]);
+			if (view.Get(x, 0).r != expected) ok = false;
+		}
+	}
+	return ok;
+}
+
+static bool Bench_ParseSize(const char* s, uint32_t& width, uint32_t& height)
+{
+	if (!strcmp(s, "1080p")) { width = 1920; height = 1080; return true; }
+	if (!strcmp(s, "4k"))    { width = 3840; height = 2160; return true; }
+	if (!strcmp(s, "8k"))    { width = 7680; height = 4320; return true; }
+	return sscanf(s, "%ux%u", &width, &height) == 2 && width && height;
+}
+
+int main(int argc, char** argv)
+{
+	std::string sizes = "1080p,4k,8k";
+	uint32_t reps = 10, warmup = 2, threads = 0;
+	const char* filter = nullptr;
+	const char* jsonPath = nullptr;
+	const char* baselinePath = nullptr;
+	double tolerance = 0.10;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value)
+		{
+			printf("missing value for %s\n", arg);
+			return 2;
+		}
+		if      (!strcmp(arg, "--sizes"))     sizes = value;
+		else if (!strcmp(arg, "--reps"))      reps = std::max(atoi(value), 1);
+		else if (!strcmp(arg, "--warmup"))    warmup = std::max(atoi(value), 0);
+		else if (!strcmp(arg, "--threads"))   threads = std::max(atoi(value), 0);
+		else if (!strcmp(arg, "--stage"))     filter = value;
+		else if (!strcmp(arg, "--json"))      jsonPath = value;
+		else if (!strcmp(arg, "--baseline"))  baselinePath = value;
+		else if (!strcmp(arg, "--tolerance")) tolerance = atof(value);
+		else
+		{
+			printf("unknown option %s\n", arg);
+			return 2;
+		}
+		i++;
+	}
+
+	const struct { const char* name; bool (*check)(); } checks[] =
+	{
+		{ "gamut volume constants", [] { return Bench_CheckGamutVolumes(); } },
+		{ "gamut coverage batch",   [] { return Bench_CheckGamutCoverage(); } },
+		{ "fused clamp",            Bench_CheckFusedClamp },
+	};
+	for (auto& c : checks)
+	{
+		if (!c.check())
+		{
+			printf("self-check failed: %s\n", c.name);
+			return 1;
+		}
+	}
+
+	PipelineExecutor executor(threads);
+	DWM_SetContentMetadata(GetDisplayCharacteristics());
+
+	ColorLUT3D lut;
+	ACPipeline_BakeLUT(lut, 33, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709,
+		UI_GetSDRBoostSetting(), UI_GetGLobalBrightnessSetting(), &executor);
+	std::vector<BenchStage> stages = Bench_Stages(executor, lut);
+
+	printf("%-26s %11s %10s %9s %12s\n", "stage", "size", "ns/pixel", "GB/s", "cycles/pixel");
+	std::vector<BenchResult> results;
+	for (size_t start = 0; start < sizes.size();)
+	{
+		size_t end = sizes.find(',', start);
+		if (end == std::string::npos)
+			end = sizes.size();
+		std::string size = sizes.substr(start, end - start);
+		start = end + 1;
+
+		uint32_t width, height;
+		if (!Bench_ParseSize(size.c_str(), width, height))
+		{
+			printf("unknown size %s\n", size.c_str());
+			return 2;
+		}
+
+		PipelineImage source(width, height), work(width, height);
+		Bench_Fill(source);
+		for (const BenchStage& stage : stages)
+		{
+			if (filter && !strstr(stage.name, filter))
+				continue;
+			BenchResult r = Bench_Run(stage, source, work, warmup, reps);
+			printf("%-26s %5ux%-5u %10.3f %9.2f %12.2f\n", r.name.c_str(), r.width, r.height, r.nsPerPixel, r.gbPerSecond, r.cyclesPerPixel);
+			results.push_back(r);
+		}
+	}
+
+	if (jsonPath && !Bench_WriteJson(jsonPath, results, executor.Threads()))
+	{
+		printf("could not write %s\n", jsonPath);
+		return 2;
+	}
+
+	int status = 0;
+	if (baselinePath)
+	{
+		std::vector<BenchResult> baseline = Bench_ReadJson(baselinePath);
+		if (baseline.empty())
+		{
+			printf("could not read %s\n", baselinePath);
+			return 2;
+		}
+		for (const BenchResult& r : results)
+			for (const BenchResult& b : baseline)
+				if (b.name == r.name && b.width == r.width && b.height == r.height && b.nsPerPixel > 0.0 &&
+					r.nsPerPixel > b.nsPerPixel * (1.0 + tolerance))
+				{
+					printf("SLOWER: %s %ux%u %.3f ns/pixel, baseline %.3f (+%.0f%%)\n", r.name.c_str(), r.width, r.height,
+						r.nsPerPixel, b.nsPerPixel, (r.nsPerPixel / b.nsPerPixel - 1.0) * 100.0);
+					status = 1;
+				}
+	}
+	return status;
+}
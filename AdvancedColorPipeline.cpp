@@ -4,10 +4,18 @@
 
 #include "pch.h"
 
-/*
-
 #include "basicmath.h"
 #include "colorspaces.h"
+#include "PipelineImage.h"
+#include "ToneMapLUT.h"
+#include "PipelineFusion.h"
+#include "ColorLUT3D.h"
+#include "PipelineStream.h"
+#include "PipelineExecutor.h"
+#include "FrameStatistics.h"
+#include "PipelineQuantize.h"
+#include "PipelineChroma.h"
+#include "PipelineLocalDimming.h"
 
 #define HALF_MAX 65504.0
 
@@ -38,8 +46,8 @@ typedef enum DXGI_COLOR_SPACE_TYPE {
 } DXGI_COLOR_SPACE_TYPE;
 #endif
 
-typedef float3 Image;		// for bring-up
-							// can be 256x1 scanline,  or a real surface someday
+typedef ImageView Image;	// planar float frame, see PipelineImage.h
+							// stages work in place on whatever view they are handed: a whole frame, a band or a tile
 
 typedef struct st2086_struct
 {
@@ -55,8 +63,14 @@ const static float defaultBrightnessSetting = 1.6666666;
 
 // model state parameters
 st2086 ContentMetadata;					// passed using global instead of an actual argument
-static float GlobalBrightnessSetting;
-static float SDRBoost;
+static float GlobalBrightnessSetting = defaultBrightnessSetting;
+static float SDRBoost = defaultSDRBoost;
+static ToneMapCurve ToneMapOperator = ToneMapBT2390;
+static FusionReport FusionTotals;			// frame traffic of the fused stage chains, summed over the run
+static QuantizeParams WireEncoding = { 10, QuantizeBlueNoise, 0 };	// bits 0 sends float
+static ChromaParams WireChroma = { Chroma444, ChromaLimited, ChromaSitingLeft, ChromaUpLinear, 0 };	// HDMI/DP pixel encoding, bits from WireEncoding
+static LocalDimmingParams PanelBacklight = { 0, 0, DimmingMax, 0.99f, 1.0f, 1000.0f };		// zonesX 0: backlight always full on
+static LocalDimmingReport BacklightReport;	// blooming and contrast of the last frame shown
 
 
 
@@ -64,7 +78,7 @@ st2086 GetDisplayCharacteristics()
 {
 	st2086 dc;
 	dc.minLuminance = 0.0f;
-	dc.minLuminance = 1200.0f;
+	dc.peakLuminance = 1200.0f;
 	dc.frameAverageLuminance = 600;
 
 	return dc;
@@ -81,7 +95,7 @@ st2086 DWM_GetContentMetadata()
 }
 
 
-float UI_SetSDRBoostSlider(uint sliderPercentage)
+float UI_SetSDRBoostSlider(unsigned int sliderPercentage)
 {
 	return SDRBoost = sliderPercentage * 50.0f / 100.0f;
 }
@@ -98,7 +112,7 @@ float UI_GetGLobalBrightnessSetting()
 }
 
 // Percentage UI slider
-float UI_GlobalBrightnessSlider(uint sliderPercentage)
+float UI_GlobalBrightnessSlider(unsigned int sliderPercentage)
 {
 	//	100 % is maxFALL of this power supply in Nits
 	// ideally should be a log scale
@@ -119,134 +133,191 @@ float Monitor_GetOSDBrightnessSlider(void)
 }
 
 
-Image ClassicApp_Render()
-{
-	Image image;
-	image = float3(1.0, 1.0, 1.0);
+// Frame-wide building blocks.  Each walks the planes a row at a time so the inner loops
+// are unit-stride and vectorize; none of them allocate.
 
-	return image;
+void Image_Fill(Image image, float3 color)
+{
+	const float value[ChannelCount] = { color.x, color.y, color.z };
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+		{
+			float* row = image.Row(c, y);
+			for (uint32_t x = 0; x < image.width; x++)
+				row[x] = value[c];
+		}
 }
 
-float Image_Average(Image inImage)
+// Applies m to every pixel as mul(m, rgb).
+void Image_Transform(Image image, const float3x3& m)
 {
-	return inImage.y;
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		float* __restrict r = image.Row(ChannelR, y);
+		float* __restrict g = image.Row(ChannelG, y);
+		float* __restrict b = image.Row(ChannelB, y);
+		for (uint32_t x = 0; x < image.width; x++)
+		{
+			float R = r[x], G = g[x], B = b[x];
+			r[x] = m._11 * R + m._12 * G + m._13 * B;
+			g[x] = m._21 * R + m._22 * G + m._23 * B;
+			b[x] = m._31 * R + m._32 * G + m._33 * B;
+		}
+	}
 }
 
-float Image_Peak(Image inImage)
+// Average, peak, percentiles and PQ histogram of a linear 709 image in one pass
+FrameStatistics Image_Statistics(Image image, PipelineExecutor* executor = nullptr)
 {
-	return inImage.z;
+	return ComputeFrameStatistics(image, 80.0f, executor);
 }
 
-Image Image_Mult(Image inImage, float factor)
+// Mean luminance (Y) of a linear 709 image
+float Image_Average(Image image)
 {
-	Image image;
-
-	image.x = inImage.x*factor;
-	image.y = inImage.y*factor;
-	image.z = inImage.z*factor;
-
-	return image;
+	return Image_Statistics(image).Average();
 }
 
-Image Image_Apply2084(Image inImage)
+// Largest channel value anywhere in the image
+float Image_Peak(Image image)
 {
-	Image image;
-
-	image.x = apply2084(inImage.x);
-	image.y = apply2084(inImage.y);
-	image.z = apply2084(inImage.z);
-
-	return image;
+	return Image_Statistics(image).peak;
 }
 
-Image Image_Remove2084(Image inImage)
+void Image_Mult(Image image, float factor)
 {
-	Image image;
-
-	image.x = remove2084(inImage.x);
-	image.y = remove2084(inImage.y);
-	image.z = remove2084(inImage.z);
-
-	return image;
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+		{
+			float* row = image.Row(c, y);
+			for (uint32_t x = 0; x < image.width; x++)
+				row[x] *= factor;
+		}
 }
 
-Image Image_Rec2100toRec709(Image inImage)
+// input normalized so 1.0 is 10000 nits
+void Image_Apply2084(Image image)
 {
-	Image image;
-
-	image = Rec709ToRec2020(inImage);
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+			Apply2084(image.Row(c, y), image.Row(c, y), image.width);
+}
 
-	return image;
+// output normalized so 1.0 is 10000 nits
+void Image_Remove2084(Image image)
+{
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+			Remove2084(image.Row(c, y), image.Row(c, y), image.width);
 }
 
-Image Image_Rec709toRec2100(Image inImage)
+void Image_Rec2100toRec709(Image image)
 {
-	Image image;
+	Image_Transform(image, mat2020to709);
+}
 
-	image = Rec709ToRec2020(inImage);
+void Image_Rec709toRec2100(Image image)
+{
+	Image_Transform(image, mat709to2020);
+}
 
-	return image;
+void Image_2020toDCIP3(Image image)
+{
+	Image_Transform(image, mat2020toDCIP3);
 }
 
-Image Image_2020toDCIP3(Image inImage)
+// Tone mapping goes through a LUT (ToneMapLUT.h) that is rebuilt only when the peaks or
+// the operator change.  Peaks are in nits.  A rebuild makes a new LUT, so stages holding
+// the old one keep it unchanged.
+static std::shared_ptr<const ToneMapLUT> GetToneMapLUT(float inputPeakLuminance, float outputPeakLuminance, ToneMapOutput output, ToneMapInput input = ToneMapInPQ)
 {
-	Image image;
+	static std::mutex lock;
+	static std::shared_ptr<const ToneMapLUT> luts[2];		// by input domain
 
-	image = Rec2020toDCIP3(inImage);
+	ToneMapParams params = { inputPeakLuminance, outputPeakLuminance, 0.0f, 0.0f, ToneMapOperator };
+	std::lock_guard<std::mutex> guard(lock);
+	std::shared_ptr<const ToneMapLUT>& lut = luts[input];
+	if (!lut || !lut->Matches(params, output, input))
+	{
+		std::shared_ptr<ToneMapLUT> built = std::make_shared<ToneMapLUT>();
+		built->Build(params, output, input);
+		lut = built;
+	}
+	return lut;
+}
 
-	return image;
+// Linear image where 1.0 is nitsPerUnit nits (80 for CCCS)
+void Image_ToneMap( Image image, float inputPeakLuminance, float outputPeakLuminance, float nitsPerUnit = 80.0f )
+{
+	std::shared_ptr<const ToneMapLUT> lut = GetToneMapLUT(inputPeakLuminance, outputPeakLuminance, ToneMapOutLinear, ToneMapInLinear);
+	if (lut->IsIdentity())
+		return;
 
+	// the scale and the PQ encode are part of the LUT input, so this is a single pass
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+			lut->ApplyLinear(image.Row(c, y), image.Row(c, y), image.width, nitsPerUnit / 10000.0f, 10000.0f / nitsPerUnit);
 }
 
-Image Image_ToneMap( Image inImage, float inputPeakLuminance, float outputPeakLuminance )
+static void AddFusionTotals(const FusedStages& stages, size_t pixelCount)
 {
-	return inImage;	// TODO implement this.
+	FusionReport report = stages.Report(pixelCount);
+	FusionTotals.stagesAdded += report.stagesAdded;
+	FusionTotals.stagesFused += report.stagesFused;
+	FusionTotals.bytesUnfused += report.bytesUnfused;
+	FusionTotals.bytesFused += report.bytesFused;
 }
 
-Image HDRMasterAndEncode(Image inImage)
+// Runs a chain of stages as one tiled pass and keeps count of the traffic saved
+void Image_RunFused(Image image, const FusedStages& stages)
 {
-	Image image;
+	stages.Run(image);
+	AddFusionTotals(stages, image.PixelCount());
+}
 
+void HDRMasterAndEncode(Image image)
+{
 	// do exposure adjustment
-	// comput average scene luminance
-	float avg = Image_Average(inImage);
+	// comput average scene luminance, and the peak with it so the frame is read once
+	FrameStatistics stats = Image_Statistics(image);
+	float avg = stats.Average();
 
 	// rescale image intensity to limited range
-	image = Image_Mult( inImage, 0.18f / avg );
+	float exposure = avg > 0.0f ? 0.18f / avg : 1.0f;
+	Image_Mult( image, exposure );
 
 	// handle any peaks above the range of the encoding format
-	float maxContentLuminance = Image_Peak(image);
+	float maxContentLuminance = stats.peak * exposure * 80.0f;
 	float maxEncodeLuminance = 10000.0f;
-	image = Image_ToneMap( image, maxContentLuminance, maxEncodeLuminance);
-
-	return image;
+	Image_ToneMap( image, maxContentLuminance, maxEncodeLuminance);
 }
 
-Image SDRMasterAndEncode(Image inImage)
+void SDRMasterAndEncode(Image image)
 {
-	Image image;
-
 	// do exposure adjustment
-	// comput average scene luminance
-	float avg = Image_Average(inImage);
+	// comput average scene luminance, and the peak with it so the frame is read once
+	FrameStatistics stats = Image_Statistics(image);
+	float avg = stats.Average();
 
 	// rescale image intensity to limited range
-	image = Image_Mult( inImage, 0.18f / avg );
+	float exposure = avg > 0.0f ? 0.18f / avg : 1.0f;
+	Image_Mult( image, exposure );
 
 	// handle any peaks above the range of the encoding format
-	float maxContentLuminance = Image_Peak(image);
+	float maxContentLuminance = stats.peak * exposure * 80.0f;
 	float maxEncodeLuminance = 80.0f;
-	image = Image_ToneMap(image, maxContentLuminance, maxEncodeLuminance);
-
-	return image;
+	Image_ToneMap(image, maxContentLuminance, maxEncodeLuminance);
 }
 
-Image HDRApp_Render()
+void ClassicApp_Render(Image image)
 {
-	Image image;
+	Image_Fill(image, float3(1.0, 1.0, 1.0));
+}
 
-	image = float3( HALF_MAX, HALF_MAX, HALF_MAX );	// simple test pattern
-//	image = LoadOpenEXRFile();						// get fp16/ACES content
+void HDRApp_Render(Image image)
+{
+	Image_Fill(image, float3( HALF_MAX, HALF_MAX, HALF_MAX ));	// simple test pattern
+//	image = LoadOpenEXRFile();									// get fp16/ACES content
 
 	// determine capabilities of display
 	st2086 displayCharacteristics = GetDisplayCharacteristics();
@@ -254,7 +325,7 @@ Image HDRApp_Render()
 
 	// define what our content range is
 	st2086 contentMetadata;
-	contentMetadata.peakLuminance = Image_Peak( image );		// this content uses entire range of float16 format
+	contentMetadata.peakLuminance = Image_Peak( image ) * 80.0f;	// this content uses entire range of float16 format
 
 
 	// TOSO: compensate for brightness setting
@@ -277,7 +348,7 @@ Image HDRApp_Render()
 		else
 		{
 			// We use app code to tone map image to match display's peak luminance
-			image = Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance);
+			Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance);
 			// leave metadata at OS default from boot
 			//		contentMetadata = displayCharacteristics;
 			//		Panel_SetMetadata( contentMetadata );
@@ -301,18 +372,13 @@ Image HDRApp_Render()
 		image = GamutMap(image, PanelGamut);
 	}
 #endif
-
-	return image;						// Image rendered by HDR app
-
 }
 
 
-Image HDR10App_Render()
+void HDR10App_Render(Image image)
 {
-	Image image;
-
-	image = float3(10000.0, 10000.0, 10000.0);			// simple test pattern
-	return image;
+	Image_Fill(image, float3(1.0, 1.0, 1.0));			// simple test pattern: 10000 nits, PQ encoded
+	return;
 
 #ifdef MORESTUFF
 	// determine capabilities of display
@@ -350,22 +416,22 @@ Image HDR10App_Render()
 }
 
 //compose or flipl
-Image DWM_Present( Image inImage, DXGI_FORMAT format, bool fullscreen, DXGI_COLOR_SPACE_TYPE space, float SDRboost )
+// On return the image is in CCCS: linear, 709 primaries, 1.0 is 80 nits
+// Each stage of the display chain is built as a FusedStages first, so it can run on a whole
+// frame or, through PipelineExecutor, tile by tile.
+FusedStages DWM_PresentStages( DXGI_FORMAT format, DXGI_COLOR_SPACE_TYPE space, float SDRboost )
 {
-	Image image;				// input image any color space
-	Image linearImage;			// image converted to linear profile
-	Image linear709Image;		// image converted to linear and 709 gamut
-
+	FusedStages stages;
 	switch ( space )		// depending on the color space
 	{
 	case DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709:					// CCCS
 		if (format == DXGI_FORMAT_R16G16B16A16_FLOAT)
 		{
-			image = inImage;
+			// already in CCCS
 		}
 		else
 		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
+			printf("Color Space %d is not supported with Format %d\n", space, format);
 			exit( 1 );
 		}
 		break;
@@ -373,19 +439,13 @@ Image DWM_Present( Image inImage, DXGI_FORMAT format, bool fullscreen, DXGI_COLO
 	case DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020:				// HDR10
 		if (format == DXGI_FORMAT_R10G10B10A2_UNORM)
 		{
-			// convert from HDR10 to CCCS for composition
-			// remove PQ/2082 profile curve
-			Image linearImage = Image_Remove2084(inImage);
-
-			// rotate to 709 primaries
-			Image linear709Image = Image_Rec2100toRec709(linearImage);
-
-			// output
-			image = linear709Image;
+			// convert from HDR10 to CCCS for composition:
+			// remove PQ/2082 profile curve, 10000 nits to 80 nits per unit, rotate to 709 primaries
+			stages = HDR10ToLinear709Stages();
 		}
 		else
 		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
+			printf("Color Space %d is not supported with Format %d\n", space, format);
 			exit(1);
 		}
 		break;
@@ -396,102 +456,126 @@ Image DWM_Present( Image inImage, DXGI_FORMAT format, bool fullscreen, DXGI_COLO
 		 || format == DXGI_FORMAT_R10G10B10A2_UNORM)
 
 		{
-			// convert from AdobeRGB to 709 color primaries
-			Image linearAdobeImage = Image_RemoveAdobeProfile(inImage);
+			// convert to linear profile (Adobe RGB gamma is 563/256)
+			stages.Pow(563.0f / 256.0f);
 
-			// convert to linear profile
-			Image linear709Image = Image_convertAdobeto709(linearAdobeImage);
+			// convert from AdobeRGB to 709 color primaries
+			stages.Matrix(RGBToRGBMatrix(ColorSpaceId::AdobeRGB, ColorSpaceId::Rec709));
 
-			image = linear709Image*UI_GetSDRBoostSetting();
+			stages.Scale(SDRboost);
 		}
 		else
 		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
+			printf("Color Space %d is not supported with Format %d\n", space, format);
 			exit(1);
 		}
+		break;
 #endif
 		
 	default:														// SDR
 		if (format == DXGI_FORMAT_R8G8B8A8_UNORM			
 		 || format == DXGI_FORMAT_R10G10B10A2_UNORM)
 		{
-			image = inImage*UI_GetSDRBoostSetting();					// apply adjustment to classic content
+			stages.Scale(SDRboost);									// apply adjustment to classic content
 		}
 		else
 		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
+			printf("Color Space %d is not supported with Format %d\n", space, format);
 			exit(1);
 		}
 	}
-
-	return image;
-
+	return stages;
 }
 
-Image GPU_Display( Image inImage, bool HDR, float brightnessFactor)
+// Not called for fullscreen (independent flip) content, which bypasses the compositor.
+void DWM_Present( Image image, DXGI_FORMAT format, DXGI_COLOR_SPACE_TYPE space, float SDRboost )
 {
-	Image image;
+	Image_RunFused(image, DWM_PresentStages(format, space, SDRboost));
+}
 
-	image = Image_Mult( inImage, UI_GetGLobalBrightnessSetting() );
+// On return the image is in wire format (HDR10)
+// The display hardware and the scaler are modelled as stage chains, fused into one pass each.
+FusedStages GPU_DisplayStages( bool HDR, float brightnessFactor)
+{
+	FusedStages stages;
+	stages.Scale( brightnessFactor );
 
-	if ( true )			// if (link is in HDR mode)
+	if ( HDR )			// if link is in HDR mode
 	{
 		// Convert from 709 to 2020 primaries
-		image = Image_Rec709toRec2100(image);
+		stages.Matrix(mat709to2020);
+
+		// 80 nits per unit to 10000 nits
+		stages.Scale(0.008f);
 
 		// convert from linear to PQ profile
-		image = Image_Apply2084( image );
+		stages.Apply2084();
 
 		// at this point, the image should be in 2084 range
-//		ASSERT(Image_Peak( image )<= 10000.0);
+//		ASSERT(Image_Peak( image )<= 1.0);
 	}
 	else
 		exit(1);				// this sample shows only HDR mode, not SDR mode
 
-	return image;		// image provided in wire format (HDR10)
+	return stages;
 }
 
-Image Scaler_Rec2020toPanelPrimaries(Image inImage)
+// Encode in 10bit using dithering: the wire carries codes, not floats
+void Wire_Quantize( Image image, PipelineExecutor* executor = nullptr )
 {
-	Image image;
-
-	// For now, assume panel has DCIP3 primaries
-	image = Image_2020toDCIP3(inImage);
-
-	return image;
+	if (QuantizeIsPixelLocal(WireEncoding.mode))
+		QuantizeImage(image, WireEncoding);
+	else
+		DiffuseImage(image, WireEncoding, executor);
 }
 
-Image Scaler_ApplyPanelProfile(Image inImage)
+void GPU_Display( Image image, bool HDR, float brightnessFactor)
 {
-	Image image;
+	Image_RunFused(image, GPU_DisplayStages(HDR, brightnessFactor));
+	Wire_Quantize(image);
+}
 
-	// for now assume panel has a gamma 4.0
-	image = powf(inImage.x, 1.0 / 4.0);
+// chroma-subsample if HDMI bw requires it: the sink sees the R'G'B' it reconstructs from
+// Y'CbCr 4:2:2 or 4:2:0
+void Wire_Send( Image image, PipelineExecutor* executor = nullptr )
+{
+	static ChromaResampler resampler;
+	ChromaParams params = WireChroma;
+	params.bits = WireEncoding.bits;		// Y'CbCr goes over the link at the R'G'B' depth
+	resampler.Run(image, params, executor);
+}
 
-	return image;
+void Scaler_Rec2020toPanelPrimaries(FusedStages& stages)
+{
+	// For now, assume panel has DCIP3 primaries
+	stages.Matrix(mat2020toDCIP3);
 }
 
-Image Scaler_Scale(Image inImage)
+void Scaler_ApplyPanelProfile(FusedStages& stages)
 {
-	Image image;
+	// for now assume panel has a gamma 4.0, out-of-gamut negatives clip
+	stages.Pow(1.0f / 4.0f);
+}
 
+// On return the image is ready for TCON and driver IC
+FusedStages Scaler_ScaleStages()
+{
 	// Scaler knows its own characteristics:
 	st2086 displayCharacteristics = GetDisplayCharacteristics();
 
 	// It also has metadata from input stream:
 	st2086 contentMetadata = DWM_GetContentMetadata();
 
-	// Apply OSD brightness factor
-	image = inImage * Monitor_GetOSDBrightnessSlider();
+	FusedStages stages;
 
-	// convert from PQ to linear
-	image = Image_Remove2084(image);
+	// Apply OSD brightness factor
+	stages.Scale(Monitor_GetOSDBrightnessSlider());
 
-	// if metadata says so, then tone map
-	image = Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance);
+	// convert from PQ to linear, and if metadata says so, tone map in the same step
+	stages.ToneMap(GetToneMapLUT(contentMetadata.peakLuminance, displayCharacteristics.peakLuminance, ToneMapOutLinear));
 
 	// convert from 2020 primaries to hardware primaries
-	image = Scaler_Rec2020toPanelPrimaries(image);
+	Scaler_Rec2020toPanelPrimaries(stages);
 
 #if 0
 	//if gamut is different, then gamut remap
@@ -499,20 +583,45 @@ Image Scaler_Scale(Image inImage)
 		then gamut map
 #endif
 
-		// Apply profile curve of this hardware panel
-		image = Scaler_ApplyPanelProfile(image);
+	// Apply profile curve of this hardware panel
+	Scaler_ApplyPanelProfile(stages);
+
+	return stages;
+}
 
-	return image;			// Image is ready for TCON and driver IC
+void Scaler_Scale(Image image)
+{
+	Image_RunFused(image, Scaler_ScaleStages());
 }
 
 
-Image Panel_Show(Image inImage)
+// TCON and driver IC.  With local dimming the frame is split into zone LED levels and LCD
+// transmittance; what the panel then emits is put back in drive values, so the output
+// means the same with the model on or off.
+void Panel_Show(Image image, PipelineExecutor* executor = nullptr)
 {
-	Image image;
+	if (PanelBacklight.zonesX == 0 || PanelBacklight.zonesY == 0)
+		return;
 
-	image = inImage;
+	static LocalDimmingSimulator backlight;
+	FusedStages toLight, toDrive;
+	toLight.Pow(4.0f);				// inverse of Scaler_ApplyPanelProfile
+	toDrive.Pow(1.0f / 4.0f);
 
-	return image;
+	auto t0 = std::chrono::steady_clock::now();
+	if (executor)
+		executor->ForEachTile(image, [&](Image tile, uint32_t) { toLight.Run(tile); });
+	else
+		toLight.Run(image);
+	BacklightReport = backlight.Run(image, PanelBacklight, executor);
+	if (executor)
+		executor->ForEachTile(image, [&](Image tile, uint32_t) { toDrive.Run(tile); });
+	else
+		toDrive.Run(image);
+
+	if (executor)
+		executor->AddTiming("Panel_Show", image.PixelCount(),
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() * executor->Threads());
 }
 
 #if 0
@@ -573,20 +682,164 @@ Image HardwareToneMapper( Image inImage )
 #endif
 
 // Routine that takes the image at any point and displays it on our current PC.
-void Image_DebugShow( Image inImage )
+void Image_DebugShow( Image image )
+{
+	if (image.Empty())
+		return;
+
+	float3 center = image.Get(image.width / 2, image.height / 2);
+	FrameStatistics stats = Image_Statistics( image );
+	printf( "%ux%u  center RGB: %6.4f %6.4f %6.4f  peak: %6.4f  Y avg/50%%/99%%: %6.4f %6.4f %6.4f\n",
+		image.width, image.height, center.r, center.g, center.b, stats.peak,
+		stats.Average(), stats.Percentile(0.5f), stats.Percentile(0.99f) );
+}
+
+
+// The same chain as ACPipeline_Display, but every 64x64 tile goes through all the stages
+// while it is in cache, spread over the executor's threads.  The stages are built up front,
+// so the tone map LUT and the metadata are only read from the workers.
+void ACPipeline_DisplayTiled(PipelineExecutor& executor, Image image, DXGI_FORMAT format, DXGI_COLOR_SPACE_TYPE colorSpace, float SDRboost, float brightnessFactor)
 {
-	printf( "RGB: %6.4f %6.4f %6.4f\n", inImage.r, inImage.g, inImage.b );
+	bool HDR = true;
+	FusedStages dwm = DWM_PresentStages(format, colorSpace, SDRboost);
+	FusedStages gpu = GPU_DisplayStages(HDR, brightnessFactor);
+	FusedStages scaler = Scaler_ScaleStages();
+
+	std::vector<ExecutorStage> source = {
+		{ "DWM_Present",  [&](Image tile) { dwm.Run(tile); } },
+		{ "GPU_Display",  [&](Image tile) { gpu.Run(tile); } },
+	};
+	std::vector<ExecutorStage> sink = {
+		{ "Scaler_Scale", [&](Image tile) { scaler.Run(tile); } },
+	};
+
+	if (QuantizeIsPixelLocal(WireEncoding.mode))
+	{
+		// ordered dithers are placed by frame position, so find where the tile is
+		source.push_back({ "Wire_Quantize", [&](Image tile)
+		{
+			size_t offset = tile.plane[ChannelR] - image.plane[ChannelR];
+			QuantizeImage(tile, WireEncoding, (uint32_t)(offset % image.stride), (uint32_t)(offset / image.stride));
+		} });
+	}
+	else
+	{
+		// error diffusion needs the rows above it, so it is a wavefront pass of its own
+		executor.Run(image, source);
+		auto t0 = std::chrono::steady_clock::now();
+		Wire_Quantize(image, &executor);
+		executor.AddTiming("Wire_Quantize", image.PixelCount(),
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() * executor.Threads());
+		source.clear();
+	}
+
+	if (WireChroma.format != Chroma444)
+	{
+		// chroma filters reach across tile edges, so the tile chain is split here
+		executor.Run(image, source);
+		auto t0 = std::chrono::steady_clock::now();
+		Wire_Send(image, &executor);
+		executor.AddTiming("Wire_Send", image.PixelCount(),
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() * executor.Threads());
+		source.clear();
+	}
+
+	source.insert(source.end(), sink.begin(), sink.end());
+	executor.Run(image, source);
+
+	// the backlight is spread over many zones, so the panel is a whole-frame pass
+	Panel_Show(image, &executor);
+
+	AddFusionTotals(dwm, image.PixelCount());
+	AddFusionTotals(gpu, image.PixelCount());
+	AddFusionTotals(scaler, image.PixelCount());
 }
 
+// Everything from the compositor to the panel.  This is a pure function of each pixel's
+// RGB, so it can also be baked into a 3D LUT.  With an executor it runs tiled.
+void ACPipeline_Display(Image image, DXGI_FORMAT format, DXGI_COLOR_SPACE_TYPE colorSpace, float SDRboost, float brightnessFactor,
+	PipelineExecutor* executor = nullptr)
+{
+	if (executor)
+	{
+		ACPipeline_DisplayTiled(*executor, image, format, colorSpace, SDRboost, brightnessFactor);
+		return;
+	}
 
-// Entire display pipeline in compilable code format
-void ACPipeline()
+	// DWM composes the Window to a canonical color space and format
+	bool fullscreen = false;
+	if (!fullscreen)
+		DWM_Present(image, format, colorSpace, SDRboost);					// DWM Compositor
+
+																			//	image is now in CCCS encoding:
+																			//		1.0 is 80 nits
+																			//		gamut potentially outside 709 if panel gamut > 709
+																			//		content is tone mapped
+																			//		Peak brightness can be up to 5M nits
+
+																			// Display final DWM composed image using GPU display hardware:
+	bool HDR = true;   //  or SDR;
+	GPU_Display(image, HDR, brightnessFactor);								// GPU Display Hardware
+
+
+	if (true)				// HDMI or DisplayPort
+	{
+		Wire_Send(image);			// Wire protocol
+		Scaler_Scale(image);		// DSP in monitor
+		Panel_Show(image);			// TCON and Driver IC
+	}
+	else 				// integrated panel
+	{
+//		eDP(image);					// Wire Protocol
+		Panel_Show(image);			// TCON and driver IC
+	}
+}
+
+// Samples ACPipeline_Display into a size^3 LUT.  Linear CCCS input is PQ shaped so the
+// lattice covers 0..10000 nits evenly; HDR10 and SDR input is already in [0..1].
+void ACPipeline_BakeLUT(ColorLUT3D& lut, uint32_t size, DXGI_FORMAT format, DXGI_COLOR_SPACE_TYPE colorSpace, float SDRboost, float brightnessFactor,
+	PipelineExecutor* executor = nullptr)
 {
-	Image image;
+	if (colorSpace == DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709)
+		lut.Resize(size, LUTShaperPQ, 80.0f);
+	else
+		lut.Resize(size, LUTShaperLinear, 1.0f);
+
+	// dither and chroma subsampling depend on where a pixel is, not on its color, so the
+	// lattice goes over an unquantized 4:4:4 link
+	QuantizeParams wire = WireEncoding;
+	ChromaFormat chroma = WireChroma.format;
+	uint32_t zones = PanelBacklight.zonesX;
+	WireEncoding.bits = 0;
+	WireChroma.format = Chroma444;
+	PanelBacklight.zonesX = 0;			// so does the backlight; Panel_Show runs after the LUT
+	lut.Bake([&](Image lattice) { ACPipeline_Display(lattice, format, colorSpace, SDRboost, brightnessFactor, executor); });
+	WireEncoding = wire;
+	WireChroma.format = chroma;
+	PanelBacklight.zonesX = zones;
+}
+
+void Image_ApplyLUT(Image image, const ColorLUT3D& lut, PipelineExecutor* executor = nullptr)
+{
+	if (executor)
+		executor->Run(image, { { "ColorLUT3D", [&](Image tile) { lut.Apply(tile); } } });
+	else
+		lut.Apply(image);
+}
+
+
+// Entire display pipeline in compilable code format
+// With lutSize set (e.g. 33 or 65) the display chain is baked once and the frame goes
+// through the LUT instead; cubePath, if given, receives the LUT as a .cube file.
+// With an executor the frame is processed in tiles on its threads.
+void ACPipeline(uint32_t width, uint32_t height, uint32_t lutSize = 0, const char* cubePath = nullptr, PipelineExecutor* executor = nullptr)
+{
+	PipelineImage frame(width, height);
+	FusionTotals = FusionReport();
+	Image image = frame;
 	DXGI_FORMAT format;
 	DXGI_COLOR_SPACE_TYPE colorSpace;
 	st2086 displayCharacteristics;
-	st2086 contentMetadata;
 
 	// OS Boot Sequence
 	// identify characteristics of display
@@ -606,61 +859,97 @@ void ACPipeline()
 	switch (1)
 	{
 	case 0:
-		image = ClassicApp_Render();				// sRGB 8-bit app
+		ClassicApp_Render(image);					// sRGB 8-bit app
 		format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709;
 		break;
 
 	case 1:											// CCCS: HDR game or image viewer
-		image = HDRApp_Render();
+		HDRApp_Render(image);
 		format = DXGI_FORMAT_R16G16B16A16_FLOAT;
 		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
 		break;
 
 	case 2:
-		image = HDR10App_Render();					// HDR10 e.g. Video Player
+		HDR10App_Render(image);						// HDR10 e.g. Video Player
 		format = DXGI_FORMAT_R10G10B10A2_UNORM;
 		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020;
 		break;
 #ifdef ADOBE_RGB
 	case 3:
-		image = AdobeApp_Render();					// e.g. Photoshop or Premiere
+		AdobeApp_Render(image);						// e.g. Photoshop or Premiere
 		format = DXGI_FORMAT_R10G10B10A2_UNORM;
 		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_PADOBE;
 		break;
 #endif
 	}
 
-	// DWM composes the Window to a canonical color space and format
-	bool fullscreen = false;
-	if (!fullscreen)
-		image = DWM_Present(image, format, fullscreen, colorSpace, SDRboost);	// DWM Compositor
+	if (lutSize)
+	{
+		ColorLUT3D lut;
+		ACPipeline_BakeLUT(lut, lutSize, format, colorSpace, SDRboost, brightnessFactor, executor);
+		if (cubePath && !lut.ExportCube(cubePath, "ACPipeline display chain"))
+			printf("Could not write %s\n", cubePath);
+		Image_ApplyLUT(image, lut, executor);
+		Panel_Show(image, executor);
+	}
+	else
+		ACPipeline_Display(image, format, colorSpace, SDRboost, brightnessFactor, executor);
+
+	Image_DebugShow(image);
+	if (BacklightReport.zones)
+		printf( "%u zones  contrast %.0f:1  blooming avg/max %.5f %.5f  clipped %.2f%%\n",
+			BacklightReport.zones, BacklightReport.Contrast(), BacklightReport.bloomingMean,
+			BacklightReport.bloomingMax, BacklightReport.ClippedFraction() * 100.0 );
+	printf( "fused %u stages into %u, saved %.1f MB of frame traffic\n",
+		FusionTotals.stagesAdded, FusionTotals.stagesFused, FusionTotals.BytesSaved() / 1048576.0 );
+	if (executor)
+		executor->PrintTimings();
+}
 
-																				//	image is now in CCCS encoding:
-																				//		1.0 is 80 nits
-																				//		gamut potentially outside 709 if panel gamut > 709
-																				//		content is tone mapped
-																				//		Peak brightness can be up to 5M nits
 
-																				// Display final DWM composed image using GPU display hardware:
-	bool HDR = true;   //  or SDR;
-	image = GPU_Display(image, HDR, brightnessFactor);					// GPU Display Hardware
+// Runs a raw clip through the display chain one frame at a time.  FP16/FP32 frames are taken
+// as scRGB (CCCS) and P010 as HDR10.  With lutSize set the chain is baked once and every
+// frame goes through the LUT instead.
+bool ACPipeline_Stream(const FrameStreamOptions& options, uint32_t lutSize = 0, PipelineExecutor* executor = nullptr)
+{
+	FusionTotals = FusionReport();
+	DWM_SetContentMetadata(GetDisplayCharacteristics());
 
+	float SDRboost = UI_GetSDRBoostSetting();
+	float brightnessFactor = UI_GlobalBrightnessSlider(100);
 
-	if (true)				// HDMI or DisplayPort
+	DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	DXGI_COLOR_SPACE_TYPE colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
+	if (options.inFormat == FrameP010)
 	{
-//		image = Wire_Send(image);			// Wire protocol
-		image = Scaler_Scale(image);		// DSP in monitor
-		image = Panel_Show(image);			// TCON and Driver IC
+		format = DXGI_FORMAT_R10G10B10A2_UNORM;
+		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020;
 	}
-	else 				// integrated panel
+
+	ColorLUT3D lut;
+	if (lutSize)
+		ACPipeline_BakeLUT(lut, lutSize, format, colorSpace, SDRboost, brightnessFactor, executor);
+
+	FrameStreamStats stats = RunFrameStream(options, [&](Image image, uint64_t index)
 	{
-//		image = eDP(image);					// Wire Protocol
-		image = Panel_Show(image);			// TCON and driver IC
-	}
+		WireEncoding.frame = (uint32_t)index;
+		if (lutSize)
+		{
+			Image_ApplyLUT(image, lut, executor);
+			Panel_Show(image, executor);
+		}
+		else
+			ACPipeline_Display(image, format, colorSpace, SDRboost, brightnessFactor, executor);
 
-	Image_DebugShow(image);
+		if (index % 1000 == 0)
+			Image_DebugShow(image);
+	});
 
-	exit(0);
+	printf( "%llu frames in %.1f s (%.2f fps), read %.1f MB, wrote %.1f MB\n",
+		(unsigned long long)stats.frames, stats.seconds, stats.FramesPerSecond(),
+		stats.bytesRead / 1048576.0, stats.bytesWritten / 1048576.0 );
+	if (executor)
+		executor->PrintTimings();
+	return stats.ok;
 }
-*/
\ No newline at end of file
@@ -13,6 +13,8 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <stdlib.h>
+#include <iostream>
 //#include <DirectXMath.h>
 
 
@@ -70,7 +72,7 @@ template <class T> struct Vector2
 		return static_cast<T*>(this)[index];
 	}
 
-	Vector2(T _x = 0, T _y = 0) : x(_x), y(_y) { }
+	constexpr Vector2(T _x = 0, T _y = 0) : x(_x), y(_y) { }
 };
 
 template <class T> struct Vector3
@@ -116,7 +118,7 @@ template <class T> struct Vector3
 		return static_cast<T*>(this)[index];
 	}
 
-	Vector3(T _x = 0, T _y = 0, T _z = 0) : x(_x), y(_y), z(_z) { }
+	constexpr Vector3(T _x = 0, T _y = 0, T _z = 0) : x(_x), y(_y), z(_z) { }
 };
 
 
@@ -138,22 +140,22 @@ template <class T> struct Matrix3x3
 		};
 	};
 
-	Matrix3x3(T value = 0)
+	constexpr Matrix3x3(T value = 0) :
+		_11(value), _12(value), _13(value),
+		_21(value), _22(value), _23(value),
+		_31(value), _32(value), _33(value)
 	{
-		_11 = _12 = _13 = value;
-		_21 = _22 = _23 = value;
-		_31 = _32 = _33 = value;
 	}
 
-	Matrix3x3(
+	constexpr Matrix3x3(
 		T i11, T i12, T i13,
 		T i21, T i22, T i23,
 		T i31, T i32, T i33
-	)
+	) :
+		_11(i11), _12(i12), _13(i13),
+		_21(i21), _22(i22), _23(i23),
+		_31(i31), _32(i32), _33(i33)
 	{
-		_11 = i11; _12 = i12; _13 = i13;
-		_21 = i21; _22 = i22; _23 = i23;
-		_31 = i31; _32 = i32; _33 = i33;
 	}
 
 	T* operator[](unsigned int index)
@@ -593,9 +595,9 @@ Vector4<T> clamp(Vector4<T> v, float min, float max)
 }
 
 // Template Matrix Operations
-// 3x3
+// 3x3, constexpr so that fixed conversion chains can be folded at compile time
 template <class T>
-Vector3<T> mul(Matrix3x3<T> m, Vector3<T> v)
+constexpr Vector3<T> mul(Matrix3x3<T> m, Vector3<T> v)
 {
 	return Vector3<T>
 		(v.x * m._11 + v.y * m._12 + v.z * m._13,
@@ -604,13 +606,13 @@ Vector3<T> mul(Matrix3x3<T> m, Vector3<T> v)
 }
 
 template <class T>
-Vector3<T> operator * (Matrix3x3<T> m, Vector3<T> v)
+constexpr Vector3<T> operator * (Matrix3x3<T> m, Vector3<T> v)
 {
 	return mul(m, v);
 }
 
 template <class T>
-Vector3<T> mul(Vector3<T> v, Matrix3x3<T> m)
+constexpr Vector3<T> mul(Vector3<T> v, Matrix3x3<T> m)
 {
 	return Vector3<T>
 	(v.x * m._11 + v.y * m._21 + v.z * m._31,
@@ -619,13 +621,13 @@ Vector3<T> mul(Vector3<T> v, Matrix3x3<T> m)
 }
 
 template <class T>
-Vector3<T> operator * (Vector3<T> v, Matrix3x3<T> m)
+constexpr Vector3<T> operator * (Vector3<T> v, Matrix3x3<T> m)
 {
 	return mul(v, m);
 }
 
 template <class T>
-Matrix3x3<T> transpose(Matrix3x3<T> m)
+constexpr Matrix3x3<T> transpose(Matrix3x3<T> m)
 {
 	return Matrix3x3<T>(
 		m._11, m._21, m._31,
@@ -635,25 +637,22 @@ Matrix3x3<T> transpose(Matrix3x3<T> m)
 
 // if performance is too slow, we can replace with DirectXMath version
 template <class T>
-Matrix3x3<T> mul( Matrix3x3<T> m1, Matrix3x3<T> m2)
+constexpr Matrix3x3<T> mul( Matrix3x3<T> m1, Matrix3x3<T> m2)
 {
-	Matrix3x3<T> mOut;
-
-	for (int i = 0; i < 3; i++)
-	{
-		for (int j = 0; j < 3; j++)
-		{
-			for (int k = 0; k < 3; k++)
-			{
-				mOut[i][j] += m1[i][k] * m2[k][j];
-			}
-		}
-	}
-	return mOut;
+	return Matrix3x3<T>(
+		m1._11 * m2._11 + m1._12 * m2._21 + m1._13 * m2._31,
+		m1._11 * m2._12 + m1._12 * m2._22 + m1._13 * m2._32,
+		m1._11 * m2._13 + m1._12 * m2._23 + m1._13 * m2._33,
+		m1._21 * m2._11 + m1._22 * m2._21 + m1._23 * m2._31,
+		m1._21 * m2._12 + m1._22 * m2._22 + m1._23 * m2._32,
+		m1._21 * m2._13 + m1._22 * m2._23 + m1._23 * m2._33,
+		m1._31 * m2._11 + m1._32 * m2._21 + m1._33 * m2._31,
+		m1._31 * m2._12 + m1._32 * m2._22 + m1._33 * m2._32,
+		m1._31 * m2._13 + m1._32 * m2._23 + m1._33 * m2._33);
 }
 
 template <class T>
-Matrix3x3<T> operator * (Matrix3x3<T> m1, Matrix3x3<T> m2)
+constexpr Matrix3x3<T> operator * (Matrix3x3<T> m1, Matrix3x3<T> m2)
 {
 	return mul(m1, m2);
 }
@@ -666,26 +665,26 @@ Matrix3x3<T> operator *= (Matrix3x3<T> m1, Matrix3x3<T> m2)		// this is broken f
 
 // Cramer's rule is fast enough for 3x3
 template <class T>
-Matrix3x3<T> inv(Matrix3x3<T> m)
+constexpr Matrix3x3<T> inv(Matrix3x3<T> m)
 {
 	double det =  (double) m._11 * ((double)m._22 * (double)m._33 - (double)m._23 * (double)m._32)
 				- (double) m._12 * ((double)m._21 * (double)m._33 - (double)m._23 * (double)m._31)
 				+ (double) m._13 * ((double)m._21 * (double)m._32 - (double)m._22 * (double)m._31);
-	if (abs(det) < 1.0e-9)
+	if ((det < 0 ? -det : det) < 1.0e-9)
 	{
-		cerr << "Error: Matrix Not Invertible" << endl;
+		std::cerr << "Error: Matrix Not Invertible" << std::endl;
 		abort();
 	}
 	Matrix3x3<T> ret;
-	ret._11 = (float)((m._22 * m._33 - m._23 * m._32) / det);
-	ret._12 = (float)((m._13 * m._32 - m._12 * m._33) / det);
-	ret._13 = (float)((m._12 * m._23 - m._13 * m._22) / det);
-	ret._21 = (float)((m._23 * m._31 - m._21 * m._33) / det);
-	ret._22 = (float)((m._11 * m._33 - m._13 * m._31) / det);
-	ret._23 = (float)((m._13 * m._21 - m._11 * m._23) / det);
-	ret._31 = (float)((m._21 * m._32 - m._22 * m._31) / det);
-	ret._32 = (float)((m._12 * m._31 - m._11 * m._32) / det);
-	ret._33 = (float)((m._11 * m._22 - m._12 * m._21) / det);
+	ret._11 = (T)((m._22 * m._33 - m._23 * m._32) / det);
+	ret._12 = (T)((m._13 * m._32 - m._12 * m._33) / det);
+	ret._13 = (T)((m._12 * m._23 - m._13 * m._22) / det);
+	ret._21 = (T)((m._23 * m._31 - m._21 * m._33) / det);
+	ret._22 = (T)((m._11 * m._33 - m._13 * m._31) / det);
+	ret._23 = (T)((m._13 * m._21 - m._11 * m._23) / det);
+	ret._31 = (T)((m._21 * m._32 - m._22 * m._31) / det);
+	ret._32 = (T)((m._12 * m._31 - m._11 * m._32) / det);
+	ret._33 = (T)((m._11 * m._22 - m._12 * m._21) / det);
 	return ret;
 }
 
@@ -0,0 +1,318 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include "ColorSpaces.h"
+#include "PipelineImage.h"
+#include "SimdMath.h"
+
+// 3D LUT of a per-pixel RGB -> RGB function, e.g. the whole display chain of the pipeline
+// model, applied with tetrahedral interpolation.
+//
+// The lattice is kept as a PipelineImage N wide and N*N tall (row = b*N + g), so baking is
+// just filling that image with the lattice inputs and running the frame stages over it, and
+// the planes are the tables the lookup gathers from.  Input can be shaped by PQ before
+// indexing, which spends the lattice points perceptually on HDR content.
+
+enum LUTShaper
+{
+	LUTShaperLinear,		// index = x / domainMax
+	LUTShaperPQ,			// index = PQ(x * nitsPerUnit / 10000)
+};
+
+// One pixel at a time; also the tail of the vector kernel
+inline void ColorLUT3D_Scalar(const float* const table[ChannelCount], size_t rowStride, int size,
+	const float* const in[ChannelCount], float* const out[ChannelCount], size_t start, size_t n)
+{
+	for (size_t i = start; i < n; i++)
+	{
+		float x[ChannelCount], f[ChannelCount];
+		int cell[ChannelCount];
+		for (int c = 0; c < ChannelCount; c++)
+		{
+			float v = in[c][i] > 0.0f ? std::min(in[c][i], 1.0f) : 0.0f;
+			x[c] = v * (size - 1);
+			cell[c] = std::min((int)x[c], size - 2);
+			f[c] = x[c] - cell[c];
+		}
+		size_t base = ((size_t)cell[ChannelB] * size + cell[ChannelG]) * rowStride + cell[ChannelR];
+		size_t step[ChannelCount] = { 1, rowStride, rowStride * size };
+
+		// sort axes by fraction, largest first
+		int order[ChannelCount] = { ChannelR, ChannelG, ChannelB };
+		if (f[order[0]] < f[order[1]]) std::swap(order[0], order[1]);
+		if (f[order[1]] < f[order[2]]) std::swap(order[1], order[2]);
+		if (f[order[0]] < f[order[1]]) std::swap(order[0], order[1]);
+
+		size_t i1 = base + step[order[0]];
+		size_t i2 = i1 + step[order[1]];
+		size_t i3 = i2 + step[order[2]];
+		float w0 = 1.0f - f[order[0]];
+		float w1 = f[order[0]] - f[order[1]];
+		float w2 = f[order[1]] - f[order[2]];
+		float w3 = f[order[2]];
+
+		for (int c = 0; c < ChannelCount; c++)
+			out[c][i] = w0 * table[c][base] + w1 * table[c][i1] + w2 * table[c][i2] + w3 * table[c][i3];
+	}
+}
+
+template <class S>
+void ColorLUT3D_Kernel(const float* const table[ChannelCount], size_t rowStride, int size,
+	const float* const in[ChannelCount], float* const out[ChannelCount], size_t n)
+{
+	typedef typename S::V V;
+	typedef typename S::M M;
+
+	const V zero = S::Set1(0.0f);
+	const V one = S::Set1(1.0f);
+	const V last = S::Set1((float)(size - 1));
+	const V lastCell = S::Set1((float)(size - 2));
+	// lattice offsets of a step along r, g and b; all exact in float
+	const V dr = S::Set1(1.0f);
+	const V dg = S::Set1((float)rowStride);
+	const V db = S::Set1((float)(rowStride * size));
+	const V dAll = S::Add(S::Add(dr, dg), db);
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		V x[ChannelCount], cell[ChannelCount], f[ChannelCount];
+		for (int c = 0; c < ChannelCount; c++)
+		{
+			x[c] = S::Mul(S::Min(S::Max(S::Load(in[c] + i), zero), one), last);		// Max first so NaN becomes 0
+			cell[c] = S::Min(S::ToFloat(S::TruncInt(x[c])), lastCell);
+			f[c] = S::Sub(x[c], cell[c]);
+		}
+		V base = S::Add(S::Mul(S::Add(S::Mul(cell[ChannelB], S::Set1((float)size)), cell[ChannelG]), dg), cell[ChannelR]);
+
+		// order the fractions: the tetrahedron runs from the base corner along the largest,
+		// then the middle, then the smallest axis
+		M rg = S::CmpLE(f[ChannelG], f[ChannelR]);
+		M gb = S::CmpLE(f[ChannelB], f[ChannelG]);
+		M rb = S::CmpLE(f[ChannelB], f[ChannelR]);
+
+		M rIsMax = S::MaskAnd(rg, rb);
+		M gIsMax = S::MaskAndNot(gb, rg);
+		V offMax = S::Select(rIsMax, dr, S::Select(gIsMax, dg, db));
+
+		M bIsMin = S::MaskAnd(gb, rb);
+		M rNotMin = S::MaskOr(rg, rb);
+		V offMin = S::Select(bIsMin, db, S::Select(rNotMin, dg, dr));
+
+		V fMax = S::Max(f[ChannelR], S::Max(f[ChannelG], f[ChannelB]));
+		V fMin = S::Min(f[ChannelR], S::Min(f[ChannelG], f[ChannelB]));
+		V fMid = S::Sub(S::Sub(S::Add(S::Add(f[ChannelR], f[ChannelG]), f[ChannelB]), fMax), fMin);
+
+		V w0 = S::Sub(one, fMax);
+		V w1 = S::Sub(fMax, fMid);
+		V w2 = S::Sub(fMid, fMin);
+		V w3 = fMin;
+
+		auto i0 = S::TruncInt(base);
+		auto i1 = S::TruncInt(S::Add(base, offMax));
+		auto i2 = S::TruncInt(S::Add(base, S::Sub(dAll, offMin)));
+		auto i3 = S::TruncInt(S::Add(base, dAll));
+
+		for (int c = 0; c < ChannelCount; c++)
+		{
+			V v = S::Mul(w0, S::Gather(table[c], i0));
+			v = S::Add(v, S::Mul(w1, S::Gather(table[c], i1)));
+			v = S::Add(v, S::Mul(w2, S::Gather(table[c], i2)));
+			v = S::Add(v, S::Mul(w3, S::Gather(table[c], i3)));
+			S::Store(out[c] + i, v);
+		}
+	}
+
+	ColorLUT3D_Scalar(table, rowStride, size, in, out, i, n);
+}
+
+class ColorLUT3D
+{
+public:
+	static const uint32_t TileWidth = 1024;
+
+	ColorLUT3D() : m_size(0), m_shaper(LUTShaperLinear), m_domain(1.0f) {}
+
+	// size is the number of lattice points per axis, e.g. 33 or 65.  For LUTShaperLinear
+	// domain is the largest input value; for LUTShaperPQ it is nits per input unit (80 for
+	// CCCS), inputs above 10000 nits clip.
+	ColorLUT3D(uint32_t size, LUTShaper shaper, float domain) : ColorLUT3D()
+	{
+		Resize(size, shaper, domain);
+	}
+
+	void Resize(uint32_t size, LUTShaper shaper, float domain)
+	{
+		m_size = std::max(size, 2u);
+		m_shaper = shaper;
+		m_domain = domain;
+		m_lattice.Resize(m_size, m_size * m_size);
+	}
+
+	// Samples f, any in-place frame function, at every lattice point.
+	template <class F>
+	void Bake(F&& f)
+	{
+		ImageView lattice = m_lattice.View();
+		for (uint32_t b = 0; b < m_size; b++)
+			for (uint32_t g = 0; g < m_size; g++)
+				for (uint32_t r = 0; r < m_size; r++)
+					lattice.Set(r, b * m_size + g, float3(LatticeInput(r), LatticeInput(g), LatticeInput(b)));
+		f(lattice);
+	}
+
+	// src and dst must be the same size; they may be the same image
+	void Apply(ImageView src, ImageView dst) const
+	{
+		SimdDispatch([&](auto s) { ApplyT(s, src, dst); });
+	}
+
+	void Apply(ImageView image) const
+	{
+		Apply(image, image);
+	}
+
+	float3 Lookup(const float3& c) const
+	{
+		float rgb[ChannelCount] = { c.x, c.y, c.z };
+		float out[ChannelCount];
+		float* outPlanes[ChannelCount] = { &out[0], &out[1], &out[2] };
+		const float* inPlanes[ChannelCount] = { &rgb[0], &rgb[1], &rgb[2] };
+		Shape(inPlanes, outPlanes, 1);
+		const float* shaped[ChannelCount] = { &out[0], &out[1], &out[2] };
+		ColorLUT3D_Scalar(Tables().data(), m_lattice.Stride(), m_size, shaped, outPlanes, 0, 1);
+		return float3(out[0], out[1], out[2]);
+	}
+
+	// Adobe/Resolve .cube text format, red varying fastest.  .cube has no shaper, so with
+	// LUTShaperPQ the table expects PQ-encoded input and a comment says so.
+	void WriteCube(std::ostream& os, const char* title) const
+	{
+		os << "TITLE \"" << (title ? title : "ACPipeline") << "\"\n";
+		if (m_shaper == LUTShaperPQ)
+			os << "# input is SMPTE ST 2084 (PQ) encoded, 1.0 = 10000 nits\n";
+		os << "LUT_3D_SIZE " << m_size << "\n";
+		os << "DOMAIN_MIN 0.0 0.0 0.0\n";
+		float top = m_shaper == LUTShaperLinear ? m_domain : 1.0f;
+		os << "DOMAIN_MAX " << top << " " << top << " " << top << "\n";
+		os << std::fixed << std::setprecision(6);
+
+		ImageView lattice = m_lattice.View();
+		for (uint32_t b = 0; b < m_size; b++)
+			for (uint32_t g = 0; g < m_size; g++)
+				for (uint32_t r = 0; r < m_size; r++)
+				{
+					float3 c = lattice.Get(r, b * m_size + g);
+					os << c.x << " " << c.y << " " << c.z << "\n";
+				}
+	}
+
+	bool ExportCube(const char* path, const char* title = nullptr) const
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+		WriteCube(file, title);
+		return (bool)file;
+	}
+
+	uint32_t  Size() const   { return m_size; }
+	LUTShaper Shaper() const { return m_shaper; }
+
+private:
+	std::array<const float*, ChannelCount> Tables() const
+	{
+		ImageView lattice = m_lattice.View();
+		return { lattice.plane[ChannelR], lattice.plane[ChannelG], lattice.plane[ChannelB] };
+	}
+
+	// input value that lands exactly on lattice index i
+	float LatticeInput(uint32_t i) const
+	{
+		float t = (float)i / (m_size - 1);
+		if (m_shaper == LUTShaperPQ)
+			return Remove2084(t) * 10000.0f / m_domain;
+		return t * m_domain;
+	}
+
+	// maps input values to [0..1] lattice coordinates
+	void Shape(const float* const in[ChannelCount], float* const out[ChannelCount], size_t n) const
+	{
+		if (m_shaper == LUTShaperPQ)
+		{
+			float k = m_domain / 10000.0f;
+			for (int c = 0; c < ChannelCount; c++)
+			{
+				for (size_t i = 0; i < n; i++)
+					out[c][i] = in[c][i] * k;
+				Apply2084(out[c], out[c], n);
+			}
+		}
+		else
+		{
+			float k = 1.0f / m_domain;
+			for (int c = 0; c < ChannelCount; c++)
+				for (size_t i = 0; i < n; i++)
+					out[c][i] = in[c][i] * k;
+		}
+	}
+
+	template <class S>
+	void Interpolate(S, const float* const table[ChannelCount], const float* const in[ChannelCount], float* const out[ChannelCount], size_t n) const
+	{
+		ColorLUT3D_Kernel<S>(table, m_lattice.Stride(), m_size, in, out, n);
+	}
+
+	void Interpolate(SimdScalar, const float* const table[ChannelCount], const float* const in[ChannelCount], float* const out[ChannelCount], size_t n) const
+	{
+		ColorLUT3D_Scalar(table, m_lattice.Stride(), m_size, in, out, 0, n);
+	}
+
+	template <class S>
+	void ApplyT(S s, ImageView src, ImageView dst) const
+	{
+		const uint32_t width = std::min(src.width, dst.width);
+		const uint32_t height = std::min(src.height, dst.height);
+		const std::array<const float*, ChannelCount> tables = Tables();
+
+		alignas(PipelineImageAlignment) float scratch[ChannelCount][TileWidth];
+		float* shapedOut[ChannelCount] = { scratch[0], scratch[1], scratch[2] };
+		const float* shapedIn[ChannelCount] = { scratch[0], scratch[1], scratch[2] };
+
+		for (uint32_t y = 0; y < height; y++)
+			for (uint32_t x0 = 0; x0 < width; x0 += TileWidth)
+			{
+				size_t n = std::min(TileWidth, width - x0);
+				const float* in[ChannelCount];
+				float* out[ChannelCount];
+				for (int c = 0; c < ChannelCount; c++)
+				{
+					in[c] = src.Row(c, y) + x0;
+					out[c] = dst.Row(c, y) + x0;
+				}
+				Shape(in, shapedOut, n);
+				Interpolate(s, tables.data(), shapedIn, out, n);
+			}
+	}
+
+	uint32_t      m_size;
+	LUTShaper     m_shaper;
+	float         m_domain;			// linear: input max, PQ: nits per input unit
+	PipelineImage m_lattice;		// m_size wide, m_size * m_size tall
+};
@@ -9,105 +9,202 @@
 // 
 //*********************************************************
 
-#include "pch.h"
+#pragma once
+
 #include <iostream>
 #include <math.h>
-#include "basicmath.h"
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "BasicMath.h"
+#include "SimdMath.h"
+#include "GamutCache.h"
 
 using namespace std;
 
 
 // White points for 2deg FoV
-const float2 D5000White = float2(0.34567, 0.35850);		// D50
-const float2 D6000White = float2(0.32168, 0.33767);		// D60
-const float2 D6500White = float2(0.31271, 0.32902);		// D65	-assumed in Win10
+constexpr float2 D5000White = float2(0.34567, 0.35850);		// D50
+constexpr float2 D6000White = float2(0.32168, 0.33767);		// D60
+constexpr float2 D6500White = float2(0.31271, 0.32902);		// D65	-assumed in Win10
 
 // RGB gamut primaries for common spaces
-const float2 primaryR_NTSC = float2(0.67, 0.33);		// NTSC 1953  uses D67 white
-const float2 primaryG_NTSC = float2(0.21, 0.71);
-const float2 primaryB_NTSC = float2(0.14, 0.08);
+constexpr float2 primaryR_NTSC = float2(0.67, 0.33);		// NTSC 1953  uses D67 white
+constexpr float2 primaryG_NTSC = float2(0.21, 0.71);
+constexpr float2 primaryB_NTSC = float2(0.14, 0.08);
 
-const float2 primaryR_SMPTEC = float2(0.630, 0.340);	// SMPTE C
-const float2 primaryG_SMPTEC = float2(0.310, 0.595);
-const float2 primaryB_SMPTEC = float2(0.155, 0.070);
+constexpr float2 primaryR_SMPTEC = float2(0.630, 0.340);	// SMPTE C
+constexpr float2 primaryG_SMPTEC = float2(0.310, 0.595);
+constexpr float2 primaryB_SMPTEC = float2(0.155, 0.070);
 
-const float2 primaryR_709 = float2(0.640, 0.330);		// 709, sRGB
-const float2 primaryG_709 = float2(0.300, 0.600);
-const float2 primaryB_709 = float2(0.150, 0.060);
+constexpr float2 primaryR_709 = float2(0.640, 0.330);		// 709, sRGB
+constexpr float2 primaryG_709 = float2(0.300, 0.600);
+constexpr float2 primaryB_709 = float2(0.150, 0.060);
 
-const float2 primaryR_Adobe = float2(0.640, 0.330);		// Adobe RGB
-const float2 primaryG_Adobe = float2(0.210, 0.710);
-const float2 primaryB_Adobe = float2(0.150, 0.060);
+constexpr float2 primaryR_Adobe = float2(0.640, 0.330);		// Adobe RGB
+constexpr float2 primaryG_Adobe = float2(0.210, 0.710);
+constexpr float2 primaryB_Adobe = float2(0.150, 0.060);
 
-const float2 primaryR_DCIP3 = float2(0.680, 0.32);		// DCI-P3
-const float2 primaryG_DCIP3 = float2(0.265, 0.69);
-const float2 primaryB_DCIP3 = float2(0.150, 0.06);
+constexpr float2 primaryR_DCIP3 = float2(0.680, 0.32);		// DCI-P3
+constexpr float2 primaryG_DCIP3 = float2(0.265, 0.69);
+constexpr float2 primaryB_DCIP3 = float2(0.150, 0.06);
 
-const float2 primaryR_2020 = float2(0.708, 0.292);		// Rec.2020 or Rec.2100
-const float2 primaryG_2020 = float2(0.170, 0.797);
-const float2 primaryB_2020 = float2(0.131, 0.046);
+constexpr float2 primaryR_2020 = float2(0.708, 0.292);		// Rec.2020 or Rec.2100
+constexpr float2 primaryG_2020 = float2(0.170, 0.797);
+constexpr float2 primaryB_2020 = float2(0.131, 0.046);
 
-const float2 primaryR_ACES = float2(0.7347, 0.2653);	// ACES AP0  uses D60 white
-const float2 primaryG_ACES = float2(0.0000, 1.0000);
-const float2 primaryB_ACES = float2(0.0001,-0.0770);
+constexpr float2 primaryR_ACES = float2(0.7347, 0.2653);	// ACES AP0  uses D60 white
+constexpr float2 primaryG_ACES = float2(0.0000, 1.0000);
+constexpr float2 primaryB_ACES = float2(0.0001,-0.0770);
 
-// From Lindbloom -transposed
-// These are all D65 spaces, except ACES
-const float3x3 XYZ_to_SMPTECRGB = float3x3(
-	 3.5053960, -1.0690722,  0.0563200,
-	-1.7394894,  1.9778245, -0.1970226,
-	-0.5439640,  0.0351722,  1.0502026
-);
-const float3x3 XYZ_to_709RGB = float3x3(
-	 3.2404542, -.9692660, 0.0556434,
-	-1.5371585, 1.8760108, -.2040259,
-	-0.4985314, 0.0415560, 1.0572252
-);
-const float3x3 XYZ_to_AdobeRGB = float3x3(
-	 2.0413690, -0.9692660,  0.0134474,
-	-0.5649464,  1.8760108, -0.1183897,
-	-0.3446944,  0.0415560,  1.0154096
-);
-const float3x3 XYZ_to_BT2020RGB = float3x3(
-	 1.716650, -0.3556710, -0.2533660,
-	-0.666684,  1.6164800,  0.0157681,
-	 0.017640, -0.0427711,  0.9421030
-);
-const float3x3 BT2020RGB_to_XYZ = float3x3(
-	 0.636958,  0.144617,  0.168881,
-	 0.262700,  0.677998,  0.059302,
-	 0.000000,  0.028073,  1.060985
-);
-const float3x3 XYZtoLMS = float3x3(
-	 0.400200,  0.707500, -0.080700,
-	-0.228000,  1.150000,  0.061200,
-	 0.000000,  0.000000,  0.918400
-);
-const float3x3 LMStoXYZ = float3x3(
-	 1.850243, -1.138302,  0.238435,
-	 0.366831,  0.643885, -0.0106734,
-	 0.000000,  0.000000,  1.088850
-);
+// Color space registry
+//
+// Primaries and white point of every RGB space we convert between.  All the conversion
+// matrices below are derived from these at compile time (in double precision) rather
+// than typed in, so chains like RGB->XYZ->RGB fold into a single constant matrix.
+// DCI-P3 is used with a D65 white throughout (i.e. P3-D65), as the panels report it.
 
-const float3x3 XYZ_to_ACESRGB = float3x3(	// NOTE this technically asumes D6000 white point
-	 1.0498110175, 0.0000000000, -0.0000974845,
-	-0.4959030231, 1.3733130458,  0.0982400361,
-	 0.0000000000, 0.0000000000,  0.9912520182
-);
+struct ColorSpaceDesc
+{
+	float2 red;
+	float2 green;
+	float2 blue;
+	float2 white;
+};
 
+enum class ColorSpaceId
+{
+	NTSC,
+	SMPTEC,
+	Rec709,
+	AdobeRGB,
+	DCIP3,
+	Rec2020,
+	ACES,
+	Count
+};
 
-// pre-multiplied matrices for direct conversion
-static const float3x3 mat709to2020 = float3x3 (
-	0.6274040, 0.3292820, 0.0433136,
-	0.0690970, 0.9195400, 0.0113612,
-	0.0163916, 0.0880132, 0.8955950
+constexpr ColorSpaceDesc ColorSpaceRegistry[(int)ColorSpaceId::Count] =
+{
+	{ primaryR_NTSC,   primaryG_NTSC,   primaryB_NTSC,   float2(0.31006, 0.31616) },	// illuminant C
+	{ primaryR_SMPTEC, primaryG_SMPTEC, primaryB_SMPTEC, D6500White },
+	{ primaryR_709,    primaryG_709,    primaryB_709,    D6500White },
+	{ primaryR_Adobe,  primaryG_Adobe,  primaryB_Adobe,  D6500White },
+	{ primaryR_DCIP3,  primaryG_DCIP3,  primaryB_DCIP3,  D6500White },
+	{ primaryR_2020,   primaryG_2020,   primaryB_2020,   D6500White },
+	{ primaryR_ACES,   primaryG_ACES,   primaryB_ACES,   D6000White },
+};
+
+constexpr const ColorSpaceDesc& GetColorSpace(ColorSpaceId id)
+{
+	return ColorSpaceRegistry[(int)id];
+}
+
+typedef Vector3<double>   double3;
+typedef Matrix3x3<double> double3x3;
+
+// xy chromaticity to XYZ with Y = 1
+constexpr double3 ChromaticityToXYZ(const float2& xy)
+{
+	return double3(xy.x / (double)xy.y, 1.0, (1.0 - xy.x - xy.y) / xy.y);
+}
+
+constexpr float3x3 ToFloat3x3(const double3x3& m)
+{
+	return float3x3(
+		(float)m._11, (float)m._12, (float)m._13,
+		(float)m._21, (float)m._22, (float)m._23,
+		(float)m._31, (float)m._32, (float)m._33);
+}
+
+// Normalized primary matrix: linear RGB -> XYZ, white maps to Y = 1.
+constexpr double3x3 RGBToXYZMatrixD(const ColorSpaceDesc& cs)
+{
+	double3 r = ChromaticityToXYZ(cs.red);
+	double3 g = ChromaticityToXYZ(cs.green);
+	double3 b = ChromaticityToXYZ(cs.blue);
+	double3x3 P(r.x, g.x, b.x,
+				r.y, g.y, b.y,
+				r.z, g.z, b.z);
+	double3 S = mul(inv(P), ChromaticityToXYZ(cs.white));
+	return double3x3(r.x * S.x, g.x * S.y, b.x * S.z,
+					 r.y * S.x, g.y * S.y, b.y * S.z,
+					 r.z * S.x, g.z * S.y, b.z * S.z);
+}
+
+constexpr double3x3 BradfordMatrix = double3x3(
+	 0.8951,  0.2664, -0.1614,
+	-0.7502,  1.7135,  0.0367,
+	 0.0389, -0.0685,  1.0296
 );
 
-static const float3x3 mat2020to709 = float3x3 (
-	 1.660491, -0.587640, -0.0728517,
-	-0.124550,  1.132900, -0.0083480,
-	-0.018151, -0.100579,  1.1187300
+// Bradford chromatic adaptation of XYZ from one white point to another.
+constexpr double3x3 ChromaticAdaptationMatrixD(const float2& srcWhite, const float2& dstWhite)
+{
+	double3 s = mul(BradfordMatrix, ChromaticityToXYZ(srcWhite));
+	double3 d = mul(BradfordMatrix, ChromaticityToXYZ(dstWhite));
+	double3x3 scale(d.x / s.x, 0.0, 0.0,
+					0.0, d.y / s.y, 0.0,
+					0.0, 0.0, d.z / s.z);
+	return mul(inv(BradfordMatrix), mul(scale, BradfordMatrix));
+}
+
+// Linear RGB in src to linear RGB in dst.  With adaptWhite, the src white is mapped onto
+// the dst white (Bradford); without it XYZ is passed through unchanged.
+constexpr double3x3 RGBToRGBMatrixD(ColorSpaceId src, ColorSpaceId dst, bool adaptWhite)
+{
+	const ColorSpaceDesc& s = GetColorSpace(src);
+	const ColorSpaceDesc& d = GetColorSpace(dst);
+	double3x3 m = RGBToXYZMatrixD(s);
+	if (adaptWhite && (s.white.x != d.white.x || s.white.y != d.white.y))
+		m = mul(ChromaticAdaptationMatrixD(s.white, d.white), m);
+	return mul(inv(RGBToXYZMatrixD(d)), m);
+}
+
+// Matrices for mul(m, v), i.e. column vectors.
+constexpr float3x3 RGBToXYZMatrix(ColorSpaceId id)
+{
+	return ToFloat3x3(RGBToXYZMatrixD(GetColorSpace(id)));
+}
+
+constexpr float3x3 XYZToRGBMatrix(ColorSpaceId id)
+{
+	return ToFloat3x3(inv(RGBToXYZMatrixD(GetColorSpace(id))));
+}
+
+constexpr float3x3 RGBToRGBMatrix(ColorSpaceId src, ColorSpaceId dst, bool adaptWhite = true)
+{
+	return ToFloat3x3(RGBToRGBMatrixD(src, dst, adaptWhite));
+}
+
+// The first three are stored transposed (Lindbloom's layout) and are used as v * m.
+// These are all D65 spaces, except ACES
+constexpr float3x3 XYZ_to_SMPTECRGB = transpose(XYZToRGBMatrix(ColorSpaceId::SMPTEC));
+constexpr float3x3 XYZ_to_709RGB    = transpose(XYZToRGBMatrix(ColorSpaceId::Rec709));
+constexpr float3x3 XYZ_to_AdobeRGB  = transpose(XYZToRGBMatrix(ColorSpaceId::AdobeRGB));
+constexpr float3x3 XYZ_to_BT2020RGB = XYZToRGBMatrix(ColorSpaceId::Rec2020);
+constexpr float3x3 BT2020RGB_to_XYZ = RGBToXYZMatrix(ColorSpaceId::Rec2020);
+constexpr float3x3 XYZ_to_ACESRGB   = XYZToRGBMatrix(ColorSpaceId::ACES);		// D60 white, as ACES specifies
+
+// Hunt-Pointer-Estevez
+constexpr float3x3 XYZtoLMS = float3x3(
+	 0.400200,  0.707500, -0.080700,
+	-0.228000,  1.150000,  0.061200,
+	 0.000000,  0.000000,  0.918400
 );
+constexpr float3x3 LMStoXYZ = inv(XYZtoLMS);
+
+// pre-multiplied matrices for direct conversion between the D65 spaces
+constexpr float3x3 mat709to2020    = RGBToRGBMatrix(ColorSpaceId::Rec709,   ColorSpaceId::Rec2020);
+constexpr float3x3 mat2020to709    = RGBToRGBMatrix(ColorSpaceId::Rec2020,  ColorSpaceId::Rec709);
+constexpr float3x3 matDCIP3to2020  = RGBToRGBMatrix(ColorSpaceId::DCIP3,    ColorSpaceId::Rec2020);
+constexpr float3x3 mat2020toDCIP3  = RGBToRGBMatrix(ColorSpaceId::Rec2020,  ColorSpaceId::DCIP3);
+constexpr float3x3 matAdobeto2020  = RGBToRGBMatrix(ColorSpaceId::AdobeRGB, ColorSpaceId::Rec2020);
+constexpr float3x3 mat2020toAdobe  = RGBToRGBMatrix(ColorSpaceId::Rec2020,  ColorSpaceId::AdobeRGB);
+constexpr float3x3 mat709toDCIP3   = RGBToRGBMatrix(ColorSpaceId::Rec709,   ColorSpaceId::DCIP3);
+constexpr float3x3 matDCIP3to709   = RGBToRGBMatrix(ColorSpaceId::DCIP3,    ColorSpaceId::Rec709);
 
 static const float3x3 matRGBtoYCbCr = float3x3(
 	0.299, -0.168736,  0.500,
@@ -121,6 +218,22 @@ static const float3x3 matYCbCrtoRGB = float3x3(
 	1.402, -0.714136, 0.0
 );
 
+// Non-constant luminance Y'CbCr from R'G'B', for mul(m, v), given the luma weights of red
+// and blue.  Y' is [0..1] and Cb, Cr are [-0.5..0.5]; range scaling and offsets are left
+// to the caller.
+constexpr float3x3 YCbCrMatrix(double Kr, double Kb)
+{
+	return float3x3(
+		(float)Kr,                       (float)(1.0 - Kr - Kb),                       (float)Kb,
+		(float)(-0.5 * Kr / (1.0 - Kb)), (float)(-0.5 * (1.0 - Kr - Kb) / (1.0 - Kb)), 0.5f,
+		0.5f,                            (float)(-0.5 * (1.0 - Kr - Kb) / (1.0 - Kr)), (float)(-0.5 * Kb / (1.0 - Kr)));
+}
+
+constexpr float3x3 matRGB709toYCbCr  = YCbCrMatrix(0.2126, 0.0722);
+constexpr float3x3 matYCbCrtoRGB709  = inv(matRGB709toYCbCr);
+constexpr float3x3 matRGB2020toYCbCr = YCbCrMatrix(0.2627, 0.0593);		// BT.2020 NCL
+constexpr float3x3 matYCbCrtoRGB2020 = inv(matRGB2020toYCbCr);
+
 // TODO: stealing namespace is bad
 const float gamutVolumeLuv709   = 1487896;
 const float gamutVolumeLuvAdobe = 1978981;
@@ -288,92 +401,302 @@ float3 Remove2084(float3 c)
 				   Remove2084(c.z) );
 }
 
-float3 Rec709ToRec2020(float3 color)		// assuming D65 white
+// Batch (span) versions of the ST.2084 curves for converting whole buffers.
+//
+// These evaluate the same formulas as the scalar functions above but replace powf with
+// polynomial exp2/log2, picking the widest instruction set available at run time
+// (AVX-512, AVX2, SSE4.1 or NEON, with a scalar fallback).  Input is saturated to
+// [0..1] first, like the float3 overloads.  Measured against the scalar functions over
+// every 16-bit code value:
+//
+//   Apply2084:  max abs error 9.4e-6 (under 0.01 of a 10-bit code step)
+//   Remove2084: max rel error 4.4e-5 above 1e-6 (0.01 nits), max abs error 1.2e-11 below that
+//
+// in and out may point to the same buffer.
+
+template <class S>
+void Apply2084_Kernel(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	typedef typename S::V V;
+	const V m1 = S::Set1(2610.0f / 4096.0f / 4);
+	const V m2 = S::Set1(2523.0f / 4096.0f * 128);
+	const V c1 = S::Set1(3424.0f / 4096.0f);
+	const V c2 = S::Set1(2413.0f / 4096.0f * 32);
+	const V c3 = S::Set1(2392.0f / 4096.0f * 32);
+	const V zero = S::Set1(0.0f);
+	const V one  = S::Set1(1.0f);
+
+	auto apply = [&](V L) -> V
 	{
-		0.627402, 0.329292, 0.043306,
-		0.069095, 0.919544, 0.011360,
-		0.016394, 0.088028, 0.895578
+		L = S::Min(S::Max(L, zero), one);
+		V Lp = SimdPow<S>(L, m1);
+		V r = S::Div(S::Add(c1, S::Mul(c2, Lp)), S::Add(one, S::Mul(c3, Lp)));
+		return SimdPow<S>(r, m2);
 	};
-	return mul(conversion, color);
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		S::Store(out + i, apply(S::Load(in + i)));
+	}
+	if (i < n)			// partial vector: go through a padded copy so the tail matches the body
+	{
+		float tmp[S::Width] = {};
+		for (size_t j = 0; j < n - i; j++) tmp[j] = in[i + j];
+		S::Store(tmp, apply(S::Load(tmp)));
+		for (size_t j = 0; j < n - i; j++) out[i + j] = tmp[j];
+	}
 }
 
-float3 Rec2020ToRec709(float3 color)		// assuming D65 white
+template <class S>
+void Remove2084_Kernel(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	typedef typename S::V V;
+	const V im1 = S::Set1(1.0f / (2610.0f / 4096.0f / 4));
+	const V im2 = S::Set1(1.0f / (2523.0f / 4096.0f * 128));
+	const V c1 = S::Set1(3424.0f / 4096.0f);
+	const V c2 = S::Set1(2413.0f / 4096.0f * 32);
+	const V c3 = S::Set1(2392.0f / 4096.0f * 32);
+	const V zero = S::Set1(0.0f);
+	const V one  = S::Set1(1.0f);
+
+	auto remove = [&](V N) -> V
 	{
-		 1.660496, -0.587656, -0.072840,
-		-0.124547,  1.132895, -0.008348,
-		-0.018154, -0.100597,  1.118751
+		N = S::Min(S::Max(N, zero), one);
+		V Np = SimdPow<S>(N, im2);
+		V num = S::Max(S::Sub(Np, c1), zero);
+		V den = S::Sub(c2, S::Mul(c3, Np));
+		return SimdPow<S>(S::Div(num, den), im1);
 	};
-	return mul(conversion, color);
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		S::Store(out + i, remove(S::Load(in + i)));
+	}
+	if (i < n)
+	{
+		float tmp[S::Width] = {};
+		for (size_t j = 0; j < n - i; j++) tmp[j] = in[i + j];
+		S::Store(tmp, remove(S::Load(tmp)));
+		for (size_t j = 0; j < n - i; j++) out[i + j] = tmp[j];
+	}
 }
 
-float3 RecDCIP3toRec2020(float3 color)		// assuming D65 white
+void Apply2084_Scalar(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	for (size_t i = 0; i < n; i++)
 	{
-		 0.75383472,  0.19860256,  0.04756273,
-		 0.04574290,  0.94178025,  0.01247684,
-		-0.00121051,  0.01760467,  0.98360584
-	};
-	return mul(conversion, color);
+		float L = in[i];
+		L = L > 1.0f ? 1.0f : (L < 0.0f ? 0.0f : L);
+		out[i] = Apply2084(L);
+	}
 }
 
-float3 Rec2020toDCIP3(float3 color)			// assuming D65 white
+void Remove2084_Scalar(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	for (size_t i = 0; i < n; i++)
 	{
-		 1.34357525, -0.28218550, -0.06138975,
-		-0.06529575,  1.07578445, -0.01048870,
-		 0.00282219, -0.01960177,  1.01677958
-	};
-	return mul(conversion, color);
+		float N = in[i];
+		N = N > 1.0f ? 1.0f : (N < 0.0f ? 0.0f : N);
+		out[i] = Remove2084(N);
+	}
 }
 
-float3 AdobeRGBtoRec2020(float3 color)		// assuming D65 white
+void Apply2084(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	switch (GetSimdLevel())
 	{
-		0.87733865,  0.07749581,  0.04516554,
-		0.09662091,  0.89153109,  0.01184800,
-		0.02292443,  0.04304395,  0.93403162
-	};
-	return mul(conversion, color);
+#if defined(SIMD_HAS_AVX512)
+	case SimdLevel::AVX512: Apply2084_Kernel<SimdAVX512>(in, out, n); break;
+#endif
+#if defined(SIMD_HAS_AVX2)
+	case SimdLevel::AVX2:   Apply2084_Kernel<SimdAVX2>(in, out, n);   break;
+#endif
+#if defined(SIMD_HAS_SSE41)
+	case SimdLevel::SSE41:  Apply2084_Kernel<SimdSSE41>(in, out, n);  break;
+#endif
+#if defined(SIMD_NEON)
+	case SimdLevel::NEON:   Apply2084_Kernel<SimdNEON>(in, out, n);   break;
+#endif
+	default:                Apply2084_Scalar(in, out, n);             break;
+	}
 }
 
-float3 Rec2020toAdobeRGB(float3 color)		// assuming D65 white
+void Remove2084(const float* in, float* out, size_t n)
 {
-	static const float3x3 conversion =
+	switch (GetSimdLevel())
 	{
-		 1.15197208, -0.09750475, -0.05446733,
-		-0.12454710,  1.13289511, -0.00834801,
-		-0.02253383, -0.04981527,  1.07234910
-	};
-	return mul(conversion, color);
+#if defined(SIMD_HAS_AVX512)
+	case SimdLevel::AVX512: Remove2084_Kernel<SimdAVX512>(in, out, n); break;
+#endif
+#if defined(SIMD_HAS_AVX2)
+	case SimdLevel::AVX2:   Remove2084_Kernel<SimdAVX2>(in, out, n);   break;
+#endif
+#if defined(SIMD_HAS_SSE41)
+	case SimdLevel::SSE41:  Remove2084_Kernel<SimdSSE41>(in, out, n);  break;
+#endif
+#if defined(SIMD_NEON)
+	case SimdLevel::NEON:   Remove2084_Kernel<SimdNEON>(in, out, n);   break;
+#endif
+	default:                Remove2084_Scalar(in, out, n);             break;
+	}
 }
 
-float3 Rec709toDCIP3(float3 RGB709)
+// Interleaved RGB (float3) buffers are just 3n floats as far as the curve is concerned.
+void Apply2084(const float3* in, float3* out, size_t n)
 {
-	static const float3x3 ConvMat =
+	Apply2084(&in->x, &out->x, n * 3);
+}
+
+void Remove2084(const float3* in, float3* out, size_t n)
+{
+	Remove2084(&in->x, &out->x, n * 3);
+}
+
+// Exact HDR10 code value tables.
+//
+// Code->nits tables for 10-bit (1024 entry) and 12-bit (4096 entry) PQ signals, generated
+// at compile time in double precision.  Each table also holds the luminance at every
+// half-code boundary, so going back from nits to the nearest code is a binary search
+// instead of a pow() evaluation.  NitsToPQ10Code(PQ10CodeToNits(c)) == c for every code.
+
+constexpr double cx_log(double x)
+{
+	if (x <= 0.0) return -1.0e300;
+	double e = 0.0;
+	while (x >= 2.0) { x *= 0.5; e += 1.0; }
+	while (x < 1.0)  { x *= 2.0; e -= 1.0; }
+	double z  = (x - 1.0) / (x + 1.0);		// |z| <= 1/3, atanh series converges fast
+	double z2 = z * z;
+	double term = z;
+	double sum = 0.0;
+	for (int k = 1; k < 60; k += 2)
 	{
-		0.822458, 0.177542, 0.000000,
-		0.033193, 0.966807, 0.000000,
-		0.017085, 0.072410, 0.910505
-	};
-	return mul(ConvMat, RGB709);
+		sum += term / k;
+		term *= z2;
+	}
+	return 2.0 * sum + e * 0.69314718055994530942;
 }
 
-float3 DCIP3toRec709(float3 RGB709)
+constexpr double cx_exp(double x)
 {
-	static const float3x3 ConvMat =
+	const double ln2 = 0.69314718055994530942;
+	int n = (int)(x / ln2 + (x < 0.0 ? -0.5 : 0.5));
+	double r = x - n * ln2;					// |r| <= ln2/2
+	double term = 1.0;
+	double sum = 1.0;
+	for (int k = 1; k < 24; k++)
 	{
-		1.224947, -0.224947, 0.000000,
-		-0.042056, 1.042056, 0.000000,
-		-0.019641, -0.078651, 1.098291
-	};
-	return mul(ConvMat, RGB709);
+		term *= r / k;
+		sum += term;
+	}
+	for (; n > 0; n--) sum *= 2.0;
+	for (; n < 0; n++) sum *= 0.5;
+	return sum;
+}
+
+constexpr double cx_pow(double x, double y)
+{
+	return x <= 0.0 ? 0.0 : cx_exp(y * cx_log(x));
+}
+
+// PQ signal [0..1] to luminance in nits
+constexpr double cx_Remove2084Nits(double N)
+{
+	const double m1 = 2610.0 / 4096.0 / 4;
+	const double m2 = 2523.0 / 4096.0 * 128;
+	const double c1 = 3424.0 / 4096.0;
+	const double c2 = 2413.0 / 4096.0 * 32;
+	const double c3 = 2392.0 / 4096.0 * 32;
+	double Np = cx_pow(N, 1.0 / m2);
+	double num = Np - c1;
+	if (num < 0.0) num = 0.0;
+	return 10000.0 * cx_pow(num / (c2 - c3 * Np), 1.0 / m1);
+}
+
+template <int Bits>
+struct PQCodeTable
+{
+	static const int Count = 1 << Bits;
+	static const int MaxCode = Count - 1;
+
+	float nits[Count];					// luminance of each code
+	float threshold[Count - 1];			// luminance at code + 0.5
+
+	constexpr PQCodeTable() : nits(), threshold()
+	{
+		for (int i = 0; i < Count; i++)
+		{
+			nits[i] = (float)cx_Remove2084Nits((double)i / MaxCode);
+			if (i < MaxCode)
+				threshold[i] = (float)cx_Remove2084Nits((i + 0.5) / MaxCode);
+		}
+	}
+
+	float CodeToNits(unsigned int code) const
+	{
+		return nits[code > (unsigned int)MaxCode ? MaxCode : code];
+	}
+
+	// nearest code, ties round up as roundf() would
+	unsigned int NitsToCode(float L) const
+	{
+		if (!(L > 0.0f)) return 0;		// also catches NaN
+		return (unsigned int)(std::upper_bound(threshold, threshold + MaxCode, L) - threshold);
+	}
+};
+
+constexpr PQCodeTable<10> PQ10Table;
+constexpr PQCodeTable<12> PQ12Table;
+
+// The UI steps PQ code values as floats, which can leave the 10-bit range (even go negative);
+// a negative float converted to unsigned is undefined, so clamp first.  NaN gives 0.
+unsigned int PQ10ClampCode(float code) { return code > 0.0f ? (unsigned int)std::min(code, 1023.0f) : 0; }
+
+float PQ10CodeToNits(unsigned int code) { return PQ10Table.CodeToNits(code); }
+float PQ12CodeToNits(unsigned int code) { return PQ12Table.CodeToNits(code); }
+unsigned int NitsToPQ10Code(float nits) { return PQ10Table.NitsToCode(nits); }
+unsigned int NitsToPQ12Code(float nits) { return PQ12Table.NitsToCode(nits); }
+
+float3 Rec709ToRec2020(float3 color)		// assuming D65 white
+{
+	return mul(mat709to2020, color);
+}
+
+float3 Rec2020ToRec709(float3 color)		// assuming D65 white
+{
+	return mul(mat2020to709, color);
+}
+
+float3 RecDCIP3toRec2020(float3 color)		// assuming D65 white
+{
+	return mul(matDCIP3to2020, color);
+}
+
+float3 Rec2020toDCIP3(float3 color)			// assuming D65 white
+{
+	return mul(mat2020toDCIP3, color);
+}
+
+float3 AdobeRGBtoRec2020(float3 color)		// assuming D65 white
+{
+	return mul(matAdobeto2020, color);
+}
+
+float3 Rec2020toAdobeRGB(float3 color)		// assuming D65 white
+{
+	return mul(mat2020toAdobe, color);
+}
+
+float3 Rec709toDCIP3(float3 RGB709)
+{
+	return mul(mat709toDCIP3, RGB709);
+}
+
+float3 DCIP3toRec709(float3 RGB709)
+{
+	return mul(matDCIP3to709, RGB709);
 }
 
 // called to convert from CCCS to HDMI-friendly format e.g. on present/scan-out
@@ -693,6 +1016,324 @@ float gamutVolumeLuv(const float2& red_xy, const float2 green_xy, const float2&
 	return (float) hits;		// return volume
 }
 
+// Parallel versions of gamutVolumeLab/gamutVolumeLuv.
+//
+// The L planes are handed out to worker threads one at a time and each worker keeps
+// its own hit count.  Within a plane everything that does not depend on the innermost
+// (b or v) axis is hoisted out, and the innermost axis is run through the SIMD traits.
+// Every voxel still goes through the same float operations in the same order as the
+// serial functions, so the counts are identical to them (given the same /fp model).
+
+const int gamutVolumeAxis = 401;		// -200..200 on the a/b and u/v axes
+
+// Returns the number of voxels in [v0, v0+Width) with any channel outside [0..1].
+// NaN channels count as inside, just like the serial loops which only reject on a compare.
+template <class S>
+inline int gamutVolumeMisses(typename S::V r, typename S::V g, typename S::V b)
+{
+	const typename S::V zero = S::Set1(0.0f);
+	const typename S::V one  = S::Set1(1.0f);
+	typename S::M out = S::MaskOr(S::CmpLT(r, zero), S::CmpGT(r, one));
+	out = S::MaskOr(out, S::MaskOr(S::CmpLT(g, zero), S::CmpGT(g, one)));
+	out = S::MaskOr(out, S::MaskOr(S::CmpLT(b, zero), S::CmpGT(b, one)));
+	return S::MaskCount(out);
+}
+
+template <class S>
+unsigned long long gamutVolumeLabPlane(int L, const float3& white_XYZ, const float3x3& XYZRGB)
+{
+	typedef typename S::V V;
+
+	// same terms as Lab_to_XYZ, one table per axis
+	float Xa[gamutVolumeAxis], Zb[gamutVolumeAxis];
+	float Ld = (float)L;
+	float fy = (Ld + 16.0f) / 116.0f;
+	float Y = white_XYZ.y * f_inv(fy);
+	for (int i = 0; i < gamutVolumeAxis; i++)
+	{
+		float d = (float)(i - 200);
+		Xa[i] = white_XYZ.x * f_inv(fy + d / 500.0f);
+		Zb[i] = white_XYZ.z * f_inv(fy - d / 200.0f);
+	}
+
+	const V m13 = S::Set1(XYZRGB._13);
+	const V m23 = S::Set1(XYZRGB._23);
+	const V m33 = S::Set1(XYZRGB._33);
+
+	unsigned long long hits = 0;
+	for (int a = 0; a < gamutVolumeAxis; a++)
+	{
+		float X = Xa[a];
+		float p1 = X * XYZRGB._11 + Y * XYZRGB._12;
+		float p2 = X * XYZRGB._21 + Y * XYZRGB._22;
+		float p3 = X * XYZRGB._31 + Y * XYZRGB._32;
+		const V vp1 = S::Set1(p1);
+		const V vp2 = S::Set1(p2);
+		const V vp3 = S::Set1(p3);
+
+		int b = 0;
+		for (; b + S::Width <= gamutVolumeAxis; b += S::Width)
+		{
+			V Z = S::Load(Zb + b);
+			int misses = gamutVolumeMisses<S>(S::Add(vp1, S::Mul(Z, m13)),
+											  S::Add(vp2, S::Mul(Z, m23)),
+											  S::Add(vp3, S::Mul(Z, m33)));
+			hits += S::Width - misses;
+		}
+		for (; b < gamutVolumeAxis; b++)
+		{
+			float Z = Zb[b];
+			hits += 1 - gamutVolumeMisses<SimdScalar>(p1 + Z * XYZRGB._13, p2 + Z * XYZRGB._23, p3 + Z * XYZRGB._33);
+		}
+	}
+	return hits;
+}
+
+template <class S>
+unsigned long long gamutVolumeLuvPlane(int L, const float3& white_XYZ, const float3x3& XYZRGB)
+{
+	typedef typename S::V V;
+
+	// same terms as Luv_to_XYZ; the v axis only depends on L so it is tabulated
+	const float delta = 6.0f / 29.0f;
+	float u_prime_n = 4.0f * white_XYZ.x / (white_XYZ.x + 15.0f * white_XYZ.y + 3.0f * white_XYZ.z);
+	float v_prime_n = 9.0f * white_XYZ.y / (white_XYZ.x + 15.0f * white_XYZ.y + 3.0f * white_XYZ.z);
+	float Ld = (float)L;
+	float L13 = 13.0f * Ld;
+	float Y;
+	if (Ld <= 8.0f) Y = white_XYZ.y * Ld * pow(delta / 2.0f, 3.0f);
+	else Y = white_XYZ.y * pow((Ld + 16.0f) / 116.0f, 3.0f);
+
+	float Vp20[gamutVolumeAxis], Vp4[gamutVolumeAxis];
+	for (int i = 0; i < gamutVolumeAxis; i++)
+	{
+		float v_prime = (float)(i - 200) / L13 + v_prime_n;
+		Vp20[i] = 20.0f * v_prime;
+		Vp4[i] = 4.0f * v_prime;
+	}
+
+	const V vY   = S::Set1(Y);
+	const V m11 = S::Set1(XYZRGB._11), m13 = S::Set1(XYZRGB._13);
+	const V m21 = S::Set1(XYZRGB._21), m23 = S::Set1(XYZRGB._23);
+	const V m31 = S::Set1(XYZRGB._31), m33 = S::Set1(XYZRGB._33);
+	const float y12 = Y * XYZRGB._12;
+	const float y22 = Y * XYZRGB._22;
+	const float y32 = Y * XYZRGB._32;
+	const V vy12 = S::Set1(y12), vy22 = S::Set1(y22), vy32 = S::Set1(y32);
+
+	unsigned long long hits = 0;
+	for (int u = 0; u < gamutVolumeAxis; u++)
+	{
+		float u_prime = (float)(u - 200) / L13 + u_prime_n;
+		float xs = Y * 9.0f * u_prime;
+		float zs = 12.0f - 3.0f * u_prime;
+		const V vxs = S::Set1(xs);
+		const V vzs = S::Set1(zs);
+
+		int v = 0;
+		for (; v + S::Width <= gamutVolumeAxis; v += S::Width)
+		{
+			V den = S::Load(Vp4 + v);
+			V X = S::Div(vxs, den);
+			V Z = S::Div(S::Mul(vY, S::Sub(vzs, S::Load(Vp20 + v))), den);
+			int misses = gamutVolumeMisses<S>(S::Add(S::Add(S::Mul(X, m11), vy12), S::Mul(Z, m13)),
+											  S::Add(S::Add(S::Mul(X, m21), vy22), S::Mul(Z, m23)),
+											  S::Add(S::Add(S::Mul(X, m31), vy32), S::Mul(Z, m33)));
+			hits += S::Width - misses;
+		}
+		for (; v < gamutVolumeAxis; v++)
+		{
+			float X = xs / Vp4[v];
+			float Z = Y * (zs - Vp20[v]) / Vp4[v];
+			hits += 1 - gamutVolumeMisses<SimdScalar>(X * XYZRGB._11 + y12 + Z * XYZRGB._13,
+													  X * XYZRGB._21 + y22 + Z * XYZRGB._23,
+													  X * XYZRGB._31 + y32 + Z * XYZRGB._33);
+		}
+	}
+	return hits;
+}
+
+// Runs plane(L) for L = 0..100 across the available cores and sums the results.
+template <class PlaneFn>
+unsigned long long gamutVolumeParallel(PlaneFn plane)
+{
+	const int numPlanes = 101;
+	unsigned int numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0) numThreads = 1;
+	if (numThreads > (unsigned int)numPlanes) numThreads = numPlanes;
+
+	std::atomic<int> nextPlane(0);
+	std::vector<unsigned long long> threadHits(numThreads, 0);
+	auto worker = [&](unsigned int t)
+	{
+		unsigned long long hits = 0;
+		for (int L = nextPlane++; L < numPlanes; L = nextPlane++)
+			hits += plane(L);
+		threadHits[t] = hits;
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++)
+		threads.emplace_back(worker, t);
+	worker(0);
+	for (auto& th : threads)
+		th.join();
+
+	unsigned long long hits = 0;
+	for (auto h : threadHits)
+		hits += h;
+	return hits;
+}
+
+float gamutVolumeLabParallel(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy)
+{
+	const float Y = 100.0;
+	float3 white_XYZ = xytoXYZ(white_xy, Y);
+	float3x3 XYZRGB = Make_XYZ_to_RGB_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
+
+	unsigned long long hits = SimdDispatch([&](auto s)
+	{
+		typedef decltype(s) S;
+		return gamutVolumeParallel([&](int L) { return gamutVolumeLabPlane<S>(L, white_XYZ, XYZRGB); });
+	});
+	return (float) hits;		// return volume
+}
+
+float gamutVolumeLuvParallel(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy)
+{
+	const float Y = 100.0;
+	float3 white_XYZ = xytoXYZ(white_xy, Y);
+	float3x3 XYZRGB = Make_XYZ_to_RGB_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
+
+	unsigned long long hits = SimdDispatch([&](auto s)
+	{
+		typedef decltype(s) S;
+		return gamutVolumeParallel([&](int L) { return gamutVolumeLuvPlane<S>(L, white_XYZ, XYZRGB); });
+	});
+	return (float) hits;		// return volume
+}
+
+// Analytic gamut volume.
+//
+// Rather than counting grid points, the surface of the RGB unit cube is tessellated,
+// mapped through RGB->XYZ->Lab (or Luv), and the enclosed volume is summed as signed
+// tetrahedra against an interior point (divergence theorem).  The face grids are doubled
+// until two successive Richardson-extrapolated estimates (the error falls as 1/n^2) agree
+// to within tolerance, relative.  A few milliseconds for the default tolerance.
+//
+// The result is the true volume, not clipped to the -200..200 a/b (u/v) box the voxel
+// counters use.  For gamuts inside that box it matches gamutVolumeLab to about 0.01%.
+// gamutVolumeLuv additionally counts the whole L=0 plane (401x401 points, Luv_to_XYZ
+// is 0/0 there and the NaN passes its range test), so its counts are 160801 higher.
+
+// XYZ_to_Luv is 0/0 at black; the limit there is the origin.
+float3 XYZ_to_Luv_Safe(const float3& color_XYZ, const float3& white_XYZ)
+{
+	if (color_XYZ.x + 15.0f * color_XYZ.y + 3.0f * color_XYZ.z <= 0.0f)
+		return float3(0.0f, 0.0f, 0.0f);
+	return XYZ_to_Luv(color_XYZ, white_XYZ);
+}
+
+// Grid spacing on each face is graded toward 0, where the cube roots in Lab/Luv are
+// steepest.  Both faces sharing a cube edge use the same points along it.
+inline float gamutGridWarp(float u)
+{
+	return u * u;
+}
+
+// Signed volume of the tetrahedron (0, a, b, c).
+inline double gamutTetVolume(const float3& a, const float3& b, const float3& c)
+{
+	double cx = (double)b.y * c.z - (double)b.z * c.y;
+	double cy = (double)b.z * c.x - (double)b.x * c.z;
+	double cz = (double)b.x * c.y - (double)b.y * c.x;
+	return (a.x * cx + a.y * cy + a.z * cz) / 6.0;
+}
+
+template <class ToSpace>
+double gamutSurfaceVolume(const float3x3& RGBXYZ, ToSpace toSpace, int n)
+{
+	float3 center = toSpace(mul(RGBXYZ, float3(0.5f, 0.5f, 0.5f)));
+	std::vector<float3> grid((n + 1) * (n + 1));
+
+	double volume = 0.0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			// map the face grid once; vertices are relative to the interior point
+			for (int j = 0; j <= n; j++)
+			{
+				for (int i = 0; i <= n; i++)
+				{
+					float rgb[3];
+					rgb[axis] = (float)side;
+					rgb[(axis + 1) % 3] = gamutGridWarp((float)i / n);
+					rgb[(axis + 2) % 3] = gamutGridWarp((float)j / n);
+					grid[j * (n + 1) + i] = toSpace(mul(RGBXYZ, float3(rgb[0], rgb[1], rgb[2]))) - center;
+				}
+			}
+
+			// signed tetrahedra; (i,j) is right handed about +axis so the 0 face is flipped
+			double faceVolume = 0.0;
+			for (int j = 0; j < n; j++)
+			{
+				for (int i = 0; i < n; i++)
+				{
+					const float3& p00 = grid[j * (n + 1) + i];
+					const float3& p10 = grid[j * (n + 1) + i + 1];
+					const float3& p01 = grid[(j + 1) * (n + 1) + i];
+					const float3& p11 = grid[(j + 1) * (n + 1) + i + 1];
+					faceVolume += gamutTetVolume(p00, p10, p11) + gamutTetVolume(p00, p11, p01);
+				}
+			}
+			volume += side ? faceVolume : -faceVolume;
+		}
+	}
+	return fabs(volume);
+}
+
+template <class ToSpace>
+float gamutVolumeAnalytic(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy,
+	ToSpace toSpace, float tolerance)
+{
+	const float Y = 100.0;
+	float3x3 RGBXYZ = Make_RGB_to_XYZ_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
+
+	const int maxN = 2048;
+	int n = 16;
+	double prev = gamutSurfaceVolume(RGBXYZ, toSpace, n);
+	double prevEstimate = 0.0;
+	double estimate = prev;
+	while (n < maxN)
+	{
+		n *= 2;
+		double cur = gamutSurfaceVolume(RGBXYZ, toSpace, n);
+		estimate = cur + (cur - prev) / 3.0;			// Richardson step for O(1/n^2) error
+		if (prevEstimate > 0.0 && fabs(estimate - prevEstimate) <= tolerance * estimate)
+			break;
+		prevEstimate = estimate;
+		prev = cur;
+	}
+	return (float) estimate;
+}
+
+float gamutVolumeLabAnalytic(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy,
+	float tolerance = 1e-4f)
+{
+	float3 white_XYZ = xytoXYZ(white_xy, 100.0f);
+	return gamutVolumeAnalytic(red_xy, green_xy, blue_xy, white_xy,
+		[&](const float3& XYZ) { return XYZ_to_Lab(XYZ, white_XYZ); }, tolerance);
+}
+
+float gamutVolumeLuvAnalytic(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy,
+	float tolerance = 1e-4f)
+{
+	float3 white_XYZ = xytoXYZ(white_xy, 100.0f);
+	return gamutVolumeAnalytic(red_xy, green_xy, blue_xy, white_xy,
+		[&](const float3& XYZ) { return XYZ_to_Luv_Safe(XYZ, white_XYZ); }, tolerance);
+}
+
 #if 0
 int main(int argc, char* argv[])
 {
@@ -778,6 +1419,8 @@ Polygon6 Intersect(const Triangle& p, const Triangle& q)
 		float2 clipB = i == 0 ? q.b : i == 1 ? q.c : q.a;
 		Polygon6 t = r;
 		r.numPoints = 0;
+		if (t.numPoints == 0)
+			break;
 		float2 s = t.points[t.numPoints - 1];
 		for (int j = 0; j < t.numPoints; j++)
 		{
@@ -798,11 +1441,23 @@ Polygon6 Intersect(const Triangle& p, const Triangle& q)
 		}
 	}
 
+	// Order the points clockwise around the first one.  There are at most six, so an
+	// insertion sort; std::sort's unrolled 16 element prefix trips -Warray-bounds here.
 	float2 c = r.points[0];
-	std::sort(&r.points[0], &r.points[r.numPoints], [c](const float2& a, const float2& b) {
-		float det = (a.x - c.x) * (b.y - c.y) - (b.x - c.x) * (a.y - c.y);
-		return det < 0;
-	});
+	for (int i = 1; i < r.numPoints; i++)
+	{
+		float2 a = r.points[i];
+		int j = i;
+		for (; j > 0; j--)
+		{
+			float2 b = r.points[j - 1];
+			float det = (a.x - c.x) * (b.y - c.y) - (b.x - c.x) * (a.y - c.y);
+			if (!(det < 0))
+				break;
+			r.points[j] = b;
+		}
+		r.points[j] = a;
+	}
 
 	return r;
 }
@@ -907,6 +1562,22 @@ float ComputeGamutCoverage(float2 r1, float2 g1, float2 b1, float2 r2, float2 g2
 	return area / ComputeGamutArea(r2, g2, b2);	// return as fraction of tri2
 }
 
+// Everything GamutCache stores for one panel.  Use a GamutCache in front of this when
+// the same primaries come up repeatedly: the volumes count 16M voxels each.
+GamutMetrics ComputeGamutMetrics(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy)
+{
+	GamutMetrics m;
+	m.volumeLab     = gamutVolumeLabParallel(red_xy, green_xy, blue_xy, white_xy);
+	m.volumeLuv     = gamutVolumeLuvParallel(red_xy, green_xy, blue_xy, white_xy);
+	m.area          = ComputeGamutArea(red_xy, green_xy, blue_xy);
+	m.coverage709   = ComputeGamutCoverage(red_xy, green_xy, blue_xy, primaryR_709,   primaryG_709,   primaryB_709);
+	m.coverageAdobe = ComputeGamutCoverage(red_xy, green_xy, blue_xy, primaryR_Adobe, primaryG_Adobe, primaryB_Adobe);
+	m.coverageDCIP3 = ComputeGamutCoverage(red_xy, green_xy, blue_xy, primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3);
+	m.coverage2020  = ComputeGamutCoverage(red_xy, green_xy, blue_xy, primaryR_2020,  primaryG_2020,  primaryB_2020);
+	m.coverageACES  = ComputeGamutCoverage(red_xy, green_xy, blue_xy, primaryR_ACES,  primaryG_ACES,  primaryB_ACES);
+	return m;
+}
+
 // Shape of human visual gamut in xy 1931 chromaticities
 #if 0
 const vec2 aa = vec2(0.174112257, 0.004963727); // 380.0
@@ -0,0 +1,270 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+#include "D2DPatternCanvas.h"
+
+using namespace Microsoft::WRL;
+
+D2DPatternCanvas::D2DPatternCanvas(DX::DeviceResources* deviceResources) :
+	m_deviceResources(deviceResources),
+	m_brushHits(0),
+	m_brushMisses(0),
+	m_textHits(0),
+	m_textMisses(0)
+{
+}
+
+void D2DPatternCanvas::SetFont(CanvasFont font, IDWriteTextFormat* format)
+{
+	m_fonts[font] = format;
+	m_layouts.clear();
+}
+
+void D2DPatternCanvas::SetEffect(CanvasEffect effect, ID2D1Effect* d2dEffect)
+{
+	if (effect != CanvasEffectNone)
+		m_effects[effect] = d2dEffect;
+}
+
+void D2DPatternCanvas::SetImage(CanvasImage image, ID2D1Image* d2dImage)
+{
+	m_images[image] = d2dImage;
+}
+
+D2D1_RECT_F D2DPatternCanvas::GetLogicalSize() const
+{
+	return m_deviceResources->GetLogicalSize();
+}
+
+D2D1_RECT_F D2DPatternCanvas::GetOutputSize() const
+{
+	RECT out = m_deviceResources->GetOutputSize();
+	return D2D1::RectF((float)out.left, (float)out.top, (float)out.right, (float)out.bottom);
+}
+
+float D2DPatternCanvas::GetDpi() const
+{
+	return m_deviceResources->GetDpi();
+}
+
+void D2DPatternCanvas::ReleaseDeviceResources()
+{
+	m_brushes.clear();
+	m_batches.clear();
+	for (auto& effect : m_effects)
+		effect.Reset();
+	m_images.clear();
+}
+
+ID2D1SolidColorBrush* D2DPatternCanvas::Brush(const D2D1_COLOR_F& color)
+{
+	BrushKey key;
+	memcpy(key.data(), &color, sizeof(key));
+
+	auto it = m_brushes.find(key);
+	if (it != m_brushes.end())
+	{
+		m_brushHits++;
+		return it->second.Get();
+	}
+
+	// Colors that animate never repeat; start over rather than grow without bound
+	m_brushMisses++;
+	if (m_brushes.size() >= MaxBrushes)
+		m_brushes.clear();
+
+	ComPtr<ID2D1SolidColorBrush> brush;
+	DX::ThrowIfFailed(m_deviceResources->GetD2DDeviceContext()->CreateSolidColorBrush(color, &brush));
+	return (m_brushes[key] = brush).Get();
+}
+
+void D2DPatternCanvas::Clear(const D2D1_COLOR_F& color)
+{
+	m_deviceResources->GetD2DDeviceContext()->Clear(color);
+}
+
+void D2DPatternCanvas::FillRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color)
+{
+	m_deviceResources->GetD2DDeviceContext()->FillRectangle(rect, Brush(color));
+}
+
+void D2DPatternCanvas::DrawRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth)
+{
+	m_deviceResources->GetD2DDeviceContext()->DrawRectangle(rect, Brush(color), strokeWidth);
+}
+
+void D2DPatternCanvas::FillEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color)
+{
+	m_deviceResources->GetD2DDeviceContext()->FillEllipse(ellipse, Brush(color));
+}
+
+void D2DPatternCanvas::FillEllipses(uint64_t batch, const D2D1_ELLIPSE* ellipses, const D2D1_COLOR_F* colors, uint32_t count)
+{
+	auto ctx = m_deviceResources->GetD2DDeviceContext();
+	if (batch == 0)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			ctx->FillEllipse(ellipses[i], Brush(colors[i]));
+		return;
+	}
+
+	EllipseBatch& entry = m_batches[batch];
+	if (!entry.list)
+	{
+		// Record untransformed: the transform applies when the list is drawn
+		ComPtr<ID2D1Image> target;
+		D2D1_MATRIX_3X2_F transform;
+		ctx->GetTarget(&target);
+		ctx->GetTransform(&transform);
+
+		DX::ThrowIfFailed(ctx->CreateCommandList(&entry.list));
+		ctx->SetTarget(entry.list.Get());
+		ctx->SetTransform(D2D1::Matrix3x2F::Identity());
+		for (uint32_t i = 0; i < count; i++)
+			ctx->FillEllipse(ellipses[i], Brush(colors[i]));
+		ctx->SetTransform(transform);
+		ctx->SetTarget(target.Get());
+		DX::ThrowIfFailed(entry.list->Close());
+	}
+	entry.used = true;
+
+	ctx->DrawImage(entry.list.Get());
+}
+
+void D2DPatternCanvas::DrawEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color, float strokeWidth)
+{
+	m_deviceResources->GetD2DDeviceContext()->DrawEllipse(ellipse, Brush(color), strokeWidth);
+}
+
+void D2DPatternCanvas::DrawLine(D2D1_POINT_2F p0, D2D1_POINT_2F p1, const D2D1_COLOR_F& color, float strokeWidth)
+{
+	m_deviceResources->GetD2DDeviceContext()->DrawLine(p0, p1, Brush(color), strokeWidth);
+}
+
+void D2DPatternCanvas::FillLinearGradient(const D2D1_RECT_F& rect, D2D1_POINT_2F start, D2D1_POINT_2F end,
+	const D2D1_GRADIENT_STOP* stops, uint32_t stopCount)
+{
+	auto ctx = m_deviceResources->GetD2DDeviceContext();
+
+	D2D1_BUFFER_PRECISION prec = D2D1_BUFFER_PRECISION_UNKNOWN;
+	switch (m_deviceResources->GetBackBufferFormat())
+	{
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		prec = D2D1_BUFFER_PRECISION_8BPC_UNORM;
+		break;
+
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		prec = D2D1_BUFFER_PRECISION_16BPC_UNORM;
+		break;
+
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		prec = D2D1_BUFFER_PRECISION_16BPC_FLOAT;
+		break;
+
+	default:
+		DX::ThrowIfFailed(E_INVALIDARG);
+		break;
+	}
+
+	ComPtr<ID2D1GradientStopCollection1> stopCollection;
+	DX::ThrowIfFailed(ctx->CreateGradientStopCollection(
+		stops,
+		stopCount,
+		D2D1_COLOR_SPACE_SRGB,
+		D2D1_COLOR_SPACE_SCRGB,
+		prec,
+		D2D1_EXTEND_MODE_CLAMP,
+		D2D1_COLOR_INTERPOLATION_MODE_PREMULTIPLIED,	// No alpha, doesn't matter
+		&stopCollection));
+
+	ComPtr<ID2D1LinearGradientBrush> brush;
+	DX::ThrowIfFailed(ctx->CreateLinearGradientBrush(
+		D2D1::LinearGradientBrushProperties(start, end),
+		stopCollection.Get(),
+		&brush));
+
+	ctx->FillRectangle(rect, brush.Get());
+}
+
+void D2DPatternCanvas::DrawString(CanvasFont font, const std::wstring& text, const D2D1_RECT_F& textBox, const D2D1_COLOR_F& color)
+{
+	// Drop shadows draw the same text again one pixel over, so they share the layout
+	TextKey key = { font, std::hash<std::wstring>()(text), textBox.right, textBox.bottom };
+	TextLayout& entry = m_layouts[key];
+	if (entry.layout && entry.text == text)
+	{
+		m_textHits++;
+	}
+	else
+	{
+		m_textMisses++;
+		entry.text = text;
+		entry.layout.Reset();
+		DX::ThrowIfFailed(m_deviceResources->GetDWriteFactory()->CreateTextLayout(
+			text.c_str(),
+			(unsigned int)text.length(),
+			m_fonts[font].Get(),
+			textBox.right,
+			textBox.bottom,
+			&entry.layout));
+	}
+	entry.used = true;
+
+	m_deviceResources->GetD2DDeviceContext()->DrawTextLayout(D2D1::Point2F(textBox.left, textBox.top), entry.layout.Get(), Brush(color));
+}
+
+template <class Map>
+static void DropUnused(Map& map)
+{
+	for (auto it = map.begin(); it != map.end();)
+	{
+		if (it->second.used)
+		{
+			it->second.used = false;
+			++it;
+		}
+		else
+			it = map.erase(it);
+	}
+}
+
+void D2DPatternCanvas::EndFrame()
+{
+	DropUnused(m_layouts);
+	DropUnused(m_batches);
+}
+
+// SetValueByName copies sizeof(value) bytes, so the types here must match the effect's properties
+void D2DPatternCanvas::SetEffectValue(CanvasEffect effect, const wchar_t* name, float value)
+{
+	if (effect != CanvasEffectNone && m_effects[effect])
+		m_effects[effect]->SetValueByName(name, value);
+}
+
+void D2DPatternCanvas::SetEffectValue(CanvasEffect effect, const wchar_t* name, D2D1_POINT_2F value)
+{
+	if (effect != CanvasEffectNone && m_effects[effect])
+		m_effects[effect]->SetValueByName(name, value);
+}
+
+void D2DPatternCanvas::DrawEffect(CanvasEffect effect)
+{
+	if (effect != CanvasEffectNone && m_effects[effect])
+		m_deviceResources->GetD2DDeviceContext()->DrawImage(m_effects[effect].Get());
+}
+
+void D2DPatternCanvas::DrawImage(CanvasImage image, D2D1_POINT_2F offset)
+{
+	auto it = m_images.find(image);
+	if (it != m_images.end() && it->second)
+		m_deviceResources->GetD2DDeviceContext()->DrawImage(it->second.Get(), offset);
+}
@@ -0,0 +1,115 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <tuple>
+#include "DeviceResources.h"
+#include "PatternCanvas.h"
+
+// PatternCanvas on the swap chain's D2D device context.  Sizes come from the device
+// resources; fonts, effects and images are registered by the owner, and the context must be
+// between BeginDraw and EndDraw while patterns draw.
+class D2DPatternCanvas : public PatternCanvas
+{
+public:
+	explicit D2DPatternCanvas(DX::DeviceResources* deviceResources);
+
+	void SetFont(CanvasFont font, IDWriteTextFormat* format);
+	void SetEffect(CanvasEffect effect, ID2D1Effect* d2dEffect);
+	void SetImage(CanvasImage image, ID2D1Image* d2dImage);
+
+	// Drops the brushes, effects and images of a lost device.  Solid brushes are shared by
+	// color until then.
+	void ReleaseDeviceResources();
+	uint64_t BrushCacheHits() const   { return m_brushHits; }
+	uint64_t BrushCacheMisses() const { return m_brushMisses; }
+	size_t   BrushCacheSize() const   { return m_brushes.size(); }
+
+	// Text layouts and ellipse batches are kept while they are drawn; call once a frame to drop
+	// those that were not, such as last second's countdown.
+	void EndFrame();
+	uint64_t TextCacheHits() const    { return m_textHits; }
+	uint64_t TextCacheMisses() const  { return m_textMisses; }
+	size_t   TextCacheSize() const    { return m_layouts.size(); }
+
+	D2D1_RECT_F GetLogicalSize() const override;
+	D2D1_RECT_F GetOutputSize() const override;
+	float       GetDpi() const override;
+
+	using PatternCanvas::FillRectangle;
+	using PatternCanvas::DrawRectangle;
+	using PatternCanvas::FillEllipse;
+	using PatternCanvas::DrawEllipse;
+
+	void Clear(const D2D1_COLOR_F& color) override;
+	void FillRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) override;
+	void DrawRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) override;
+	void FillEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color) override;
+	void FillEllipses(uint64_t batch, const D2D1_ELLIPSE* ellipses, const D2D1_COLOR_F* colors, uint32_t count) override;
+	void DrawEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color, float strokeWidth) override;
+	void DrawLine(D2D1_POINT_2F p0, D2D1_POINT_2F p1, const D2D1_COLOR_F& color, float strokeWidth) override;
+	void FillLinearGradient(const D2D1_RECT_F& rect, D2D1_POINT_2F start, D2D1_POINT_2F end,
+		const D2D1_GRADIENT_STOP* stops, uint32_t stopCount) override;
+	void DrawString(CanvasFont font, const std::wstring& text, const D2D1_RECT_F& textBox, const D2D1_COLOR_F& color) override;
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, float value) override;
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, D2D1_POINT_2F value) override;
+	void DrawEffect(CanvasEffect effect) override;
+	void DrawImage(CanvasImage image, D2D1_POINT_2F offset) override;
+
+private:
+	// Colors are keyed by their exact bits: patches a code value apart must not share a brush
+	typedef std::array<uint32_t, 4> BrushKey;
+	static const size_t MaxBrushes = 4096;
+
+	ID2D1SolidColorBrush* Brush(const D2D1_COLOR_F& color);
+
+	// Layouts depend on the font, the text and the box size, not its position
+	struct TextKey
+	{
+		CanvasFont  font;
+		size_t      hash;
+		float       width, height;
+
+		bool operator<(const TextKey& k) const
+		{
+			return std::tie(font, hash, width, height) < std::tie(k.font, k.hash, k.width, k.height);
+		}
+	};
+
+	struct TextLayout
+	{
+		std::wstring                                text;		// to tell hash collisions apart
+		Microsoft::WRL::ComPtr<IDWriteTextLayout>   layout;
+		bool                                        used = false;
+	};
+
+	// A batch is recorded into a command list once, then drawn as one image
+	struct EllipseBatch
+	{
+		Microsoft::WRL::ComPtr<ID2D1CommandList>    list;
+		bool                                        used = false;
+	};
+
+	DX::DeviceResources*                                        m_deviceResources;
+	Microsoft::WRL::ComPtr<IDWriteTextFormat>                   m_fonts[CanvasFontCount];
+	Microsoft::WRL::ComPtr<ID2D1Effect>                         m_effects[CanvasEffectCount];
+	std::map<CanvasImage, Microsoft::WRL::ComPtr<ID2D1Image>>   m_images;
+	std::map<BrushKey, Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>> m_brushes;
+	uint64_t                                                    m_brushHits;
+	uint64_t                                                    m_brushMisses;
+	std::map<TextKey, TextLayout>                               m_layouts;
+	uint64_t                                                    m_textHits;
+	uint64_t                                                    m_textMisses;
+	std::map<uint64_t, EllipseBatch>                            m_batches;
+};
@@ -0,0 +1,145 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "ColorSpaces.h"
+#include "PipelineImage.h"
+#include "PipelineExecutor.h"
+
+// Whole-frame statistics gathered in a single read of the frame.
+//
+// Each row is reduced to a luminance sum and a channel peak, and its luminance is PQ
+// encoded (in L1, a chunk at a time) and binned into a 1024-bin histogram.  PQ bins are
+// perceptually even, so percentiles are as good at 0.01 nits as at 1000 nits.  On an
+// executor every worker fills its own partial and the partials are merged at the end.
+
+struct FrameStatistics
+{
+	static const int HistogramBins = 1024;
+
+	float    nitsPerUnit;			// luminance scale of the image, 80 for CCCS
+	uint64_t pixelCount;
+	double   luminanceSum;			// Rec.709 Y, in image units
+	float    peak;					// largest channel value
+	float    peakLuminance;			// largest Y, in image units
+	uint32_t histogram[HistogramBins];
+
+	explicit FrameStatistics(float nits = 80.0f) { Reset(nits); }
+
+	void Reset(float nits)
+	{
+		nitsPerUnit = nits;
+		pixelCount = 0;
+		luminanceSum = 0.0;
+		peak = 0.0f;
+		peakLuminance = 0.0f;
+		memset(histogram, 0, sizeof(histogram));
+	}
+
+	void Merge(const FrameStatistics& s)
+	{
+		pixelCount += s.pixelCount;
+		luminanceSum += s.luminanceSum;
+		peak = std::max(peak, s.peak);
+		peakLuminance = std::max(peakLuminance, s.peakLuminance);
+		for (int i = 0; i < HistogramBins; i++)
+			histogram[i] += s.histogram[i];
+	}
+
+	float Average() const { return pixelCount ? (float)(luminanceSum / pixelCount) : 0.0f; }
+
+	// Luminance below which fraction p of the pixels fall, in image units.  Interpolated in
+	// PQ within the bin, so the error is a fraction of a PQ code.
+	float Percentile(float p) const
+	{
+		if (pixelCount == 0)
+			return 0.0f;
+
+		double target = std::min(std::max(p, 0.0f), 1.0f) * pixelCount;
+		double below = 0.0;
+		for (int i = 0; i < HistogramBins; i++)
+		{
+			if (histogram[i] && below + histogram[i] >= target)
+			{
+				float f = (float)((target - below) / histogram[i]);
+				float pq = (i + f) / HistogramBins;
+				return std::min(Remove2084(pq) * 10000.0f / nitsPerUnit, peakLuminance);
+			}
+			below += histogram[i];
+		}
+		return peakLuminance;
+	}
+
+	// Accumulates one region of a linear Rec.709 image
+	void Add(ImageView image)
+	{
+		const int Chunk = 1024;
+		float Y[Chunk];
+		const float toPQ = nitsPerUnit / 10000.0f;
+
+		for (uint32_t y = 0; y < image.height; y++)
+		{
+			const float* r = image.Row(ChannelR, y);
+			const float* g = image.Row(ChannelG, y);
+			const float* b = image.Row(ChannelB, y);
+
+			for (uint32_t x0 = 0; x0 < image.width; x0 += Chunk)
+			{
+				uint32_t n = std::min((uint32_t)Chunk, image.width - x0);
+				float sum = 0.0f, channelPeak = peak, lumPeak = peakLuminance;
+				for (uint32_t i = 0; i < n; i++)
+				{
+					float R = r[x0 + i], G = g[x0 + i], B = b[x0 + i];
+					float L = 0.2126f * R + 0.7152f * G + 0.0722f * B;
+					sum += L;
+					channelPeak = std::max(channelPeak, std::max(R, std::max(G, B)));
+					lumPeak = std::max(lumPeak, L);
+					Y[i] = L * toPQ;
+				}
+				luminanceSum += sum;
+				peak = channelPeak;
+				peakLuminance = lumPeak;
+
+				// Apply2084 saturates, but the scalar path lets NaN through, so clamp before
+				// converting: the compare is false for NaN and sends it to bin 0
+				Apply2084(Y, Y, n);
+				for (uint32_t i = 0; i < n; i++)
+				{
+					float bin = Y[i] > 0.0f ? std::min(Y[i] * HistogramBins, (float)(HistogramBins - 1)) : 0.0f;
+					histogram[(int)bin]++;
+				}
+			}
+		}
+		pixelCount += image.PixelCount();
+	}
+};
+
+// One pass over the frame; tiled over the executor's threads when one is given
+inline FrameStatistics ComputeFrameStatistics(ImageView image, float nitsPerUnit = 80.0f, PipelineExecutor* executor = nullptr)
+{
+	FrameStatistics stats(nitsPerUnit);
+	if (!executor || executor->Threads() == 1)
+	{
+		stats.Add(image);
+		return stats;
+	}
+
+	std::vector<FrameStatistics> partial(executor->Threads(), FrameStatistics(nitsPerUnit));
+	executor->ForEachTile(image, [&](ImageView tile, uint32_t worker) { partial[worker].Add(tile); });
+	for (const FrameStatistics& p : partial)
+		stats.Merge(p);
+	return stats;
+}
@@ -0,0 +1,508 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+#include "BasicMath.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Cache for the gamut area and coverage numbers of a set of panel primaries.
+//
+// Lookups are keyed on the primaries and white point quantized to the 1/50000 units that
+// HDR10 metadata uses, so panels reporting the same EDID values share one entry.  Recently
+// used entries live in an in-memory LRU; optionally a memory-mapped file keeps them across
+// runs and can be shared by several processes.
+//
+// The volumes take a good fraction of a second, so code that must not stall, such as a
+// test pattern, uses TryGet() to have them computed on a worker thread.
+
+// Everything computed for one gamut.  Volumes are on the gamutVolumeLab*/Luv* scale,
+// area and coverages are in CIE 1976 u'v' like ComputeGamutArea/ComputeGamutCoverage.
+struct GamutMetrics
+{
+	float volumeLab;
+	float volumeLuv;
+	float area;
+	float coverage709;			// fraction of each reference gamut covered
+	float coverageAdobe;
+	float coverageDCIP3;
+	float coverage2020;
+	float coverageACES;
+};
+
+struct GamutKey
+{
+	uint16_t xy[8];				// r.x r.y g.x g.y b.x b.y w.x w.y in units of 1/50000
+
+	bool operator==(const GamutKey& k) const { return memcmp(xy, k.xy, sizeof(xy)) == 0; }
+
+	float2 Red()   const { return float2(xy[0], xy[1]) / 50000.0f; }
+	float2 Green() const { return float2(xy[2], xy[3]) / 50000.0f; }
+	float2 Blue()  const { return float2(xy[4], xy[5]) / 50000.0f; }
+	float2 White() const { return float2(xy[6], xy[7]) / 50000.0f; }
+};
+
+// Same truncation as SetMetadata, clamped to what fits in 16 bits.
+inline uint16_t QuantizeChromaticity(float c)
+{
+	float v = c * 50000.0f;
+	if (!(v > 0.0f)) return 0;
+	if (v > 65535.0f) return 65535;
+	return static_cast<uint16_t>(v);
+}
+
+inline GamutKey MakeGamutKey(const float2& r, const float2& g, const float2& b, const float2& w)
+{
+	GamutKey key;
+	key.xy[0] = QuantizeChromaticity(r.x);  key.xy[1] = QuantizeChromaticity(r.y);
+	key.xy[2] = QuantizeChromaticity(g.x);  key.xy[3] = QuantizeChromaticity(g.y);
+	key.xy[4] = QuantizeChromaticity(b.x);  key.xy[5] = QuantizeChromaticity(b.y);
+	key.xy[6] = QuantizeChromaticity(w.x);  key.xy[7] = QuantizeChromaticity(w.y);
+	return key;
+}
+
+struct GamutKeyHash
+{
+	size_t operator()(const GamutKey& k) const
+	{
+		uint64_t h = 14695981039346656037ull;		// FNV-1a
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(k.xy);
+		for (size_t i = 0; i < sizeof(k.xy); i++)
+		{
+			h ^= p[i];
+			h *= 1099511628211ull;
+		}
+		return (size_t)h;
+	}
+};
+
+class GamutCache
+{
+public:
+	// Computes the metrics for an uncached key, e.g. ComputeGamutMetrics in ColorSpaces.h.
+	typedef GamutMetrics(*ComputeFn)(const float2& red_xy, const float2& green_xy, const float2& blue_xy, const float2& white_xy);
+
+	struct Stats
+	{
+		uint64_t hits;				// found in memory
+		uint64_t storeHits;			// found in the mapped file
+		uint64_t misses;			// had to be computed
+	};
+
+	// storePath names the shared file; empty keeps the cache in memory only
+	GamutCache(ComputeFn compute, size_t capacity = 256, const std::filesystem::path& storePath = {}, uint32_t storeSlots = 4096) :
+		m_compute(compute),
+		m_capacity(capacity ? capacity : 1),
+		m_stats{},
+#if defined(_WIN32)
+		m_file(nullptr),
+		m_mapping(nullptr),
+#else
+		m_file(-1),
+#endif
+		m_store(nullptr),
+		m_storeSize(0)
+	{
+		if (!storePath.empty())
+			OpenStore(storePath, storeSlots);
+	}
+
+	~GamutCache()
+	{
+		WaitIdle();
+		CloseStore();
+	}
+
+	GamutCache(const GamutCache&) = delete;
+	GamutCache& operator=(const GamutCache&) = delete;
+
+	// Blocks until the metrics are available
+	GamutMetrics Get(const float2& r, const float2& g, const float2& b, const float2& w)
+	{
+		GamutKey key = MakeGamutKey(r, g, b, w);
+		GamutMetrics metrics;
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (Lookup(key, metrics))
+				return metrics;
+			m_stats.misses++;
+		}
+		return Compute(key);
+	}
+
+	// Never blocks: returns true with the metrics if they are cached, otherwise starts
+	// computing them on a worker thread (once per key) and returns false.
+	bool TryGet(const float2& r, const float2& g, const float2& b, const float2& w, GamutMetrics& metrics)
+	{
+		GamutKey key = MakeGamutKey(r, g, b, w);
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (Lookup(key, metrics))
+			return true;
+
+		m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [](const Pending& p)
+			{ return p.second.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }), m_pending.end());
+		for (auto& p : m_pending)
+			if (p.first == key)
+				return false;
+
+		m_stats.misses++;
+		m_pending.emplace_back(key, std::async(std::launch::async, [this, key] { Compute(key); }));
+		return false;
+	}
+
+	// true while metrics started by TryGet are still being computed
+	bool IsComputing()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (auto& p : m_pending)
+			if (p.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return true;
+		return false;
+	}
+
+	// Waits for everything TryGet started
+	void WaitIdle()
+	{
+		std::vector<Pending> pending;
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			pending.swap(m_pending);
+		}
+		for (auto& p : pending)
+			p.second.wait();
+	}
+
+	Stats GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_stats;
+	}
+
+	bool HasStore() const { return m_store != nullptr; }
+
+	// File name for a store in a shared folder.  It carries the layout version, so a build
+	// with a different GamutMetrics starts its own file rather than finding an unusable one.
+	static std::filesystem::path StoreFileName()
+	{
+		return "GamutCache" + std::to_string(StoreVersion) + ".bin";
+	}
+
+private:
+	// On-disk layout: header followed by an open-addressed table of slots.
+	static const uint32_t StoreMagic = 0x43544D47;		// 'GMTC'
+	static const uint32_t StoreVersion = 3;				// bump when GamutMetrics changes
+
+	struct StoreHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t slotCount;
+		uint32_t reserved;
+	};
+
+	enum SlotState : long
+	{
+		SlotEmpty   = 0,
+		SlotWriting = 1,
+		SlotValid   = 2,
+	};
+
+	struct StoreSlot
+	{
+		volatile long state;		// SlotState, claimed with a compare-exchange
+		GamutKey      key;
+		GamutMetrics  metrics;
+	};
+
+	typedef std::pair<GamutKey, std::future<void>> Pending;
+
+	// m_lock held
+	bool Lookup(const GamutKey& key, GamutMetrics& metrics)
+	{
+		auto it = m_index.find(key);
+		if (it != m_index.end())
+		{
+			m_lru.splice(m_lru.begin(), m_lru, it->second);
+			m_stats.hits++;
+			metrics = it->second->second;
+			return true;
+		}
+		if (FindInStore(key, metrics))
+		{
+			Insert(key, metrics);
+			m_stats.storeHits++;
+			return true;
+		}
+		return false;
+	}
+
+	// Runs without holding the lock; the key, not the caller's floats, is the input so
+	// every process derives the same numbers for a given entry
+	GamutMetrics Compute(const GamutKey& key)
+	{
+		GamutMetrics metrics = m_compute(key.Red(), key.Green(), key.Blue(), key.White());
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_index.find(key) == m_index.end())
+			Insert(key, metrics);
+		AddToStore(key, metrics);
+		return metrics;
+	}
+
+	void Insert(const GamutKey& key, const GamutMetrics& metrics)
+	{
+		m_lru.emplace_front(key, metrics);
+		m_index[key] = m_lru.begin();
+		if (m_lru.size() > m_capacity)
+		{
+			m_index.erase(m_lru.back().first);
+			m_lru.pop_back();
+		}
+	}
+
+	StoreSlot* Slots() const
+	{
+		return reinterpret_cast<StoreSlot*>(reinterpret_cast<StoreHeader*>(m_store) + 1);
+	}
+
+	bool FindInStore(const GamutKey& key, GamutMetrics& metrics) const
+	{
+		if (!m_store) return false;
+		const StoreHeader* header = reinterpret_cast<const StoreHeader*>(m_store);
+		StoreSlot* slots = Slots();
+		uint32_t n = header->slotCount;
+		size_t start = GamutKeyHash()(key) % n;
+		for (uint32_t i = 0; i < n; i++)
+		{
+			StoreSlot& slot = slots[(start + i) % n];
+			long state = LoadState(slot.state);
+			if (state == SlotEmpty)
+				return false;
+			if (state == SlotValid && slot.key == key)
+			{
+				metrics = slot.metrics;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void AddToStore(const GamutKey& key, const GamutMetrics& metrics)
+	{
+		if (!m_store) return;
+		const StoreHeader* header = reinterpret_cast<const StoreHeader*>(m_store);
+		StoreSlot* slots = Slots();
+		uint32_t n = header->slotCount;
+		size_t start = GamutKeyHash()(key) % n;
+		for (uint32_t i = 0; i < n; i++)
+		{
+			StoreSlot& slot = slots[(start + i) % n];
+			if (LoadState(slot.state) != SlotEmpty)
+			{
+				if (slot.key == key) return;			// another process got there first
+				continue;
+			}
+			if (!ClaimSlot(slot.state))
+				continue;
+			slot.key = key;
+			slot.metrics = metrics;
+			PublishSlot(slot.state);
+			return;
+		}
+		// table full: the entry just stays in memory
+	}
+
+	// Slot state is shared with other processes through the mapping
+	static long LoadState(const volatile long& state)
+	{
+#if defined(_WIN32)
+		long s = state;
+		MemoryBarrier();
+		return s;
+#else
+		return __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+#endif
+	}
+
+	static bool ClaimSlot(volatile long& state)
+	{
+#if defined(_WIN32)
+		return InterlockedCompareExchange(&state, SlotWriting, SlotEmpty) == SlotEmpty;
+#else
+		return __sync_bool_compare_and_swap(&state, (long)SlotEmpty, (long)SlotWriting);
+#endif
+	}
+
+	static void PublishSlot(volatile long& state)
+	{
+#if defined(_WIN32)
+		MemoryBarrier();
+		state = SlotValid;
+#else
+		__atomic_store_n(&state, (long)SlotValid, __ATOMIC_RELEASE);
+#endif
+	}
+
+	static bool IsValidHeader(const StoreHeader& header, uint64_t fileSize)
+	{
+		return header.magic == StoreMagic && header.version == StoreVersion && header.slotCount > 0 &&
+			fileSize >= sizeof(StoreHeader) + (uint64_t)header.slotCount * sizeof(StoreSlot);
+	}
+
+	// Only a file this call creates is initialized.  An existing file may be mapped by other
+	// processes, so it is used as is if its header checks out and left alone otherwise, in
+	// which case the cache runs from memory; delete the file to start over.
+	void OpenStore(const std::filesystem::path& path, uint32_t slotCount)
+	{
+		if (slotCount == 0) return;
+		uint64_t size = sizeof(StoreHeader) + (uint64_t)slotCount * sizeof(StoreSlot);
+		StoreHeader onDisk = {};
+
+#if defined(_WIN32)
+		m_file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+		bool created = m_file != INVALID_HANDLE_VALUE;
+		if (!created)
+			m_file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			m_file = nullptr;
+			return;
+		}
+
+		if (!created)
+		{
+			LARGE_INTEGER existing = {};
+			DWORD read = 0;
+			if (!GetFileSizeEx(m_file, &existing) ||
+				!ReadFile(m_file, &onDisk, sizeof(onDisk), &read, nullptr) || read != sizeof(onDisk) ||
+				!IsValidHeader(onDisk, (uint64_t)existing.QuadPart))
+			{
+				CloseStore();
+				return;
+			}
+			size = sizeof(StoreHeader) + (uint64_t)onDisk.slotCount * sizeof(StoreSlot);
+		}
+
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, nullptr);
+		if (m_mapping)
+			m_store = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+#else
+		m_file = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+		bool created = m_file >= 0;
+		if (!created)
+			m_file = open(path.c_str(), O_RDWR);
+		if (m_file < 0)
+			return;
+
+		if (created)
+		{
+			if (ftruncate(m_file, (off_t)size) != 0)
+			{
+				CloseStore();
+				return;
+			}
+		}
+		else
+		{
+			struct stat st;
+			if (fstat(m_file, &st) != 0 ||
+				pread(m_file, &onDisk, sizeof(onDisk), 0) != (ssize_t)sizeof(onDisk) ||
+				!IsValidHeader(onDisk, (uint64_t)st.st_size))
+			{
+				CloseStore();
+				return;
+			}
+			size = sizeof(StoreHeader) + (uint64_t)onDisk.slotCount * sizeof(StoreSlot);
+		}
+
+		void* view = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+		if (view != MAP_FAILED)
+			m_store = view;
+#endif
+		if (!m_store)
+		{
+			CloseStore();
+			return;
+		}
+		m_storeSize = (size_t)size;
+
+		// a new file reads as zeros: every slot empty, the header published last
+		if (created)
+		{
+			StoreHeader* header = reinterpret_cast<StoreHeader*>(m_store);
+			header->version = StoreVersion;
+			header->slotCount = slotCount;
+#if defined(_WIN32)
+			MemoryBarrier();
+#else
+			__sync_synchronize();
+#endif
+			header->magic = StoreMagic;
+		}
+	}
+
+	void CloseStore()
+	{
+#if defined(_WIN32)
+		if (m_store)   UnmapViewOfFile(m_store);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file)    CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		if (m_store)     munmap(m_store, m_storeSize);
+		if (m_file >= 0) close(m_file);
+		m_file = -1;
+#endif
+		m_store = nullptr;
+		m_storeSize = 0;
+	}
+
+	ComputeFn                      m_compute;
+	size_t                         m_capacity;
+	Stats                          m_stats;
+	std::mutex                     m_lock;
+
+	typedef std::list<std::pair<GamutKey, GamutMetrics>> LruList;
+	LruList                                                       m_lru;		// most recent first
+	std::unordered_map<GamutKey, LruList::iterator, GamutKeyHash> m_index;
+
+	std::vector<Pending>           m_pending;		// started by TryGet
+
+#if defined(_WIN32)
+	void*                          m_file;			// HANDLEs
+	void*                          m_mapping;
+#else
+	int                            m_file;
+#endif
+	void*                          m_store;
+	size_t                         m_storeSize;
+};
@@ -0,0 +1,330 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include "ColorSpaces.h"
+#include "SimdMath.h"
+
+// Batch gamut coverage.
+//
+// Computes, for many panel triangles at once, how much of each reference gamut the panel
+// covers and the ratio of their areas, in both CIE 1931 xy and CIE 1976 u'v'.  Panels are
+// stored structure-of-arrays and processed one SIMD vector of panels at a time.
+//
+// Instead of building the clipped polygon like Intersect(Triangle, Triangle), the overlap
+// area comes from Green's theorem: it is the sum of the edge integrals of each triangle's
+// edges clipped (Cyrus-Beck) against the other triangle.  That needs no branches or
+// variable length vertex lists, so it vectorizes directly.  Edges of the panel are clipped
+// against the closed reference triangle and edges of the reference against the open panel
+// triangle, so an edge shared by both is only counted once.  The parallel and on-edge
+// tests use a small tolerance so that holds however the compiler rounds the cross products.
+
+enum GamutReference
+{
+	GamutRef709,
+	GamutRefDCIP3,
+	GamutRef2020,
+	GamutRefAdobe,
+	GamutRefACES,
+	GamutRefCount
+};
+
+enum GamutPlane
+{
+	GamutPlaneXY,			// CIE 1931 xy
+	GamutPlaneUV,			// CIE 1976 u'v', same as ComputeGamutCoverage
+	GamutPlaneCount
+};
+
+struct GamutCoverageBatch
+{
+	// panel primaries in xy, one entry per panel
+	std::vector<float> rx, ry, gx, gy, bx, by;
+
+	// results, [plane][reference][panel]
+	std::vector<float> coverage[GamutPlaneCount][GamutRefCount];		// fraction of the reference inside the panel
+	std::vector<float> areaRatio[GamutPlaneCount][GamutRefCount];		// panel area / reference area
+
+	void AddPanel(const float2& r, const float2& g, const float2& b)
+	{
+		rx.push_back(r.x);  ry.push_back(r.y);
+		gx.push_back(g.x);  gy.push_back(g.y);
+		bx.push_back(b.x);  by.push_back(b.y);
+	}
+
+	size_t Count() const { return rx.size(); }
+};
+
+// xy -> u'v' using the same operations as xytouv() so shared primaries stay bit-identical.
+template <class S>
+inline void GamutXYtoUV(typename S::V& x, typename S::V& y)
+{
+	typedef typename S::V V;
+	V d = S::Add(S::Add(S::Mul(S::Set1(-2.f), x), S::Mul(S::Set1(12.f), y)), S::Set1(3.f));
+	V u = S::Div(S::Mul(S::Set1(4.f), x), d);
+	V v = S::Div(S::Mul(S::Set1(9.f), y), d);
+	x = u;
+	y = v;
+}
+
+// Twice the signed area of triangle abc, positive when counter-clockwise.
+template <class S>
+inline typename S::V GamutArea2(const typename S::V px[3], const typename S::V py[3])
+{
+	return S::Sub(S::Mul(S::Sub(px[1], px[0]), S::Sub(py[2], py[0])),
+				  S::Mul(S::Sub(px[2], px[0]), S::Sub(py[1], py[0])));
+}
+
+// |a|, there is no Abs in SimdMath.
+template <class S>
+inline typename S::V GamutAbs(typename S::V a)
+{
+	return S::Max(a, S::Sub(S::Set1(0.0f), a));
+}
+
+// Relative tolerance of the parallel and on-edge tests.  Exact comparisons against zero
+// are not enough: whether the compiler contracts the cross products into FMAs changes
+// their rounding, and a shared edge then comes out as slightly inside both triangles.
+const float GamutCollinearEpsilon = 1e-5f;
+
+// Edge integral of the part of segment A + tD, t in [0,1], that lies inside the
+// counter-clockwise triangle c.  Returns twice the area contribution.
+template <class S, bool Strict>
+inline typename S::V GamutClippedEdge(typename S::V ax, typename S::V ay, typename S::V dx, typename S::V dy,
+	const typename S::V cx[3], const typename S::V cy[3])
+{
+	typedef typename S::V V;
+	typedef typename S::M M;
+	const V zero = S::Set1(0.0f);
+	const V eps = S::Set1(GamutCollinearEpsilon);
+	const V dlen = S::Add(GamutAbs<S>(dx), GamutAbs<S>(dy));
+
+	V t0 = zero;
+	V t1 = S::Set1(1.0f);
+	for (int i = 0; i < 3; i++)
+	{
+		int j = i == 2 ? 0 : i + 1;
+		V ex = S::Sub(cx[j], cx[i]);
+		V ey = S::Sub(cy[j], cy[i]);
+		V n0 = S::Sub(S::Mul(ex, S::Sub(ay, cy[i])), S::Mul(ey, S::Sub(ax, cx[i])));		// side of A
+		V nd = S::Sub(S::Mul(ex, dy), S::Mul(ey, dx));									// rate along D
+		V r  = S::Div(S::Sub(zero, n0), nd);
+
+		// tolerances scale with the edge lengths (L1, good enough for a threshold)
+		V elen = S::Add(GamutAbs<S>(ex), GamutAbs<S>(ey));
+		M parallel = S::CmpLE(GamutAbs<S>(nd), S::Mul(eps, S::Mul(elen, dlen)));
+		M onEdge   = S::CmpLE(GamutAbs<S>(n0), S::Mul(eps, S::Mul(elen, S::Add(elen, dlen))));
+
+		M entering = S::MaskAndNot(S::CmpGT(nd, zero), parallel);
+		M leaving  = S::MaskAndNot(S::CmpLT(nd, zero), parallel);
+		t0 = S::Select(entering, S::Max(t0, r), t0);
+		t1 = S::Select(leaving,  S::Min(t1, r), t1);
+
+		// parallel to this edge: all in or all out.  Lying on it, the segment is an edge
+		// shared by both triangles.  Running the same way both triangles are on the same
+		// side of it and it is counted once, from the panel (non-strict) side; running
+		// the opposite way the triangles only touch there and neither counts it.
+		M sameDir = S::CmpGT(S::Add(S::Mul(ex, dx), S::Mul(ey, dy)), zero);
+		M outside = S::MaskAndNot(S::CmpLT(n0, zero), onEdge);
+		outside = S::MaskOr(outside, Strict ? onEdge : S::MaskAndNot(onEdge, sameDir));
+		t1 = S::Select(S::MaskAnd(parallel, outside), S::Set1(-1.0f), t1);
+	}
+
+	V len = S::Max(S::Sub(t1, t0), zero);
+	return S::Mul(len, S::Sub(S::Mul(ax, dy), S::Mul(ay, dx)));		// (t1-t0) * cross(A, D)
+}
+
+// Twice the overlap area of counter-clockwise triangles p and q.
+template <class S>
+inline typename S::V GamutOverlap2(const typename S::V px[3], const typename S::V py[3],
+	const typename S::V qx[3], const typename S::V qy[3])
+{
+	typedef typename S::V V;
+	V sum = S::Set1(0.0f);
+	for (int i = 0; i < 3; i++)
+	{
+		int j = i == 2 ? 0 : i + 1;
+		sum = S::Add(sum, GamutClippedEdge<S, false>(px[i], py[i], S::Sub(px[j], px[i]), S::Sub(py[j], py[i]), qx, qy));
+		sum = S::Add(sum, GamutClippedEdge<S, true >(qx[i], qy[i], S::Sub(qx[j], qx[i]), S::Sub(qy[j], qy[i]), px, py));
+	}
+	return sum;
+}
+
+// Reference triangles, counter-clockwise and centered on their centroid to keep the
+// cross products well conditioned.
+struct GamutReferenceTriangle
+{
+	float x[3], y[3];
+	float cx, cy;			// centroid that was subtracted
+	float area2;			// twice the area
+};
+
+inline void GamutMakeReferences(GamutReferenceTriangle refs[GamutPlaneCount][GamutRefCount])
+{
+	const float2 prims[GamutRefCount][3] =
+	{
+		{ primaryR_709,   primaryG_709,   primaryB_709   },
+		{ primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3 },
+		{ primaryR_2020,  primaryG_2020,  primaryB_2020  },
+		{ primaryR_Adobe, primaryG_Adobe, primaryB_Adobe },
+		{ primaryR_ACES,  primaryG_ACES,  primaryB_ACES  },
+	};
+
+	for (int plane = 0; plane < GamutPlaneCount; plane++)
+	{
+		for (int ref = 0; ref < GamutRefCount; ref++)
+		{
+			GamutReferenceTriangle& t = refs[plane][ref];
+			for (int k = 0; k < 3; k++)
+			{
+				float x = prims[ref][k].x, y = prims[ref][k].y;
+				if (plane == GamutPlaneUV) GamutXYtoUV<SimdScalar>(x, y);
+				t.x[k] = x;
+				t.y[k] = y;
+			}
+			if (GamutArea2<SimdScalar>(t.x, t.y) < 0.0f)
+			{
+				std::swap(t.x[1], t.x[2]);
+				std::swap(t.y[1], t.y[2]);
+			}
+			t.cx = (t.x[0] + t.x[1] + t.x[2]) / 3.0f;
+			t.cy = (t.y[0] + t.y[1] + t.y[2]) / 3.0f;
+			for (int k = 0; k < 3; k++)
+			{
+				t.x[k] -= t.cx;
+				t.y[k] -= t.cy;
+			}
+			t.area2 = GamutArea2<SimdScalar>(t.x, t.y);
+		}
+	}
+}
+
+// Processes panels [i, i + Width) reading from the given arrays.
+template <class S>
+inline void GamutCoverageKernel(const float* const in[6], float* const out[2][GamutPlaneCount][GamutRefCount],
+	const GamutReferenceTriangle refs[GamutPlaneCount][GamutRefCount])
+{
+	typedef typename S::V V;
+
+	for (int plane = 0; plane < GamutPlaneCount; plane++)
+	{
+		V x[3], y[3];
+		for (int k = 0; k < 3; k++)
+		{
+			x[k] = S::Load(in[2 * k]);
+			y[k] = S::Load(in[2 * k + 1]);
+			if (plane == GamutPlaneUV) GamutXYtoUV<S>(x[k], y[k]);
+		}
+
+		// make every panel counter-clockwise
+		typename S::M cw = S::CmpLT(GamutArea2<S>(x, y), S::Set1(0.0f));
+		V tx = x[1], ty = y[1];
+		x[1] = S::Select(cw, x[2], x[1]);  y[1] = S::Select(cw, y[2], y[1]);
+		x[2] = S::Select(cw, tx, x[2]);    y[2] = S::Select(cw, ty, y[2]);
+
+		for (int ref = 0; ref < GamutRefCount; ref++)
+		{
+			const GamutReferenceTriangle& t = refs[plane][ref];
+			V px[3], py[3], qx[3], qy[3];
+			for (int k = 0; k < 3; k++)
+			{
+				px[k] = S::Sub(x[k], S::Set1(t.cx));
+				py[k] = S::Sub(y[k], S::Set1(t.cy));
+				qx[k] = S::Set1(t.x[k]);
+				qy[k] = S::Set1(t.y[k]);
+			}
+
+			V invRef = S::Set1(1.0f / t.area2);
+			V coverage = S::Mul(GamutOverlap2<S>(px, py, qx, qy), invRef);
+			S::Store(out[0][plane][ref], S::Min(S::Max(coverage, S::Set1(0.0f)), S::Set1(1.0f)));
+			S::Store(out[1][plane][ref], S::Mul(GamutArea2<S>(px, py), invRef));
+		}
+	}
+}
+
+template <class S>
+inline void GamutCoverageBatchT(GamutCoverageBatch& batch, const GamutReferenceTriangle refs[GamutPlaneCount][GamutRefCount])
+{
+	const size_t n = batch.Count();
+	const std::vector<float>* inputs[6] = { &batch.rx, &batch.ry, &batch.gx, &batch.gy, &batch.bx, &batch.by };
+
+	const float* in[6];
+	float* out[2][GamutPlaneCount][GamutRefCount];
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		for (int k = 0; k < 6; k++)
+			in[k] = inputs[k]->data() + i;
+		for (int plane = 0; plane < GamutPlaneCount; plane++)
+		{
+			for (int ref = 0; ref < GamutRefCount; ref++)
+			{
+				out[0][plane][ref] = batch.coverage[plane][ref].data() + i;
+				out[1][plane][ref] = batch.areaRatio[plane][ref].data() + i;
+			}
+		}
+		GamutCoverageKernel<S>(in, out, refs);
+	}
+
+	if (i < n)				// last partial vector: pad by repeating the final panel
+	{
+		float pad[6][S::Width];
+		float result[2][GamutPlaneCount][GamutRefCount][S::Width];
+		for (int k = 0; k < 6; k++)
+		{
+			for (int j = 0; j < S::Width; j++)
+				pad[k][j] = (*inputs[k])[i + j < n ? i + j : n - 1];
+			in[k] = pad[k];
+		}
+		for (int r = 0; r < 2; r++)
+			for (int plane = 0; plane < GamutPlaneCount; plane++)
+				for (int ref = 0; ref < GamutRefCount; ref++)
+					out[r][plane][ref] = result[r][plane][ref];
+
+		GamutCoverageKernel<S>(in, out, refs);
+
+		for (int plane = 0; plane < GamutPlaneCount; plane++)
+		{
+			for (int ref = 0; ref < GamutRefCount; ref++)
+			{
+				for (size_t j = 0; i + j < n; j++)
+				{
+					batch.coverage[plane][ref][i + j]  = result[0][plane][ref][j];
+					batch.areaRatio[plane][ref][i + j] = result[1][plane][ref][j];
+				}
+			}
+		}
+	}
+}
+
+// Fills in batch.coverage and batch.areaRatio for every panel in the batch.
+inline void ComputeGamutCoverageBatch(GamutCoverageBatch& batch)
+{
+	static GamutReferenceTriangle refs[GamutPlaneCount][GamutRefCount];
+	static std::once_flag refsInit;
+	std::call_once(refsInit, [] { GamutMakeReferences(refs); });
+
+	const size_t n = batch.Count();
+	for (int plane = 0; plane < GamutPlaneCount; plane++)
+	{
+		for (int ref = 0; ref < GamutRefCount; ref++)
+		{
+			batch.coverage[plane][ref].resize(n);
+			batch.areaRatio[plane][ref].resize(n);
+		}
+	}
+
+	SimdDispatch([&](auto s) { GamutCoverageBatchT<decltype(s)>(batch, refs); });
+}
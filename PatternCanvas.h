@@ -0,0 +1,132 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+// The drawing surface the test patterns render to.
+//
+// This is the subset of ID2D1DeviceContext the patterns actually use, with brushes replaced
+// by plain scRGB colors (1.0 = 80 nits), text by a font id, and effects and images by ids the
+// backend resolves.  D2DPatternCanvas draws on the swap chain; SoftwarePatternCanvas rasterizes
+// into an FP16 buffer on the CPU, so patterns can be generated and checked without a GPU.
+// Coordinates are DIPs, as in D2D.
+
+#if defined(_WIN32)
+#include <d2d1_1.h>
+#else
+// The D2D value types the canvas uses, layout-identical, so headless builds do not need the SDK
+struct D2D1_POINT_2F      { float x, y; };
+struct D2D1_RECT_F        { float left, top, right, bottom; };
+struct D2D1_COLOR_F       { float r, g, b, a; };
+struct D2D1_ELLIPSE       { D2D1_POINT_2F point; float radiusX, radiusY; };
+struct D2D1_GRADIENT_STOP { float position; D2D1_COLOR_F color; };
+
+namespace D2D1
+{
+	inline D2D1_POINT_2F Point2F(float x = 0.0f, float y = 0.0f) { return { x, y }; }
+	inline D2D1_RECT_F RectF(float left = 0.0f, float top = 0.0f, float right = 0.0f, float bottom = 0.0f) { return { left, top, right, bottom }; }
+
+	class ColorF : public D2D1_COLOR_F
+	{
+	public:
+		enum Enum { Black = 0x000000, Blue = 0x0000FF, Green = 0x008000, Red = 0xFF0000, White = 0xFFFFFF };
+
+		ColorF(uint32_t rgb, float alpha = 1.0f)
+		{
+			r = ((rgb >> 16) & 0xFF) / 255.0f;
+			g = ((rgb >>  8) & 0xFF) / 255.0f;
+			b = ( rgb        & 0xFF) / 255.0f;
+			a = alpha;
+		}
+		ColorF(Enum knownColor, float alpha = 1.0f) : ColorF((uint32_t)knownColor, alpha) {}
+		ColorF(float red, float green, float blue, float alpha = 1.0f) { r = red; g = green; b = blue; a = alpha; }
+	};
+}
+#endif
+
+enum CanvasFont
+{
+	CanvasFontSmall,		// Segoe UI 14
+	CanvasFontLarge,		// Segoe UI 24
+	CanvasFontMonospace,	// Consolas 18
+	CanvasFontSubtitle,		// Segoe UI 64
+	CanvasFontCount
+};
+
+// The custom pixel-shader effects; values are set by the names the shaders declare
+enum CanvasEffect
+{
+	CanvasEffectNone = -1,
+	CanvasEffectBackgroundNoise,
+	CanvasEffectBandedGradient,
+	CanvasEffectSineSweep,
+	CanvasEffectToneSpike,
+	CanvasEffectCount
+};
+
+// Images are registered with the backend under an id of the caller's choosing
+typedef uint32_t CanvasImage;
+
+class PatternCanvas
+{
+public:
+	virtual ~PatternCanvas() {}
+
+	// target size in DIPs and in pixels, and DIPs per inch
+	virtual D2D1_RECT_F GetLogicalSize() const = 0;
+	virtual D2D1_RECT_F GetOutputSize() const = 0;
+	virtual float       GetDpi() const = 0;
+
+	virtual void Clear(const D2D1_COLOR_F& color) = 0;
+	virtual void FillRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) = 0;
+	virtual void DrawRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth = 1.0f) = 0;
+	virtual void FillEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color) = 0;
+	virtual void DrawEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color, float strokeWidth = 1.0f) = 0;
+	virtual void DrawLine(D2D1_POINT_2F p0, D2D1_POINT_2F p1, const D2D1_COLOR_F& color, float strokeWidth = 1.0f) = 0;
+
+	// Many filled ellipses, a color each, in order.  A nonzero batch names content that never
+	// changes, so a backend may build it once and draw it whole every time the batch comes back.
+	virtual void FillEllipses(uint64_t, const D2D1_ELLIPSE* ellipses, const D2D1_COLOR_F* colors, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			FillEllipse(ellipses[i], colors[i]);
+	}
+
+	// Linear gradient clamped at the ends.  Stops are interpolated as given (sRGB encoded) and
+	// the result converted to linear scRGB, like a D2D stop collection from sRGB to scRGB.
+	virtual void FillLinearGradient(const D2D1_RECT_F& rect, D2D1_POINT_2F start, D2D1_POINT_2F end,
+		const D2D1_GRADIENT_STOP* stops, uint32_t stopCount) = 0;
+
+	// textBox is { left, top, width, height }, as in PatternGenerator::RenderText
+	virtual void DrawString(CanvasFont font, const std::wstring& text, const D2D1_RECT_F& textBox, const D2D1_COLOR_F& color) = 0;
+
+	// An effect covers the whole target; its values stay set until changed
+	virtual void SetEffectValue(CanvasEffect effect, const wchar_t* name, float value) = 0;
+	virtual void SetEffectValue(CanvasEffect effect, const wchar_t* name, D2D1_POINT_2F value) = 0;
+	virtual void DrawEffect(CanvasEffect effect) = 0;
+
+	virtual void DrawImage(CanvasImage image, D2D1_POINT_2F offset) = 0;
+
+	// The part of a pattern that changes every frame, such as a jittered patch or a running
+	// countdown.  A canvas draws it at once; a recording keeps draw and calls it again on each
+	// replay, so the rest of the pattern is recorded once with this drawn in place, in order.
+	virtual void DrawLive(const std::function<void(PatternCanvas*)>& draw) { draw(this); }
+
+	// ID2D1RenderTarget-style pointer overloads, so call sites read like the D2D calls
+	void FillRectangle(const D2D1_RECT_F* rect, const D2D1_COLOR_F& color)                    { FillRectangle(*rect, color); }
+	void DrawRectangle(const D2D1_RECT_F* rect, const D2D1_COLOR_F& color, float width = 1.0f) { DrawRectangle(*rect, color, width); }
+	void FillEllipse(const D2D1_ELLIPSE* ellipse, const D2D1_COLOR_F& color)                   { FillEllipse(*ellipse, color); }
+	void DrawEllipse(const D2D1_ELLIPSE* ellipse, const D2D1_COLOR_F& color, float width = 1.0f) { DrawEllipse(*ellipse, color, width); }
+};
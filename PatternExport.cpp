@@ -0,0 +1,977 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Renders the test patterns offscreen and writes them out as a golden image set.
+//
+//   PatternExport [--out dir] [--format exr|png] [--size 1920x1080] [--threads 0]
+//                 [--patterns 6,19-22] [--tiers 400,1000]
+//
+// A job is one test pattern at one testing tier and, for the tests that use it, one of the
+// white-level brackets; it renders every subtest ChangeSubtest steps through.  Three stages
+// run at once, joined by bounded queues: render workers, each with its own PatternGenerator
+// and SoftwarePatternCanvas; encode workers, which hash every frame and encode only content not
+// seen before; and a writer thread.  Files are named by content hash, so the many frames that
+// do not change with the tier are encoded and written once, and manifest.json maps every
+// pattern/tier/bracket/subtest to its file.
+//
+// EXR is uncompressed FP16 scRGB (1.0 = 80 nits), the swap chain's format.  PNG is 16-bit
+// Rec.2100 PQ, the HDR10 signal.  Frames are at t = 0 with calibration values at their
+// defaults.  Text is drawn in the software canvas's bitmap font, so it is legible but does
+// not match the app's glyphs.
+
+// No precompiled header and nothing from the Windows SDK beyond what PipelineStream.h uses
+// for file I/O, so this builds wherever PatternGenerator.cpp does.
+#include "PatternGenerator.h"
+#include "SoftwarePatternCanvas.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const wchar_t* g_exportTitle = L"PatternExport";
+
+enum ExportFormat
+{
+	ExportEXR,
+	ExportPNG,
+};
+
+struct ExportJob
+{
+	PatternGenerator::TestPattern   pattern;
+	PatternGenerator::TestingTier   tier;
+	int                             bracket;		// -1: the test does not use the white level
+};
+
+// One rendered frame, on its way from a render worker to the writer
+struct ExportFrame
+{
+	const ExportJob*        job;
+	int                     subtest;
+	uint32_t                whiteLevel;		// nits, 0 if the test does not use it
+	std::vector<uint16_t>   pixels;			// FP16 RGBA
+	std::vector<uint8_t>    encoded;		// empty if this content is already on its way to disk
+	uint64_t                hash;
+};
+
+struct ExportRecord
+{
+	int         pattern;
+	int         tier;
+	int         bracket;
+	int         subtest;
+	uint32_t    whiteLevel;
+	uint64_t    hash;
+
+	bool operator<(const ExportRecord& r) const
+	{
+		if (pattern != r.pattern) return pattern < r.pattern;
+		if (tier != r.tier)       return tier < r.tier;
+		if (bracket != r.bracket) return bracket < r.bracket;
+		return subtest < r.subtest;
+	}
+};
+
+// FNV-1a a pixel at a time; far cheaper than encoding the frame it saves
+static uint64_t Export_Hash(const std::vector<uint16_t>& pixels)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const uint16_t* p = pixels.data();
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		uint64_t pixel;
+		memcpy(&pixel, p + i, sizeof(pixel));
+		hash = (hash ^ pixel) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static std::string Export_FileName(uint64_t hash, ExportFormat format)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.%s", (unsigned long long)hash, format == ExportEXR ? "exr" : "png");
+	return name;
+}
+
+static std::string Export_TierName(PatternGenerator::TestingTier tier)
+{
+	std::string name;
+	for (const wchar_t* c = PatternGenerator::GetTierName(tier); *c; c++)
+		name += (char)*c;
+	return name;
+}
+
+static void Export_Put(uint8_t*& out, const void* data, size_t bytes)
+{
+	memcpy(out, data, bytes);
+	out += bytes;
+}
+
+static void Export_Attribute(std::vector<uint8_t>& header, const char* name, const char* type, const void* value, int32_t size)
+{
+	header.insert(header.end(), name, name + strlen(name) + 1);
+	header.insert(header.end(), type, type + strlen(type) + 1);
+	header.insert(header.end(), (const uint8_t*)&size, (const uint8_t*)&size + sizeof(size));
+	header.insert(header.end(), (const uint8_t*)value, (const uint8_t*)value + size);
+}
+
+// Single-part scanline OpenEXR, uncompressed HALF channels, one scan line per chunk
+static void Export_EncodeEXR(const std::vector<uint16_t>& pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& out)
+{
+	std::vector<uint8_t> header;
+	const uint32_t magic = 20000630, version = 2;
+	header.insert(header.end(), (const uint8_t*)&magic, (const uint8_t*)&magic + 4);
+	header.insert(header.end(), (const uint8_t*)&version, (const uint8_t*)&version + 4);
+
+	// channels must be listed, and stored, in name order
+	std::vector<uint8_t> channels;
+	for (const char* name : { "A", "B", "G", "R" })
+	{
+		const int32_t pixelType = 1, sampling = 1;			// HALF, every pixel
+		const uint8_t linear[4] = {};
+		channels.push_back((uint8_t)name[0]);
+		channels.push_back(0);
+		channels.insert(channels.end(), (const uint8_t*)&pixelType, (const uint8_t*)&pixelType + 4);
+		channels.insert(channels.end(), linear, linear + 4);
+		channels.insert(channels.end(), (const uint8_t*)&sampling, (const uint8_t*)&sampling + 4);
+		channels.insert(channels.end(), (const uint8_t*)&sampling, (const uint8_t*)&sampling + 4);
+	}
+	channels.push_back(0);
+
+	const uint8_t noCompression = 0, increasingY = 0;
+	const int32_t window[4] = { 0, 0, (int32_t)width - 1, (int32_t)height - 1 };
+	const float one = 1.0f, center[2] = {}, nitsPerUnit = 80.0f;
+	const float chromaticities[8] =							// scRGB: Rec.709 primaries, D65
+	{
+		0.640f, 0.330f, 0.300f, 0.600f, 0.150f, 0.060f, 0.3127f, 0.3290f
+	};
+	Export_Attribute(header, "channels", "chlist", channels.data(), (int32_t)channels.size());
+	Export_Attribute(header, "compression", "compression", &noCompression, 1);
+	Export_Attribute(header, "dataWindow", "box2i", window, sizeof(window));
+	Export_Attribute(header, "displayWindow", "box2i", window, sizeof(window));
+	Export_Attribute(header, "lineOrder", "lineOrder", &increasingY, 1);
+	Export_Attribute(header, "pixelAspectRatio", "float", &one, 4);
+	Export_Attribute(header, "screenWindowCenter", "v2f", center, sizeof(center));
+	Export_Attribute(header, "screenWindowWidth", "float", &one, 4);
+	Export_Attribute(header, "chromaticities", "chromaticities", chromaticities, sizeof(chromaticities));
+	Export_Attribute(header, "whiteLuminance", "float", &nitsPerUnit, 4);
+	header.push_back(0);
+
+	// header, offset table, then per line: y, byte count, and the A, B, G, R rows
+	int32_t lineBytes = (int32_t)width * 4 * 2;
+	uint64_t chunkBytes = 8 + (uint64_t)lineBytes;
+	uint64_t firstChunk = header.size() + 8ull * height;
+	out.resize(firstChunk + chunkBytes * height);
+
+	uint8_t* p = out.data();
+	Export_Put(p, header.data(), header.size());
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint64_t offset = firstChunk + chunkBytes * y;
+		Export_Put(p, &offset, 8);
+	}
+	for (uint32_t y = 0; y < height; y++)
+	{
+		int32_t line = (int32_t)y;
+		Export_Put(p, &line, 4);
+		Export_Put(p, &lineBytes, 4);
+		const uint16_t* row = &pixels[(size_t)y * width * 4];
+		for (int c = 3; c >= 0; c--)
+		{
+			uint16_t* dst = reinterpret_cast<uint16_t*>(p);
+			for (uint32_t x = 0; x < width; x++)
+				dst[x] = row[x * 4 + c];
+			p += width * 2;
+		}
+	}
+}
+
+// SMPTE ST 2084, L in units of 10000 nits
+static float Export_Apply2084(float L)
+{
+	const float m1 = 2610.0f / 4096.0f / 4;
+	const float m2 = 2523.0f / 4096.0f * 128;
+	const float c1 = 3424.0f / 4096.0f;
+	const float c2 = 2413.0f / 4096.0f * 32;
+	const float c3 = 2392.0f / 4096.0f * 32;
+	float Lp = powf(std::min(std::max(L, 0.0f), 1.0f), m1);
+	return powf((c1 + c2 * Lp) / (1 + c3 * Lp), m2);
+}
+
+static uint16_t Export_PQCode(float nits)
+{
+	return (uint16_t)(Export_Apply2084(nits / 10000.0f) * 65535.0f + 0.5f);
+}
+
+// CRC-32 of PNG chunks (ISO 3309), continuing from crc
+static uint32_t Export_CRC32(uint32_t crc, const uint8_t* data, size_t bytes)
+{
+	static const std::array<uint32_t, 256> table = []
+	{
+		std::array<uint32_t, 256> t;
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < bytes; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+// Adler-32 of a zlib stream's data, continuing from adler
+static uint32_t Export_Adler32(uint32_t adler, const uint8_t* data, size_t bytes)
+{
+	uint32_t a = adler & 0xffff, b = adler >> 16;
+	while (bytes)
+	{
+		size_t run = std::min(bytes, (size_t)5552);		// the most that cannot overflow b
+		for (size_t i = 0; i < run; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		data += run;
+		bytes -= run;
+	}
+	return (b << 16) | a;
+}
+
+static void Export_PutBE32(std::vector<uint8_t>& out, uint32_t v)
+{
+	const uint8_t bytes[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+	out.insert(out.end(), bytes, bytes + 4);
+}
+
+static uint32_t Export_GetBE32(const uint8_t* p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static void Export_PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t bytes)
+{
+	Export_PutBE32(out, (uint32_t)bytes);
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data, data + bytes);
+	Export_PutBE32(out, Export_CRC32(0, &out[start], bytes + 4));
+}
+
+// 16-bit RGB PNG of the HDR10 signal: scRGB to Rec.2020 nits, then PQ.  The zlib stream uses
+// stored (uncompressed) deflate blocks only: the files are larger than a compressing encoder
+// would write, but identical content is still written once, see Export_Hash.
+static void Export_EncodePNG(const std::vector<uint16_t>& pixels, uint32_t width, uint32_t height,
+	std::vector<uint8_t>& scratch, std::vector<uint8_t>& out)
+{
+	// Scan lines of filter type 0 (none) and big-endian samples
+	size_t rowBytes = 1 + (size_t)width * 6;
+	scratch.resize(rowBytes * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* row = &scratch[rowBytes * y];
+		const uint16_t* src = &pixels[(size_t)y * width * 4];
+		*row++ = 0;
+		for (uint32_t x = 0; x < width; x++, src += 4)
+		{
+			float r = HalfToFloat(src[0]) * 80.0f;
+			float g = HalfToFloat(src[1]) * 80.0f;
+			float b = HalfToFloat(src[2]) * 80.0f;
+			const uint16_t codes[3] =
+			{
+				Export_PQCode(0.627404f * r + 0.329283f * g + 0.043313f * b),
+				Export_PQCode(0.069097f * r + 0.919540f * g + 0.011362f * b),
+				Export_PQCode(0.016391f * r + 0.088013f * g + 0.895595f * b),
+			};
+			for (uint16_t code : codes)
+			{
+				*row++ = (uint8_t)(code >> 8);
+				*row++ = (uint8_t)code;
+			}
+		}
+	}
+
+	// zlib header (deflate, 32K window, no dictionary), stored blocks, Adler-32
+	const size_t blockBytes = 65535;
+	size_t blocks = std::max((scratch.size() + blockBytes - 1) / blockBytes, (size_t)1);
+	std::vector<uint8_t> zlib;
+	zlib.reserve(2 + blocks * 5 + scratch.size() + 4);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	for (size_t i = 0; i < blocks; i++)
+	{
+		size_t offset = i * blockBytes;
+		uint16_t len = (uint16_t)std::min(scratch.size() - offset, blockBytes);
+		const uint8_t header[5] = { (uint8_t)(i + 1 == blocks), (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)~len, (uint8_t)(~len >> 8) };
+		zlib.insert(zlib.end(), header, header + 5);
+		zlib.insert(zlib.end(), scratch.begin() + offset, scratch.begin() + offset + len);
+	}
+	Export_PutBE32(zlib, Export_Adler32(1, scratch.data(), scratch.size()));
+
+	std::vector<uint8_t> ihdr;
+	Export_PutBE32(ihdr, width);
+	Export_PutBE32(ihdr, height);
+	const uint8_t format[5] = { 16, 2, 0, 0, 0 };		// 16 bits, RGB, deflate, adaptive filters, not interlaced
+	ihdr.insert(ihdr.end(), format, format + 5);
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	out.assign(signature, signature + 8);
+	Export_PutChunk(out, "IHDR", ihdr.data(), ihdr.size());
+	Export_PutChunk(out, "IDAT", zlib.data(), zlib.size());
+	Export_PutChunk(out, "IEND", nullptr, 0);
+}
+
+// Bit reader and canonical Huffman decoding for Export_Inflate, after zlib's puff.c
+struct ExportBits
+{
+	const uint8_t*  data;
+	size_t          size;
+	size_t          pos;
+	uint32_t        buffer;
+	int             count;
+
+	uint32_t Get(int bits)
+	{
+		uint32_t value = buffer;
+		while (count < bits)
+		{
+			if (pos == size)
+				throw std::runtime_error("truncated PNG image data");
+			value |= (uint32_t)data[pos++] << count;
+			count += 8;
+		}
+		buffer = value >> bits;
+		count -= bits;
+		return value & ((1u << bits) - 1);
+	}
+};
+
+struct ExportHuffman
+{
+	uint16_t    counts[16];		// codes of each length
+	uint16_t    symbols[288];	// in canonical order
+};
+
+static void Export_BuildHuffman(ExportHuffman& h, const uint8_t* lengths, int n)
+{
+	memset(h.counts, 0, sizeof(h.counts));
+	for (int i = 0; i < n; i++)
+		h.counts[lengths[i]]++;
+
+	int left = 1;
+	for (int len = 1; len < 16; len++)
+	{
+		left = left * 2 - h.counts[len];
+		if (left < 0)
+			throw std::runtime_error("bad Huffman code in PNG image data");
+	}
+
+	uint16_t offsets[16];
+	offsets[1] = 0;
+	for (int len = 1; len < 15; len++)
+		offsets[len + 1] = offsets[len] + h.counts[len];
+	for (int i = 0; i < n; i++)
+		if (lengths[i])
+			h.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+}
+
+static int Export_DecodeSymbol(ExportBits& bits, const ExportHuffman& h)
+{
+	int code = 0, first = 0, index = 0;
+	for (int len = 1; len < 16; len++)
+	{
+		code |= (int)bits.Get(1);
+		int count = h.counts[len];
+		if (code - count < first)
+			return h.symbols[index + (code - first)];
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+	throw std::runtime_error("bad Huffman code in PNG image data");
+}
+
+// Decompresses a zlib stream (RFC 1950/1951) and checks its Adler-32
+static void Export_Inflate(const std::vector<uint8_t>& in, std::vector<uint8_t>& out)
+{
+	static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const uint8_t  lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const uint8_t  distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	static const uint8_t  lengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	if (in.size() < 6 || (in[0] & 0x0f) != 8 || ((in[0] << 8) | in[1]) % 31 != 0 || (in[1] & 0x20))
+		throw std::runtime_error("bad zlib header in PNG image data");
+
+	ExportBits bits = { in.data(), in.size() - 4, 2, 0, 0 };
+	for (bool last = false; !last; )
+	{
+		last = bits.Get(1) != 0;
+		uint32_t type = bits.Get(2);
+		if (type == 0)
+		{
+			// stored: byte aligned LEN, NLEN, then the bytes
+			bits.buffer = 0;
+			bits.count = 0;
+			if (bits.pos + 4 > bits.size)
+				throw std::runtime_error("truncated PNG image data");
+			uint32_t len = bits.data[bits.pos] | bits.data[bits.pos + 1] << 8;
+			uint32_t nlen = bits.data[bits.pos + 2] | bits.data[bits.pos + 3] << 8;
+			bits.pos += 4;
+			if (len != (~nlen & 0xffff) || bits.pos + len > bits.size)
+				throw std::runtime_error("bad stored block in PNG image data");
+			out.insert(out.end(), bits.data + bits.pos, bits.data + bits.pos + len);
+			bits.pos += len;
+			continue;
+		}
+
+		ExportHuffman lengthCodes, distCodes;
+		uint8_t lengths[320];
+		if (type == 1)
+		{
+			// fixed codes
+			int i = 0;
+			for (; i < 144; i++) lengths[i] = 8;
+			for (; i < 256; i++) lengths[i] = 9;
+			for (; i < 280; i++) lengths[i] = 7;
+			for (; i < 288; i++) lengths[i] = 8;
+			Export_BuildHuffman(lengthCodes, lengths, 288);
+			for (i = 0; i < 30; i++) lengths[i] = 5;
+			Export_BuildHuffman(distCodes, lengths, 30);
+		}
+		else if (type == 2)
+		{
+			// dynamic codes, themselves Huffman coded
+			int nlen = (int)bits.Get(5) + 257, ndist = (int)bits.Get(5) + 1, ncode = (int)bits.Get(4) + 4;
+			if (nlen > 286 || ndist > 30)
+				throw std::runtime_error("bad code counts in PNG image data");
+			memset(lengths, 0, sizeof(lengths));
+			for (int i = 0; i < ncode; i++)
+				lengths[lengthOrder[i]] = (uint8_t)bits.Get(3);
+			ExportHuffman codeCodes;
+			Export_BuildHuffman(codeCodes, lengths, 19);
+
+			for (int i = 0; i < nlen + ndist; )
+			{
+				int symbol = Export_DecodeSymbol(bits, codeCodes);
+				if (symbol < 16)
+				{
+					lengths[i++] = (uint8_t)symbol;
+					continue;
+				}
+				uint8_t length = 0;
+				int repeat;
+				if (symbol == 16)
+				{
+					if (i == 0)
+						throw std::runtime_error("bad code lengths in PNG image data");
+					length = lengths[i - 1];
+					repeat = 3 + (int)bits.Get(2);
+				}
+				else if (symbol == 17)
+					repeat = 3 + (int)bits.Get(3);
+				else
+					repeat = 11 + (int)bits.Get(7);
+				if (i + repeat > nlen + ndist)
+					throw std::runtime_error("bad code lengths in PNG image data");
+				while (repeat--)
+					lengths[i++] = length;
+			}
+			Export_BuildHuffman(lengthCodes, lengths, nlen);
+			Export_BuildHuffman(distCodes, lengths + nlen, ndist);
+		}
+		else
+			throw std::runtime_error("bad block type in PNG image data");
+
+		for (;;)
+		{
+			int symbol = Export_DecodeSymbol(bits, lengthCodes);
+			if (symbol < 256)
+				out.push_back((uint8_t)symbol);
+			else if (symbol == 256)
+				break;
+			else
+			{
+				symbol -= 257;
+				if (symbol >= 29)
+					throw std::runtime_error("bad length in PNG image data");
+				size_t length = lengthBase[symbol] + bits.Get(lengthExtra[symbol]);
+				int dist = Export_DecodeSymbol(bits, distCodes);
+				if (dist >= 30)
+					throw std::runtime_error("bad distance in PNG image data");
+				size_t distance = distBase[dist] + bits.Get(distExtra[dist]);
+				if (distance > out.size())
+					throw std::runtime_error("bad distance in PNG image data");
+				size_t from = out.size() - distance;
+				for (size_t i = 0; i < length; i++)			// may overlap what it writes
+					out.push_back(out[from + i]);
+			}
+		}
+	}
+
+	if (Export_GetBE32(&in[in.size() - 4]) != Export_Adler32(1, out.data(), out.size()))
+		throw std::runtime_error("bad checksum in PNG image data");
+}
+
+static uint8_t Export_Paeth(int a, int b, int c)
+{
+	int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// The test's image as straight-alpha scRGB RGBA, as the app gets it from WIC: samples are
+// taken as sRGB coded and color profiles are ignored.  Non-interlaced PNG of any color type
+// and bit depth.  Returns false if the file is missing; throws if it is not such a PNG.
+static bool Export_LoadImage(const std::filesystem::path& path, uint32_t& width, uint32_t& height, std::vector<float>& rgba)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	if (data.size() < 8 || memcmp(data.data(), signature, 8) != 0)
+		throw std::runtime_error(path.string() + " is not a PNG file");
+
+	uint8_t bitDepth = 0, colorType = 0, interlace = 0;
+	std::vector<uint8_t> idat, palette, transparency;
+	width = height = 0;
+	for (size_t pos = 8; ; )
+	{
+		if (pos + 12 > data.size())
+			throw std::runtime_error(path.string() + " is truncated");
+		uint32_t length = Export_GetBE32(&data[pos]);
+		const uint8_t* type = &data[pos + 4];
+		const uint8_t* chunk = &data[pos + 8];
+		if (length > data.size() - pos - 12)
+			throw std::runtime_error(path.string() + " is truncated");
+		if (Export_GetBE32(chunk + length) != Export_CRC32(0, type, length + 4))
+			throw std::runtime_error(path.string() + " has a bad chunk checksum");
+		pos += 12 + length;
+
+		if (!memcmp(type, "IHDR", 4) && length == 13)
+		{
+			width = Export_GetBE32(chunk);
+			height = Export_GetBE32(chunk + 4);
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			interlace = chunk[12];
+		}
+		else if (!memcmp(type, "PLTE", 4))
+			palette.assign(chunk, chunk + length);
+		else if (!memcmp(type, "tRNS", 4))
+			transparency.assign(chunk, chunk + length);
+		else if (!memcmp(type, "IDAT", 4))
+			idat.insert(idat.end(), chunk, chunk + length);
+		else if (!memcmp(type, "IEND", 4))
+			break;
+	}
+
+	static const int channelCounts[7] = { 1, 0, 3, 1, 2, 0, 4 };
+	int channels = colorType < 7 ? channelCounts[colorType] : 0;
+	if (!width || !height || !channels || interlace != 0 ||
+		!(bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16) ||
+		(colorType == 3 && (bitDepth == 16 || palette.empty())) || (colorType != 0 && colorType != 3 && bitDepth < 8))
+		throw std::runtime_error(path.string() + " is not a supported PNG format");
+
+	std::vector<uint8_t> raw;
+	raw.reserve(((size_t)width * channels * bitDepth + 15) / 8 * height);
+	Export_Inflate(idat, raw);
+
+	// Undo the scan line filters in place; bpp is whole bytes per pixel, at least 1
+	size_t rowBytes = ((size_t)width * channels * bitDepth + 7) / 8;
+	size_t bpp = std::max((size_t)channels * bitDepth / 8, (size_t)1);
+	if (raw.size() < (rowBytes + 1) * height)
+		throw std::runtime_error(path.string() + " is truncated");
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* row = &raw[(rowBytes + 1) * y + 1];
+		const uint8_t* prior = y ? row - (rowBytes + 1) : nullptr;
+		uint8_t filter = row[-1];
+		for (size_t i = 0; i < rowBytes; i++)
+		{
+			int a = i >= bpp ? row[i - bpp] : 0;
+			int b = prior ? prior[i] : 0;
+			int c = prior && i >= bpp ? prior[i - bpp] : 0;
+			switch (filter)
+			{
+			case 0: break;
+			case 1: row[i] += (uint8_t)a; break;
+			case 2: row[i] += (uint8_t)b; break;
+			case 3: row[i] += (uint8_t)((a + b) / 2); break;
+			case 4: row[i] += Export_Paeth(a, b, c); break;
+			default: throw std::runtime_error(path.string() + " has a bad filter type");
+			}
+		}
+	}
+
+	// Samples to straight-alpha scRGB
+	float maxValue = (float)((1 << bitDepth) - 1);
+	rgba.resize((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* row = &raw[(rowBytes + 1) * y + 1];
+		for (uint32_t x = 0; x < width; x++)
+		{
+			uint32_t samples[4] = {};
+			for (int c = 0; c < channels; c++)
+			{
+				size_t bit = ((size_t)x * channels + c) * bitDepth;
+				if (bitDepth == 16)
+					samples[c] = (uint32_t)row[bit / 8] << 8 | row[bit / 8 + 1];
+				else
+					samples[c] = (row[bit / 8] >> (8 - bitDepth - bit % 8)) & ((1u << bitDepth) - 1);
+			}
+
+			bool color = colorType == 2 || colorType == 6;
+			float r = samples[0] / maxValue;
+			float g = (color ? samples[1] : samples[0]) / maxValue;
+			float b = (color ? samples[2] : samples[0]) / maxValue;
+			float a = 1.0f;
+			if (colorType == 4 || colorType == 6)
+				a = samples[color ? 3 : 1] / maxValue;
+			else if (colorType == 3)
+			{
+				uint32_t index = samples[0];
+				if ((size_t)index * 3 + 2 >= palette.size())
+					throw std::runtime_error(path.string() + " has a bad palette index");
+				r = palette[index * 3] / 255.0f;
+				g = palette[index * 3 + 1] / 255.0f;
+				b = palette[index * 3 + 2] / 255.0f;
+				if (index < transparency.size())
+					a = transparency[index] / 255.0f;
+			}
+			else if (colorType == 0 && transparency.size() >= 2)
+				a = samples[0] == (uint32_t)(transparency[0] << 8 | transparency[1]) ? 0.0f : 1.0f;
+			else if (colorType == 2 && transparency.size() >= 6)
+				a = samples[0] == (uint32_t)(transparency[0] << 8 | transparency[1]) &&
+					samples[1] == (uint32_t)(transparency[2] << 8 | transparency[3]) &&
+					samples[2] == (uint32_t)(transparency[4] << 8 | transparency[5]) ? 0.0f : 1.0f;
+
+			float* dst = &rgba[((size_t)y * width + x) * 4];
+			dst[0] = Canvas_SRGBToLinear(r);
+			dst[1] = Canvas_SRGBToLinear(g);
+			dst[2] = Canvas_SRGBToLinear(b);
+			dst[3] = a;
+		}
+	}
+	return true;
+}
+
+// "6,19-22" -> flags for those values; an empty list selects everything
+static bool Export_ParseList(const char* list, std::vector<bool>& selected)
+{
+	std::fill(selected.begin(), selected.end(), false);
+	for (const char* p = list; *p;)
+	{
+		char* end;
+		long first = strtol(p, &end, 10);
+		if (end == p)
+			return false;
+		long last = first;
+		if (*end == '-')
+		{
+			p = end + 1;
+			last = strtol(p, &end, 10);
+			if (end == p)
+				return false;
+		}
+		for (long i = std::max(first, 0L); i <= last && i < (long)selected.size(); i++)
+			selected[i] = true;
+		p = *end == ',' ? end + 1 : end;
+		if (*end && *end != ',')
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::filesystem::path outDir = "golden";
+	ExportFormat format = ExportEXR;
+	uint32_t width = 1920, height = 1080, threads = 0;
+	const char* patternList = nullptr;
+	const char* tierList = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value)
+		{
+			printf("missing value for %s\n", arg);
+			return 2;
+		}
+		if      (!strcmp(arg, "--out"))      outDir = value;
+		else if (!strcmp(arg, "--format"))
+		{
+			if      (!strcmp(value, "exr")) format = ExportEXR;
+			else if (!strcmp(value, "png")) format = ExportPNG;
+			else { printf("unknown format %s\n", value); return 2; }
+		}
+		else if (!strcmp(arg, "--size"))     { if (sscanf(value, "%ux%u", &width, &height) != 2 || !width || !height) { printf("bad size %s\n", value); return 2; } }
+		else if (!strcmp(arg, "--threads"))  threads = std::max(atoi(value), 0);
+		else if (!strcmp(arg, "--patterns")) patternList = value;
+		else if (!strcmp(arg, "--tiers"))    tierList = value;
+		else
+		{
+			printf("unknown option %s\n", arg);
+			return 2;
+		}
+		i++;
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(outDir, ec);
+	if (ec)
+	{
+		printf("could not create %s\n", outDir.string().c_str());
+		return 2;
+	}
+
+	// --patterns takes TestPattern values, --tiers the number in the tier's name
+	std::vector<bool> patterns((size_t)PatternGenerator::TestPattern::EndOfTest + 1, true);
+	if (patternList && !Export_ParseList(patternList, patterns))
+	{
+		printf("bad pattern list %s\n", patternList);
+		return 2;
+	}
+	std::vector<bool> tierNits(10001, true);
+	if (tierList && !Export_ParseList(tierList, tierNits))
+	{
+		printf("bad tier list %s\n", tierList);
+		return 2;
+	}
+
+	std::vector<ExportJob> jobs;
+	for (int p = (int)PatternGenerator::TestPattern::StartOfTest; p <= (int)PatternGenerator::TestPattern::EndOfTest; p++)
+	{
+		if (!patterns[p])
+			continue;
+		PatternGenerator::TestPattern pattern = (PatternGenerator::TestPattern)p;
+		for (int t = PatternGenerator::DisplayHDR400; t <= PatternGenerator::DisplayHDR10000; t++)
+		{
+			PatternGenerator::TestingTier tier = (PatternGenerator::TestingTier)t;
+			if (!tierNits[atoi(Export_TierName(tier).c_str() + strlen("DisplayHDR"))])
+				continue;
+			if (PatternGenerator::UsesWhiteLevel(pattern))
+				for (int bracket = 0; bracket < NUM_WBRACKETS; bracket++)
+					jobs.push_back({ pattern, tier, bracket });
+			else
+				jobs.push_back({ pattern, tier, -1 });
+		}
+	}
+
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t renderThreads = threads;
+	uint32_t encodeThreads = std::max(threads / 2, 1u);
+
+	// Every frame in flight holds a full FP16 image, so the pool bounds memory
+	size_t frameCount = renderThreads + encodeThreads + 2;
+	std::vector<ExportFrame> frames(frameCount);
+	BoundedQueue<ExportFrame*> freeFrames(frameCount), rendered(frameCount), encoded(frameCount);
+	for (ExportFrame& frame : frames)
+	{
+		frame.pixels.resize((size_t)width * height * 4);
+		freeFrames.Push(&frame);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<uint32_t> nextJob(0);
+	std::atomic<bool> failed(false);
+	std::mutex seenLock;
+	std::set<uint64_t> seen;				// content already encoded
+
+	auto fail = [&](const char* what)
+	{
+		printf("%s\n", what);
+		failed = true;
+		freeFrames.Close();					// stop the renderers, drain what is in flight
+	};
+
+	std::vector<std::thread> renderers;
+	for (uint32_t t = 0; t < renderThreads; t++)
+		renderers.emplace_back([&]
+		{
+			try
+			{
+				SoftwarePatternCanvas canvas(width, height);
+				std::map<PatternGenerator::TestPattern, std::pair<uint32_t, uint32_t>> images;	// given to this canvas; 0 x 0 if missing
+				for (uint32_t j = nextJob++; j < jobs.size() && !failed; j = nextJob++)
+				{
+					const ExportJob& job = jobs[j];
+					auto game = std::make_unique<PatternGenerator>(g_exportTitle);
+					game->InitializeOffscreen(job.tier);
+					if (job.bracket >= 0)
+						game->SetWhiteLevelBracket(job.bracket);
+
+					auto& resources = game->GetTestPatternResources(job.pattern);
+					if (!resources.imageFilename.empty())
+					{
+						auto image = images.find(job.pattern);
+						if (image == images.end())
+						{
+							uint32_t imageWidth = 0, imageHeight = 0;
+							std::vector<float> rgba;
+							if (Export_LoadImage(resources.imageFilename, imageWidth, imageHeight, rgba))
+								canvas.SetImage((CanvasImage)job.pattern, imageWidth, imageHeight, std::move(rgba));
+							image = images.insert({ job.pattern, { imageWidth, imageHeight } }).first;
+						}
+
+						// The patterns center the image by its size
+						resources.imageWidth = image->second.first;
+						resources.imageHeight = image->second.second;
+						resources.imageIsValid = resources.imageWidth != 0;
+					}
+
+					game->SetTestPattern(job.pattern);
+					for (int subtest = 0; ; )
+					{
+						game->RenderOffscreen(canvas);
+						canvas.Render();
+
+						ExportFrame* frame;
+						if (!freeFrames.Pop(frame))
+							break;
+						frame->job = &job;
+						frame->subtest = subtest;
+						frame->whiteLevel = job.bracket >= 0 ? game->GetWhiteLevelNits() : 0;
+						memcpy(frame->pixels.data(), canvas.Data(), frame->pixels.size() * sizeof(uint16_t));
+						rendered.Push(frame);
+
+						// ProfileCurve only knows its count once drawn
+						if (++subtest >= game->GetSubtestCount())
+							break;
+						game->ChangeSubtest(1);
+					}
+				}
+			}
+			catch (std::exception& e)
+			{
+				fail(e.what());
+			}
+		});
+
+	std::vector<std::thread> encoders;
+	for (uint32_t t = 0; t < encodeThreads; t++)
+		encoders.emplace_back([&]
+		{
+			try
+			{
+				std::vector<uint8_t> scratch;
+				ExportFrame* frame;
+				while (rendered.Pop(frame))
+				{
+					frame->hash = Export_Hash(frame->pixels);
+					bool first;
+					{
+						std::lock_guard<std::mutex> lock(seenLock);
+						first = seen.insert(frame->hash).second;
+					}
+
+					frame->encoded.clear();
+					if (first && format == ExportEXR)
+						Export_EncodeEXR(frame->pixels, width, height, frame->encoded);
+					else if (first)
+						Export_EncodePNG(frame->pixels, width, height, scratch, frame->encoded);
+					encoded.Push(frame);
+				}
+			}
+			catch (std::exception& e)
+			{
+				fail(e.what());
+			}
+		});
+
+	std::vector<ExportRecord> records;
+	uint64_t files = 0, bytesWritten = 0;
+	std::thread writer([&]
+	{
+		ExportFrame* frame;
+		while (encoded.Pop(frame))
+		{
+			if (!frame->encoded.empty())
+			{
+				std::string path = (outDir / Export_FileName(frame->hash, format)).string();
+				FrameFile file;
+				if (file.Open(path.c_str(), true) && file.Write(frame->encoded.data(), frame->encoded.size()))
+				{
+					files++;
+					bytesWritten += frame->encoded.size();
+				}
+				else if (!failed)
+					fail(("could not write " + path).c_str());
+			}
+			records.push_back({ (int)frame->job->pattern, (int)frame->job->tier, frame->job->bracket,
+				frame->subtest, frame->whiteLevel, frame->hash });
+			freeFrames.Push(frame);
+		}
+	});
+
+	for (auto& renderer : renderers)
+		renderer.join();
+	rendered.Close();
+	for (auto& encoder : encoders)
+		encoder.join();
+	encoded.Close();
+	writer.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (failed)
+		return 1;
+
+	// Sorted, so the manifest of an unchanged build is unchanged
+	std::sort(records.begin(), records.end());
+	std::string manifestPath = (outDir / "manifest.json").string();
+	FILE* f = fopen(manifestPath.c_str(), "w");
+	if (!f)
+	{
+		printf("could not write %s\n", manifestPath.c_str());
+		return 2;
+	}
+	fprintf(f, "{\n  \"width\": %u,\n  \"height\": %u,\n  \"format\": \"%s\",\n  \"frames\": [\n",
+		width, height, format == ExportEXR ? "exr scRGB half" : "png Rec.2100 PQ 16-bit");
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const ExportRecord& r = records[i];
+		fprintf(f, "    { \"pattern\": %d, \"tier\": \"%s\", \"whiteLevel\": %u, \"subtest\": %d, \"file\": \"%s\" }%s\n",
+			r.pattern, Export_TierName((PatternGenerator::TestingTier)r.tier).c_str(), r.whiteLevel, r.subtest,
+			Export_FileName(r.hash, format).c_str(), i + 1 < records.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	if (fclose(f) != 0)
+	{
+		printf("could not write %s\n", manifestPath.c_str());
+		return 2;
+	}
+
+	printf("%zu jobs, %zu frames, %llu files (%.1f MB) in %.2f s on %u render + %u encode threads\n",
+		jobs.size(), records.size(), (unsigned long long)files, bytesWritten / 1e6, seconds, renderThreads, encodeThreads);
+	return 0;
+}
@@ -0,0 +1,5588 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// No precompiled header: this file builds without the Windows SDK, see PatternGenerator.h.
+// ColorSpaces.h defines its functions out of line, so it is included here and nowhere else in
+// the app.
+#include "ColorSpaces.h"
+#include "PatternGenerator.h"
+
+#include <assert.h>
+#include <string.h>
+#include <wchar.h>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+template <typename T>
+static std::wstring to_string_with_precision(const T a_value, const int n = 4)
+{
+    std::wstringstream out;
+    out << std::setprecision(n) << a_value;
+    return out.str();
+}
+
+PatternGenerator::PatternGenerator(const std::wstring& appTitle, const std::filesystem::path& gamutStorePath)
+{
+    m_appTitle = appTitle;
+    m_host = nullptr;
+
+	m_shiftKey = false;			// whether shift key is pressed
+    m_currentTest = TestPattern::StartOfTest;
+    m_cachedTest = TestPattern::StartOfTest;
+	m_currentColor = 0;			// Which of R/G/B to test.
+	m_currentProfileTile = 0;	// which intensity profile tile we are on
+	m_maxPQCode = 1;
+	m_maxProfileTile = 1;
+
+    m_gradientColor = D2D1::ColorF(0.25f, 0.25f, 0.25f);
+    m_gradientAnimationBase = 0.25f;
+    m_flashOn = false;
+    m_testingTier = DisplayHDR400;
+    m_outputDesc = {};
+    m_rawOutDesc = {};
+    m_modeWidth = 0;
+    m_modeHeight = 0;
+    m_displayFrequency = 0;
+    m_Metadata = {};
+    m_MetadataGamut = GAMUT_Native;
+	m_totalTime = 0;
+    m_testTimeRemainingSec = 0;
+    m_showExplanatoryText = true;
+    m_newTestSelected = true;
+    m_contentChanged = true;
+    m_offscreen = false;
+    m_gamutVolume = 0.0f;
+    m_gamutPending = false;
+    m_gamutCache = std::make_unique<GamutCache>(ComputeGamutMetrics, 256, gamutStorePath);
+
+	m_currentBlack = 0;			// Which black level is crushed
+
+	m_checkerboard = Checkerboard::Cb6x4;
+	m_snoodDiam = 40.f;							// OD of sensor snood in mm
+	m_LocalDimmingBars = 0;						// v1.2 Local Dimming Contrast test
+	m_subtitleVisible = 1;						// v1.4 subTitle Flicker Test
+	m_currentXRiteIndex = 0;					// v1.5 current index into array of Xrite patch colors
+	m_XRitePatchAutoMode = false;				// v1.5 flag for when it auto animates
+	m_XRitePatchDisplayTime = 1.f;				// v1.5 duration to show color patch in auto mode
+	m_whiteLevelBracket = 1;					// what tier/level we should use
+	m_XRiteIntensity = 0;						// correction for panel
+
+	//	These are sRGB code values for HDR10:
+	m_maxEffectivesRGBValue = -1;	// not set yet
+	m_maxFullFramesRGBValue = -1;
+	m_minEffectivesRGBValue = -1;
+
+	//	These are PQ code values for HDR10:
+	m_maxEffectivePQValue = -1;	// not set yet
+	m_maxFullFramePQValue = -1;
+	m_minEffectivePQValue = -1;
+
+	// enable adjustment to tests 5.x for active dimming
+	m_staticContrastsRGBValue = 0.0f;
+	m_staticContrastPQValue = 0.0f;
+	m_activeDimming50PQValue = 0.0f;
+	m_activeDimming05PQValue = 0.0f;
+	m_activeDimming50sRGBValue = 0.0f;
+	m_activeDimming05sRGBValue = 0.0f;
+
+	m_bPaused = false;							// default to animations running, not paused
+
+    m_whiteColor = D2D1::ColorF(D2D1::ColorF::White, 1);
+	m_blackColor = D2D1::ColorF(D2D1::ColorF::Black, 1);
+	m_redColor = D2D1::ColorF(D2D1::ColorF::Red, 1);
+
+    m_testTitleRect = m_largeTextRect = m_MetadataTextRect = m_TestingTierTextRect = {};
+    m_gradientStops[0] = m_gradientStops[1] = {};
+
+    RegisterTestPatterns();
+
+    m_hideTextString = std::wstring(L"Press SPACE to hide this text.");
+}
+
+// Takes what the host last read about the display.  Patterns that show it are drawn again
+// only if it has changed.
+void PatternGenerator::SetDisplay(const PatternDisplayDesc& display)
+{
+    if (memcmp(&display.output, &m_outputDesc, sizeof(m_outputDesc)) != 0 ||
+        memcmp(&display.raw, &m_rawOutDesc, sizeof(m_rawOutDesc)) != 0 ||
+        display.modeWidth != m_modeWidth || display.modeHeight != m_modeHeight ||
+        display.refreshRate != m_displayFrequency ||
+        display.adapterName != m_adapterName || display.monitorName != m_monitorName ||
+        display.connectorName != m_connectorName)
+        m_contentChanged = true;
+
+    m_outputDesc = display.output;
+    m_rawOutDesc = display.raw;
+    m_modeWidth = display.modeWidth;
+    m_modeHeight = display.modeHeight;
+    m_displayFrequency = display.refreshRate;
+    m_adapterName = display.adapterName;
+    m_monitorName = display.monitorName;
+    m_connectorName = display.connectorName;
+
+	// set staticContrast test#5 to maxLuminance but clamped to 500nits.
+	float maxNits = fmin(m_outputDesc.MaxLuminance, 500.f);
+	if (CheckHDR_On())
+		m_staticContrastPQValue = (float)NitsToPQ10Code(maxNits);
+	else
+		m_staticContrastsRGBValue = (maxNits / 270.f) * 255.f;
+
+	// get PQ code at MaxLuminance
+	m_maxPQCode = NitsToPQ10Code(m_rawOutDesc.MaxLuminance);
+//	m_maxPQCode = 1023;			// limit PQ code to valid range
+}
+
+void PatternGenerator::SetDefaultsForDisplay()
+{
+	// Try to guess the testing tier that we are trying against
+	m_testingTier = GetTestingTier();
+
+	// get reasonable starting points for calibration
+	InitEffectiveValues();
+
+	m_activeDimming50PQValue = 113 * 4;		// 50.825 nits in nearest 8-bit code value
+	m_activeDimming05PQValue = 64 * 4;		//  5.172 nits in nearest 8-bit code value
+}
+
+// Used instead of a host's SetDisplay to render without a display (PatternExport).  The panel
+// is modelled as exactly meeting the testing tier, and the effects are taken to be provided by
+// the caller's canvas.
+void PatternGenerator::InitializeOffscreen(TestingTier tier)
+{
+    m_offscreen = true;
+
+    PatternDisplayDesc display = {};
+    display.raw.MaxLuminance = GetTierLuminance(tier);
+    display.raw.MaxFullFrameLuminance = display.raw.MaxLuminance * 0.5f;
+    display.raw.MinLuminance = 0.05f;
+
+    PatternOutputDesc& output = display.output;
+    wcscpy(output.DeviceName, L"\\\\.\\OFFSCREEN");
+    output.BitsPerColor = 10;
+    output.ColorSpace = OutputColorSpaceHDR10;
+    output.RedPrimary[0]   = primaryR_DCIP3.x;
+    output.RedPrimary[1]   = primaryR_DCIP3.y;
+    output.GreenPrimary[0] = primaryG_DCIP3.x;
+    output.GreenPrimary[1] = primaryG_DCIP3.y;
+    output.BluePrimary[0]  = primaryB_DCIP3.x;
+    output.BluePrimary[1]  = primaryB_DCIP3.y;
+    output.WhitePoint[0]   = D6500White.x;
+    output.WhitePoint[1]   = D6500White.y;
+    output.MaxLuminance = display.raw.MaxLuminance;
+    output.MaxFullFrameLuminance = display.raw.MaxFullFrameLuminance;
+    output.MinLuminance = display.raw.MinLuminance;
+    display.connectorName = L"Virtual";
+    SetDisplay(display);
+
+    SetDefaultsForDisplay();
+    m_testingTier = tier;
+
+    for (auto& desc : m_testPatterns)
+        desc.resources.effectIsValid = desc.resources.canvasEffect != CanvasEffectNone;
+}
+
+PatternGenerator::TestPatternResources& PatternGenerator::GetTestPatternResources(TestPattern test)
+{
+    return GetTestPatternDesc(test).resources;
+}
+
+// Update any parameters used for animations.
+void PatternGenerator::Update(float elapsedSeconds, float totalSeconds)
+{
+    m_totalTime = totalSeconds;
+
+    // TODO: This should go into a shared method for the gradient test patterns.
+    // Patterns that draw a gradient set its end color in their update.
+    m_gradientStops[0].color = D2D1::ColorF(D2D1::ColorF::Black, 1);
+    m_gradientStops[0].position = 0.0f;
+    m_gradientStops[1].color = D2D1::ColorF(D2D1::ColorF::Black, 1);
+    m_gradientStops[1].position = 1.0f;
+
+    const TestPatternDesc& desc = GetTestPatternDesc(m_currentTest);
+    if (desc.update)
+        (this->*desc.update)(elapsedSeconds);
+}
+
+// Whether what the current pattern draws has changed, other than through its animation key,
+// since the last call: a new test, a key, or the display.  Hosts that replay a recording of the
+// pattern record it again when this is true.
+bool PatternGenerator::TakeContentChanged()
+{
+    bool changed = m_contentChanged || m_newTestSelected;
+    m_contentChanged = false;
+    return changed;
+}
+
+#define BRIGHTNESS_SLIDER_FACTOR (m_rawOutDesc.MaxLuminance / m_outputDesc.MaxLuminance)
+
+#define PATCHPCT (0.08f)
+#define TARGETAPL (0.02f)
+#define NUMXRITECOLORS (97.f)
+struct XriteColors		// provided courtesy of Portrait X-Rite(TM) calibration technology
+{
+	int num;
+	int row;
+	char col;
+	uint32_t RGB;
+	float  R, G, B;		// for 100 nit D65 white point in 2020 gamut primaries
+	double X, Y, Z;		// (CIE 1931 2 degree)
+} XRite[] = {
+//n row col    RRGGBB      R          G           B         X             Y             Z
+//0, 0, '-', 0xFFFFFF,  1.000000, 1.000000, 1.000000, 100.000000000,100.000000000,100.000000000,
+  1, 1, 'A', 0xF4F6F3,  0.498834, 0.499625, 0.497344,  86.533211290, 91.585525820, 97.878649400,
+  2, 1, 'B', 0x818181,  0.364688, 0.364859, 0.365180,  20.792432080, 21.884200640, 23.925671570,
+  3, 1, 'C', 0x3C3C3B,  0.240312, 0.240033, 0.239499,   4.256057219,  4.474643989,  4.833733497,  // skip 4-15
+ 16, 2, 'B', 0x933E6E,  0.359104, 0.268128, 0.332106,  16.526303580, 10.753371090, 16.008163310,
+ 17, 2, 'C', 0x55445F,  0.283570, 0.261789, 0.306806,   7.899895441,  6.898727382, 11.774254880,
+ 18, 2, 'D', 0xCCD6E3,  0.462816, 0.468296, 0.480466,  62.735330580, 66.451241440, 82.240083590,
+ 19, 2, 'E', 0x765446,  0.330253, 0.294836, 0.267084,  11.750768390, 10.590861790,  7.186192248,
+ 20, 2, 'F', 0xC59482,  0.431643, 0.396995, 0.371157,  37.583017980, 34.669699420, 25.836393250,
+ 21, 2, 'G', 0x5F7B9D,  0.333089, 0.353966, 0.399236,  17.837678130, 18.961502280, 34.681355200,
+ 22, 2, 'H', 0x5A6E42,  0.313280, 0.333256, 0.266624,  10.832807340, 13.750247450,  7.303778533,
+ 23, 2, 'I', 0x8280AF,  0.369187, 0.365089, 0.420534,  24.670403040, 23.327084940, 43.628533060,
+ 24, 2, 'J', 0x65BEAD,  0.383048, 0.437697, 0.423882,  31.263243540, 42.546305730, 45.948413660,
+ 25, 2, 'K', 0xF2CFB8,  0.483620, 0.464457, 0.440228,  67.553141900, 67.104629060, 54.824288420,
+ 26, 2, 'L', 0x6E3D46,  0.311767, 0.254055, 0.263454,   9.248634896,  7.123491009,  6.742289138,
+ 27, 2, 'M', 0xBC3F64,  0.403831, 0.284703, 0.318748,  24.886900670, 15.231543150, 13.686284150,  // skip 28, 29
+ 30, 3, 'B', 0xB88BB9,  0.420486, 0.384844, 0.433509,  37.638886490, 32.008638080, 50.160484400,
+ 31, 3, 'C', 0x7266A6,  0.341450, 0.326192, 0.408593,  18.644913870, 15.907477420, 38.201392190,
+ 32, 3, 'D', 0xEFCDD6,  0.482344, 0.462548, 0.468715,  69.637304040, 67.011486060, 73.044700990,
+ 33, 3, 'E', 0xDF7F33,  0.446294, 0.375568, 0.261945,  38.524340580, 31.114525100,  7.148722041,
+ 34, 3, 'F', 0x4B5EAB,  0.298593, 0.308490, 0.413195,  14.222416490, 12.384797420, 40.058298340,
+ 35, 3, 'G', 0xC35561,  0.413632, 0.315869, 0.317071,  27.841684530, 18.923019180, 13.524133140,
+ 36, 3, 'H', 0x5C3F6B,  0.291663, 0.253529, 0.325210,   8.848467026,  6.856047893, 14.710645450,
+ 37, 3, 'I', 0xA1BE44,  0.417937, 0.439934, 0.302363,  34.063394940, 44.746591560, 12.372120840,
+ 38, 3, 'J', 0xE2A22D,  0.456973, 0.415694, 0.269431,  44.613171700, 42.127022240,  8.225577179,
+ 39, 3, 'K', 0xC6EBD5,  0.466355, 0.486926, 0.469523,  64.899359280, 76.071553550, 74.137955910,
+ 40, 3, 'L', 0xCA3C3C,  0.416690, 0.285280, 0.254187,  26.901992700, 16.175839940,  6.031991297,
+ 41, 3, 'M', 0x603C50,  0.293062, 0.247799, 0.280432,   7.891606323,  6.263674361,  8.412485400,  // skip 42, 43
+ 44, 4, 'B', 0x7C3B91,  0.334272, 0.257589, 0.380366,  14.984765510,  9.453061058, 27.850117650,
+ 45, 4, 'C', 0x324A74,  0.247897, 0.269742, 0.338992,   6.899378575,  6.859692772, 17.368376520,
+ 46, 4, 'D', 0xB0E0D5,  0.448749, 0.475551, 0.468542,  56.546648740, 67.176637550, 73.170544650,
+ 47, 4, 'E', 0x364191,  0.251805, 0.254680, 0.380224,   8.563477857,  6.664989920, 27.799448970,
+ 48, 4, 'F', 0x47974B,  0.329089, 0.389127, 0.292306,  14.858863500, 23.829750370, 10.461868100,
+ 49, 4, 'G', 0xB3323E,  0.391908, 0.262092, 0.253351,  20.698947040, 12.250337220,  5.902634969,
+ 50, 4, 'H', 0xEBC821,  0.474327, 0.455687, 0.280104,  55.123904260, 58.969821910,  9.885304636,
+ 51, 4, 'I', 0xBF5696,  0.411869, 0.317747, 0.390308,  30.256590580, 19.922766010, 31.288718640,
+ 52, 4, 'J', 0x008AA9,  0.288986, 0.371841, 0.414080,  15.367801500, 20.604087770, 40.791705610,
+ 53, 4, 'K', 0xDBD3E0,  0.471163, 0.466250, 0.478069,  65.832282760, 66.887123200, 80.264910000,
+ 54, 4, 'L', 0xCF8295,  0.435661, 0.376770, 0.392828,  39.022037260, 31.281204360, 32.516169310,
+ 55, 4, 'M', 0xBD3749,  0.402886, 0.273609, 0.274269,  23.574967010, 14.052860450,  7.823662074,  // skip 56, 57
+ 58, 5, 'B', 0x1589CC,  0.309459, 0.371737, 0.451158,  20.087209920, 22.344742210, 60.110134410,
+ 59, 5, 'C', 0x55A2CB,  0.358090, 0.406097, 0.452458,  27.505824980, 32.203205660, 61.229380280,
+ 60, 5, 'D', 0xF1CECA,  0.483452, 0.463290, 0.457837,  69.059715320, 67.146317300, 65.498748310,
+ 62, 5, 'F', 0xC8C8C9,  0.454365, 0.454102, 0.454591,  55.059386940, 57.830193630, 63.228199920,
+ 63, 5, 'G', 0xA3A4A5,  0.411982, 0.412326, 0.413178,  35.241397610, 37.093821930, 40.779328730,
+ 65, 5, 'I', 0x626262,  0.315105, 0.315390, 0.316092,  11.556000200, 12.163244770, 13.364081910,
+ 66, 5, 'J', 0x434445,  0.257156, 0.258030, 0.260185,   5.464348778,  5.756852478,  6.462477420,
+ 67, 5, 'K', 0xB4DCE2,  0.450069, 0.472251, 0.479783,  58.061821080, 66.239982950, 81.760975930,
+ 68, 5, 'L', 0xD58482,  0.441048, 0.379923, 0.370181,  39.789279170, 32.226929400, 25.408667110,
+ 69, 5, 'M', 0xE74D48,  0.445733, 0.317605, 0.280531,  36.849623790, 22.849407730,  8.634066840,  // skip 70, 71
+ 72, 6, 'B', 0x32A8C3,  0.344687, 0.411823, 0.444856,  25.228780790, 32.684552730, 56.694721920,
+ 73, 6, 'C', 0x284E5F,  0.238055, 0.276002, 0.307405,   5.692425950,  6.780516852, 11.897590810,
+ 74, 6, 'D', 0xCFDAA5,  0.463829, 0.471380, 0.421437,  57.590018830, 66.018199150, 45.368799830,
+ 76, 6, 'F', 0x59595A,  0.299838, 0.300238, 0.301483,   9.564253689, 10.064608710, 11.134841100,
+ 77, 6, 'G', 0x6A6B6B,  0.330352, 0.330736, 0.331527,  13.923263050, 14.660007630, 16.124553600,
+ 78, 6, 'H', 0x989899,  0.397295, 0.397368, 0.398364,  30.004027410, 31.537344570, 34.699049160,
+ 79, 6, 'I', 0xBDBDBE,  0.442224, 0.442057, 0.442609,  48.525018480, 50.982961880, 55.792765100,
+ 80, 6, 'J', 0xE0E1E1,  0.479188, 0.479766, 0.480139,  71.247395410, 75.107046350, 82.206832430,
+ 81, 6, 'K', 0xB2B2B3,  0.429090, 0.429287, 0.430159,  42.317392640, 44.512028860, 48.915528100,
+ 82, 6, 'L', 0xF4752D,  0.462019, 0.368007, 0.253055,  44.131007750, 32.177121340,  6.344859403,
+ 83, 6, 'M', 0xFFBC31,  0.493019, 0.447417, 0.290890,  64.079413780, 59.655086600, 10.992190490,  // skip 84, 85
+ 86, 7, 'B', 0x2B4F4F,  0.240023, 0.277619, 0.279228,   5.230441806,  6.723176467,  8.352868857,
+ 87, 7, 'C', 0x759ECF,  0.376705, 0.402414, 0.456569,  30.780046770, 32.682966400, 63.818882210,
+ 88, 7, 'D', 0xD38866,  0.439892, 0.384637, 0.334056,  38.254848490, 32.547350950, 16.965111700,
+ 89, 7, 'E', 0xECB49B,  0.471569, 0.436637, 0.406738,  56.916514990, 52.865360010, 38.407424560,
+ 90, 7, 'F', 0xBE9778,  0.427175, 0.399974, 0.358764,  35.859866060, 34.637042750, 22.564393980,
+ 91, 7, 'G', 0x916A50,  0.368336, 0.334573, 0.291096,  18.242782700, 16.929283660,  9.935993265,
+ 92, 7, 'H', 0xC6A18E,  0.437239, 0.411973, 0.388115,  40.995412260, 39.472809370, 31.230776140,
+ 93, 7, 'I', 0xA16645,  0.383626, 0.330956, 0.272423,  20.552375850, 17.498776050,  7.850930456,
+ 94, 7, 'J', 0xD09078,  0.439537, 0.393557, 0.357762,  39.377642320, 34.722317270, 22.252946180,
+ 95, 7, 'K', 0x777777,  0.350299, 0.350419, 0.350463,  17.591371710, 18.517812990, 20.183763000,
+ 96, 7, 'L', 0xC1BA0C,  0.439649, 0.437897, 0.254956,  39.620944430, 46.434482250,  7.229951406,
+ 97, 7, 'M', 0xF4C904,  0.480913, 0.457776, 0.269437,  58.281188360, 61.077446520,  8.830551879,  // skip 98, 99
+100, 8, 'B', 0x18ABAB,  0.336325, 0.414111, 0.419404,  22.226046050, 32.146142550, 43.556240210,
+101, 8, 'C', 0x009690,  0.291845, 0.387396, 0.385725,  14.523757570, 23.159776430, 30.192359560,
+102, 8, 'D', 0xC89684,  0.434688, 0.399257, 0.374270,  38.792469530, 35.648401980, 26.754607140,
+103, 8, 'E', 0xF0A591,  0.470462, 0.421585, 0.393360,  54.585824170, 47.552870650, 33.151261110,
+104, 8, 'F', 0xBF9A88,  0.429034, 0.402877, 0.379152,  37.466446930, 35.892141540, 28.254225400,
+105, 8, 'G', 0xC19989,  0.430383, 0.401702, 0.379994,  37.854159750, 35.785057360, 28.501861920,
+106, 8, 'H', 0xC39986,  0.432243, 0.402706, 0.376863,  38.326792330, 36.215167020, 27.557513300,
+107, 8, 'I', 0x7D5A45,  0.340984, 0.306668, 0.267055,  13.240071880, 12.144334740,  7.226119588,
+108, 8, 'J', 0xD29879,  0.443156, 0.402747, 0.361315,  41.209678110, 37.455523660, 23.238538180,
+109, 8, 'K', 0x494A4A,  0.269673, 0.269785, 0.271010,   6.443906197,  6.770644576,  7.488444555,
+110, 8, 'L', 0xB39A45,  0.417464, 0.401490, 0.291054,  31.266612070, 33.197161740, 10.425517790,
+111, 8, 'M', 0xB1BA2C,  0.427692, 0.436537, 0.275347,  36.057458440, 44.517234190,  9.083313607,  // skip 112, 113
+114, 9, 'B', 0x4D4841,  0.272895, 0.267784, 0.253529,   6.360790471,  6.640126351,  5.930663147,
+115, 9, 'C', 0x58AB77,  0.358377, 0.414806, 0.358557,  21.892603240, 32.388512910, 22.671978430,
+116, 9, 'D', 0x00966B,  0.303113, 0.387440, 0.337556,  13.423201510, 22.836472970, 17.680583050,
+117, 9, 'E', 0x345044,  0.248617, 0.279043, 0.259748,   5.323550029,  6.868151643,  6.477754156,
+118, 9, 'F', 0x3EAB89,  0.345338, 0.414493, 0.380557,  21.027393740, 31.892228140, 28.814915220,
+119, 9, 'G', 0x79A759,  0.377192, 0.411624, 0.317874,  23.485085090, 32.329292180, 14.345078770,
+120, 9, 'H', 0x39953E,  0.318414, 0.386510, 0.273172,  13.282935450, 22.690171490,  8.297622316,
+121, 9, 'I', 0x49B14F,  0.352433, 0.421254, 0.306759,  19.833708900, 33.329363180, 12.744002250,
+122, 9, 'J', 0xC3904F,  0.427704, 0.391774, 0.302679,  33.918413780, 32.207291480, 11.849344930,
+123, 9, 'K', 0x9AA348,  0.400663, 0.409218, 0.295429,  27.607046040, 33.474874880, 11.055671170,
+124, 9, 'L', 0xA0C132,  0.418941, 0.443273, 0.283704,  34.220708820, 45.934211170, 10.083474300,
+125, 9, 'M', 0x5B453D,  0.288689, 0.264016, 0.246976,   7.270479024,  6.817176846,  5.415485843,
+126, 0, 'Z', 0x000000,  0.000000, 0.000000, 0.000000,   0.000000000,  0.000000000,  0.000000000,	// black
+127, 0, 'Z', 0xFFFFFF,  0.508057, 0.508057, 0.508057,  95.0470000,   100.00000000, 108.88300000		// white
+ };
+
+ // Keep value in range from min to max by clamping
+ float clamp(float v, float min, float max)		// inclusive
+ {
+	 if (v > max)
+		 v = max; else
+		 if (v < min)
+			 v = min;
+	 return v;
+ }
+
+ // Keep value in from min to max by wrapping
+ float wrap(float v, float min, float max)			// inclusive
+ {
+	 float range = max - min + 1.f;
+	 while (v >= max)
+		 v -= range;
+	 while (v < min)
+		 v += range;
+	 return v;
+ }
+
+// The descriptor of every test pattern, in TestPattern order.  Fields left out are null or
+// their defaults: no update, no subtests, and a static pattern that is recorded once.
+void PatternGenerator::RegisterTestPatterns()
+{
+    GetTestPatternDesc(TestPattern::StartOfTest)                         = { &PatternGenerator::GenerateTestPattern_StartOfTest };
+    GetTestPatternDesc(TestPattern::ConnectionProperties)                = { &PatternGenerator::GenerateTestPattern_ConnectionProperties };
+    GetTestPatternDesc(TestPattern::PanelCharacteristics)                = { &PatternGenerator::GenerateTestPattern_PanelCharacteristics, &PatternGenerator::UpdateTestPattern_PanelCharacteristics, &PatternGenerator::ChangeSubtest_TestingTier };
+    GetTestPatternDesc(TestPattern::ResetInstructions)                   = { &PatternGenerator::GenerateTestPattern_ResetInstructions };
+    GetTestPatternDesc(TestPattern::PQLevelsInNits)                      = { &PatternGenerator::GenerateTestPattern_PQLevelsInNits };
+    GetTestPatternDesc(TestPattern::WarmUp)                              = { &PatternGenerator::GenerateTestPattern_WarmUp, &PatternGenerator::UpdateTestPattern_Countdown };
+    GetTestPatternDesc(TestPattern::TenPercentPeak)                      = { &PatternGenerator::GenerateTestPattern_TenPercentPeak, &PatternGenerator::UpdateTestPattern_Countdown, &PatternGenerator::ChangeSubtest_TestingTier };
+    GetTestPatternDesc(TestPattern::TenPercentPeakMAX)                   = { &PatternGenerator::GenerateTestPattern_TenPercentPeakMAX, &PatternGenerator::UpdateTestPattern_Countdown, &PatternGenerator::ChangeSubtest_TestingTier };
+    GetTestPatternDesc(TestPattern::FlashTest)                           = { &PatternGenerator::GenerateTestPattern_FlashTest, &PatternGenerator::UpdateTestPattern_FlashTest, nullptr, 1, AnimationFlash };
+    GetTestPatternDesc(TestPattern::FlashTestMAX)                        = { &PatternGenerator::GenerateTestPattern_FlashTestMAX, &PatternGenerator::UpdateTestPattern_FlashTest, nullptr, 1, AnimationFlash };
+    GetTestPatternDesc(TestPattern::LongDurationWhite)                   = { &PatternGenerator::GenerateTestPattern_LongDurationWhite, &PatternGenerator::UpdateTestPattern_Countdown, nullptr, 1, AnimationCountdown };
+    GetTestPatternDesc(TestPattern::FullFramePeak)                       = { &PatternGenerator::GenerateTestPattern_FullFramePeak, &PatternGenerator::UpdateTestPattern_Countdown, nullptr, 1, AnimationCountdown };
+    GetTestPatternDesc(TestPattern::DualCornerBox)                       = { &PatternGenerator::GenerateTestPattern_DualCornerBox };
+    GetTestPatternDesc(TestPattern::StaticContrastRatio)                 = { &PatternGenerator::GenerateTestPattern_StaticContrastRatio, nullptr, &PatternGenerator::ChangeSubtest_StaticContrastRatio };
+    GetTestPatternDesc(TestPattern::ActiveDimming)                       = { &PatternGenerator::GenerateTestPattern_ActiveDimming, nullptr, &PatternGenerator::ChangeSubtest_ActiveDimming };
+    GetTestPatternDesc(TestPattern::ActiveDimmingDark)                   = { &PatternGenerator::GenerateTestPattern_ActiveDimmingDark, nullptr, &PatternGenerator::ChangeSubtest_ActiveDimmingDark };
+    GetTestPatternDesc(TestPattern::ActiveDimmingSplit)                  = { &PatternGenerator::GenerateTestPattern_ActiveDimmingSplit };
+    GetTestPatternDesc(TestPattern::ColorPatches)                        = { &PatternGenerator::GenerateTestPattern_ColorPatches, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::ColorPatchesFull)                    = { &PatternGenerator::GenerateTestPattern_ColorPatchesFull, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::BitDepthPrecision)                   = { &PatternGenerator::GenerateTestPattern_BitDepthPrecision, &PatternGenerator::UpdateTestPattern_BitDepthPrecision };
+    GetTestPatternDesc(TestPattern::RiseFallTime)                        = { &PatternGenerator::GenerateTestPattern_RiseFallTime, &PatternGenerator::UpdateTestPattern_RiseFallTime };
+    GetTestPatternDesc(TestPattern::ProfileCurve)                        = { &PatternGenerator::GenerateTestPattern_ProfileCurve, nullptr, &PatternGenerator::ChangeSubtest_ProfileCurve };
+    GetTestPatternDesc(TestPattern::LocalDimmingContrast)                = { &PatternGenerator::GenerateTestPattern_LocalDimmingContrast, nullptr, &PatternGenerator::ChangeSubtest_LocalDimmingContrast, 2 };
+    GetTestPatternDesc(TestPattern::BlackLevelHDRvsSDR)                  = { &PatternGenerator::GenerateTestPattern_BlackLevelHDRvsSDR };
+    GetTestPatternDesc(TestPattern::BlackLevelCrush)                     = { &PatternGenerator::GenerateTestPattern_BlackLevelCrush, nullptr, &PatternGenerator::ChangeSubtest_BlackLevelCrush, 5 };
+    GetTestPatternDesc(TestPattern::SubTitleFlicker)                     = { &PatternGenerator::GenerateTestPattern_SubTitleFlicker };
+    GetTestPatternDesc(TestPattern::XRiteColors)                         = { &PatternGenerator::GenerateTestPattern_XRiteColors, &PatternGenerator::UpdateTestPattern_XRiteColors, &PatternGenerator::ChangeSubtest_XRiteColors, (int)NUMXRITECOLORS + 1 };
+    GetTestPatternDesc(TestPattern::EndOfMandatoryTests)                 = { &PatternGenerator::GenerateTestPattern_EndOfMandatoryTests };
+    GetTestPatternDesc(TestPattern::SharpeningFilter)                    = { &PatternGenerator::GenerateTestPattern_SharpeningFilter, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::ToneMapSpike)                        = { &PatternGenerator::GenerateTestPattern_ToneMapSpike, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::TextQuality)                         = { &PatternGenerator::GenerateTestPattern_ImageCommon };
+    GetTestPatternDesc(TestPattern::OnePixelLinesBW)                     = { &PatternGenerator::GenerateTestPattern_ImageCommon };
+    GetTestPatternDesc(TestPattern::OnePixelLinesRG)                     = { &PatternGenerator::GenerateTestPattern_ImageCommon };
+    GetTestPatternDesc(TestPattern::ColorPatches709)                     = { &PatternGenerator::GenerateTestPattern_ColorPatches709, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::FullFrameSDRWhite)                   = { &PatternGenerator::GenerateTestPattern_FullFrameSDRWhite, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::FullFrameSDRWhiteWithHDR)            = { &PatternGenerator::GenerateTestPattern_FullFrameSDRWhiteWithHDR, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::CalibrateMaxEffectiveValue)          = { &PatternGenerator::GenerateTestPattern_CalibrateMaxEffectiveValue, nullptr, &PatternGenerator::ChangeSubtest_MaxEffectiveValue };
+    GetTestPatternDesc(TestPattern::CalibrateMaxEffectiveFullFrameValue) = { &PatternGenerator::GenerateTestPattern_CalibrateMaxFullFrameValue, nullptr, &PatternGenerator::ChangeSubtest_MaxFullFrameValue };
+    GetTestPatternDesc(TestPattern::CalibrateMinEffectiveValue)          = { &PatternGenerator::GenerateTestPattern_CalibrateMinEffectiveValue, nullptr, &PatternGenerator::ChangeSubtest_MinEffectiveValue };
+    GetTestPatternDesc(TestPattern::StaticGradient)                      = { &PatternGenerator::GenerateTestPattern_StaticGradient, &PatternGenerator::UpdateTestPattern_StaticGradient, &PatternGenerator::ChangeSubtest_StaticGradient };
+    GetTestPatternDesc(TestPattern::AnimatedGrayGradient)                = { &PatternGenerator::GenerateTestPattern_AnimatedGrayGradient, &PatternGenerator::UpdateTestPattern_AnimatedGrayGradient, nullptr, 1, AnimationLive };
+    GetTestPatternDesc(TestPattern::AnimatedColorGradient)               = { &PatternGenerator::GenerateTestPattern_AnimatedColorGradient, &PatternGenerator::UpdateTestPattern_AnimatedColorGradient, nullptr, 1, AnimationLive };
+    GetTestPatternDesc(TestPattern::BlackLevelHdrCorners)                = { &PatternGenerator::GenerateTestPattern_BlackLevelHdrCorners };
+    GetTestPatternDesc(TestPattern::BlackLevelSdrTunnel)                 = { &PatternGenerator::GenerateTestPattern_BlackLevelSdrTunnel };
+    GetTestPatternDesc(TestPattern::ColorPatchesMAX)                     = { &PatternGenerator::GenerateTestPattern_ColorPatchesMAX, nullptr, &PatternGenerator::ChangeSubtest_Color, 4 };
+    GetTestPatternDesc(TestPattern::EndOfTest)                           = { &PatternGenerator::GenerateTestPattern_EndOfTest };
+    GetTestPatternDesc(TestPattern::Cooldown)                            = { &PatternGenerator::GenerateTestPattern_Cooldown, &PatternGenerator::UpdateTestPattern_Cooldown, nullptr, 1, AnimationCountdown };
+
+    // Images and effects, loaded by the host
+    GetTestPatternDesc(TestPattern::TenPercentPeak).resources    = TestPatternResources{ std::wstring(L"Background Noise")                          , std::wstring()                                , std::wstring(L"BackgroundNoiseEffect.cso")   , CanvasEffectBackgroundNoise };
+    GetTestPatternDesc(TestPattern::BitDepthPrecision).resources = TestPatternResources{ std::wstring(L"7. Bit-Depth/Precision")                    , std::wstring()                                , std::wstring(L"BandedGradientEffect.cso")    , CanvasEffectBandedGradient };
+    GetTestPatternDesc(TestPattern::SharpeningFilter).resources  = TestPatternResources{ std::wstring(L"Fresnel zone plate (sharpening test)")      , std::wstring()                                , std::wstring(L"SineSweepEffect.cso")         , CanvasEffectSineSweep };
+    GetTestPatternDesc(TestPattern::ToneMapSpike).resources      = TestPatternResources{ std::wstring(L"ST.2084 Spike (Tone map test)")             , std::wstring()                                , std::wstring(L"ToneSpikeEffect.cso")         , CanvasEffectToneSpike };
+    GetTestPatternDesc(TestPattern::OnePixelLinesBW).resources   = TestPatternResources{ std::wstring(L"Single pixel lines (black/white)")          , std::wstring(L"OnePixelLinesBW1200x700.png")  , std::wstring()                               , CanvasEffectNone };
+    GetTestPatternDesc(TestPattern::OnePixelLinesRG).resources   = TestPatternResources{ std::wstring(L"Single pixel lines (red/green)")            , std::wstring(L"OnePixelLinesRG1200x700.png")  , std::wstring()                               , CanvasEffectNone };
+    GetTestPatternDesc(TestPattern::TextQuality).resources       = TestPatternResources{ std::wstring(L"Antialiased text (ClearType and grayscale)"), std::wstring(L"CalibriBoth96Dpi.png")         , std::wstring()                               , CanvasEffectNone };
+}
+
+PatternGenerator::TestPatternDesc& PatternGenerator::GetTestPatternDesc(TestPattern test)
+{
+    return m_testPatterns[static_cast<size_t>(test)];
+}
+
+// Returns whether the reported display metadata consists of
+// default values generated by Windows.
+bool PatternGenerator::CheckForDefaults()
+{
+    return (
+        // Default SDR display values (RS2)
+        (270.0f == m_rawOutDesc.MaxLuminance &&
+         270.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.5f == m_rawOutDesc.MinLuminance) ||
+        // Default HDR display values (RS2)
+        (550.0f == m_rawOutDesc.MaxLuminance &&
+         450.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.5f == m_rawOutDesc.MinLuminance) ||
+        // Default HDR display values (RS3)
+        (1499.0f == m_rawOutDesc.MaxLuminance &&
+         799.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.01f == m_rawOutDesc.MinLuminance)
+        );
+}
+
+// Default to tier based on what the EDID specified
+PatternGenerator::TestingTier PatternGenerator::GetTestingTier()
+{
+#define SAFETY (0.970)
+         if (m_rawOutDesc.MaxLuminance >= SAFETY * 10000.0f)
+        return TestingTier::DisplayHDR10000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 6000.0f)
+        return TestingTier::DisplayHDR6000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 4000.0f)
+        return TestingTier::DisplayHDR4000;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 3000.0f)
+		return TestingTier::DisplayHDR3000;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 2000.0f)
+        return TestingTier::DisplayHDR2000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 1400.0f)
+        return TestingTier::DisplayHDR1400;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 1000.0f)
+        return TestingTier::DisplayHDR1000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 600.0f)
+        return TestingTier::DisplayHDR600;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 500.0f)
+			 return TestingTier::DisplayHDR500;
+	else
+        return TestingTier::DisplayHDR400;
+}
+
+const wchar_t* PatternGenerator::GetTierName(PatternGenerator::TestingTier tier)
+{
+         if (tier == DisplayHDR400)   return L"DisplayHDR400";
+	else if (tier == DisplayHDR500)   return L"DisplayHDR500";
+	else if (tier == DisplayHDR600)   return L"DisplayHDR600";
+	else if (tier == DisplayHDR1000)  return L"DisplayHDR1000";
+	else if (tier == DisplayHDR1400)  return L"DisplayHDR1400";
+    else if (tier == DisplayHDR2000)  return L"DisplayHDR2000";
+	else if (tier == DisplayHDR3000)  return L"DisplayHDR3000";
+	else if (tier == DisplayHDR4000)  return L"DisplayHDR4000";
+    else if (tier == DisplayHDR6000)  return L"DisplayHDR6000";
+    else if (tier == DisplayHDR10000) return L"DisplayHDR10000";
+    else return L"Unsupported DisplayHDR Tier";
+}
+
+float PatternGenerator::GetTierLuminance(PatternGenerator::TestingTier tier)
+{
+	     if (tier == DisplayHDR400)	  return  400.f;
+	else if (tier == DisplayHDR500)   return  500.f;
+	else if (tier == DisplayHDR600)   return  600.f;
+	else if (tier == DisplayHDR1000)  return  1015.27f;
+	else if (tier == DisplayHDR1400)  return  1400.f;
+	else if (tier == DisplayHDR2000)  return  2000.f;
+	else if (tier == DisplayHDR3000)  return  3000.f;
+	else if (tier == DisplayHDR4000)  return  4000.f;
+	else if (tier == DisplayHDR6000)  return  6000.f;
+	else if (tier == DisplayHDR10000) return 10000.f;
+	else return -1.0f;
+}
+
+void PatternGenerator::InitEffectiveValues()
+{
+	if (m_maxEffectivePQValue < 0.0)
+	{
+		float val = (float)NitsToPQ10Code(m_rawOutDesc.MaxLuminance);
+		m_maxEffectivePQValue = val - 5.0f;
+	}
+	if (m_maxFullFramePQValue < 0.0)
+	{
+		float val = (float)NitsToPQ10Code(m_rawOutDesc.MaxFullFrameLuminance);
+		m_maxFullFramePQValue = val - 5.0f;
+	}
+	if (m_minEffectivePQValue < 0.0)
+	{
+		float val = (float)NitsToPQ10Code(m_rawOutDesc.MinLuminance);
+		m_minEffectivePQValue = val + 5.0f;
+	}
+
+	if (m_maxEffectivesRGBValue < 0.0)
+	{
+		float val = 255;
+		m_maxEffectivesRGBValue = val - 5.0f;
+	}
+	if (m_maxFullFramesRGBValue < 0.0)
+	{
+		float val = 255;
+		m_maxFullFramesRGBValue = val - 5.0f;
+	}
+	if (m_minEffectivesRGBValue < 0.0)
+	{
+		float val = 10;
+		m_minEffectivesRGBValue = val + 5.0f;
+	}
+}
+
+void PatternGenerator::UpdateTestPattern_PanelCharacteristics(float)
+{
+	// the panel's values are shown live; SetDisplay flags them if they change
+	if (m_host)
+		m_host->RefreshDisplay();
+
+	// the gamut numbers have come in from the worker thread
+	if (m_gamutPending && !m_gamutCache->IsComputing())
+		m_contentChanged = true;
+}
+
+// Tests 1., 3. and the warm up run for 30 minutes.
+void PatternGenerator::UpdateTestPattern_Countdown(float elapsedSeconds)
+{
+    if (m_newTestSelected)
+    {
+        m_testTimeRemainingSec = 1800.0f;		// 30 minutes
+    }
+    else
+    {
+        m_testTimeRemainingSec -= elapsedSeconds;
+        m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+    }
+}
+
+void PatternGenerator::UpdateTestPattern_Cooldown(float elapsedSeconds)
+{
+    if (m_newTestSelected)
+    {
+        m_testTimeRemainingSec = 60.0f;		// One minute
+    }
+    else
+    {
+        m_testTimeRemainingSec -= elapsedSeconds;
+        m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+    }
+    if (m_testTimeRemainingSec <= 0.0f)
+        SetTestPattern(m_cachedTest);
+}
+
+void PatternGenerator::UpdateTestPattern_FlashTest(float elapsedSeconds)
+{
+    if (m_newTestSelected)
+    {
+        m_testTimeRemainingSec = 4.0f; // 4 seconds
+        m_flashOn = false;
+    }
+    else
+    {
+        // TODO make this show 10ths of a second.
+        m_testTimeRemainingSec -= elapsedSeconds;
+        m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+        if (m_testTimeRemainingSec <= 0.0001)
+        {
+            if (!m_flashOn)
+            {
+                m_flashOn = true;
+                m_testTimeRemainingSec = 2;
+            }
+            else if (m_flashOn)
+            {
+                m_flashOn = false;
+                m_testTimeRemainingSec = 10;
+            }
+        }
+    }
+}
+
+void PatternGenerator::UpdateTestPattern_RiseFallTime(float elapsedSeconds)
+{
+	if (m_newTestSelected)
+	{
+		m_testTimeRemainingSec = 3.0f;
+	}
+	else
+	{
+		m_testTimeRemainingSec -= elapsedSeconds;
+		m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+		if (m_testTimeRemainingSec <= 0.0001)
+		{
+			if (!m_flashOn)
+			{
+				m_flashOn = true;
+				m_testTimeRemainingSec = 5;
+			}
+			else if (m_flashOn)
+			{
+				m_flashOn = false;
+				m_testTimeRemainingSec = 5;
+			}
+		}
+	}
+}
+
+void PatternGenerator::UpdateTestPattern_XRiteColors(float elapsedSeconds)
+{
+	if (m_newTestSelected)
+	{
+		m_testTimeRemainingSec = m_XRitePatchDisplayTime;
+		m_XRitePatchAutoMode = false;           // v1.5 flag for when it auto animates
+	}
+	else
+	{
+		if (m_XRitePatchAutoMode)
+		{
+			m_testTimeRemainingSec -= elapsedSeconds;
+			if (m_testTimeRemainingSec < 0.f)
+			{
+				m_currentXRiteIndex += 1;
+				m_currentXRiteIndex = (int)wrap((float)m_currentXRiteIndex, 0.f, NUMXRITECOLORS);	// Just wrap on each end <inclusive!>
+				m_testTimeRemainingSec += m_XRitePatchDisplayTime;					// extend timer by one period
+				m_contentChanged = true;
+			}
+		}
+	}
+}
+
+void PatternGenerator::UpdateTestPattern_BitDepthPrecision(float)
+{
+    // TODO: How exactly are we choosing this to correspond with expected banding?
+    // We don't know what internal EOTF is being used by the display, so how
+    // do we draw a ruler that matches with anything but sRGB?
+    m_gradientStops[1].color = D2D1::ColorF(0.25f, 0.25f, 0.25f);
+}
+
+void PatternGenerator::UpdateTestPattern_StaticGradient(float)
+{
+    m_gradientStops[1].color = m_gradientColor;
+}
+
+void PatternGenerator::UpdateTestPattern_AnimatedGrayGradient(float)
+{
+    // Color channels vary between 0.0 and 2 * m_gradientEndPoint.
+    m_gradientStops[1].color = D2D1::ColorF(
+        m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase,
+        m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase,
+        m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase);
+}
+
+void PatternGenerator::UpdateTestPattern_AnimatedColorGradient(float)
+{
+    // Color channels vary between 0.0 and 2 * m_gradientEndPoint.
+    m_gradientStops[1].color = D2D1::ColorF(
+        m_gradientAnimationBase * sin(m_totalTime * 2.0f) + m_gradientAnimationBase,
+        m_gradientAnimationBase * sin(m_totalTime * 1.0f) + m_gradientAnimationBase,
+        m_gradientAnimationBase * sin(m_totalTime * 0.5f) + m_gradientAnimationBase);
+}
+
+// reset metadata to default state (same as panel properties) so it need do no tone mapping
+// Note: OS does this on boot and on app exit.
+void PatternGenerator::SetMetadataNeutral()
+{
+
+    m_Metadata.MaxContentLightLevel      = static_cast<uint16_t>(m_rawOutDesc.MaxLuminance);
+    m_Metadata.MaxFrameAverageLightLevel = static_cast<uint16_t>(m_rawOutDesc.MaxFullFrameLuminance);
+    m_Metadata.MaxMasteringLuminance     = static_cast<unsigned int>(m_rawOutDesc.MaxLuminance);
+    m_Metadata.MinMasteringLuminance     = static_cast<unsigned int>(m_rawOutDesc.MinLuminance * 10000.0f);
+
+	m_MetadataGamut = ColorGamut::GAMUT_Native;
+	m_Metadata.RedPrimary[0]  = static_cast<uint16_t>(m_outputDesc.RedPrimary[0]   * 50000.0f);
+    m_Metadata.RedPrimary[1]  = static_cast<uint16_t>(m_outputDesc.RedPrimary[1]   * 50000.0f);
+    m_Metadata.GreenPrimary[0]= static_cast<uint16_t>(m_outputDesc.GreenPrimary[0] * 50000.0f);
+    m_Metadata.GreenPrimary[1]= static_cast<uint16_t>(m_outputDesc.GreenPrimary[1] * 50000.0f);
+    m_Metadata.BluePrimary[0] = static_cast<uint16_t>(m_outputDesc.BluePrimary[0]  * 50000.0f);
+    m_Metadata.BluePrimary[1] = static_cast<uint16_t>(m_outputDesc.BluePrimary[1]  * 50000.0f);
+    m_Metadata.WhitePoint[0]  = static_cast<uint16_t>(m_outputDesc.WhitePoint[0]   * 50000.0f);
+    m_Metadata.WhitePoint[1]  = static_cast<uint16_t>(m_outputDesc.WhitePoint[1]   * 50000.0f);
+
+    if (m_host)
+        m_host->SetHDRMetadata(m_Metadata);
+}
+
+void PatternGenerator::SetMetadata(float max, float avg, ColorGamut gamut)
+{
+    m_Metadata.MaxContentLightLevel = static_cast<uint16_t>(max);
+    m_Metadata.MaxFrameAverageLightLevel = static_cast<uint16_t>(avg);
+    m_Metadata.MaxMasteringLuminance = static_cast<unsigned int>(max);
+    m_Metadata.MinMasteringLuminance = static_cast<unsigned int>(0.0 * 10000.0f);
+
+    switch (gamut)
+    {
+    case GAMUT_Native:
+		m_MetadataGamut = ColorGamut::GAMUT_Native;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(m_outputDesc.RedPrimary[0]   * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(m_outputDesc.RedPrimary[1]   * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(m_outputDesc.GreenPrimary[0] * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(m_outputDesc.GreenPrimary[1] * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(m_outputDesc.BluePrimary[0]  * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(m_outputDesc.BluePrimary[1]  * 50000.0f);
+		break;
+    case GAMUT_sRGB:
+		m_MetadataGamut = ColorGamut::GAMUT_sRGB;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_709.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_709.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_709.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_709.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_709.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_709.y * 50000.0f);
+        break;
+    case GAMUT_Adobe:
+		m_MetadataGamut = ColorGamut::GAMUT_Adobe;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_Adobe.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_Adobe.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_Adobe.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_Adobe.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_Adobe.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_Adobe.y * 50000.0f);
+		break;
+    case GAMUT_DCIP3:
+		m_MetadataGamut = ColorGamut::GAMUT_DCIP3;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_DCIP3.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_DCIP3.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_DCIP3.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_DCIP3.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_DCIP3.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_DCIP3.y * 50000.0f);
+		break;
+    case GAMUT_BT2100:
+		m_MetadataGamut = ColorGamut::GAMUT_BT2100;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_2020.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_2020.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_2020.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_2020.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_2020.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_2020.y * 50000.0f);
+		break;
+    }
+
+    m_Metadata.WhitePoint[0] = static_cast<uint16_t>(D6500White.x * 50000.0f);
+    m_Metadata.WhitePoint[1] = static_cast<uint16_t>(D6500White.y * 50000.0f);
+
+    if (m_host)
+        m_host->SetHDRMetadata(m_Metadata);
+}
+
+// dump out the metadata to a string for display
+void PatternGenerator::PrintMetadata( PatternCanvas* ctx, bool blackText /* = false */ )
+{
+	std::wstringstream text;
+	// print luminance levels
+	text << "MaxCLL: ";
+	text << std::to_wstring((int)m_Metadata.MaxContentLightLevel);
+	text << "  MaxFALL: ";
+	text << std::to_wstring((int)m_Metadata.MaxFrameAverageLightLevel);
+	text << "  MinCLL: ";
+	text << std::to_wstring(m_Metadata.MinMasteringLuminance / 10000.0f);
+
+	// print gamut in use
+	text << "  Gamut: ";
+	switch ( m_MetadataGamut )
+	{
+	case GAMUT_Native:
+		text << "Native\n";
+		break;
+	case GAMUT_sRGB:
+		text << "sRGB\n";
+		break;
+	case GAMUT_Adobe:
+		text << "Adobe\n";
+		break;
+	case GAMUT_DCIP3:
+		text << "DCI-P3\n";
+		break;
+	case GAMUT_BT2100:
+		text << "bt.2100\n";
+		break;
+	}
+
+	RenderText(ctx, CanvasFontLarge, text.str(), m_MetadataTextRect, blackText);
+}
+
+// dump out the metadata to a string for display
+void PatternGenerator::PrintTestingTier(PatternCanvas* ctx, bool blackText /* = false */)
+{
+	std::wstringstream text;
+	// print luminance levels
+
+	text << GetTierName(m_testingTier);
+
+	RenderText(ctx, CanvasFontLarge, text.str(), m_TestingTierTextRect, blackText);
+}
+
+void PatternGenerator::GenerateTestPattern_StartOfTest(PatternCanvas* ctx)
+{
+    std::wstringstream text;
+
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    text << m_appTitle;
+    text << L"\n\nVersion 1.2\n\n";
+    //text << L"ALT-ENTER: Toggle fullscreen: all measurements should be made in fullscreen\n";
+	text << L"->, PAGE DN:       Move to next test\n";
+	text << L"<-, PAGE UP:        Move to previous test\n";
+    text << L"NUMBER KEY:	Jump to test number (shift for 1.2 tests)\n";
+    text << L"SPACE:		Hide text and target circle\n";
+    text << L"C:		Start 60s cool-down\n";
+    text << L"ALT-ENTER:	Toggle fullscreen\n";
+    text << L"ESCAPE:		Exit fullscreen\n";
+    text << L"ALT-F4:		Exit app\n";
+    text << L"\nCopyright \u00A9 VESA\nLast updated: " << __DATE__;
+    text << L"\nIncludes Portrait X-Rite\u2122 color technology\n";
+
+    RenderText(ctx, CanvasFontLarge, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream title;
+        title << L"Home.   Start Screen\n" << m_hideTextString;
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+    }
+    m_newTestSelected = false;
+
+}
+
+bool PatternGenerator::CheckHDR_On()
+{
+	// TODO this should query an HDR bit if one is available
+	bool HDR_On = false;
+	switch (m_outputDesc.ColorSpace)
+	{
+	case OutputColorSpaceSRGB: // sRGB
+		break;
+
+	case OutputColorSpaceHDR10: // HDR10 PC
+		HDR_On = true;
+		break;
+
+	default:
+		break;
+	}
+
+	return HDR_On;
+}
+
+void PatternGenerator::GenerateTestPattern_ConnectionProperties(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+
+	text << L"Render GPU: ";
+	text << m_adapterName;
+
+	text << L"\nMonitor: ";
+	text << m_monitorName;
+
+	text << L"\nDisplay: ";
+	const wchar_t* DisplayName = wcsrchr(m_outputDesc.DeviceName, '\\');
+	text << (DisplayName ? DisplayName + 1 : m_outputDesc.DeviceName);
+
+	text << L"\nConnector: ";
+	text << m_connectorName;
+
+    text << L"\n\nConnection colorspace: [";
+	text << std::to_wstring(m_outputDesc.ColorSpace);
+	switch (m_outputDesc.ColorSpace)
+	{
+	case OutputColorSpaceSRGB: // sRGB
+		text << L"] sRGB/SDR";
+		break;
+
+	case OutputColorSpaceHDR10: // HDR10 PC
+		text << L"] HDR/advanced color ON";
+		break;
+	default:
+		text << L"] Unknown";
+		break;
+	}
+
+	text << "\nResolution: " << m_modeWidth << " x " << m_modeHeight;
+	text << " x " << std::to_wstring(m_outputDesc.BitsPerColor) << L"bits @ ";
+	text << m_displayFrequency << L"Hz\n";
+
+    bool HDR_On = CheckHDR_On();
+
+	if (!HDR_On)
+    {
+        text << L"\nBefore starting tests, make sure \"HDR and Advanced color\"";
+        text << L"\n is enabled in the Display settings panel.";
+    }
+
+#if 0		// these values are useful for HGIG, but not really for DisplayHDR
+	// display properties of any tone mapper applied as determined from manual calibration screens
+	if ( HDR_On )
+	{
+		text << L"\n\nSupported PQ Values - ";
+		text << L"\nMax Effective Value: ";
+		text << std::to_wstring((int)m_maxEffectivePQValue);
+		text << L" (";
+		text << std::to_wstring(PQ10CodeToNits(PQ10ClampCode(m_maxEffectivePQValue)));
+		text << L" nits)";
+
+		text << L"\nMax FullFrame Value: ";
+		text << std::to_wstring((int)m_maxFullFramePQValue);
+		text << L" (";
+		text << std::to_wstring(PQ10CodeToNits(PQ10ClampCode(m_maxFullFramePQValue)));
+		text << L" nits)";
+
+		text << L"\nMin Effective Value: ";
+		text << std::to_wstring((int)m_minEffectivePQValue);
+		text << L" (  ";
+		text << std::to_wstring(PQ10CodeToNits(PQ10ClampCode(m_minEffectivePQValue)));
+		text << L" nits)";
+	}
+	else
+	{
+		text << L"\n\nSupported sRGB Values - ";
+		text << L"\nMax Effective Value: ";
+		text << std::to_wstring((int)m_maxEffectivesRGBValue);
+		text << L" (";
+		text << std::to_wstring(RemoveSRGBCurve(m_maxEffectivesRGBValue/255.0f)*80.0f);
+		text << L" nits)";
+
+		text << L"\nMax FullFrame Value: ";
+		text << std::to_wstring((int)m_maxFullFramesRGBValue);
+		text << L" (";
+		text << std::to_wstring(RemoveSRGBCurve(m_maxFullFramesRGBValue/255.0f)*80.0f);
+		text << L" nits)";
+
+		text << L"\nMin Effective Value: ";
+		text << std::to_wstring((int)m_minEffectivesRGBValue);
+		text << L" (  ";
+		text << std::to_wstring(RemoveSRGBCurve(m_minEffectivesRGBValue/255.0f)*80.0f);
+		text << L" nits)";
+	}
+#endif
+
+    RenderText(ctx, CanvasFontMonospace, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Connection properties:\nPress SPACE to hide this text\n";
+        RenderText(ctx, CanvasFontLarge, title, m_testTitleRect);
+    }
+
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_PanelCharacteristics(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+	text << fixed << setw(9) << setprecision(2);
+
+	// TODO: ensure these values are up to date.
+	if (CheckForDefaults())
+	{
+		text << L"***WARNING: These are OS-provided defaults. Display did not provide any data.***\n";
+	}
+	// else
+	{
+		text << L"\nHDR Testing Tier: " << GetTierName(m_testingTier);
+		text << L" - Change using Up/Down Arrow Keys" << L"\n";
+	}
+	
+	
+	//	text << m_outputDesc.DeviceName;
+
+	text << L"\nBase Levels: (nits)";
+    text << L"\n  Max peak luminance:          ";
+	text << setprecision(0);
+    text << m_rawOutDesc.MaxLuminance;
+    text << L".\n  Max frame-average luminance: ";
+    text << m_rawOutDesc.MaxFullFrameLuminance;
+	text << L".\n  Min luminance:                 ";
+	text << setprecision(4);
+	text << m_rawOutDesc.MinLuminance;
+	text << L"\nAdjusted Levels: (nits)";
+	text << L"\n  Max peak luminance:          ";
+	text << setprecision(0);
+	text << m_outputDesc.MaxLuminance;
+	text << L".\n  Max frame-average luminance: ";
+	text << m_outputDesc.MaxFullFrameLuminance;
+	text << L".\n  Min luminance:                 ";
+	text << setprecision(4);
+	text << m_outputDesc.MinLuminance;
+	text << L"\nCurr. Brightness Slider Factor:  ";
+	text << setprecision(2);
+	text << BRIGHTNESS_SLIDER_FACTOR;
+
+//  text << L"\nContrast ratio (peak/min):   ";
+//  text << std::to_wstring(m_outputDesc.MaxLuminance / m_outputDesc.MinLuminance );
+    text << L"\n";
+
+    // Compute area of this device's gamut in uv coordinates
+
+    // first, get primaries of display in 1931 xy coordinates
+    float2 red_xy, grn_xy, blu_xy, wht_xy;
+    red_xy = m_outputDesc.RedPrimary;
+    grn_xy = m_outputDesc.GreenPrimary;
+    blu_xy = m_outputDesc.BluePrimary;
+    wht_xy = m_outputDesc.WhitePoint;
+
+	text << L"\nCIE 1931          x         y";
+    text << L"\nRed Primary  :  " << std::to_wstring(red_xy.x) << L"  " << std::to_wstring(red_xy.y);
+    text << L"\nGreen Primary:  " << std::to_wstring(grn_xy.x) << L"  " << std::to_wstring(grn_xy.y);
+    text << L"\nBlue Primary :  " << std::to_wstring(blu_xy.x) << L"  " << std::to_wstring(blu_xy.y);
+    text << L"\nWhite Point  :  " << std::to_wstring(wht_xy.x) << L"  " << std::to_wstring(wht_xy.y);
+
+    // the volumes take a while, so new primaries show as pending until the cache has them
+    GamutMetrics gamut = {};
+    if (m_offscreen)
+        gamut = m_gamutCache->Get(red_xy, grn_xy, blu_xy, wht_xy);
+    else
+        m_gamutPending = !m_gamutCache->TryGet(red_xy, grn_xy, blu_xy, wht_xy, gamut);
+    m_gamutVolume = gamut.volumeLab;
+
+    float gamutAreaDevice = gamut.area;
+
+    // rec.709/sRGB gamut area in uv coordinates
+    float gamutAreasRGB = ComputeGamutArea(primaryR_709, primaryG_709, primaryB_709);
+
+    // AdobeRGB gamut area in uv coordinates
+    float GamutAreaAdobe = ComputeGamutArea(primaryR_Adobe, primaryG_Adobe, primaryB_Adobe);
+
+    // DCI-P3 gamut area in uv coordinates
+    float gamutAreaDCIP3 = ComputeGamutArea(primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3);
+
+    // BT.2020 gamut area in uv coordinates
+    float gamutAreaBT2100 = ComputeGamutArea(primaryR_2020, primaryG_2020, primaryB_2020);
+
+    // ACES gamut area in uv coordinates
+    float gamutAreaACES = ComputeGamutArea(primaryR_ACES, primaryG_ACES, primaryB_ACES);
+
+    const float gamutAreaHuman = 0.195f;	// TODO get this actual data!
+
+    // Compute extent that this device gamut covers known popular ones:
+    float coverageSRGB  = gamut.coverage709;
+    float coverageAdobe = gamut.coverageAdobe;
+    float coverageDCIP3 = gamut.coverageDCIP3;
+    float coverage2100  = gamut.coverage2020;
+    float coverageACES  = gamut.coverageACES;
+
+    // display coverage values
+    text << L"\n\nGamut Coverage based on reported primaries";
+    if (m_gamutPending)
+    {
+        text << L"\n   computing...";
+    }
+    else
+    {
+        text << L"\n        % sRGB : " << std::to_wstring(coverageSRGB*100.f);
+        text << L"\n    % AdobeRGB : " << std::to_wstring(coverageAdobe*100.f);
+        text << L"\n      % DCI-P3 : " << std::to_wstring(coverageDCIP3*100.f);
+        text << L"\n     % BT.2100 : " << std::to_wstring(coverage2100*100.f);
+        text << L"\n   % Human eye : " << std::to_wstring(gamutAreaDevice / gamutAreaHuman*100.f);
+
+        text << L"\n\nGamut Volume relative to BT.2100";
+        text << L"\n      % CIELAB : " << std::to_wstring(gamut.volumeLab / gamutVolumeLab2020*100.f);
+        text << L"\n      % CIELUV : " << std::to_wstring(gamut.volumeLuv / gamutVolumeLuv2020*100.f);
+    }
+
+    // test code:
+    float theory = gamutAreaDevice / gamutAreaBT2100;
+    //	text << L"\n     %  Theory : " << std::to_wstring( theory*100.f);
+    //	text << L"\n       % Error : " << std::to_wstring((coverage2100 - theory) / theory * 100.f);
+
+    RenderText(ctx, CanvasFontMonospace, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Reported Panel Characteristics\n" + m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, title, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+
+    // TODO should bail here if no valid data
+}
+
+void PatternGenerator::GenerateTestPattern_ResetInstructions(PatternCanvas* ctx)
+{
+	if (m_newTestSelected)
+	{
+
+		SetMetadataNeutral();
+
+// This works but we don't know what to set it to.
+// So it is commented out until we do
+//		setBrightnessSliderPercent(33);
+// EDID settings don't update afterwards anyway until next app run
+	}
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Start of performance tests\n" + m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, title, m_testTitleRect);
+    }
+    std::wstringstream text;
+    text << L"For external displays, use their OSD to reset\n";
+    text << L"all settings to the default or factory state.\n\n";
+
+	text << L"Set any OS \'Brightness\' slider to factor 1.0 on previous screen.\n";
+	text << L"Set the \'SDR color appearance\' slider to the leftmost point.\n";
+	text << L"DO NOT CHANGE BRIGHTNESS SLIDERS AFTER APP START.\n\n";
+
+	text << L"Be sure the \'Night light' setting is off.\n";
+
+	text << L"Disable any Ambient Light Sensor or Adaptive Color capability.\n\n";
+
+	text << L"The display should be at normal operating temperature.\n";
+    text << L"  -This can take as much as 30 minutes for some panels.\n";
+
+    text << L"  -Also note, ambient temperature may affect scores.\n\n";
+
+    text << L"Use the following screen to check correct brightness levels";
+
+    RenderText(ctx, CanvasFontLarge, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::DrawLogo(PatternCanvas* ctx, float c)
+{
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(0.10);  // dimension of a square of 10% screen area
+	size = size * 0.3333333f;
+
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+
+	D2D1_RECT_F centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare1, centerColor);
+
+	D2D1_RECT_F centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare2, centerColor);
+
+	D2D1_RECT_F centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare3, centerColor);
+
+	D2D1_RECT_F centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare4, centerColor);
+}
+
+void PatternGenerator::GenerateTestPattern_CalibrateMaxEffectiveValue(PatternCanvas* ctx) // Detect white crush (MaxTML)
+{
+	// outer box
+	float outerNits = m_outputDesc.MaxLuminance;
+	float avg = 600.0f;
+	if (m_newTestSelected) SetMetadata(outerNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(outerNits);
+
+	D2D1_COLOR_F outerColor;
+	outerColor = D2D1::ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(0.10);  // dimension of a square of 10% screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+	D2D1_RECT_F outerSquare =
+	{
+		center.x - size * 0.50f,
+		center.y - size * 0.50f,
+		center.x + size * 0.50f,
+		center.y + size * 0.50f
+	};
+
+	ctx->FillRectangle(&outerSquare, outerColor);
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PQ10CodeToNits(PQ10ClampCode(m_maxEffectivePQValue));
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = m_maxEffectivesRGBValue / 255.0f;
+		nits = RemoveSRGBCurve(c) * 80.0f;
+	}
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	size = size * 0.3333333f;
+	D2D1_RECT_F centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare1, centerColor);
+
+	D2D1_RECT_F centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare2, centerColor);
+
+	D2D1_RECT_F centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare3, centerColor);
+
+	D2D1_RECT_F centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare4, centerColor);
+
+	if( m_showExplanatoryText )
+	{
+		std::wstringstream title;
+		title << L"Calibrate Max Tone Mapped Luminance Value: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << PQ10ClampCode(m_maxEffectivePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_maxEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_CalibrateMaxFullFrameValue(PatternCanvas* ctx) // Verify MaxFALL (MaxFF TML)
+{
+	// set up background (clear full screen)
+	float backNits = m_outputDesc.MaxFullFrameLuminance;
+	float avg = backNits;
+	if (m_newTestSelected) SetMetadata(backNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(backNits);
+	D2D1_COLOR_F backColor;
+	backColor = D2D1::ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	ctx->FillRectangle(&logSize, backColor);
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PQ10CodeToNits(PQ10ClampCode(m_maxFullFramePQValue));
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = m_maxFullFramesRGBValue / 255.0f;
+		nits = RemoveSRGBCurve(c)*270.0f;
+	}
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	size = size * 0.333333333f;
+	size = size * 0.333333333f;
+	D2D1_RECT_F centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare1, centerColor);
+
+	D2D1_RECT_F centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(&centerSquare2, centerColor);
+
+	D2D1_RECT_F centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare3, centerColor);
+
+	D2D1_RECT_F centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(&centerSquare4, centerColor);
+
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << L"Calibrate Max Full Frame Luminance Value: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << PQ10ClampCode(m_maxFullFramePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_maxEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+
+	m_newTestSelected = false;
+
+}
+
+
+void PatternGenerator::GenerateTestPattern_CalibrateMinEffectiveValue(PatternCanvas* ctx) // Detect Black Crush
+{
+	// set up background
+	float backNits = 2.0f;
+	float avg = backNits*0.90f;
+	if (m_newTestSelected) SetMetadata(backNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(backNits);
+	D2D1_COLOR_F backColor;
+	backColor = D2D1::ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	ctx->FillRectangle(&logSize, backColor);
+
+	// draw 10% square in pure black
+	float outerNits = 0.0f;
+	c = nitstoCCCS(outerNits);
+	D2D1_COLOR_F outerColor;
+	outerColor = D2D1::ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size*sqrtf(0.10);  // dimension of a square of 10% screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+	D2D1_RECT_F outerSquare =
+	{
+		center.x - size*0.50f,
+		center.y - size*0.50f,
+		center.x + size*0.50f,
+		center.y + size*0.50f
+	};
+
+	ctx->FillRectangle(&outerSquare, outerColor);
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PQ10CodeToNits(PQ10ClampCode(m_minEffectivePQValue));
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = m_minEffectivesRGBValue / 255.0f;
+		nits = RemoveSRGBCurve(c)*80.0f;
+	}
+
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	size = size*0.3333333f;
+	D2D1_RECT_F centerSquare1 =
+	{
+		center.x - size*1.03f,
+		center.y - size*1.03f,
+		center.x - size*0.03f,
+		center.y - size*0.03f
+	};
+	ctx->FillRectangle(&centerSquare1, centerColor);
+
+	D2D1_RECT_F centerSquare2 =
+	{
+		center.x + size*0.03f,
+		center.y - size*1.03f,
+		center.x + size*1.03f,
+		center.y - size*0.03f
+	};
+	ctx->FillRectangle(&centerSquare2, centerColor);
+
+	D2D1_RECT_F centerSquare3 =
+	{
+		center.x - size*1.03f,
+		center.y + size*0.03f,
+		center.x - size*0.03f,
+		center.y + size*1.03f
+	};
+	ctx->FillRectangle(&centerSquare3, centerColor);
+
+	D2D1_RECT_F centerSquare4 =
+	{
+		center.x + size*0.03f,
+		center.y + size*0.03f,
+		center.x + size*1.03f,
+		center.y + size*1.03f
+	};
+	ctx->FillRectangle(&centerSquare4, centerColor);
+
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << L"Calibrate Min Tone-Mapped Luminance Level: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << PQ10ClampCode(m_minEffectivePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_minEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+}
+
+
+void PatternGenerator::GenerateTestPattern_PQLevelsInNits(PatternCanvas* ctx)		// 
+{
+
+
+    if (m_newTestSelected) SetMetadata(10000.0, 180.0, GAMUT_Native);
+
+    // Grayscale patches generated using the following table:
+    // PQ Code	Nits	CCCS
+    // 0		0		0.0f
+    // 153		1		0.0125f
+    // 192		2		0.025f
+    // 206		2.5		0.03125f
+    // 253		5		0.0625f
+    // 306		10		0.125f
+    // 364		20		0.25f
+    // 428		40		0.5f
+    // 496		80		1.0f
+    // 567		160		2.0f
+    // 641		320		4.0f
+    // 719		640		8.0f
+    // 767		1000	12.5f
+    // 844		2000	25.0f
+    // 920		4000	50.0f
+    // 1023		10000	125.0f
+    // (PQ code values are not exact, reference is nits).
+
+    D2D1_COLOR_F nits0, nits1, nits2, nits2_5, nits5, nits10, nits20, nits40, nits80;
+    D2D1_COLOR_F nits160, nits320, nits640, nits1000, nits2000, nits4000, nits10000;
+
+	float c = 0.f;
+    nits0 = D2D1::ColorF(c,c,c);
+	c = 0.0125f / BRIGHTNESS_SLIDER_FACTOR;
+    nits1 = D2D1::ColorF(c,c,c);
+	c = 0.025f / BRIGHTNESS_SLIDER_FACTOR;
+    nits2 = D2D1::ColorF(c,c,c);
+	c = 0.03125f / BRIGHTNESS_SLIDER_FACTOR;
+	nits2_5 = D2D1::ColorF(c,c,c);
+	c = 0.0625f / BRIGHTNESS_SLIDER_FACTOR;
+	nits5 = D2D1::ColorF(c,c,c);
+	c = 0.125f / BRIGHTNESS_SLIDER_FACTOR;
+	nits10 = D2D1::ColorF(c,c,c);
+	c = 0.25f / BRIGHTNESS_SLIDER_FACTOR;
+	nits20 = D2D1::ColorF(c,c,c);
+	c = 0.5f / BRIGHTNESS_SLIDER_FACTOR;
+	nits40 = D2D1::ColorF(c,c,c);
+	c = 1.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits80 = D2D1::ColorF(c,c,c);
+	c = 2.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits160 = D2D1::ColorF(c,c,c);
+	c = 4.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits320 = D2D1::ColorF(c,c,c);
+	c = 8.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits640 = D2D1::ColorF(c,c,c);
+	c = 12.5f / BRIGHTNESS_SLIDER_FACTOR;
+	nits1000 = D2D1::ColorF(c,c,c);
+	c = 25.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits2000 = D2D1::ColorF(c,c,c);
+	c = 50.0f / BRIGHTNESS_SLIDER_FACTOR;
+	nits4000 = D2D1::ColorF(c,c,c);
+	c = 125.f / BRIGHTNESS_SLIDER_FACTOR;
+	nits10000 = D2D1::ColorF(c,c,c);
+
+    // We only render small patches of each color to limit power consumption.
+    auto rect = ctx->GetLogicalSize();
+    auto w = (rect.right - rect.left) / 4.0f; // Divide screen in 4x4 grid.
+    auto h = (rect.bottom - rect.top) / 4.0f;
+    auto w1 = w * 0.2f; // Left/top edge of each patch offset.
+    auto h1 = h * 0.2f;
+    auto w2 = w * 0.8f; // Right/bottom edge of each patch offset.
+    auto h2 = h * 0.8f;
+
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 0.0f + h1, w * 0.0f + w2, h * 0.0f + h2), nits0);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 0.0f + h1, w * 1.0f + w2, h * 0.0f + h2), nits1);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 0.0f + h1, w * 2.0f + w2, h * 0.0f + h2), nits2);
+    ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 0.0f + h1, w * 3.0f + w2, h * 0.0f + h2), nits2_5);
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 1.0f + h1, w * 0.0f + w2, h * 1.0f + h2), nits5);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 1.0f + h1, w * 1.0f + w2, h * 1.0f + h2), nits10);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 1.0f + h1, w * 2.0f + w2, h * 1.0f + h2), nits20);
+    ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 1.0f + h1, w * 3.0f + w2, h * 1.0f + h2), nits40);
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 2.0f + h1, w * 0.0f + w2, h * 2.0f + h2), nits80);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 2.0f + h1, w * 1.0f + w2, h * 2.0f + h2), nits160);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 2.0f + h1, w * 2.0f + w2, h * 2.0f + h2), nits320);
+    ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 2.0f + h1, w * 3.0f + w2, h * 2.0f + h2), nits640);
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 3.0f + h1, w * 0.0f + w2, h * 3.0f + h2), nits1000);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 3.0f + h1, w * 1.0f + w2, h * 3.0f + h2), nits2000);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 3.0f + h1, w * 2.0f + w2, h * 3.0f + h2), nits4000);
+    ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 3.0f + h1, w * 3.0f + w2, h * 3.0f + h2), nits10000);
+
+    if (m_showExplanatoryText)
+    {
+
+        RenderText(ctx, CanvasFontLarge, L"PQ:0    Nits:0    ", { w * 0.0f + w1, h * 1.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:153  Nits:1    ", { w * 1.0f + w1, h * 1.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:193  Nits:2    ", { w * 2.0f + w1, h * 1.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:206  Nits:2.5  ", { w * 3.0f + w1, h * 1.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:254  Nits:5    ", { w * 0.0f + w1, h * 2.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:307  Nits:10   ", { w * 1.0f + w1, h * 2.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:366  Nits:20   ", { w * 2.0f + w1, h * 2.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:429  Nits:40   ", { w * 3.0f + w1, h * 2.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:497  Nits:80   ", { w * 0.0f + w1, h * 3.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:568  Nits:160  ", { w * 1.0f + w1, h * 3.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:643  Nits:320  ", { w * 2.0f + w1, h * 3.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:719  Nits:640  ", { w * 3.0f + w1, h * 3.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:767  nits:1000 ", { w * 0.0f + w1, h * 4.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:844  nits:2000 ", { w * 1.0f + w1, h * 4.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:920  nits:4000 ", { w * 2.0f + w1, h * 4.0f - h1, 200.0f, 30.0f });
+        RenderText(ctx, CanvasFontLarge, L"PQ:1023 nits:10000", { w * 3.0f + w1, h * 4.0f - h1, 250.0f, 30.0f });
+
+        std::wstring title = L"PQ/ST 2084 levels in nits\n" + m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, title, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_WarmUp(PatternCanvas* ctx)
+{
+    float nits = 180.0f; // warm up level
+    if (m_newTestSelected) SetMetadata(nits, nits, GAMUT_Native);
+    float c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+    D2D1_COLOR_F peakColor;
+    peakColor = D2D1::ColorF(c, c, c);
+
+    auto logSize = ctx->GetLogicalSize();
+    ctx->FillRectangle(&logSize, peakColor);
+
+    if (m_showExplanatoryText)
+    {
+        // the countdown runs in hundredths, so the title is drawn live over the recording
+        ctx->DrawLive([=](PatternCanvas* target)
+        {
+            std::wstringstream title;
+            title << L"Warm-Up: ";
+            title << fixed << setw(8) << setprecision(2);
+            if (0.0f != m_testTimeRemainingSec)
+            {
+                title << m_testTimeRemainingSec;
+                title << L" seconds remaining";
+                title << L"\nNits: ";
+                title << nits;
+                title << L"  HDR10: ";
+                title << setprecision(0);
+                title << NitsToPQ10Code(c * 80.f);
+                title << L"\n" << m_hideTextString;
+            }
+            else
+            {
+                title << L" done.";
+            }
+
+            RenderText(target, CanvasFontLarge, title.str(), m_testTitleRect, true);
+        });
+
+		PrintMetadata(ctx, true);
+    }
+    m_newTestSelected = false;
+}
+
+// this is invoked via the C key
+// it just draws a black screen for 60seconds.
+void PatternGenerator::GenerateTestPattern_Cooldown(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+        title << L"Cool-down: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+#define randf()((float)rand()/(float(RAND_MAX)+1.0f))
+static float randf_s()
+{
+	static thread_local std::minstd_rand engine(std::random_device{}());
+	return std::uniform_real_distribution<float>(0.f, 1.f)(engine);
+}
+
+#define JITTER_RADIUS 10.0f		// not applied offscreen, so exported frames are repeatable
+
+// The center patch of the patch tests, moved a few DIPs every frame so the panel cannot tell
+// it is static.  Patterns draw it through DrawLive, so the rest of them is recorded once.
+void PatternGenerator::FillJitteredPatch(PatternCanvas* ctx, float2 center, float size, D2D1_COLOR_F color)
+{
+	float2 jitter;
+	float radius = m_offscreen ? 0.f : JITTER_RADIUS * ctx->GetDpi() / 96.0f;
+	do {
+		jitter.x = radius * (randf_s() * 2.f - 1.f);
+		jitter.y = radius * (randf_s() * 2.f - 1.f);
+	} while ((jitter.x * jitter.x + jitter.y * jitter.y) > radius);
+
+	// Apply jitter
+	center = center + jitter;
+
+	D2D1_RECT_F rect =
+	{
+		center.x - size * 0.50f,
+		center.y - size * 0.50f,
+		center.x + size * 0.50f,
+		center.y + size * 0.50f
+	};
+	ctx->FillRectangle(&rect, color);
+}
+void PatternGenerator::GenerateTestPattern_TenPercentPeak(PatternCanvas* ctx) //********************** 1.a
+{
+	float patchPct = PATCHPCT;			// patch percentage of screen area
+	auto logSize = ctx->GetLogicalSize();
+	std::wstringstream title;
+
+	// "tone map" PQ limit of 10k nits down to panel maxLuminance in CCCS
+	float nits = m_outputDesc.MaxLuminance;
+	float avg = nits*patchPct + TARGETAPL/(1.f - PATCHPCT)*80.f;
+	if (m_newTestSelected) {
+		SetMetadata(nits, avg, GAMUT_Native);
+	}
+
+#ifdef NOISE
+	// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		float TierMaxLum = GetTierLuminance(m_testingTier);
+		float APL = TierMaxLum * TARGETAPL/(1.f - PATCHPCT);							// convert to nits based on current tier
+		float limit = 100.0f;
+		float time = m_totalTime;									// animate with the clock
+		if (m_bPaused) time = 0;									// unless paused so we fix it at 0.0
+
+		// ******* Arguments to this call are not type checked  *********
+		// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+		ctx->SetEffectValue(rsc.canvasEffect, L"APL", APL );		// ****** MUST BE FLOAT!	// in nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );								// nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );									// seconds
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+#else
+	// draw a starfield background
+	DrawStarfield(ctx, min(nits, 100.f));						// clamp nits to max of 100
+#endif
+
+	// draw the center rectangle
+	float c;
+    c = nitstoCCCS(nits);
+    D2D1_COLOR_F centerColor;
+    centerColor = D2D1::ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	float dpi = ctx->GetDpi();
+
+	// the patch jitters every frame, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, centerColor); });
+
+    if (m_showExplanatoryText)
+    {
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 40mm -> inches -> dips
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 1 );
+
+		// the title shows the countdown, so it is drawn live too
+		ctx->DrawLive([=](PatternCanvas* target)
+		{
+			std::wstringstream title;
+			title << fixed << setw(8) << setprecision(2);
+			title << L"1.a Peak Luminance @ ";
+			title << patchPct*100.f << L"% screen area\nWait before taking measurements : ";
+			title << m_testTimeRemainingSec;
+			title << L" seconds remaining";
+			title << L"\nNits: ";
+			title << nits*BRIGHTNESS_SLIDER_FACTOR;
+			title << L"  HDR10: ";
+			title << setprecision(0);
+			title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+			title << L"\n - Change Tier using Up/Down arrow keys";
+			title << L"\n" << m_hideTextString;
+
+			RenderText(target, CanvasFontLarge, title.str(), m_testTitleRect);
+		});
+
+		PrintMetadata(ctx);
+		PrintTestingTier(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+// aka 1.b from v1.0
+void PatternGenerator::GenerateTestPattern_TenPercentPeakMAX(PatternCanvas* ctx) //**************** 1.MAX
+{
+    // MAX version uses 10,000 nits as peak
+    float nits = 10000.0f;		// max PQ value
+    float avg =   1000.0f;		// maxFALL
+
+	if (m_newTestSelected) {
+		SetMetadata(nits, avg, GAMUT_Native);
+	}
+
+	float c = nitstoCCCS(nits);
+
+	float dpi = ctx->GetDpi();
+    auto logSize = ctx->GetLogicalSize();
+	std::wstringstream title;
+
+#ifdef NOISE
+	// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		float TierMaxLum = GetTierLuminance(m_testingTier);
+		float APL = TierMaxLum * TARGETAPL / (1.f - PATCHPCT);								// convert to nits based on current tier
+		float limit = 400.0f;
+		float time = m_totalTime;								// animate with the clock
+		if (m_bPaused) time = 0;								// unless paused so we fix it at 0.0
+		// ******* Arguments to this call are not type checked  *********
+		// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+		ctx->SetEffectValue(rsc.canvasEffect, L"APL", APL);		// ****** MUST BE FLOAT! // average luminance in nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );						// nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );							// seconds
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+#else
+	// draw a starfield background
+	DrawStarfield(ctx, min(nits, 100.f));						// clamp nits to max of 100
+#endif
+
+	// draw the center white square of the correct intensity
+	D2D1_COLOR_F peakColor;
+	peakColor = D2D1::ColorF(c, c, c);
+
+	float patchPct = PATCHPCT;		// patch percentage of screen area
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	// the patch jitters every frame, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, peakColor); });
+
+    if (m_showExplanatoryText)
+    {
+//		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 40mm -> inches -> dips
+
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2 );
+
+		// the title shows the countdown, so it is drawn live too
+		std::wstring error = title.str();
+		ctx->DrawLive([=](PatternCanvas* target)
+		{
+			std::wstringstream title;
+			title << error;
+			title << fixed << setw(8) << setprecision(2);
+			title << L"1.b Peak Luminance MAX @ ";
+			title << patchPct*100.f << L"% screen area\nWait before taking measurements: ";
+			title << m_testTimeRemainingSec;
+			title << L" seconds remaining";
+			title << L"\nNits: ";
+			title << nits;
+			title << L"  HDR10: ";
+			title << setprecision(0);
+			title << NitsToPQ10Code(c * 80.f);
+			title << L"\n - Change Tier using Up/Down arrow keys";
+			title << L"\n" << m_hideTextString;
+
+			RenderText(target, CanvasFontLarge, title.str(), m_testTitleRect);
+		});
+
+		PrintMetadata(ctx);
+		PrintTestingTier(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_FlashTest(PatternCanvas* ctx) //************************** 2.a
+{
+
+    // We "tone map" down to the maxLuminance reported by panel
+    float nits = m_outputDesc.MaxLuminance;
+    float avg = nits * 0.1f;
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits);
+
+    D2D1_COLOR_F peakFFWhite, blackColor;
+    peakFFWhite = D2D1::ColorF(c, c, c);
+    blackColor = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    if (m_flashOn)
+    {
+        title << "2.a Flash Test On\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+    }
+    else
+    {
+        title << "2.a Flash Test Off\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), blackColor);
+    }
+
+    if (m_showExplanatoryText)
+    {
+        // TODO make this show 10ths of a second.
+        title << static_cast<unsigned int>(m_testTimeRemainingSec);
+        title << L" seconds remaining\nTests peak power throughput rendering at reported peak level";
+        title << L"\nNits: ";
+        title << nits*BRIGHTNESS_SLIDER_FACTOR;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, m_flashOn);
+
+		PrintMetadata(ctx, m_flashOn);
+	}
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_FlashTestMAX(PatternCanvas* ctx) //********************* 2.MAX
+{
+    // MAX version shoots for 10,000 nits
+    float nits = 10000.0f;		// Max PQ Value
+    float avg  =  1000.0f;		// MaxFALL
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits);
+
+    D2D1_COLOR_F peakFFWhite, blackColor;
+    peakFFWhite = D2D1::ColorF(c, c, c);
+    blackColor = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    if (m_flashOn)
+    {
+        title << "2.b MAX Flash Test On\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+    }
+    else
+    {
+        title << "2.b MAX Flash Test Off\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), blackColor);
+    }
+
+    if (m_showExplanatoryText)
+    {
+        // TODO make this show 10ths of a second.
+        title << static_cast<unsigned int>(m_testTimeRemainingSec);
+        title << L" seconds remaining\nTests peak power throughput rendering MAX PQ";
+        title << L"\nNits: ";
+        title << nits;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << NitsToPQ10Code(c * 80.f);
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, m_flashOn);
+
+		PrintMetadata(ctx, m_flashOn);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_LongDurationWhite(PatternCanvas* ctx) //******************* 3.
+{
+    float nits = m_outputDesc.MaxLuminance;
+    float avg = nits;								// Full frame means 100% of Max.
+    if (m_newTestSelected)
+		SetMetadata(nits, avg, GAMUT_Native);		// Effectively same as calling SetMetadataNeutral();
+    float c = nitstoCCCS(nits);						// This test is for MaxFALL
+
+    D2D1_COLOR_F peakFFWhite;
+    peakFFWhite = D2D1::ColorF(c, c, c);
+
+    ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"3.a Full-frame white for 30 minutes: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining\nTests cooling solution by rendering reported MaxFALL";
+            title << L"\nNits: ";
+            title << nits*BRIGHTNESS_SLIDER_FACTOR;
+            title << L"  HDR10: ";
+			title << setprecision(0);
+            title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+            title << L"\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_FullFramePeak(PatternCanvas* ctx)	//******************** 3.MAX
+{
+    // Renders 10,000 nits. This is 125.0f in CCCS or 1023 HDR10 PQ.
+    float nits = 10000.0f;
+    float avg  = 10000.0f;   // full frame
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+    D2D1_COLOR_F peakColor;
+    peakColor = D2D1::ColorF(c, c, c);
+
+	// fill entire screen
+    ctx->FillRectangle(ctx->GetLogicalSize(), peakColor);
+
+    if (m_showExplanatoryText)
+    {
+
+        //	D2D1_COLOR_F blackColor;
+        //	blackColor = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+        //	ctx->FillRectangle(m_testTitleRect, blackColor);
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"3.b Full-frame white for 30 minutes: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining";
+            title << L"\nRenders HDR10 max (10,000 nits)";
+            title << L"\nNits: ";
+            title << nits;
+            title << L"  HDR10: ";
+			title << setprecision(0);
+            title << 1023.f;
+            title << L"\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+// Original 4-corner box test from v1.0
+void PatternGenerator::GenerateTestPattern_BlackLevelHdrCorners(PatternCanvas* ctx) //**************** 4. legacy
+{
+	// Renders 10,000 nits. This is 125.0f CCCS or 1024 HDR10.
+	D2D1_COLOR_F cornerColor;
+
+	// Compute box intensity based on EDID
+	float nits = m_outputDesc.MaxLuminance; // set to value from EDID ("tone map")
+	if (nits > 600.0f)
+		nits = 600.0f;                      // clamp to max of 600.0 per spec (712)
+	if (nits < 400.0f)
+		nits = 400.0f;						// clamp to min of 400.0 per spec (668)
+
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float c = nitstoCCCS(nits);
+	cornerColor = D2D1::ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt(2.5f / 100.0f); // % screen area of each corner box
+
+	D2D1_RECT_F upperLeftRect =
+	{
+		(logSize.right - logSize.left) * 0.0f,
+		(logSize.bottom - logSize.top) * 0.0f,
+		(logSize.right - logSize.left) * fSize,
+		(logSize.bottom - logSize.top) * fSize
+	};
+
+
+	D2D1_RECT_F upperRightRect =
+	{
+		(logSize.right - logSize.left) * (1.0f - fSize),
+		(logSize.bottom - logSize.top) * 0.0f,
+		(logSize.right - logSize.left) * 1.0f,
+		(logSize.bottom - logSize.top) * fSize
+	};
+
+	D2D1_RECT_F lowerLeftRect =
+	{
+		(logSize.right - logSize.left) * 0.0f,
+		(logSize.bottom - logSize.top) * (1.0f - fSize),
+		(logSize.right - logSize.left) * fSize,
+		(logSize.bottom - logSize.top) * 1.0f
+	};
+
+	D2D1_RECT_F lowerRightRect =
+	{
+		(logSize.right - logSize.left) * (1.0f - fSize),
+		(logSize.bottom - logSize.top) * (1.0f - fSize),
+		(logSize.right - logSize.left) * 1.0f,
+		(logSize.bottom - logSize.top) * 1.0f
+	};
+
+	ctx->FillRectangle(&upperLeftRect, cornerColor);
+	ctx->FillRectangle(&upperRightRect, cornerColor);
+	ctx->FillRectangle(&lowerLeftRect, cornerColor);
+	ctx->FillRectangle(&lowerRightRect, cornerColor);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_RECT_F centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, m_whiteColor);
+#if 0
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad * 0.5f,
+			fRad * 0.5f
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+#endif
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for HDR black level\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		D2D1_RECT_F textRect = m_testTitleRect;
+		textRect.left = (logSize.right - logSize.left) * fSize;
+		RenderText(ctx, CanvasFontLarge, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#if 1
+void PatternGenerator::GenerateTestPattern_DualCornerBox(PatternCanvas* ctx)	//************************ 4.
+{
+	// Renders 10,000 nits. This is 125.0f CCCS or 1024 HDR10.
+	D2D1_COLOR_F cornerColor;
+
+	// Compute box intensity based on EDID
+	float nits = m_outputDesc.MaxLuminance; // set to value from EDID ("tone map")
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float c = nitstoCCCS(nits);
+	cornerColor = D2D1::ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.05f);  // 5% screen area corner box
+	D2D1_RECT_F upperRightRect =
+	{
+		logSize.right - fSize,
+		0.0f,
+		logSize.right,
+		fSize
+	};
+	ctx->FillRectangle(&upperRightRect, cornerColor);
+
+	D2D1_RECT_F lowerLeftRect =
+	{
+		0.0f,
+		logSize.bottom - fSize,
+		fSize,
+		logSize.bottom
+	};
+	ctx->FillRectangle(&lowerLeftRect, cornerColor);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float dpi = ctx->GetDpi();
+
+//		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.04f);	// 4% screen area colorimeter box
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for Total Contrast\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		D2D1_RECT_F textRect = m_testTitleRect;
+		RenderText(ctx, CanvasFontLarge, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#else
+/* How this should work:
+	select PQ codes for test from CTS doc
+	convert to nits for metadata
+	convert to CCCS color
+	be sure to scale this down so that brightness control has no effect.
+*/
+
+void PatternGenerator::GenerateTestPattern_DualCornerBox(PatternCanvas* ctx)	//************************ 4.
+{
+	// from CTS doc
+	unsigned int PQCode = 668;
+	if (m_testingTier > TestingTier::DisplayHDR400)
+		PQCode =712;
+
+	float nits = PQ10CodeToNits(PQCode);		// go to linear space
+
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+	// TODO: metadata needs to handle brightness slider factor
+
+	D2D1_COLOR_F cornerColor;
+	float c = nitstoCCCS(nits / BRIGHTNESS_SLIDER_FACTOR);		// scale by 80 and slider
+	cornerColor = D2D1::ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.05f );  // 5% screen area corner box
+	D2D1_RECT_F upperRightRect =
+	{
+		logSize.right - fSize,
+		0.0f,
+		logSize.right,
+		fSize
+	};
+	ctx->FillRectangle(&upperRightRect, cornerColor);
+
+	D2D1_RECT_F lowerLeftRect =
+	{
+		0.0f,
+		logSize.bottom - fSize,
+		fSize,
+		logSize.bottom
+	};
+	ctx->FillRectangle(&lowerLeftRect, cornerColor);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+		ctx->DrawEllipse( &ellipse, m_redColor);
+
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for Total Contrast\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << PQCode;
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		D2D1_RECT_F textRect = m_testTitleRect;
+		RenderText(ctx, CanvasFontLarge, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+#endif
+
+void PatternGenerator::DrawChecker6x4( PatternCanvas* ctx, float colorL, float colorR = -1.f)
+{
+	D2D1_COLOR_F whiteColor;			// the "white" color
+	D2D1_COLOR_F rightColor;			// the "white" color on right half of screen
+
+	//get the right white:
+	whiteColor = D2D1::ColorF(colorL, colorL, colorL);
+	if (colorR > 0)
+		rightColor = D2D1::ColorF(colorR, colorR, colorR);
+
+	// draw the "white" boxes on the black background
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	const int nCols = 6;
+	const int nRows = 4;
+	float width = (logSize.right - logSize.left);
+	float height = (logSize.bottom - logSize.top);
+
+	float2 step;
+	step.x = width / nCols;
+	step.y = height / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{  
+				D2D1_RECT_F rect =
+				{
+					iCol * step.x,
+					jRow * step.y,
+					(iCol + 1) * step.x,
+					(jRow + 1) * step.y
+				};
+				if ( ( iCol*step.x < (0.5f * width - 5.f) ) || (colorR < 0) )	// draw left half in other color if valid
+					ctx->FillRectangle(&rect, whiteColor);
+				else if (colorR >= 0)
+					ctx->FillRectangle(&rect, rightColor);
+			}
+		}
+	}
+
+	// add any cross-hairs needed:
+	if (m_showExplanatoryText)
+	{
+		float dpi = ctx->GetDpi();
+
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 40mm -> inches -> dips
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_ELLIPSE ellipse;
+		ellipse =
+		{
+			D2D1::Point2F(center.x + step.x * 0.5f, center.y + step.y * 0.5f),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2.2f );
+		ellipse =
+		{
+			D2D1::Point2F(center.x + step.x * 0.5f, center.y - step.y * 0.5f),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+		ellipse =
+		{
+			D2D1::Point2F(center.x - step.x * 0.5f, center.y - step.y * 0.5f),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2.2f );
+		ellipse =
+		{
+			D2D1::Point2F(center.x - step.x * 0.5f, center.y + step.y * 0.5f),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+
+		// draw crosshairs
+		ctx->DrawLine(
+			D2D1::Point2F(center.x - step.x, center.y - step.y * 0.5f),		// top horizontal line
+			D2D1::Point2F(center.x + step.x, center.y - step.y * 0.5f),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(center.x - step.x, center.y + step.y * 0.5f),		// bottom horizontal line
+			D2D1::Point2F(center.x + step.x, center.y + step.y * 0.5f),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(center.x - step.x*0.5f, center.y - step.y ),		// left vertical
+			D2D1::Point2F(center.x - step.x*0.5f, center.y + step.y ),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(center.x + step.x*0.5f, center.y - step.y ),		// right vertical
+			D2D1::Point2F(center.x + step.x*0.5f, center.y + step.y ),
+			m_redColor,
+			2
+		);
+
+
+	}
+}
+
+void PatternGenerator::DrawChecker4x3(PatternCanvas* ctx, float colorL, float colorR = -1.f)
+{
+	D2D1_COLOR_F whiteColor;			// the "white" color
+	D2D1_COLOR_F rightColor;			// the "white" color on right half of screen
+
+	//get the right white:
+	whiteColor = D2D1::ColorF(colorL, colorL, colorL);
+	if (colorR > 0)
+		rightColor = D2D1::ColorF(colorR, colorR, colorR);
+
+	// draw the "white" boxes on the black background
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	const int nCols = 4;
+	const int nRows = 3;
+	float width = (logSize.right - logSize.left);
+	float height = (logSize.bottom - logSize.top);
+
+	float centerWidth = roundf(0.48f * width * 2.f / 3.f);				// eqn 5-1 in DHDR 1.1 SCR VP235H App. A
+	float sideWidth = floorf(width / 2.f) - centerWidth;				// eqn 5-2
+	float edgeHeight = floorf(0.26f * height);						// eqn 5-3
+	float centerHeight = height - 2.f * edgeHeight;					// eqn 5-4
+
+	float2 step[5];
+	step[0].x = 0.f;
+	step[1].x = sideWidth;
+	step[2].x = sideWidth + centerWidth;
+	step[3].x = width - sideWidth;
+	step[4].x = width;
+
+	step[0].y = 0.f;
+	step[1].y = edgeHeight;
+	step[2].y = edgeHeight + centerHeight;
+	step[3].y = height;
+
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ( !((iCol + jRow) & 0x01) )
+			{
+				D2D1_RECT_F rect =
+				{
+					step[iCol].x,
+					step[jRow].y,
+					step[iCol + 1].x,
+					step[jRow + 1].y
+				};
+				if ((iCol * step[iCol].x < (0.5 * width - 5.)) || (colorR < 0))	// draw left half in other color if valid
+					ctx->FillRectangle(&rect, whiteColor);
+				else if (colorR >= 0)
+					ctx->FillRectangle(&rect, rightColor);
+			}
+		}
+	}
+
+	// add any cross-hairs needed:
+	if (m_showExplanatoryText)
+	{
+		float dpi = ctx->GetDpi();
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia -> inches -> dips
+		float2 center;
+
+		center.y = height * 0.5f;
+		center.x = sideWidth + centerWidth * 0.5f;
+		D2D1_ELLIPSE ellipse;
+		ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2.5f );
+		center.x = sideWidth + centerWidth * 1.5f;
+		ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor );
+
+		ctx->DrawLine(
+			D2D1::Point2F( sideWidth,		height*0.5f ),							// horizontal line
+			D2D1::Point2F( width-sideWidth, height*0.5f ),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(sideWidth + centerWidth * 0.5f, edgeHeight),				// left vertical
+			D2D1::Point2F(sideWidth + centerWidth * 0.5f, height-edgeHeight ),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(sideWidth + centerWidth * 1.5f, edgeHeight),				// right vertical
+			D2D1::Point2F(sideWidth + centerWidth * 1.5f, height - edgeHeight ),
+			m_redColor,
+			1
+		);
+
+	}
+
+}
+
+void PatternGenerator::DrawChecker4x3n(PatternCanvas* ctx, float colorL, float colorR = -1.f )
+{
+	D2D1_COLOR_F whiteColor;			// the "white" color
+	D2D1_COLOR_F rightColor;			// the "white" color on right half of screen
+
+	//get the correct white:
+	whiteColor = D2D1::ColorF(colorL, colorL, colorL);
+	if ( colorR > 0)
+		rightColor = D2D1::ColorF(colorR, colorR, colorR);
+
+	// draw the "white" boxes on the black background
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	const int nCols = 4;
+	const int nRows = 3;
+	float width  = (logSize.right - logSize.left);
+	float height = (logSize.bottom - logSize.top);
+
+	float centerWidth = roundf( 0.48f * width * 2.f / 3.f );				// eqn 5-1 in DHDR 1.1 SCR VP235H App. A
+	float sideWidth  = floorf( width/2.f ) - centerWidth;				// eqn 5-2
+	float edgeHeight = floorf(0.26f * height);							// eqn 5-3
+	float centerHeight = height - 2.f * edgeHeight;						// eqn 5-4
+
+	float2 step[5];
+	step[0].x =  0.;
+	step[1].x = sideWidth;
+	step[2].x = sideWidth + centerWidth;
+	step[3].x = width - sideWidth;
+	step[4].x = width;
+
+	step[0].y = 0.;
+	step[1].y = edgeHeight;
+	step[2].y = edgeHeight + centerHeight;
+	step[3].y = height;
+
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				D2D1_RECT_F rect =
+				{
+					step[iCol].x,
+					step[jRow].y,
+					step[iCol+1].x,
+					step[jRow+1].y
+				};
+				if ((iCol * step[iCol].x < (0.5 * width - 5.)) || (colorR < 0))	// draw left half in other color if valid
+					ctx->FillRectangle(&rect, whiteColor);
+				else if (colorR >= 0)
+					ctx->FillRectangle(&rect, rightColor);
+			}
+		}
+	}
+
+	if (m_showExplanatoryText)
+	{
+		float dpi = ctx->GetDpi();
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+		float2 center;
+
+		center.y = height * 0.5f;
+		center.x = sideWidth + centerWidth * 0.5f;
+		D2D1_ELLIPSE ellipse;
+		ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+		center.x = sideWidth + centerWidth * 1.5f;
+		ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2.5f);
+
+		ctx->DrawLine(
+			D2D1::Point2F(sideWidth, height * 0.5f),									// horizontal line
+			D2D1::Point2F(width - sideWidth, height * 0.5f),
+			m_redColor,
+			2
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(sideWidth + centerWidth * 0.5f, edgeHeight),					// left vertical
+			D2D1::Point2F(sideWidth + centerWidth * 0.5f, height - edgeHeight),
+			m_redColor,
+			1
+		);
+		ctx->DrawLine(
+			D2D1::Point2F(sideWidth + centerWidth * 1.5f, edgeHeight),					// right vertical
+			D2D1::Point2F(sideWidth + centerWidth * 1.5f, height - edgeHeight),
+			m_redColor,
+			2
+		);
+	}
+
+}
+
+void PatternGenerator::GenerateTestPattern_StaticContrastRatio(PatternCanvas* ctx)       //**************** 5.
+{
+	float color, nits;
+	if (CheckHDR_On())
+	{
+		nits = PQ10CodeToNits(PQ10ClampCode(m_staticContrastPQValue));
+		color = nitstoCCCS( nits );
+	}
+	else
+	{
+		color = m_staticContrastsRGBValue /255.0f;
+		nits = RemoveSRGBCurve( color ) * 80.0f;
+	}
+
+	float avg = nits*0.50f;								// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	switch (m_checkerboard)
+	{
+	case Checkerboard::Cb6x4:
+		DrawChecker6x4(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3:
+		DrawChecker4x3(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3not:
+		DrawChecker4x3n(ctx, color);
+		break;
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5. Static Contrast Ratio\nMeasure black vs white";
+		title << L"\nNits: ";
+		title << nits*BRIGHTNESS_SLIDER_FACTOR;
+		if (CheckHDR_On())
+		{
+			title << L"  HDR10: ";
+			title << setprecision(0);
+			title << NitsToPQ10Code(color * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+//			title << m_staticContrastPQValue;
+		}
+		else
+		{
+			title << L"   sRGB: ";
+			title << setprecision(0);
+			title << m_staticContrastsRGBValue;
+		}
+
+		title << L" -adjust using up/down arrows\n";
+		title << L"Select checkerboard using LessThan < or GreaterThan > keys\n";
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_ActiveDimming(PatternCanvas* ctx)	//********************** 5.1
+{
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	D2D1_COLOR_F whiteColor;			// the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float HDR10 = m_activeDimming50PQValue;
+	nits = PQ10CodeToNits(PQ10ClampCode(HDR10));		// "white" checker brightness
+
+	float color = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+	switch (m_checkerboard)
+	{
+	case Checkerboard::Cb6x4:
+		DrawChecker6x4(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3:
+		DrawChecker4x3(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3not:
+		DrawChecker4x3n(ctx, color);
+		break;
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5.1 Active Dimming\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L" -adjust using up/down arrows\n";
+		title << L"Select checkerboard using LessThan < or GreaterThan > keys\n";
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_ActiveDimmingDark(PatternCanvas* ctx) //****************** 5.2
+{
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	D2D1_COLOR_F whiteColor;			// the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float HDR10 = m_activeDimming05PQValue;
+	nits = PQ10CodeToNits(PQ10ClampCode(HDR10));
+
+	// draw checkerboard of that brightness
+	float color = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+	switch (m_checkerboard)
+	{
+	case Checkerboard::Cb6x4:
+		DrawChecker6x4(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3:
+		DrawChecker4x3(ctx, color);
+		break;
+
+	case Checkerboard::Cb4x3not:
+		DrawChecker4x3n(ctx, color);
+		break;
+	}
+
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(3);
+
+		title << L"5.2 Active Dimming Dark\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L" -adjust using up/down arrows\n";
+		title << L"Select checkerboard using LessThan < or GreaterThan > keys\n";
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_ActiveDimmingSplit(PatternCanvas* ctx) //***************** 5.3
+{
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	D2D1_COLOR_F whiteColor;			// the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	nits = 50.0f;										// "white" checker brightness
+	float HDR10 = (float)NitsToPQ10Code(nits);		// PQ code
+	float colorL = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+	nits = 5.0f;										// less "white" checker brightness
+	HDR10 = (float)NitsToPQ10Code(nits);				// PQ Code
+	float colorR = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+	// draw the squares
+	switch (m_checkerboard)
+	{
+	case Checkerboard::Cb6x4:
+		DrawChecker6x4(ctx, colorL, colorR);
+		break;
+
+	case Checkerboard::Cb4x3:
+		DrawChecker4x3(ctx, colorL, colorR);
+		break;
+
+	case Checkerboard::Cb4x3not:
+		DrawChecker4x3n(ctx, colorL, colorR);
+		break;
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		nits = 50.0f;										// either 50 or 5 should be displayed
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5.3 Active Dimming Splitscreen\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L"\n";
+		title << L"Select checkerboard using LessThan < or GreaterThan > keys\n";
+		title << L"\n" << m_hideTextString;
+ 
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#define NUMBOXES 32
+void PatternGenerator::GenerateTestPattern_BlackLevelSdrTunnel(PatternCanvas* ctx) //**************** 5. Original v1.0 Tunnel Test
+{
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	float fBox, fBoxMin, fBoxMax, fBoxDelta;            // box dimension
+	fBoxMin = sqrt(4.0f / 100.0f);                      // 4% screen area of center box
+	fBoxMax = 1.f;
+	fBoxDelta = (fBoxMax - fBoxMin) / NUMBOXES;         // increment for each step
+
+	float nits = 96.0f;                                 // outer brightness
+	float avg = 26.0f;
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native); // average was computed by hand
+	float codeMax = 515;                                // outer border set at 96 nits
+
+	D2D1_COLOR_F boxColor;              // the current color
+	float codeDelta;
+	codeDelta = codeMax / NUMBOXES;
+
+    // standard pattern is 32 nested boxes
+    for (int i = 0; i < NUMBOXES; i++)
+    {
+        fBox = fBoxMax - fBoxDelta*i;
+        float code = codeMax - codeDelta*i;
+        float3 vCode = float3(code / 1023.f, code / 1023.f, code / 1023.f);
+        float3 C = HDR10ToLinear709(vCode);			  // aka c. Represented in CCCS
+
+        if (i >= (NUMBOXES - 1))
+            C = 0.0; // make sure center is black
+
+        D2D1_RECT_F centerRect =
+        {
+            (logSize.right - logSize.left) * (0.5f - fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f - fBox*0.5f),
+            (logSize.right - logSize.left) * (0.5f + fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f + fBox*0.5f)
+        };
+
+        boxColor = D2D1::ColorF(C.x, C.y, C.z);
+        ctx->FillRectangle(&centerRect, boxColor);
+    }
+
+    // Everything below this point should be hidden during actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        // draw the white outline where the sensor goes
+        fBox = sqrt(4.0f / 100.0f);
+        D2D1_RECT_F centerRect =
+        {
+            (logSize.right - logSize.left) * (0.5f - fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f - fBox*0.5f),
+            (logSize.right - logSize.left) * (0.5f + fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f + fBox*0.5f)
+        };
+        ctx->DrawRectangle(centerRect, m_whiteColor);
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"5. Tunnel for SDR black level\nMeasure in the center box";
+        title << L"\nNits: ";
+        title << nits;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << codeMax;
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_BlackLevelSdrTunnelTrueBlack(PatternCanvas* ctx) //******** 5. Legacy
+{
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	float fBox, fBoxMin, fBoxMax, fBoxDelta;            // box dimension
+	fBoxMin = sqrt(4.0f / 100.0f);                      // 4% screen area of center box
+	fBoxMax = 1.f;
+	fBoxDelta = (fBoxMax - fBoxMin) / NUMBOXES;         // increment for each step
+
+	float nits = 80.0f;                                 // outer brightness
+	float avg = 68.0f;
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native); // average was computed by hand
+
+	D2D1_COLOR_F boxColor;              // the current color
+	unsigned int codeSet[14] = { 16, 32, 48, 64, 80, 97, 113, 129, 145, 161, 177, 193, 209, 225 };
+	float codeMax = 497;                                // outer border set at 96 nits
+	float code;
+
+	// standard pattern is 32 nested boxes
+	for (int i = 0; i < NUMBOXES; i++)
+	{
+		int ri = NUMBOXES - i - 1;				// reverse order
+		fBox = fBoxMax - fBoxDelta * i;
+		if (ri < 14)
+			code = (float) codeSet[ri];
+		else
+			code = codeMax;
+
+		float3 vCode = float3(code / 1023.f, code / 1023.f, code / 1023.f);
+		float3 C = HDR10ToLinear709(vCode);			  // aka c. Represented in CCCS
+
+		if (i >= (NUMBOXES - 1))
+			C = 0.0; // make sure center is black
+
+		D2D1_RECT_F centerRect =
+		{
+			(logSize.right - logSize.left) * (0.5f - fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f - fBox * 0.5f),
+			(logSize.right - logSize.left) * (0.5f + fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f + fBox * 0.5f)
+		};
+
+		boxColor = D2D1::ColorF(C.x, C.y, C.z);
+		ctx->FillRectangle(&centerRect, boxColor);
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+
+		// draw the red outline where the sensor goes
+		fBox = sqrt(4.0f / 100.0f);
+		D2D1_RECT_F centerRect =
+		{
+			(logSize.right - logSize.left) * (0.5f - fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f - fBox * 0.5f),
+			(logSize.right - logSize.left) * (0.5f + fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f + fBox * 0.5f)
+		};
+		ctx->DrawRectangle(centerRect, m_redColor);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(100.f, 100.f),
+			75.f,
+			50.f
+		};
+
+		ctx->DrawEllipse(&ellipse, m_redColor );
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5. Tunnel for SDR black level\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << codeMax;
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+	m_newTestSelected = false;
+
+}
+
+/*
+std::wstring colorString(float3 color)
+{
+	std:wstring str[512];
+
+	wsprintf( str, );
+	float3 code = Linear709ToHDR10(code)*1023.0f;			// convert to HDR10
+	int wHDR10r = (int)roundf(code.r);
+	int wHDR10g = (int)roundf(code.g);
+	int wHDR10b = (int)roundf(code.b);
+
+	return str;
+}
+*/
+
+float3 roundf3(float3 in)
+{
+	float3 out;
+	if (in.x < 0) in.x = 0;
+	if (in.y < 0) in.y = 0;
+	if (in.z < 0) in.z = 0;
+
+	out.x = roundf(in.x);
+	out.y = roundf(in.y);
+	out.z = roundf(in.z);
+	return out;
+}
+
+void PatternGenerator::GenerateTestPattern_ColorPatches(PatternCanvas* ctx)
+{
+	GenerateTestPattern_ColorPatches(ctx, false);
+}
+
+void PatternGenerator::GenerateTestPattern_ColorPatchesFull(PatternCanvas* ctx)
+{
+	GenerateTestPattern_ColorPatches(ctx, true);
+}
+
+// Test Pattern 6.
+void PatternGenerator::GenerateTestPattern_ColorPatches			//******************************************* 6.
+(
+	PatternCanvas* ctx,
+	bool fullscreen									// fullscreen vs std patch size
+)
+{
+	float nits;										// Equivalent brightness (for white)
+	nits = m_outputDesc.MaxLuminance;				// for 10% OPR case
+
+	float OPR = PATCHPCT;							// On-Pixel-Ratio: Proportion of screen that is test patch
+	bool blackText = false;
+	if (fullscreen)
+	{
+		OPR = 1.0f;
+		blackText = true;
+	}
+
+	if (m_newTestSelected)
+	{
+		SetMetadata(nits, nits*OPR, GAMUT_Native);	// max and average
+	}
+    D2D1_COLOR_F redColor, greenColor, blueColor;
+    D2D1_COLOR_F blackColor, whiteColor;
+
+    // convert EDID primaries from chromaticity coords into sRGB colors for rendering in CCCS
+    float2 red_xy, grn_xy, blu_xy, wht_xy;
+
+// This should be close to D6500White (0.31271, 0.32902) as assumed by Windows in most cases
+	wht_xy = m_outputDesc.WhitePoint;				// from EDID or INF
+	red_xy = m_outputDesc.RedPrimary;
+    grn_xy = m_outputDesc.GreenPrimary;
+    blu_xy = m_outputDesc.BluePrimary;
+
+#if 0
+	// Test 709 primaries
+	nits = 270.f;
+	red_xy = primaryR_709;
+    grn_xy = primaryG_709;
+    blu_xy = primaryB_709;
+
+	// Jay's test case
+	wht_xy = float2(0.313000, 0.329607); 
+    red_xy = float2(0.708508, 0.292492);
+    grn_xy = float2(0.170422, 0.797375);
+    blu_xy = float2(0.131359, 0.046398);
+
+	// Jean Huang's test case
+	nits = 1000.f;
+	red_xy = float2(0.681, 0.315);
+	grn_xy = float2(0.253, 0.719);
+	blu_xy = float2(0.168, 0.048);
+	wht_xy = float2(0.319, 0.356);
+
+	// 2020 test case
+	nits = 1015.0f;
+	wht_xy = D6500White;		// (0.31271, 0.32902)		// Assumed by Windows in most cases
+	red_xy = primaryR_2020;
+	grn_xy = primaryG_2020;
+	blu_xy = primaryB_2020;
+
+	red_xy = primaryR_DCIP3;
+	grn_xy = primaryG_DCIP3;
+	blu_xy = primaryB_DCIP3;
+#endif
+
+	const float WhiteLevel = 1.0f;				// reference value only
+    float3 WhiteCol = xytoXYZ(wht_xy, WhiteLevel);
+    float3 RedCol   = xytoXYZ(red_xy, WhiteLevel);
+    float3 GreenCol = xytoXYZ(grn_xy, WhiteLevel);
+    float3 BlueCol  = xytoXYZ(blu_xy, WhiteLevel);
+
+#if 1
+	float3x3 PanelMatrix = float3x3(
+		RedCol.x, GreenCol.x, BlueCol.x,
+		RedCol.y, GreenCol.y, BlueCol.y,
+		RedCol.z, GreenCol.z, BlueCol.z
+	);
+#else
+	float3x3 PanelMatrix = float3x3(
+		RedCol.x,   RedCol.y,   RedCol.z,
+		GreenCol.x, GreenCol.y, GreenCol.z,
+		BlueCol.x,  BlueCol.y,  BlueCol.z
+	);
+#endif
+//	float3x3 matTemp = PanelMatrix;		// this produces equivalent results
+//	PanelMatrix = transpose(matTemp);
+
+//	float K = 1.6f*nits / 10000.f; 
+	float K = nits / 10000.f;
+	float3x3 invPanelMatrix = inv(PanelMatrix);
+	float3 Yrow = invPanelMatrix*WhiteCol*K;
+	 
+    float3 RXYZ;
+    RXYZ.y = Yrow.x;
+    RXYZ.x = RXYZ.y*red_xy.x / red_xy.y;
+    RXYZ.z = RXYZ.y*(1.0f - red_xy.x - red_xy.y) / red_xy.y;
+
+    float3 GXYZ;
+    GXYZ.y = Yrow.y;
+    GXYZ.x = GXYZ.y*grn_xy.x / grn_xy.y;
+    GXYZ.z = GXYZ.y*(1.0f - grn_xy.x - grn_xy.y) / grn_xy.y;
+
+    float3 BXYZ;
+    BXYZ.y = Yrow.z;
+    BXYZ.x = BXYZ.y*blu_xy.x / blu_xy.y;
+    BXYZ.z = BXYZ.y*(1.0f - blu_xy.x - blu_xy.y) / blu_xy.y;
+
+//	wht_xy = D6500White;
+	float3 WXYZ;
+	WXYZ.y = Yrow.w;
+	WXYZ.x = WXYZ.y*wht_xy.x / wht_xy.y;
+	WXYZ.z = WXYZ.y*(1.0f - wht_xy.x - wht_xy.y) / wht_xy.y;
+
+	// convert to 2020 gamut space	
+	float3 R2020 = XYZ_to_BT2020RGB*RXYZ; 
+    float3 G2020 = XYZ_to_BT2020RGB*GXYZ;
+    float3 B2020 = XYZ_to_BT2020RGB*BXYZ;
+    float3 W2020 = XYZ_to_BT2020RGB*WhiteCol*K;
+//		   W2020 = XYZ_to_BT2020RGB*WXYZ;
+
+	// apply PQ curve
+    float3 RHDR10 = Apply2084(R2020);   
+    float3 GHDR10 = Apply2084(G2020);
+    float3 BHDR10 = Apply2084(B2020);
+	float3 WHDR10 = Apply2084(W2020);
+
+	// convert HDR10 to linear+709 for CCCS rendering
+#if 0
+	float3x3 tXYZ_to_709RGB = transpose( XYZ_to_709RGB );
+    float3 RCCCS = tXYZ_to_709RGB*RXYZ*80.f;
+    float3 GCCCS = tXYZ_to_709RGB*GXYZ*80.f;
+    float3 BCCCS = tXYZ_to_709RGB*BXYZ*80.f;
+	float3 WCCCS = tXYZ_to_709RGB*WhiteCol*K*80.f;
+#else
+    float3 RCCCS = HDR10ToLinear709(RHDR10);
+    float3 GCCCS = HDR10ToLinear709(GHDR10);
+    float3 BCCCS = HDR10ToLinear709(BHDR10);
+    float3 WCCCS = HDR10ToLinear709(WHDR10);
+#endif
+
+    // colors for each primary
+	redColor = D2D1::ColorF(RCCCS.r, RCCCS.g, RCCCS.b);
+	greenColor = D2D1::ColorF(GCCCS.r, GCCCS.g, GCCCS.b);
+	blueColor = D2D1::ColorF(BCCCS.r, BCCCS.g, BCCCS.b);
+	whiteColor = D2D1::ColorF(WCCCS.r, WCCCS.g, WCCCS.b);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    title << L"6. Checking ";	// show test number
+
+	// convert to 10-bit code values for printout display
+	RHDR10 = Apply2084(R2020*BRIGHTNESS_SLIDER_FACTOR)*1023.f;           // apply PQ curve
+	GHDR10 = Apply2084(G2020*BRIGHTNESS_SLIDER_FACTOR)*1023.f;
+	BHDR10 = Apply2084(B2020*BRIGHTNESS_SLIDER_FACTOR)*1023.f;
+	WHDR10 = Apply2084(W2020*BRIGHTNESS_SLIDER_FACTOR)*1023.f;
+
+	float fSize = sqrt(OPR);
+	float dpi = ctx->GetDpi();
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+
+	D2D1_RECT_F centerRect;
+	if (fullscreen)
+		centerRect = logSize;
+	else
+	{
+		float patchPct = OPR;			// patch percentage of screen area
+		float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+		size = size * sqrtf(OPR);		// dimensions for a square of this % screen area
+
+		float2 center;
+		center.x = (logSize.right - logSize.left) * 0.50f;
+		center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+		float2 jitter;
+		float radius = m_offscreen ? 0.f : JITTER_RADIUS * dpi / 96.0f;
+		do {
+			jitter.x = radius * (randf_s() * 2.f - 1.f);
+			jitter.y = radius * (randf_s() * 2.f - 1.f);
+		} while ((jitter.x * jitter.x + jitter.y * jitter.y) > radius);
+
+		if (fullscreen) jitter = float2(0.f, 0.f);
+
+		// Apply jitter
+		center = center + jitter;
+
+		centerRect =
+		{
+			center.x - size * 0.50f,
+			center.y - size * 0.50f,
+			center.x + size * 0.50f,
+			center.y + size * 0.50f
+		};
+	}
+  
+    switch (m_currentColor)
+    {
+    case 0:
+        ctx->FillRectangle(centerRect, redColor);
+        title << L"Red Chromaticity Point\n xy:    ";
+        title << setprecision(5) << red_xy.x << ", " << red_xy.y << "\n";
+		title << L"CCCS:  ";
+		title << setprecision(3) << RCCCS.r << ", " << RCCCS.g << ", " << RCCCS.b << "\n";
+		title << L"HDR10: ";
+        title << setprecision(0) << RHDR10.r << ", " << RHDR10.g << ", " << RHDR10.b;
+        break;
+
+    case 1:
+        ctx->FillRectangle(centerRect, greenColor);
+        title << L"Green Chromaticity Point\n xy:    ";
+        title << setprecision(5) << grn_xy.x << ", " << grn_xy.y << "\n";
+		title << L"CCCS:  ";
+		title << setprecision(3) << GCCCS.r << ", " << GCCCS.g << ", " << GCCCS.b << "\n";
+		title << L"HDR10: ";
+		title << setprecision(0) << GHDR10.r << ", " << GHDR10.g << ", " << GHDR10.b;
+        break;
+
+    case 2:
+        ctx->FillRectangle(centerRect, blueColor);
+        title << L"Blue Chromaticity Point\n xy:    ";
+        title << setprecision(5) << blu_xy.x << ", " << blu_xy.y << "\n";
+		title << L"CCCS:  ";
+		title << setprecision(3) << BCCCS.r << ", " << BCCCS.g << ", " << BCCCS.b << "\n";
+		title << L"HDR10: ";
+		title << setprecision(0) << BHDR10.r << ", " << BHDR10.g << ", " << BHDR10.b;
+        break;
+
+    case 3:
+        ctx->FillRectangle(centerRect, whiteColor);
+        title << L"White Point\n xy:    ";
+		title << setprecision(5) << wht_xy.x << ", " << wht_xy.y << "\n";
+        title << L"CCCS:  ";
+		title << setprecision(3) << WCCCS.r << ", " << WCCCS.g << ", " << WCCCS.b << "\n";
+        //		title << L"\nNits:    ";
+        //		title << std::to_wstring(nits) << ", " << std::to_wstring(nits) << ", " << std::to_wstring(nits);
+        title << L"HDR10: ";
+        title << setprecision(0) << WHDR10.r << ", " << WHDR10.g << ", " << WHDR10.b;
+        break;
+    }
+
+    if (m_showExplanatoryText)
+    {
+		// Draw outline/borders to track clipped limit (like old v1.0 color 6.B test)
+		K = m_outputDesc.MaxLuminance / 10000.f;
+		invPanelMatrix = inv(XYZ_to_BT2020RGB);		// assume 2020 primaries for reference and hope they get clipped to actual
+		Yrow = invPanelMatrix * WhiteCol * K;
+//		Yrow = XYZ_to_BT2020RGB * WhiteCol * K;
+
+		RXYZ.y = Yrow.x;
+		RXYZ.x = RXYZ.y * red_xy.x / red_xy.y;
+		RXYZ.z = RXYZ.y * (1.0f - red_xy.x - red_xy.y) / red_xy.y;
+
+		GXYZ.y = Yrow.y;
+		GXYZ.x = GXYZ.y * grn_xy.x / grn_xy.y;
+		GXYZ.z = GXYZ.y * (1.0f - grn_xy.x - grn_xy.y) / grn_xy.y;
+
+		BXYZ.y = Yrow.z;
+		BXYZ.x = BXYZ.y * blu_xy.x / blu_xy.y;
+		BXYZ.z = BXYZ.y * (1.0f - blu_xy.x - blu_xy.y) / blu_xy.y;
+
+		WXYZ.y = Yrow.w;
+		WXYZ.x = WXYZ.y * wht_xy.x / wht_xy.y;
+		WXYZ.z = WXYZ.y * (1.0f - wht_xy.x - wht_xy.y) / wht_xy.y;
+
+		// convert to 2020 gamut space	
+		R2020 = XYZ_to_BT2020RGB * RXYZ;
+		G2020 = XYZ_to_BT2020RGB * GXYZ;
+		B2020 = XYZ_to_BT2020RGB * BXYZ;
+		W2020 = XYZ_to_BT2020RGB * WhiteCol * K;
+		// W2020 = XYZ_to_BT2020RGB*WXYZ;
+
+		// apply PQ curve
+		RHDR10 = Apply2084(R2020);
+		GHDR10 = Apply2084(G2020);
+		BHDR10 = Apply2084(B2020);
+		WHDR10 = Apply2084(W2020);
+
+		// convert HDR10 to linear+709 for CCCS rendering
+#if 0
+		float3x3 tXYZ_to_709RGB = transpose(XYZ_to_709RGB);
+		float3 RCCCS = tXYZ_to_709RGB * RXYZ * 80.f;
+		float3 GCCCS = tXYZ_to_709RGB * GXYZ * 80.f;
+		float3 BCCCS = tXYZ_to_709RGB * BXYZ * 80.f;
+		float3 WCCCS = tXYZ_to_709RGB * WhiteCol * K * 80.f;
+#else
+		float3 RCCCS = HDR10ToLinear709(RHDR10);
+		float3 GCCCS = HDR10ToLinear709(GHDR10);
+		float3 BCCCS = HDR10ToLinear709(BHDR10);
+		float3 WCCCS = HDR10ToLinear709(WHDR10);
+#endif
+
+		BCCCS.r = 0.f;
+
+		redColor = D2D1::ColorF(RCCCS.r, RCCCS.g, RCCCS.b);
+		greenColor = D2D1::ColorF(GCCCS.r, GCCCS.g, GCCCS.b);
+		blueColor = D2D1::ColorF(BCCCS.r, BCCCS.g, BCCCS.b);
+		whiteColor = D2D1::ColorF(WCCCS.r, WCCCS.g, WCCCS.b);
+
+		// draw the rect in the correct color
+		switch (m_currentColor)
+		{
+		case 0:
+			ctx->DrawRectangle(centerRect, redColor,   12);	break;
+		case 1:
+			ctx->DrawRectangle(centerRect, greenColor, 12);	break;
+		case 2:
+			ctx->DrawRectangle(centerRect, blueColor,  12);	break;
+		case 3:
+			ctx->DrawRectangle(centerRect, whiteColor, 12);	break;
+		}
+
+		title << L"\nUp & Down arrow keys rotate between RGBW colors\n";
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_ColorPatches709(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();    // This simulates desktop content where default metadata is used.
+
+    // Overload the color selector to allow selecting the desired SDR white level.
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+        nits = 80.0f;
+        break;
+    case 1:
+        nits = 160.0f;
+        break;
+    case 2:
+        nits = 240.0f;
+        break;
+    case 3:
+        nits = 320.0f;
+        break;
+    default:
+        throw std::invalid_argument("m_currentColor");
+        break;
+    }
+
+    D2D1_COLOR_F redColor, greenColor, blueColor;
+
+    // Generating the colors is trivial since 709 primaries == CCCS primaries and we are emulating
+    // SDR boost which simply scales RGB colors linearly.
+    redColor = D2D1::ColorF(nitstoCCCS(nits), 0.0f, 0.0f);
+    greenColor = D2D1::ColorF(0.0f, nitstoCCCS(nits), 0.0f);
+    blueColor = D2D1::ColorF(0.0f, 0.0f, nitstoCCCS(nits));
+
+    auto full = ctx->GetLogicalSize();
+    // Divide screen into thirds.
+    // D2D1_RECT_F: Left, Top, Right, Bottom
+    D2D1_RECT_F redRect   = { full.left, (full.bottom - full.top) * 0.0f / 3.0f , full.right, (full.bottom - full.top) * 1.0f / 3.0f };
+    D2D1_RECT_F greenRect = { full.left, (full.bottom - full.top) * 1.0f / 3.0f , full.right, (full.bottom - full.top) * 2.0f / 3.0f };
+    D2D1_RECT_F blueRect  = { full.left, (full.bottom - full.top) * 2.0f / 3.0f , full.right, (full.bottom - full.top) * 3.0f / 3.0f };
+
+    ctx->FillRectangle(redRect, redColor);
+    ctx->FillRectangle(greenRect, greenColor);
+    ctx->FillRectangle(blueRect, blueColor);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"709 primaries\nUsing reference level of: " << nits;
+        title << " nits.\nUp & Down arrow keys select white level.\n";
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+}
+
+// aka 6.b from v1.0
+void PatternGenerator::GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx)
+{
+	GenerateTestPattern_ColorPatchesMAX(ctx, 1.00);
+}
+
+void PatternGenerator::GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx, float OPR) // *******6.MAX
+{
+    D2D1_COLOR_F redColor, greenColor, blueColor;
+    D2D1_COLOR_F blackColor, whiteColor;
+
+    // convert EDID primaries from chromaticity coords into sRGB colors for rendering in CCCS
+    float2 red_xy, grn_xy, blu_xy, wht_xy;
+
+    wht_xy = D6500White;
+    red_xy = primaryR_2020;
+    grn_xy = primaryG_2020;
+    blu_xy = primaryB_2020;
+
+    // convert primary colors to RGB709 space
+    float3 R = xytoXYZ(red_xy, 1.0)*XYZ_to_709RGB;
+    float3 G = xytoXYZ(grn_xy, 1.0)*XYZ_to_709RGB;
+    float3 B = xytoXYZ(blu_xy, 1.0)*XYZ_to_709RGB;
+    float3 W = xytoXYZ(wht_xy, 1.0)*XYZ_to_709RGB;
+    //	float3 W = float3(Y, Y, Y);
+
+    // Adjust them to desired output brightness level
+ // const float nits = 300.0f;								// white level should be 300 cd/m2
+	const float nits = m_outputDesc.MaxLuminance;			// set to value from EDID 10% peak
+    if (m_newTestSelected) SetMetadata(nits, nits*OPR, GAMUT_BT2100); // max and average are same for full screen
+
+    const float Y = nitstoCCCS(nits);
+    float3 YRow = float3(0.069095, 0.919544, 0.011360);
+    R = R*Y;
+    G = G*Y;
+    B = B*Y;
+    W = W*Y;
+
+    float3 Rspec = float3(636. / 1023., 0., 0.);
+    float3 Gspec = float3(0., 636. / 1023., 0.);
+    float3 Bspec = float3(0., 0., 636. / 1023.);
+    float3 Wspec = float3(636. / 1023., 636. / 1023., 636. / 1023.);
+
+    R = HDR10ToLinear709(Rspec);
+    G = HDR10ToLinear709(Gspec);
+    B = HDR10ToLinear709(Bspec);
+    W = HDR10ToLinear709(Wspec);
+
+    // colors for each primary
+    redColor = D2D1::ColorF(R.r, R.g, R.b);
+    greenColor = D2D1::ColorF(G.r, G.g, G.b);
+    blueColor = D2D1::ColorF(B.r, B.g, B.b);
+
+    blackColor = D2D1::ColorF(0.0, 0.0, 0.0);
+    whiteColor = D2D1::ColorF(W.r, W.g, W.b);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    title << L"6.b Checking ";	// show test number
+
+	float fSize = sqrt(OPR);
+	D2D1_RECT_F logSize = ctx->GetLogicalSize();
+	D2D1_RECT_F centerRect =
+	{
+		(logSize.right - logSize.left) * (0.5f - fSize * 0.5f),
+		(logSize.bottom - logSize.top) * (0.5f - fSize * 0.5f),
+		(logSize.right - logSize.left) * (0.5f + fSize * 0.5f),
+		(logSize.bottom - logSize.top) * (0.5f + fSize * 0.5f)
+	};
+
+    float3 HDR10;
+    switch (m_currentColor)
+    {
+    case 0:
+        ctx->FillRectangle(centerRect, redColor);
+        title << L"Red Chromaticity Point\n xy: ";
+        title << std::to_wstring(red_xy.x) << ", " << std::to_wstring(red_xy.y) << "\n";
+        title << std::to_wstring(R.r) << ", " << std::to_wstring(R.g) << ", " << std::to_wstring(R.b) << "\n";
+        HDR10 = Linear709ToHDR10(R)*1023.0f;						// convert to HDR10
+        HDR10 = roundf3(HDR10);
+        title << std::to_wstring((int)HDR10.r) << ", " << std::to_wstring((int)HDR10.g) << ", " << std::to_wstring((int)HDR10.b);
+        break;
+
+    case 1:
+        ctx->FillRectangle(centerRect, greenColor);
+        title << L"Green Chromaticity Point\n xy: ";
+        title << std::to_wstring(grn_xy.x) << ", " << std::to_wstring(grn_xy.y) << "\n";
+        title << std::to_wstring(G.r) << ", " << std::to_wstring(G.g) << ", " << std::to_wstring(G.b) << "\n";
+        HDR10 = Linear709ToHDR10(G)*1023.0f;						// convert to HDR10
+        HDR10 = roundf3(HDR10);
+        title << std::to_wstring((int)HDR10.r) << ", " << std::to_wstring((int)HDR10.g) << ", " << std::to_wstring((int)HDR10.b);
+        break;
+
+    case 2:
+        ctx->FillRectangle(centerRect, blueColor);
+        title << L"Blue Chromaticity Point\n xy: ";
+        title << std::to_wstring(blu_xy.x) << ", " << std::to_wstring(blu_xy.y) << "\n";
+        title << std::to_wstring(B.r) << ", " << std::to_wstring(B.g) << ", " << std::to_wstring(B.b) << "\n";
+        HDR10 = Linear709ToHDR10(B)*1023.0f;						// convert to HDR10
+        HDR10 = roundf3(HDR10);
+        title << std::to_wstring((int)HDR10.r) << ", " << std::to_wstring((int)HDR10.g) << ", " << std::to_wstring((int)HDR10.b);
+        break;
+
+    case 3:
+        ctx->FillRectangle(centerRect, whiteColor);
+        title << L"White Point\n xy: ";
+        title << std::to_wstring(wht_xy.x) << ", " << std::to_wstring(wht_xy.y);
+        title << L"\nCCCS:    ";
+        title << std::to_wstring(W.r) << ", " << std::to_wstring(W.g) << ", " << std::to_wstring(W.b);
+        //		title << L"\nNits:    ";
+        //		title << std::to_wstring(nits) << ", " << std::to_wstring(nits) << ", " << std::to_wstring(nits);
+        title << L"\nHDR10: ";
+        HDR10 = Linear709ToHDR10(W)*1023.0f;						// convert to HDR10
+        HDR10 = roundf3(HDR10);
+        title << std::to_wstring((int)HDR10.r) << ", " << std::to_wstring((int)HDR10.g) << ", " << std::to_wstring((int)HDR10.b);
+        break;
+    }
+
+    if (m_showExplanatoryText)
+    {
+        title << L"\nUp & Down arrow keys rotate between RGBW colors\n";
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+
+#if 0
+void PatternGenerator::GenerateTestPattern_ColorPatches(PatternCanvas* ctx)
+{
+    // Create colors for 50% sRGB, 100% sRGB, DCI-P3, and Rec. 2020.
+    D2D1_COLOR_F red50, redSrgb, redP3, red2020;
+    D2D1_COLOR_F green50, greenSrgb, greenP3, green2020;
+    D2D1_COLOR_F blue50, blueSrgb, blueP3, blue2020;
+
+    // CCCS values are reverse engineered from FV2 tool test patterns.
+    red50 = D2D1::ColorF( 0.994f,  0.498f,  0.515f);
+    redSrgb = D2D1::ColorF( 1.000f,  0.000f,  0.000f);
+    redP3 = D2D1::ColorF( 1.132f, -0.039f, -0.017f);
+    red2020 = D2D1::ColorF( 3.172f, -0.234f, -0.033f);
+
+    green50 = D2D1::ColorF( 0.522f,  0.989f,  0.513f);
+    greenSrgb = D2D1::ColorF( 0.000f,  1.000f,  0.000f);
+    greenP3 = D2D1::ColorF(-0.221f,  1.062f, -0.079f);
+    green2020 = D2D1::ColorF(-0.433f,  0.822f, -0.074f);
+
+    blue50 = D2D1::ColorF( 0.512f,  0.493f,  1.000f);
+    blueSrgb = D2D1::ColorF( 0.000f,  0.000f,  1.000f);
+    blueP3 = D2D1::ColorF( 0.000f,  0.000f,  1.000f);
+    blue2020 = D2D1::ColorF(-0.609f, -0.065f,  9.297f);
+
+    // Divide pattern in a 3x4 grid.
+    auto rect = ctx->GetLogicalSize();
+    auto w = (rect.right - rect.left) / 4.0f;
+    auto h = (rect.bottom - rect.top) / 3.0f;
+    auto w1 = w * 0.2f; // Left/top edge of each patch offset.
+    auto h1 = h * 0.2f;
+    auto w2 = w * 0.8f; // Right/bottom edge of each patch offset.
+    auto h2 = h * 0.8f;
+
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 0.0f + h1, w * 0.0f + w2, h * 0.0f + h2), red50);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 0.0f + h1, w * 1.0f + w2, h * 0.0f + h2), redSrgb);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 0.0f + h1, w * 2.0f + w2, h * 0.0f + h2), redP3);
+    // TODO: Unsure if the Rec. 2020 colors are indeed correct. Double check and add them back.
+    //ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 0.0f + h1, w * 3.0f + w2, h * 0.0f + h2), red2020);
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 1.0f + h1, w * 0.0f + w2, h * 1.0f + h2), green50);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 1.0f + h1, w * 1.0f + w2, h * 1.0f + h2), greenSrgb);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 1.0f + h1, w * 2.0f + w2, h * 1.0f + h2), greenP3);
+    //ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 1.0f + h1, w * 3.0f + w2, h * 1.0f + h2), green2020);
+    ctx->FillRectangle(D2D1::RectF(w * 0.0f + w1, h * 2.0f + h1, w * 0.0f + w2, h * 2.0f + h2), blue50);
+    ctx->FillRectangle(D2D1::RectF(w * 1.0f + w1, h * 2.0f + h1, w * 1.0f + w2, h * 2.0f + h2), blueSrgb);
+    ctx->FillRectangle(D2D1::RectF(w * 2.0f + w1, h * 2.0f + h1, w * 2.0f + w2, h * 2.0f + h2), blueP3);
+    //ctx->FillRectangle(D2D1::RectF(w * 3.0f + w1, h * 2.0f + h1, w * 3.0f + w2, h * 2.0f + h2), blue2020);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (!m_showExplanatoryText)
+    {
+        return;
+    }
+
+    RenderText(ctx, CanvasFontSmall, L"Red: 50% sRGB   ", { w * 0.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Red: 100% sRGB  ", { w * 1.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Red: DCI-P3     ", { w * 2.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, CanvasFontSmall, L"Red: Rec. 2020  ", { w * 3.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Green: 50% sRGB ", { w * 0.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Green: 100% sRGB", { w * 1.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Green: DCI-P3   ", { w * 2.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, CanvasFontSmall, L"Green: Rec. 2020", { w * 3.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Blue: 50% sRGB  ", { w * 0.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Blue: 100% sRGB ", { w * 1.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, CanvasFontSmall, L"Blue: DCI-P3    ", { w * 2.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, CanvasFontSmall, L"Blue: Rec. 2020 ", { w * 3.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+
+    std::wstring text = L"RGB color patches\n" << m_hideTextString;
+    RenderText(ctx, CanvasFontLarge, text, m_testTitleRect);
+}
+#endif
+
+void PatternGenerator::GenerateTestPattern_BitDepthPrecision(PatternCanvas* ctx) //******************* 7.
+{
+    if (m_newTestSelected)
+		SetMetadata( m_outputDesc.MaxLuminance, 2.0f, GAMUT_Native);
+
+    // TODO: merge into common effect test pattern generator.
+    auto& rsc = GetTestPatternDesc(TestPattern::BitDepthPrecision).resources;
+
+    std::wstringstream title;
+    auto rect = ctx->GetOutputSize();
+
+    if (!rsc.effectIsValid)
+    {
+        title << L"\nERROR: BandedGradientEffect.cso is missing\n";
+    }
+    else
+    {
+        ctx->SetEffectValue(rsc.canvasEffect,
+            L"OutputSize",
+            D2D1::Point2F((float)rect.right - rect.left, (float)rect.bottom - rect.top));
+
+        ctx->DrawEffect(rsc.canvasEffect);
+    }
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+        title << rsc.testTitle << L"\n" << m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+        // Text labels are manually aligned with offsets from BandedGradientEffect.hlsl
+
+        D2D1_RECT_F text10Rect = { 0.0f, (rect.bottom - rect.top) * 0.1f, 300.0f, 50.0f };
+        D2D1_RECT_F text30Rect = { 0.0f, (rect.bottom - rect.top) * 0.3f, 300.0f, 50.0f };
+        D2D1_RECT_F text50Rect = { 0.0f, (rect.bottom - rect.top) * 0.5f, 300.0f, 50.0f };
+        D2D1_RECT_F text70Rect = { 0.0f, (rect.bottom - rect.top) * 0.7f, 300.0f, 50.0f };
+        D2D1_RECT_F text90Rect = { 0.0f, (rect.bottom - rect.top) * 0.9f, 300.0f, 50.0f };
+
+        RenderText(ctx, CanvasFontLarge, L"6-bit quantization", text10Rect);
+        RenderText(ctx, CanvasFontLarge, L"Display-native", text30Rect);
+        //	RenderText(ctx, CanvasFontLarge, L"6+2 dither 2x2",		text30Rect);
+        RenderText(ctx, CanvasFontLarge, L"8-bit quantization", text50Rect);
+        RenderText(ctx, CanvasFontLarge, L"Display-native", text70Rect);
+        RenderText(ctx, CanvasFontLarge, L"10-bit quantization", text90Rect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_RiseFallTime(PatternCanvas* ctx) //************************ 8.
+{
+//  "tone map" PQ limit of 10k nits down to panel maxLuminance in CCCS
+//  float nits = m_outputDesc.MaxLuminance;
+//	float avg = nits * 0.1f; // 10% screen area
+	float nits = m_outputDesc.MaxLuminance;
+	float patchPCT = PATCHPCT;
+	float avg = m_outputDesc.MaxLuminance*patchPCT;
+
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    
+    auto logSize = ctx->GetLogicalSize();
+	std::wstringstream title;
+
+#if 0
+	// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		auto out = ctx->GetOutputSize();
+		D2D1_POINT_2F time = { m_totalTime, 0.f };
+
+		// init var.
+		float init = 30.0f;
+
+		// How many pixels before the wavelength halves.
+		float dist = (out.right - out.left) / 4.0f;
+
+		ctx->SetEffectValue(rsc.canvasEffect, L"Center", time);
+		ctx->SetEffectValue(rsc.canvasEffect, L"InitialWavelength", init);
+		ctx->SetEffectValue(rsc.canvasEffect, L"WavelengthHalvingDistance", dist);
+		ctx->SetEffectValue(rsc.canvasEffect, L"WhiteLevelMultiplier", nitstoCCCS(185));
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+
+	// draw a starfield background
+	float starNits = min(nits, 100.f);							// clamp nits to max of 100
+	D2D1_COLOR_F starColor;
+	D2D1_ELLIPSE ellipse;
+	float pixels = 0;
+	srand(314159);												// seed the starfield rng
+	for (int i = 1; i < 2000; i++)
+	{
+		float s = nitstoCCCS((randf()) * starNits);
+		starColor = D2D1::ColorF(s, s, s);
+
+		float2 center = float2(logSize.right * randf(), logSize.bottom * randf());
+		float fRad = randf() * randf() * randf() * 19.f + 1.f;
+		ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->FillEllipse(&ellipse, starColor);
+
+		pixels += M_PI_F * fRad * fRad * s;
+
+	}
+	float area = (logSize.right - logSize.left) * (logSize.bottom - logSize.top);
+	float APL = pixels / area;
+#endif
+
+	// draw center square
+	float c = nitstoCCCS(nits);
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	float patchPct = PATCHPCT;
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	// the patch flashes and jitters, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target)
+	{
+		if (m_flashOn)
+			FillJitteredPatch(target, center, size, centerColor);
+	});
+
+    if (m_showExplanatoryText)
+    {
+		// the title shows the countdown, so it is drawn live too
+		ctx->DrawLive([=](PatternCanvas* target)
+		{
+			std::wstringstream title;
+			title << fixed << setw(8) << setprecision(2);
+
+			title << L"8. Rise/Fall Time";
+			title << L"\nNits: ";
+			title << nits*BRIGHTNESS_SLIDER_FACTOR;
+			title << L"  HDR10: ";
+			title << setprecision(0);
+			title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+			title << L"\n";
+			title << setprecision(2) << m_testTimeRemainingSec;
+			title << L" seconds remaining";
+			title << L"\n" << m_hideTextString;
+
+			RenderText(target, CanvasFontLarge, title.str(), m_testTitleRect);
+		});
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_ProfileCurve(PatternCanvas* ctx)  //*********************** 9.
+{
+#define NPQCODES 45
+	uint PQCodes[NPQCODES] =
+	{
+		1023,
+		0,
+		8,
+		16,
+		24,
+		36,
+		48,
+		56,
+		64,
+		120,
+		156,
+		256,
+		340,
+		384,
+		452,
+		488,
+		520,
+		592,
+		616,
+		636,
+		660,
+		664,
+		668,
+		688,
+		692,
+		704,
+		708,
+		712,
+		728,
+		744,
+		756,
+		760,
+		764,
+		768,
+		788,
+		804,
+		808,
+		812,
+		828,
+		840,
+		844,
+		872,
+		892,
+		920,
+		1023
+	};
+
+	if (m_newTestSelected)
+	{
+		SetMetadata( m_outputDesc.MaxLuminance, m_outputDesc.MaxLuminance*0.10f, GAMUT_Native );
+	}
+
+	// find the brightest tile we need to test on this panel
+	for (int i = 3; i < NPQCODES; i++)
+	{
+		m_maxProfileTile = i;
+		if (PQCodes[i] > m_maxPQCode)
+			break;
+	}
+
+	// get current intensity value to display on tile
+	unsigned int PQCode = PQCodes[m_currentProfileTile];
+	if (PQCode > m_maxPQCode) PQCode = m_maxPQCode;				// clamp to max reported possible
+
+	float nits = PQ10CodeToNits(PQCode);		// go to linear space
+	float c = nitstoCCCS(nits/BRIGHTNESS_SLIDER_FACTOR);		// scale by 80 and slider
+
+	// "tone map" PQ limit of 10k nits down to panel maxLuminance in CCCS
+	float patchPct = PATCHPCT;							// patch percentage of screen area
+	float avg = nits * patchPct + TARGETAPL/(1.f - patchPct)*80.f;
+	if (m_newTestSelected) {
+		SetMetadata(nits, avg, GAMUT_Native);
+	}
+
+	auto logSize = ctx->GetLogicalSize();
+	std::wstringstream title;
+
+#ifdef NOISE
+	// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		float TierMaxLum = GetTierLuminance(m_testingTier);
+		float noiseAPL = TierMaxLum * TARGETAPL/(1.f - PATCHPCT);					// assume noise covers 92% of screen
+		if (noiseAPL > 100.0f) noiseAPL = 100.0f;				// clamp noise APL to max of 100 nits in all cases
+		float limit = 100.0f;									// clamp all noise pixel values to this
+		if (limit > nits) limit = nits;							// no noise pixels brighter than patch
+		if (noiseAPL > limit) noiseAPL = limit;					// don't have average APL higher than pixel limit
+		float time = m_totalTime;								// animate with the clock
+		if (m_bPaused) time = 0;								// unless paused so we fix it at 0.0
+
+		// ******* Arguments to this call are not type checked  *********
+		// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+		ctx->SetEffectValue(rsc.canvasEffect, L"APL", noiseAPL );	// ****** MUST BE FLOAT!	// average luminance of noise in nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );								// no pixels above this (nits)
+		ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );									// seconds
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+#else
+
+	// draw a starfield background
+	float TierLum = GetTierLuminance(m_testingTier);
+	float noiseAPL = TierLum * TARGETAPL/(1.f - patchPct);		// assume noise covers 92% of screen
+
+	D2D1_COLOR_F starColor;
+	float starNits = min(nits, 100.f);							// clamp nits to max of 100
+	if (starNits < 5.f)
+	{
+		float c = nitstoCCCS(starNits);
+		starColor = D2D1::ColorF(c, c, c);
+		ctx->FillRectangle(&logSize, starColor);
+	}
+	else
+	{
+		DrawStarfield(ctx, starNits);
+	}
+#endif
+
+	// draw center square
+	float dpi = ctx->GetDpi();
+
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	// the patch jitters every frame, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, centerColor); });
+
+	float PQcheck = Apply2084(c * 80.f * BRIGHTNESS_SLIDER_FACTOR / 10000.f) * 1023.f;
+
+	if (m_showExplanatoryText)
+	{
+		// draw target circle
+//		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f)*0.35;	// 4% screen area colorimeter box
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 1 );
+
+		title << fixed << setw(8) << setprecision(0);
+		title << L"9. Validating 2084 Profile Curve in nits\n";
+		title << L"Subtest#: ";
+		title << setw(2) << m_currentProfileTile;
+		title << L"   HDR10: ";
+		title << setw(3) << PQCode;
+		title << L"   Nits: ";
+		title << setw(4) << setprecision(3) << nits;
+//		title << L"   HDR10b: ";
+//		title << setprecision(4) << PQcheck;		// echo input to validate precision
+		title << L"\nUp/Down arrow keys select level";
+		title << L"\n";
+		title << m_hideTextString;
+
+		RenderText( ctx, CanvasFontLarge, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+	}
+
+#if 0
+	std::wstringstream title;
+	title << L"3.b Full-frame white for 30 minutes: ";
+	if (0.0f != m_testTimeRemainingSec)
+	{
+		title << static_cast<unsigned int>(m_testTimeRemainingSec);
+		title << L" seconds remaining";
+		title << L"\nRenders HDR10 max (10,000 nits)";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << NitsToPQ10Code(c * 80.f);
+		title << L"\n" << m_hideTextString;
+	}
+	else
+	{
+		title << L" done.";
+	}
+	RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+#endif
+	m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_LocalDimmingContrast(PatternCanvas* ctx)				// v1.2.1
+{
+	D2D1_COLOR_F barColor;								// for white bars
+	float patchPct = PATCHPCT;							// patch percentage of screen area
+
+	// Compute box intensity based on EDID
+	float nits = m_outputDesc.MaxLuminance;
+	float avg = nits * patchPct + TARGETAPL/(1.f - patchPct)*80.f;
+
+	if (m_newTestSelected)
+		SetMetadata(nits, avg, GAMUT_Native);
+
+	std::wstringstream title;
+	float dpi = ctx->GetDpi();
+	auto logSize = ctx->GetLogicalSize();
+	float fSizeW = (logSize.right - logSize.left) * 0.03f;				// bar is 3% screen width
+	float fSizeH = (logSize.bottom - logSize.top) * 0.03f;				// bar is 3% screen height
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+	float screenSize = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	D2D1_COLOR_F centerColor;
+	float c = nitstoCCCS(nits);
+	centerColor = D2D1::ColorF(c, c, c);
+
+	switch (m_LocalDimmingBars)
+	{
+
+	case 0:				// 1-D local dimming test image
+	{
+#ifdef NOISE
+		// Draw the background noise effect
+		auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+		if (!rsc.effectIsValid)
+		{
+			title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+		}
+		else
+		{
+			float avg = nits * 0.09f;        // 9% screen area
+
+			if (m_newTestSelected)
+				SetMetadata(nits, avg, GAMUT_Native);
+
+			float APL = 5.0f;
+			float limit = 10.0f;
+			float time = m_totalTime;								// animate with the clock
+			if (m_bPaused) time = 0;								// unless paused so we fix it at 0.0
+			// ******* Arguments to this call are not type checked  *********
+			// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+			ctx->SetEffectValue(rsc.canvasEffect, L"APL", APL );		// ****** MUST BE FLOAT!
+			ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );				// nits
+			ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );					// seconds
+
+			ctx->DrawEffect(rsc.canvasEffect);
+		}
+#else
+		// draw a starfield background
+		DrawStarfield(ctx, min(nits, 10.f));						// clamp nits to max of 10
+#endif
+
+		// speckle boxes should be 30% of screen area each, not just 1/4
+		float dx = (logSize.right - logSize.left) * sqrt(0.30f);
+		float dy = (logSize.bottom - logSize.top) * sqrt(0.30f);
+		// lower left black box
+		D2D1_RECT_F LL_Rect =
+		{
+			logSize.left,			// xmin
+			logSize.top   + dy,		// ymin
+			logSize.right - dx,		// xmax
+			logSize.bottom			// ymax
+		};
+		ctx->FillRectangle(&LL_Rect, m_blackColor);
+
+		// upper right black box
+		D2D1_RECT_F UR_Rect =
+		{
+			logSize.left + dx,		// xmin
+			logSize.top,			// ymin
+			logSize.right,			// xmax
+			logSize.bottom - dy,	// ymax
+		};
+		ctx->FillRectangle(&UR_Rect, m_blackColor);
+
+		// 8% screen area center box
+		float size = screenSize * sqrtf(patchPct);  // dimensions for a square of this % screen area
+
+		// the patch jitters every frame, so it is drawn live over the recording
+		ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, centerColor); });
+	}
+	break;
+
+	case 1:													// 2-D local dimming test image
+	{
+		float avg = nits * 0.20f;        // 20% screen area
+
+		if (m_newTestSelected)
+			SetMetadata(nits, avg, GAMUT_Native);
+
+		// define the white bars
+		c = nitstoCCCS(nits);
+		barColor = D2D1::ColorF(c, c, c);
+
+		D2D1_RECT_F leftRect =
+		{
+			logSize.left,				// xmin
+			logSize.top,				// ymin
+			logSize.left + fSizeW,		// xmax
+			logSize.bottom,				// ymax
+		};
+		ctx->FillRectangle(&leftRect, barColor);
+
+		D2D1_RECT_F rightRect =
+		{
+			logSize.right - fSizeW,		// xmin
+			logSize.top,				// ymin
+			logSize.right,				// xmax
+			logSize.bottom				// ymax
+		};
+		ctx->FillRectangle(&rightRect, barColor);
+
+		D2D1_RECT_F topRect =
+		{
+			logSize.left,				// xmin
+			logSize.top,				// ymin
+			logSize.right,				// xmax
+			logSize.top + fSizeH,		// ymax
+		};
+		ctx->FillRectangle(&topRect, barColor);
+
+		D2D1_RECT_F bottomRect =
+		{
+			logSize.left,				// xmin
+			logSize.bottom - fSizeH,	// ymin
+			logSize.right,				// xmax
+			logSize.bottom				// ymax
+		};
+		ctx->FillRectangle(&bottomRect, barColor);
+
+		float size = screenSize * sqrtf(0.08f);						// dimensions for a square of this % screen area
+		D2D1_RECT_F BrightRect =
+		{
+			logSize.left + fSizeH,
+			logSize.top + center.y - size * 0.50f,
+			logSize.left + fSizeH  + size,
+			logSize.top + center.y + size * 0.50f
+		};
+		ctx->FillRectangle(&BrightRect, barColor);
+	}
+	break;
+
+	}
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float size = screenSize * sqrtf(0.08f);						// dimensions for a square of this % screen area
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+		D2D1_ELLIPSE ellipse;
+//		float bigger = sqrtf(2.0f);		// 58mm
+		float bigger = sqrtf(1.5f);		// 50mm
+
+		switch (m_LocalDimmingBars)
+		{
+		case 0:
+			ellipse =
+			{
+				D2D1::Point2F(center.x, center.y),
+				fRad, fRad
+			};
+			ctx->DrawEllipse(&ellipse, m_redColor, 2.f );
+
+			size = screenSize * sqrtf(0.05f);						// dimensions for a square of this % screen area
+
+			ellipse =
+			{
+				D2D1::Point2F(logSize.right - size * 0.5f, logSize.top + size * 0.5f),
+				fRad* bigger, fRad* bigger
+			};
+			ctx->DrawEllipse(&ellipse, m_redColor);
+
+			ellipse =
+			{
+				D2D1::Point2F(logSize.left + size * 0.5f, logSize.bottom - size * 0.5f),
+				fRad* bigger, fRad* bigger
+			};
+			ctx->DrawEllipse(&ellipse, m_redColor);
+		break;
+
+		case 1:
+			ellipse =
+			{
+				D2D1::Point2F(logSize.left + fSizeH + size*0.5f, center.y),
+				fRad, fRad
+			};
+			ctx->DrawEllipse(&ellipse, m_redColor, 2.f );
+
+			ellipse =
+			{
+				D2D1::Point2F(logSize.right - (center.y - fSizeH) - fSizeW, center.y),
+				fRad, fRad
+			};
+			ctx->DrawEllipse(&ellipse, m_redColor);
+		break;
+		}
+
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"1.2.1 Contrast test for Local Dimming: ";
+		switch (m_LocalDimmingBars)
+		{
+		case 0: title << L" 1-D";
+			break;
+		case 1: title << L" 2-D";
+			break;
+		}
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+		title << L"\nUp/Down arrows select 1D vs 2D dimming\n";
+		title << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		D2D1_RECT_F textRect = m_testTitleRect;
+		RenderText(ctx, CanvasFontLarge, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+void PatternGenerator::GenerateTestPattern_BlackLevelHDRvsSDR(PatternCanvas* ctx)			   		// v1.2.2
+{
+	// Renders 10,000 nits. This is 125.0f CCCS or 1024 HDR10.
+	D2D1_COLOR_F leftColor;
+
+	// Compute box intensity based on EDID
+	float nits = 200;
+	float avg = nits * 0.5f;                // 50% screen area
+	if (m_newTestSelected)
+		SetMetadata( m_outputDesc.MaxLuminance, avg, GAMUT_Native);
+
+	float c = nitstoCCCS(nits);
+	leftColor = D2D1::ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	D2D1_RECT_F leftRect =
+	{
+		logSize.left,
+		logSize.top,
+		logSize.right*0.5f,
+		logSize.bottom
+	};
+	ctx->FillRectangle(&leftRect, leftColor);
+
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float dpi = ctx->GetDpi();
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(logSize.right*0.25f, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 2.f);
+		ellipse =
+		{
+			D2D1::Point2F(logSize.right * 0.75f, center.y),
+			fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor);
+
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"1.2.2 Black Level in HDR vs SDR";
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f * BRIGHTNESS_SLIDER_FACTOR);
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		D2D1_RECT_F textRect = m_testTitleRect;
+		RenderText(ctx, CanvasFontLarge, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_BlackLevelCrush(PatternCanvas* ctx)		       		// v1.2.3
+{
+	float nitsList[] = { 0.5f, 0.3f, 0.1f, 0.05f, 0.0f };
+	float nits = nitsList[m_currentBlack];
+
+	if (m_newTestSelected)
+		SetMetadata(m_outputDesc.MaxLuminance, nits, GAMUT_Native);
+
+	// Get fp16 color of this nit level
+	float c = nitstoCCCS(nits) / BRIGHTNESS_SLIDER_FACTOR;
+
+	// get that color
+	D2D1_COLOR_F darkColor;
+	darkColor = D2D1::ColorF(c, c, c);
+
+	// get entire screen rect and fill it
+	auto logSize = ctx->GetLogicalSize();
+	ctx->FillRectangle(&logSize, darkColor);
+
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << L"v1.2.3 Black Level Crush Test: ";
+		title << fixed << setw(8) << setprecision(2);
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f);
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_SubTitleFlicker(PatternCanvas* ctx)	        		// v1.2.4
+{
+	// Draw the center patch:
+	float nits = 10.0f;		// per specification
+	float c;
+	c = nitstoCCCS(nits) / BRIGHTNESS_SLIDER_FACTOR;
+
+	float avg = nits;
+	if (m_newTestSelected)
+		SetMetadata(m_outputDesc.MaxLuminance, avg, GAMUT_Native);
+
+	// get bounds of entire window
+	auto logSize = ctx->GetLogicalSize();
+	std::wstringstream title;
+
+#ifdef NOISE
+	// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		float noiseAPL = 5.0f;
+		float limit = 10.0f;
+		float time = m_totalTime;								// animate with the clock
+		if (m_bPaused) time = 0;								// unless paused so we fix it at 0.0
+		// ******* Arguments to this call are not type checked  *********
+		// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+		ctx->SetEffectValue(rsc.canvasEffect, L"APL", noiseAPL );		// ****** MUST BE FLOAT!
+		ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );					// nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );						// seconds
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+#else
+	// draw a starfield background
+	DrawStarfield(ctx, min(nits, 10.f));						// clamp nits to max of 10
+#endif
+
+	// the center patch
+	// same brightness as everything else
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	float patchPct = PATCHPCT;
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	// the patch jitters every frame, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, centerColor); });
+
+	// draw the Subtitle text
+	if (m_subtitleVisible & 0x01)			// only switch visibility on last bit
+	{
+		// set the sub title color
+		float textNits = 200.0f;			// bright white
+		float cs = nitstoCCCS(textNits) / BRIGHTNESS_SLIDER_FACTOR;
+
+		D2D1_COLOR_F subtitleColor;
+		subtitleColor = D2D1::ColorF(cs, cs, cs);
+
+		std::wstring subtitle = L"This is a subtitle text string for testing";
+		float ctrx = (logSize.right + logSize.left) * 0.5f;
+		D2D1_RECT_F subtitleRect =
+		{
+			ctrx - 500.0f, logSize.bottom - 150.f,
+			ctrx + 600.0f, logSize.bottom
+		};
+
+		// the text box is { left, top, width, height } and the layout extends to the rect's far corner
+		D2D1_RECT_F textBox = { subtitleRect.left, subtitleRect.top, subtitleRect.right, subtitleRect.bottom };
+		D2D1_RECT_F shadowBox = { subtitleRect.left + 1.f, subtitleRect.top + 1.f, subtitleRect.right, subtitleRect.bottom };
+
+		// draw the subtitle with a black dropshadow underneath
+		ctx->DrawString(CanvasFontSubtitle, subtitle, shadowBox, m_blackColor);
+		ctx->DrawString(CanvasFontSubtitle, subtitle, textBox, subtitleColor);
+	}
+
+	if (m_showExplanatoryText)
+	{
+		title << L"1.2.4 Subtitle Flicker Test: ";
+		title << fixed << setw(8) << setprecision(2);
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << NitsToPQ10Code(c * 80.f);
+		title << L"\n<Ctrl> key toggles subtitles";
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_XRiteColors(PatternCanvas* ctx)						// v1.2.5
+{
+	if (m_newTestSelected)
+	{
+		SetMetadata(m_outputDesc.MaxLuminance, m_outputDesc.MaxLuminance * 0.08f, GAMUT_Native);
+		m_testTimeRemainingSec = 1.0f;			// 1 seconds  be sure we are set up for animation
+	}
+
+	float3 colorXYZ;
+	colorXYZ.x = (float)XRite[m_currentXRiteIndex].X/100.f;
+	colorXYZ.y = (float)XRite[m_currentXRiteIndex].Y/100.f;
+	colorXYZ.z = (float)XRite[m_currentXRiteIndex].Z/100.f;
+
+	// convert to 709 gamut space	
+	float3 color709 = XYZ_to_709RGB * colorXYZ;
+
+#if 0
+	if (CheckHDR_On())
+		ColorCCCS = Apply2084(Color709);
+	else
+		ColorCCCS = ApplySRGBCurve(Color709);
+#endif
+
+	float3 colorHDR10;
+	colorHDR10.r = XRite[m_currentXRiteIndex].R;
+	colorHDR10.g = XRite[m_currentXRiteIndex].G;
+	colorHDR10.b = XRite[m_currentXRiteIndex].B;
+
+	
+	// convert to Canonical Composition Color Space for desktop compositor
+	float3 colorCCCS = HDR10ToLinear709( colorHDR10 );
+
+	// scale up for white level selected now we are linear
+	colorCCCS = colorCCCS * (float)(0.01f * WhiteLevelBrackets[m_whiteLevelBracket]);
+
+	float factor = (1024.f + m_XRiteIntensity) / 1024.f;
+	colorCCCS = colorCCCS * factor;
+
+	float nits = PQ10CodeToNits(1023);		// go to linear space
+//	float c = nitstoCCCS(nits / BRIGHTNESS_SLIDER_FACTOR);		// scale by 80 and slider
+
+	std::wstringstream title;
+	auto logSize = ctx->GetLogicalSize();
+
+#ifdef NOISE
+// Draw the background noise effect
+	auto& rsc = GetTestPatternDesc(TestPattern::TenPercentPeak).resources;
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		float TierMaxLum = GetTierLuminance(m_testingTier);
+		float noiseAPL = TierMaxLum * TARGETAPL/(1.f - PATCHPCT);
+		float limit = 100.0f;
+		float time = m_totalTime;								// animate with the clock
+		if (m_bPaused) time = 0;								// unless paused so we fix it at 0.0
+		// ******* Arguments to these calls are not type checked  *********
+		// ******* DO NOT PASS A DOUBLE HERE (EVEN LITERAL!) *** ELSE FAIL ************* 
+		ctx->SetEffectValue(rsc.canvasEffect, L"APL", noiseAPL);	// ****** MUST BE FLOAT!	// fraction of screen
+		ctx->SetEffectValue(rsc.canvasEffect, L"Clamp", limit );								// nits
+		ctx->SetEffectValue(rsc.canvasEffect, L"iTime", time );									// seconds
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+#else
+	// draw a starfield background
+	DrawStarfield(ctx, min(nits, 100.f));						// clamp nits to max of 100
+#endif
+
+	// this color
+	D2D1_COLOR_F centerColor;
+	centerColor = D2D1::ColorF(colorCCCS.r, colorCCCS.g, colorCCCS.b);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	float patchPct = PATCHPCT;
+	size = size * sqrtf(patchPct);  // dimensions for a square of this % screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+
+	float dpi = ctx->GetDpi();
+
+	// the patch jitters every frame, so it is drawn live over the recording
+	ctx->DrawLive([=](PatternCanvas* target) { FillJitteredPatch(target, center, size, centerColor); });
+
+	if (m_showExplanatoryText)
+	{
+		float fRad = 0.5f * m_snoodDiam / 25.4f * dpi * 1.2f;      // radius of dia 27mm -> inches -> dips
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		D2D1_ELLIPSE ellipse =
+		{
+			D2D1::Point2F(center.x, center.y),
+			fRad, fRad						// TODO: make target diameter 27mm using DPI data
+		};
+
+		ctx->DrawEllipse(&ellipse, m_redColor, 2 );
+
+		title << fixed << setprecision(0);
+
+		title << L"1.2.5 X-Rite\u2122 Colors\n";
+		title << L"Color#: ";
+		title << setw(3) << XRite[m_currentXRiteIndex].num;
+		title << L"   RxC: ";
+		title << setw(2) << XRite[m_currentXRiteIndex].row;
+		title << L"|";
+		title << XRite[m_currentXRiteIndex].col;
+		title << setbase(16) << L"   RGB  ";
+		title << setw(6) << XRite[m_currentXRiteIndex].RGB;
+		title << L" - adjust using arrow keys";
+		title << setbase(10) << L"\n White Level: ";
+		title << WhiteLevelBrackets[m_whiteLevelBracket];
+		title << L" - change bracket using [,] keys";
+//		title << setw(3) << m_XRiteIntensity;
+//		title << L" adjust using Up/Down arrow keys";
+		title << setprecision(1) << L"\nAuto advance using 'A' key.\n";
+		title << L"  Advances every " << m_XRitePatchDisplayTime << "sec";
+		title << " - change timing using +/- keys";
+		if (m_XRitePatchAutoMode)
+			title << L"\n  Auto Advance ON";
+		title << L"\n";
+		title << m_hideTextString;
+
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+#if 0
+	std::wstringstream title;
+	title << L"3.b Full-frame white for 30 minutes: ";
+	if (0.0f != m_testTimeRemainingSec)
+	{
+		title << static_cast<unsigned int>(m_testTimeRemainingSec);
+		title << L" seconds remaining";
+		title << L"\nRenders HDR10 max (10,000 nits)";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << NitsToPQ10Code(c * 80.f);
+		title << L"\n" << m_hideTextString;
+	}
+	else
+	{
+		title << L" done.";
+	}
+	RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+#endif
+	m_newTestSelected = false;
+
+}
+
+
+void PatternGenerator::GenerateTestPattern_EndOfMandatoryTests(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+    text << L"This is the end of mandatory test content.\n";
+    text << L"Optional/informative tests follow.";
+
+    RenderText(ctx, CanvasFontLarge, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_SharpeningFilter(PatternCanvas* ctx)
+{
+	auto& rsc = GetTestPatternDesc(TestPattern::SharpeningFilter).resources;
+
+	// Overload the color selector to allow selecting the desired SDR white level.
+	float nits = 80.0f;
+	switch (m_currentColor)
+	{
+	case 0:
+		nits = 80.0f;
+		break;
+	case 1:
+		nits = 160.0f;
+		break;
+	case 2:
+		nits = 240.0f;
+		break;
+	case 3:
+		nits = 320.0f;
+		break;
+	default:
+		throw std::invalid_argument("m_currentColor");
+		break;
+	}
+	if (m_newTestSelected)
+		SetMetadata(m_outputDesc.MaxLuminance, nits * 0.50f, GAMUT_Native); SetMetadataNeutral();
+
+	std::wstringstream title;
+
+	// TODO: Convert to a generalized custom effect pipeline.
+	if (!rsc.effectIsValid)
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+	else
+	{
+		auto out = ctx->GetOutputSize();
+		D2D1_POINT_2F center = { (out.right - out.left) / 2.0f, (out.bottom - out.top) / 2.0f };
+
+		// Initial wavelength of sine wave at the centerpoint.
+		float init = 30.0f;
+
+		// How many pixels before the wavelength halves.
+		float dist = (out.right - out.left) / 4.0f;
+
+		ctx->SetEffectValue(rsc.canvasEffect, L"Center", center);
+		ctx->SetEffectValue(rsc.canvasEffect, L"InitialWavelength", init);
+		ctx->SetEffectValue(rsc.canvasEffect, L"WavelengthHalvingDistance", dist);
+		ctx->SetEffectValue(rsc.canvasEffect, L"WhiteLevelMultiplier", nitstoCCCS(nits));
+
+		ctx->DrawEffect(rsc.canvasEffect);
+	}
+
+	if (m_showExplanatoryText)
+	{
+		D2D1_COLOR_F blackColor;
+		blackColor = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+		ctx->FillRectangle(m_testTitleRect, blackColor);
+		title << fixed << setw(8) << setprecision(2);
+		title << rsc.testTitle << "\nUsing reference level of : " << nits;
+		title << " nits.\nUp & Down arrow keys select white level.\n";
+		RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_ToneMapSpike(PatternCanvas* ctx)
+{
+    auto& rsc = GetTestPatternDesc(TestPattern::ToneMapSpike).resources;
+
+    // Overload the color selector to set the level we tone map the content to
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+//		nits = m_outputDesc.MaxLuminance;
+		nits = 350.0f;
+		SetMetadata(nits, nits*0.1f, GAMUT_Native);
+        break;
+    case 1:
+        nits = 700.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+		break;
+    case 2:
+        nits = 1015.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+		break;
+    case 3:
+        nits = 10000.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+        break;
+    default:
+        throw std::invalid_argument("m_currentColor");
+        break;
+    }
+//	if (m_newTestSelected)
+//		SetMetadata(m_outputDesc.MaxLuminance, nits*0.50f, GAMUT_Native); SetMetadataNeutral();
+
+    std::wstringstream title;
+
+    // TODO: Convert to a generalized custom effect pipeline.
+	D2D1_POINT_2F center;
+	center.x = 640.f;
+	center.y = 360.f;
+
+	if (!rsc.effectIsValid)
+    {
+        title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+    }
+    else
+    {
+        auto out = ctx->GetOutputSize();
+        center = { (out.right - out.left) / 2.0f, (out.bottom - out.top) / 2.0f };
+
+        // Initial wavelength of sine wave at the centerpoint.
+        float init = 30.0f;
+
+        // How many pixels before the wavelength halves.
+        float dist = (out.right - out.left) / 4.0f;
+
+        ctx->SetEffectValue(rsc.canvasEffect, L"Center", center);
+        ctx->SetEffectValue(rsc.canvasEffect, L"InitialWavelength", init);
+        ctx->SetEffectValue(rsc.canvasEffect, L"WavelengthHalvingDistance", dist);
+        ctx->SetEffectValue(rsc.canvasEffect, L"WhiteLevelMultiplier", nitstoCCCS(nits));
+
+        ctx->DrawEffect(rsc.canvasEffect);
+    }
+
+    if (m_showExplanatoryText)
+    {
+		auto logSize = ctx->GetLogicalSize();
+
+		float fRad = sqrtf(center.x * center.y *4.0f / M_PI_F);	// 100% screen area circle
+		D2D1_ELLIPSE ellipse =
+		{
+			center, fRad, fRad
+		};
+		ctx->DrawEllipse(&ellipse, m_redColor, 1);
+
+		float OPR = 0.10f;									// 10% screen area for maxLuminance
+		float fR = fRad * sqrt(OPR);
+		D2D1_ELLIPSE ellipse10 =
+		{
+			center, fR, fR
+		};
+		ctx->DrawEllipse(&ellipse10, m_redColor, 2);
+
+		OPR = 0.0001f;									// 0.01% screen area for sun (noise rejection limit)
+		fR = fRad * sqrt(OPR);
+		D2D1_ELLIPSE ellipse0001 =
+		{
+			center, fR, fR
+		};
+		ctx->DrawEllipse(&ellipse0001, m_redColor, 3);
+		
+		D2D1_COLOR_F blackColor;
+        blackColor = D2D1::ColorF(0.0f, 0.0f, 0.0f);
+        ctx->FillRectangle(m_testTitleRect, blackColor);
+		title << fixed << setw(8) << setprecision(0);
+        title << rsc.testTitle << "\nTone Mapping to : "  << nits;
+        title << " nits.\nUp & Down arrow keys select level.\n";
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_StaticGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, D2D1::Point2F(0, 0), D2D1::Point2F(rect.right, 0), m_gradientStops, (uint32_t)std::size(m_gradientStops));
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream text;
+        text << L"Static Gradient: R(" << to_string_with_precision(m_gradientColor.r)
+            << L") G(" << to_string_with_precision(m_gradientColor.g)
+            << L") B(" << to_string_with_precision(m_gradientColor.b)
+            << L")\n";
+        text << L"A/S: increment gradient color\n" << m_hideTextString;
+
+        RenderText(ctx, CanvasFontLarge, text.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_AnimatedGrayGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, D2D1::Point2F(0, 0), D2D1::Point2F(rect.right, 0), m_gradientStops, (uint32_t)std::size(m_gradientStops));
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstring text = L"Animated Gray Gradient\n" + m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, text, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_AnimatedColorGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, D2D1::Point2F(0, 0), D2D1::Point2F(rect.right, 0), m_gradientStops, (uint32_t)std::size(m_gradientStops));
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstring text = L"Animated Color Gradient\n" + m_hideTextString;
+        RenderText(ctx, CanvasFontLarge, text, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void PatternGenerator::GenerateTestPattern_FullFrameSDRWhite(PatternCanvas* ctx)
+{
+    // Default metadata is used because this simulates a desktop environment.
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // Overload the color selector to allow selecting the desired SDR white level.
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+        nits = 80.0f;
+        break;
+    case 1:
+        nits = 160.0f;
+        break;
+    case 2:
+        nits = 240.0f;
+        break;
+    case 3:
+        nits = 320.0f;
+        break;
+    default:
+        throw std::invalid_argument("m_currentColor");
+        break;
+    }
+
+    D2D1_COLOR_F whiteColor;
+    whiteColor = D2D1::ColorF(nitstoCCCS(nits), nitstoCCCS(nits), nitstoCCCS(nits));
+    ctx->FillRectangle(ctx->GetLogicalSize(), whiteColor);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"Full frame SDR white\nUsing reference level of: " << nits;
+        title << " nits.\nUp & Down arrow keys select white level.\n";
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_FullFrameSDRWhiteWithHDR(PatternCanvas* ctx)
+{
+    // Default metadata is used because this simulates a desktop environment.
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // Overload the color selector to allow selecting the desired HDR highlight level.
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+        // Default case is to use the display's reported max nits.
+        nits = m_outputDesc.MaxLuminance;
+        break;
+    case 1:
+        nits = 600.0f;
+        break;
+    case 2:
+        nits = 1000.0f;
+        break;
+    case 3:
+        nits = 1400.0f;
+        break;
+    default:
+        throw std::invalid_argument("m_currentColor");
+        break;
+    }
+
+    // SDR full frame background is locked at 240 nits.
+    float sdrNits = 240.0f;
+
+    D2D1_COLOR_F sdrColor;
+    sdrColor = D2D1::ColorF(nitstoCCCS(sdrNits), nitstoCCCS(sdrNits), nitstoCCCS(sdrNits));
+
+    D2D1_COLOR_F hdrColor;
+    hdrColor = D2D1::ColorF(nitstoCCCS(nits), nitstoCCCS(nits), nitstoCCCS(nits));
+
+    auto logSize = ctx->GetLogicalSize();
+    D2D1_RECT_F tenPercentRect =
+    {
+        (logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f)
+    };
+
+    ctx->FillRectangle(&logSize, sdrColor);
+    ctx->FillRectangle(&tenPercentRect, hdrColor);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"Full frame SDR white with 10% HDR window (" << nits;
+        title << " nits).\nUp & Down arrow keys select HDR nits.\n";
+
+        RenderText(ctx, CanvasFontLarge, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true );
+	}
+
+    m_newTestSelected = false;
+}
+
+
+// Common method to render the current test's image to the screen.
+void PatternGenerator::GenerateTestPattern_ImageCommon(PatternCanvas* ctx)
+{
+    const TestPatternResources& resources = GetTestPatternDesc(m_currentTest).resources;
+
+    // SetMetadata depending on if we tone mapped the image or not
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    if (resources.imageIsValid == true)
+    {
+        // Center the image, draw at 1.0x (pixel) zoom.
+        // TODO: Currently we force all D2D rendering to 96 DPI regardless of display DPI.
+        // Therefore DIPs = pixels.
+        auto targetSize = ctx->GetOutputSize();
+        unsigned int width = resources.imageWidth, height = resources.imageHeight;
+
+        float dX = (targetSize.right - targetSize.left - static_cast<float>(width)) / 2.0f;
+        float dY = (targetSize.bottom - targetSize.top - static_cast<float>(height)) / 2.0f;
+
+        ctx->DrawImage((CanvasImage)m_currentTest, D2D1::Point2F(dX, dY));
+    }
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream text;
+        text << resources.testTitle << L"\n" << m_hideTextString;
+
+        if (resources.imageIsValid == false)
+        {
+            text << L"\nERROR: " << resources.imageFilename << " is missing.";
+        }
+
+        RenderText(ctx, CanvasFontLarge, text.str(), m_testTitleRect);
+    }
+
+    m_newTestSelected = false;
+}
+
+void PatternGenerator::GenerateTestPattern_EndOfTest(PatternCanvas* ctx)
+{
+    std::wstringstream text;
+    text << L"This is the end of the test content.\n";
+    text << L"Press ALT-F4 to quit.";
+
+    RenderText(ctx, CanvasFontLarge, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+
+}
+
+// Draws the current test pattern.  Everything common to all test patterns, such as
+// BeginDraw/EndDraw, is left to the caller.
+void PatternGenerator::Render(PatternCanvas& canvas)
+{
+    const TestPatternDesc& desc = GetTestPatternDesc(m_currentTest);
+    if (!desc.generate)
+        throw std::logic_error("test pattern has no generator");
+
+    (this->*desc.generate)(&canvas);
+}
+
+// Whether the current pattern can be replayed from a recording.  If so, key is what its
+// recorded countdowns and flashes show, and the pattern is recorded again when it changes.
+// Jittered patches and running timers go through DrawLive instead, so they do not change
+// the key.  Patterns that move with the clock throughout return false.
+bool PatternGenerator::GetPatternAnimationKey(uint64_t* key)
+{
+    // countdowns show whole seconds, or "done" at zero
+    uint64_t seconds = m_testTimeRemainingSec > 0.0f ? (uint64_t)m_testTimeRemainingSec + 1 : 0;
+
+    *key = 0;
+    switch (GetTestPatternDesc(m_currentTest).animation)
+    {
+    case AnimationCountdown:
+        *key = seconds;
+        break;
+
+    case AnimationFlash:
+        *key = seconds * 2 + (m_flashOn ? 1 : 0);
+        break;
+
+    case AnimationLive:
+        return false;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+// The starfield background of the patch tests, with stars up to maxNits.  Over the whole
+// screen it averages TARGETAPL/(1 - PATCHPCT) in linear light, so what the patch leaves of it
+// averages TARGETAPL.  Stars are generated once per size and level, and drawn as one batch.
+void PatternGenerator::DrawStarfield(PatternCanvas* ctx, float maxNits)
+{
+    auto logSize = ctx->GetLogicalSize();
+    StarfieldKey key = { logSize.right - logSize.left, logSize.bottom - logSize.top, maxNits, TARGETAPL / (1.f - PATCHPCT) };
+
+    auto it = m_starfields.find(key);
+    if (it == m_starfields.end())
+    {
+        // a handful of sizes and tiers in use at once; more means the window is being resized
+        if (m_starfields.size() >= 8)
+            m_starfields.clear();
+        it = m_starfields.emplace(key, std::make_unique<Starfield>(key)).first;
+    }
+    assert(it->second->Reached());		// debug builds: APL() fell short of the target it could reach
+    it->second->Draw(ctx);
+}
+
+// One frame of the current test pattern onto canvas.  No time passes offscreen, so
+// animations and count-downs stay at their first frame.
+void PatternGenerator::RenderOffscreen(PatternCanvas& canvas)
+{
+    // the target stands in for both the window and the panel's mode
+    D2D1_RECT_F outputSize = canvas.GetOutputSize();
+    m_modeWidth = static_cast<int32_t>(outputSize.right - outputSize.left);
+    m_modeHeight = static_cast<int32_t>(outputSize.bottom - outputSize.top);
+    LayoutText(canvas.GetLogicalSize());
+
+    Update(0.0f, 0.0f);
+
+    canvas.Clear(D2D1::ColorF(D2D1::ColorF::Black, 1));
+    Render(canvas);
+}
+
+// Note: textPos is interpreted as { Left, Top, ***Width***, ***Height*** } which is different from the
+// definition of D2D1_RECT_F
+void PatternGenerator::RenderText(PatternCanvas* ctx, CanvasFont font, std::wstring text, D2D1_RECT_F textPos, bool useBlackText /* = false */)
+{
+    D2D1_RECT_F shadowPos = { textPos.left + 1.f, textPos.top + 1.f, textPos.right, textPos.bottom };
+
+	if (useBlackText)
+    {
+		// add highlight
+//		ctx->DrawString(font, text, textPos, m_whiteColor);
+		ctx->DrawString(font, text, shadowPos, m_blackColor);
+    }
+    else
+    {
+		// add dropshadow
+		ctx->DrawString(font, text, shadowPos, m_blackColor);
+		ctx->DrawString(font, text, textPos, m_whiteColor);
+    }
+
+
+
+}
+
+// Places the text for a target of the given size in DIPs.
+void PatternGenerator::LayoutText(D2D1_RECT_F logicalSize)
+{
+    // D2D1_RECT_F is defined as: Left, Left, Right, Bottom
+    // But we will interpret the struct members as: Left, Left, Width, Height
+    // This lets us pack the size (for IDWriteTextLayout) and offset (for DrawText)
+    // into a single struct.
+    m_testTitleRect = { 0.0f, 0.0f, 800.0f, 100.0f };
+
+    m_largeTextRect =
+    {
+        (logicalSize.right - logicalSize.left) * 0.15f,
+        (logicalSize.bottom - logicalSize.top) * 0.15f,
+        (logicalSize.right - logicalSize.left) * 0.75f,
+        (logicalSize.bottom - logicalSize.top) * 0.75f
+    };
+
+	m_MetadataTextRect =
+	{
+		logicalSize.right - 700.0f,
+		logicalSize.bottom - 35.0f,
+		logicalSize.right,
+		logicalSize.bottom
+	};
+
+	m_TestingTierTextRect =
+	{
+		logicalSize.right - 200.0f,
+		logicalSize.top,
+		logicalSize.right,
+		logicalSize.top + 35.f
+	};
+}
+
+// Set increment = true to go up, false to go down.
+void PatternGenerator::SetTestPattern(TestPattern testPattern)
+{
+    // save previous pattern in cache
+    if (testPattern == TestPattern::Cooldown
+        && m_currentTest != TestPattern::Cooldown)
+        m_cachedTest = m_currentTest;
+
+    if (TestPattern::StartOfTest <= testPattern)
+    {
+
+        if (TestPattern::Cooldown >= testPattern)
+        {
+            m_currentTest = testPattern;
+        }
+    }
+
+    //	m_showExplanatoryText = true;
+    m_newTestSelected = true;
+}
+
+// Set increment = true to go up, false to go down.
+void PatternGenerator::ChangeTestPattern(bool increment)
+{
+    if (TestPattern::Cooldown == m_currentTest)
+    {
+        m_currentTest = m_cachedTest;
+		m_newTestSelected = true;
+        return;
+    }
+
+    if (increment)
+    {
+        if (TestPattern::EndOfTest == m_currentTest)
+        {
+            // Clamp to the end of the list.
+        }
+        else
+        {
+            unsigned int testInt = static_cast<unsigned int>(m_currentTest) + 1;
+            m_currentTest = static_cast<TestPattern>(testInt);
+        }
+    }
+    else
+    {
+        if (TestPattern::StartOfTest == m_currentTest)
+        {
+            // Clamp to the start of the list.
+        }
+        else
+        {
+            unsigned int testInt = static_cast<unsigned int>(m_currentTest) - 1;
+            m_currentTest = static_cast<TestPattern>(testInt);
+        }
+    }
+
+    //	m_showExplanatoryText = true;
+    m_newTestSelected = true;
+}
+
+void PatternGenerator::SetShift(bool shift)
+{
+	m_shiftKey = shift;
+}
+
+bool PatternGenerator::GetShift( void )
+{
+	return( m_shiftKey );
+}
+
+void PatternGenerator::ChangeSubtest( int32_t increment )		// called from up/down arrow keys (at least)
+{
+	m_contentChanged = true;
+	if (m_shiftKey)
+		increment *= 10;
+
+	const TestPatternDesc& desc = GetTestPatternDesc(m_currentTest);
+	if (desc.changeSubtest)
+		(this->*desc.changeSubtest)(increment);
+}
+
+// How many frames ChangeSubtest(+1) steps the current test through before it wraps around.
+// Where it steps the testing tier or a calibration value this is 1: offscreen, the tier is
+// chosen with InitializeOffscreen and calibration values stay at their defaults.
+int PatternGenerator::GetSubtestCount()
+{
+	// ProfileCurve depends on the panel, so its count is only known once it has been drawn.
+	if (m_currentTest == TestPattern::ProfileCurve)
+		return m_maxProfileTile + 1;
+
+	return GetTestPatternDesc(m_currentTest).subtestCount;
+}
+
+void PatternGenerator::ChangeSubtest_TestingTier(int32_t increment)
+{
+	int testTier = (int)m_testingTier;
+	testTier += increment;
+	testTier = clamp(testTier, (int)TestingTier::DisplayHDR400, (int)TestingTier::DisplayHDR10000);
+	m_testingTier = (TestingTier)testTier;
+}
+
+void PatternGenerator::ChangeSubtest_StaticContrastRatio(int32_t increment)
+{
+	if (CheckHDR_On())
+	{
+		m_staticContrastPQValue += increment;
+		m_staticContrastPQValue = clamp(m_staticContrastPQValue, 100, 750);		// 1..?? nits
+	}
+	else
+	{
+		m_staticContrastsRGBValue += increment;
+		m_staticContrastsRGBValue = clamp(m_staticContrastsRGBValue, 0.f, 255.f);
+	}
+}
+
+void PatternGenerator::ChangeSubtest_ActiveDimming(int32_t increment)
+{
+	m_activeDimming50PQValue += increment;
+	m_activeDimming50PQValue = clamp(m_activeDimming50PQValue, 420, 488);	// 35..75 nits
+}
+
+void PatternGenerator::ChangeSubtest_ActiveDimmingDark(int32_t increment)
+{
+	m_activeDimming05PQValue += increment;
+	m_activeDimming05PQValue = clamp(m_activeDimming05PQValue, 208, 292); 	// 2.5..8 nits
+}
+
+void PatternGenerator::ChangeSubtest_MaxEffectiveValue(int32_t increment)
+{
+	if (CheckHDR_On())
+	{
+		m_maxEffectivePQValue += increment;
+		m_maxEffectivePQValue = clamp(m_maxEffectivePQValue, 0.0f, 10000.0f);
+	}
+	else
+	{
+		m_maxEffectivesRGBValue += increment;
+		m_maxEffectivesRGBValue = clamp(m_maxEffectivesRGBValue, 0.0f, 255.0f);
+	}
+}
+
+void PatternGenerator::ChangeSubtest_MaxFullFrameValue(int32_t increment)
+{
+	if (CheckHDR_On())
+	{
+		m_maxFullFramePQValue += increment;
+		m_maxFullFramePQValue = clamp(m_maxFullFramePQValue, 0.0f, 10000.0f);
+	}
+	else
+	{
+		m_maxFullFramesRGBValue += increment;
+		m_maxFullFramesRGBValue = clamp(m_maxFullFramesRGBValue, 0.0f, 255.0f);
+	}
+}
+
+void PatternGenerator::ChangeSubtest_MinEffectiveValue(int32_t increment)
+{
+	if (CheckHDR_On())
+	{
+		m_minEffectivePQValue += increment;
+		m_minEffectivePQValue = clamp(m_minEffectivePQValue, 0.0f, 10000.0f);
+	}
+	else
+	{
+		m_minEffectivesRGBValue += increment;
+		m_minEffectivesRGBValue = clamp(m_minEffectivesRGBValue, 0.0f, 255.0f);
+	}
+}
+
+// These all rotate among R, G, B, and W.
+void PatternGenerator::ChangeSubtest_Color(int32_t increment)
+{
+	m_currentColor -= increment;
+	m_currentColor = (int) wrap( (float)m_currentColor, 0.f, 3.f );	// Just wrap on each end
+}
+
+void PatternGenerator::ChangeSubtest_ProfileCurve(int32_t increment)
+{
+	m_currentProfileTile += increment;
+	m_currentProfileTile = (int) wrap((float)m_currentProfileTile, 0.f, (float)m_maxProfileTile);
+}
+
+void PatternGenerator::ChangeSubtest_LocalDimmingContrast(int32_t increment)		// swtich white bars based on tier
+{
+	m_LocalDimmingBars -= increment;
+	m_LocalDimmingBars = (int) wrap((float)m_LocalDimmingBars, 0.f, 1.f);	// Just wrap on each end <inclusive!>
+	m_newTestSelected = true;
+}
+
+void PatternGenerator::ChangeSubtest_BlackLevelCrush(int32_t increment)			// rotate through 4 fulllscreen background colors
+{
+	m_currentBlack -= increment;
+	m_currentBlack = (int) wrap((float)m_currentBlack, 0.f, 4.f);	// Just wrap on each end <inclusive!>
+}
+
+void PatternGenerator::ChangeSubtest_XRiteColors(int32_t increment)				// cycle through the official Xrite patch colors
+{
+	if (m_XRitePatchAutoMode)
+		return;									// ignore arrow keys if auto advancing
+	m_currentXRiteIndex += increment;
+	m_currentXRiteIndex = (int)wrap((float)m_currentXRiteIndex, 0.f, NUMXRITECOLORS);	// Just wrap on each end <inclusive!>
+
+#if 0
+	if (CheckHDR_On())
+	{
+		m_XRiteIntensity += increment;
+		m_XRiteIntensity = clamp(m_XRiteIntensity, -50, 50 );		// delta plus or minus
+	}
+#endif
+}
+
+void PatternGenerator::ChangeSubtest_StaticGradient(int32_t increment)
+{
+	if ( increment < 0 )
+		ChangeGradientColor(-0.05f, -0.05f, -0.05f);
+	else
+		ChangeGradientColor(+0.05f, +0.05f, +0.05f);
+}
+
+void PatternGenerator::ChangeGradientColor(float deltaR, float deltaG, float deltaB)
+{
+    m_contentChanged = true;
+    m_gradientColor.r += deltaR;
+    m_gradientColor.g += deltaG;
+    m_gradientColor.b += deltaB;
+}
+
+void PatternGenerator:: ChangeCheckerboard( int32_t increment )
+{
+	m_contentChanged = true;
+	if (m_currentTest == TestPattern::XRiteColors)
+	{
+		if (m_XRitePatchAutoMode)
+			return;									// ignore arrow keys if auto advancing
+		m_currentXRiteIndex += increment;
+		m_currentXRiteIndex = (int)wrap((float)m_currentXRiteIndex, 0.f, NUMXRITECOLORS);	// Just wrap on each end <inclusive!>
+
+		return;
+	}
+
+	if (increment < 0)
+	{
+		if (Checkerboard::Cb4x3not == m_checkerboard )
+		{
+			// Wrap to the start of the list.
+			m_checkerboard = Checkerboard::Cb6x4;
+		}
+		else
+		{
+			unsigned int checkInt = static_cast<unsigned int>(m_checkerboard) + 1;
+			m_checkerboard = static_cast<Checkerboard>(checkInt);
+		}
+	}
+	else // (increment > 0)
+	{
+		if (Checkerboard::Cb6x4 == m_checkerboard)
+		{
+			// Wrap to the end of the list.
+			m_checkerboard = Checkerboard::Cb4x3not;
+		}
+		else
+		{
+			unsigned int checkInt = static_cast<unsigned int>(m_checkerboard) - 1;
+			m_checkerboard = static_cast<Checkerboard>(checkInt);
+		}
+	}
+}
+
+void PatternGenerator::StartTestPattern(void)
+{
+    m_contentChanged = true;
+    m_currentTest = TestPattern::StartOfTest;
+    // m_showExplanatoryText = true;
+}
+
+// Many test patterns can be affected by the presence of explanatory text.
+// Allow user to toggle visibility on/off for each test pattern.
+// Returns whether the visibility is true or false after the update.
+bool PatternGenerator::ToggleInfoTextVisible()
+{
+    m_contentChanged = true;
+    m_showExplanatoryText = !m_showExplanatoryText;
+    return m_showExplanatoryText;
+}
+
+bool PatternGenerator::ToggleSubtitle()
+{
+	m_contentChanged = true;
+	m_subtitleVisible = !m_subtitleVisible;
+	return m_subtitleVisible;
+}
+
+bool PatternGenerator::PauseAnimation()
+{
+	m_contentChanged = true;
+	m_bPaused = !m_bPaused;
+	return m_bPaused;
+}
+
+void PatternGenerator::ToggleXRitePatchAuto( void )
+{
+	m_contentChanged = true;
+	m_XRitePatchAutoMode = !m_XRitePatchAutoMode;
+
+	if (m_XRitePatchAutoMode)				// reset counter on mode start
+	{
+		m_currentXRiteIndex = 0;
+		m_testTimeRemainingSec = m_XRitePatchDisplayTime;
+	}
+}
+
+// used to manually correct for monitor not being exactly PQ/2084 profile
+void PatternGenerator::ChangeXRitePatchDisplayTime(int32_t increment)
+{
+	m_contentChanged = true;
+	if (m_shiftKey)
+		increment *= 10;
+
+	if (m_currentTest == TestPattern::XRiteColors)
+	{
+		m_XRitePatchDisplayTime += increment * 0.1f;
+		return;
+	}
+}
+
+// select brightness level for color patch test - usually based on target testing tier
+void PatternGenerator::SelectWhiteLevel(int32_t increment)
+{
+	m_contentChanged = true;
+	if (increment > 0)
+	{
+		m_whiteLevelBracket++;
+		if (m_whiteLevelBracket > NUM_WBRACKETS-1)
+			m_whiteLevelBracket = 0;					// wrap
+	}
+
+	if (increment < 0)
+	{
+		m_whiteLevelBracket--;
+		if (m_whiteLevelBracket < 0)
+			m_whiteLevelBracket = NUM_WBRACKETS - 1;	// wrap
+	}
+}
+
+void PatternGenerator::SetWhiteLevelBracket(int32_t bracket)
+{
+	m_contentChanged = true;
+	m_whiteLevelBracket = std::max(0, std::min(bracket, NUM_WBRACKETS - 1));
+}
+
+uint32_t PatternGenerator::GetWhiteLevelNits()
+{
+	return WhiteLevelBrackets[m_whiteLevelBracket];
+}
+
+// Whether the test draws differently for each of the WhiteLevelBrackets
+bool PatternGenerator::UsesWhiteLevel(TestPattern test)
+{
+	return test == TestPattern::XRiteColors;
+}
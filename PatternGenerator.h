@@ -0,0 +1,445 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include "BasicMath.h"
+#include "GamutCache.h"
+#include "PatternCanvas.h"
+#include "Starfield.h"
+
+// The test patterns and the state of a test session, apart from any window or device.
+//
+// PatternGenerator draws the current pattern on a PatternCanvas and steps through the tests and
+// subtests as the keys ask.  It does not include Windows headers: Game shows the patterns on the
+// swap chain, tells the generator what DXGI reports about the display and applies the HDR
+// metadata the patterns ask for; PatternExport renders them on a SoftwarePatternCanvas.
+
+struct rawOutputDesc
+{
+	float MaxLuminance;
+	float MaxFullFrameLuminance;
+	float MinLuminance;
+};
+
+// The DXGI_COLOR_SPACE_TYPE values the patterns tell apart
+enum OutputColorSpace : uint32_t
+{
+	OutputColorSpaceSRGB   = 0,		// DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709
+	OutputColorSpaceHDR10  = 12,	// DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020
+};
+
+// The DXGI_OUTPUT_DESC1 members the patterns read, under the same names
+struct PatternOutputDesc
+{
+	wchar_t     DeviceName[32];
+	uint32_t    BitsPerColor;
+	uint32_t    ColorSpace;				// a DXGI_COLOR_SPACE_TYPE
+	float       RedPrimary[2];
+	float       GreenPrimary[2];
+	float       BluePrimary[2];
+	float       WhitePoint[2];
+	float       MinLuminance;
+	float       MaxLuminance;
+	float       MaxFullFrameLuminance;
+};
+
+// DXGI_HDR_METADATA_HDR10, member for member
+struct PatternMetadata
+{
+	uint16_t    RedPrimary[2];
+	uint16_t    GreenPrimary[2];
+	uint16_t    BluePrimary[2];
+	uint16_t    WhitePoint[2];
+	uint32_t    MaxMasteringLuminance;
+	uint32_t    MinMasteringLuminance;
+	uint16_t    MaxContentLightLevel;
+	uint16_t    MaxFrameAverageLightLevel;
+};
+
+// What the host knows about the display the patterns are shown on
+struct PatternDisplayDesc
+{
+	PatternOutputDesc   output;				// as scaled by the OS for the brightness slider
+	rawOutputDesc       raw;				// as the monitor reports it
+	int32_t             modeWidth;			// native resolution
+	int32_t             modeHeight;
+	uint32_t            refreshRate;		// Hz
+	std::wstring        adapterName;
+	std::wstring        monitorName;		// friendlier name
+	std::wstring        connectorName;		// e.g. "Wired HDMI"
+};
+
+// Provides an interface for the host to apply what the patterns ask of the display.
+struct IPatternHost
+{
+	virtual void SetHDRMetadata(const PatternMetadata& metadata) = 0;
+	virtual void RefreshDisplay() = 0;		// read the display again and pass it to SetDisplay
+};
+
+class PatternGenerator
+{
+public:
+	enum TestingTier
+	{
+		DisplayHDR400   = 0,
+		DisplayHDR500   = 1,
+		DisplayHDR600   = 2,
+		DisplayHDR1000  = 3,
+		DisplayHDR1400  = 4,
+		DisplayHDR2000  = 5,
+		DisplayHDR3000  = 6,
+		DisplayHDR4000  = 7,
+		DisplayHDR6000  = 8,
+		DisplayHDR10000 = 9
+	};
+
+	enum class Checkerboard             // Which pattern to use in Checkerboard tests                    5.x
+	{
+		Cb6x4,
+		Cb4x3,
+		Cb4x3not,
+	};
+
+	enum class TestPattern
+	{
+		StartOfTest, // Must always be first.
+		ConnectionProperties,
+		PanelCharacteristics,
+		ResetInstructions,
+		PQLevelsInNits,
+		WarmUp,
+		TenPercentPeak,             // 1.
+		TenPercentPeakMAX,          // 1. MAX
+		FlashTest,                  // 2.
+		FlashTestMAX,               // 2. MAX
+		LongDurationWhite,          // 3.
+		FullFramePeak,              // 3. MAX
+		DualCornerBox,				// 4. Total contrast test for TrueBlack
+		StaticContrastRatio,		// 5. was tunnel
+		ActiveDimming,				// 5.1
+		ActiveDimmingDark,			// 5.2
+		ActiveDimmingSplit,			// 5.3
+		ColorPatches,               // 6. 8-10% OPR
+		ColorPatchesFull,           // 6. Fullscreen 100% OPR
+		BitDepthPrecision,          // 7. Uses custom effect.
+		RiseFallTime,               // 8.
+		ProfileCurve,               // 9. Validate tracking of 2084 profile
+		LocalDimmingContrast,       // v1.2.1
+		BlackLevelHDRvsSDR,         // v1.2.2
+		BlackLevelCrush,            // v1.2.3
+		SubTitleFlicker,            // v1.2.4
+		XRiteColors,			    // v1.2.5   cycle through the official Xrite patch colors
+		EndOfMandatoryTests,        //
+		SharpeningFilter,           // Uses custom Sine Sweep effect.
+		ToneMapSpike,				// Uses custom Tone Spike effect
+		TextQuality,                // Uses image.
+		//PQLevelsInNitsDynamic,
+		OnePixelLinesBW,            // Uses image.
+		OnePixelLinesRG,            // Uses image.
+		ColorPatches709,
+		FullFrameSDRWhite,
+		FullFrameSDRWhiteWithHDR,
+		CalibrateMaxEffectiveValue,		// max value to send that has any effect
+		CalibrateMaxEffectiveFullFrameValue,	// MaxFALL after tone mapping
+		CalibrateMinEffectiveValue,		// minimal value that is still visible by user
+		StaticGradient,
+		AnimatedGrayGradient,
+		AnimatedColorGradient,
+		BlackLevelHdrCorners,       // 4.
+		BlackLevelSdrTunnel,        // 5. Tunnel test Moved here from v1.0. Replaced with StaticContrastRatio in v1.1
+		ColorPatchesMAX,            // 6. MAX
+		EndOfTest, // Must always be last.
+		Cooldown,
+	};
+	static const size_t NumTestPatterns = static_cast<size_t>(TestPattern::Cooldown) + 1;
+
+	#define NUM_WBRACKETS 8
+
+	// Used by any test that loads a custom effect or image from file.  The host loads them and
+	// registers them with its canvas: images under the test pattern, effects under canvasEffect.
+	struct TestPatternResources
+	{
+		std::wstring testTitle; // Mandatory.
+		std::wstring imageFilename; // Empty means no image is needed for this test.
+		std::wstring effectShaderFilename; // Empty means no shader is needed for this test.
+		CanvasEffect canvasEffect = CanvasEffectNone; // How patterns refer to the effect. CanvasEffectNone for images.
+		// Members above this point need to be specified at app start.
+		// ---
+		// Members below this point are set by the host as it loads them.
+		uint32_t imageWidth = 0; // Pixels; images are drawn 1:1.
+		uint32_t imageHeight = 0;
+		bool imageIsValid = false; // false means image file is missing or invalid.
+		bool effectIsValid = false; // false means effect file is missing or invalid.
+	};
+
+	PatternGenerator(const std::wstring& appTitle, const std::filesystem::path& gamutStorePath = {});
+
+	void RegisterPatternHost(IPatternHost* host) { m_host = host; }
+
+	// The display the patterns are for.  SetDefaultsForDisplay guesses the testing tier and the
+	// starting calibration values from it; call it once the display is first known.
+	void SetDisplay(const PatternDisplayDesc& display);
+	void SetDefaultsForDisplay();
+	TestPatternResources& GetTestPatternResources(TestPattern test);
+	void LayoutText(D2D1_RECT_F logicalSize);
+
+	// Frame loop
+	void Update(float elapsedSeconds, float totalSeconds);
+	void Render(PatternCanvas& canvas);
+	bool GetPatternAnimationKey(uint64_t* key);
+	bool TakeContentChanged();
+	TestPattern GetCurrentTest() const { return m_currentTest; }
+
+	// Test pattern control
+	void SetTestPattern(TestPattern testPattern);
+	void ChangeTestPattern(bool increment);
+	void ChangeSubtest( int32_t increment );
+	void SetShift( bool shift );
+	bool GetShift( void );
+	void ToggleXRitePatchAuto( void );
+	void ChangeXRitePatchDisplayTime(int32_t increment);
+	void SelectWhiteLevel(int32_t incrememnt);
+	void StartTestPattern(void);
+	void ChangeGradientColor(float deltaR, float deltaG, float deltaB);
+	void ChangeCheckerboard( int32_t increment);
+	bool PauseAnimation();
+	bool ToggleSubtitle();
+	bool ToggleInfoTextVisible();
+	void SetMetadataNeutral(); // OS defaults
+	void PrintMetadata(   PatternCanvas* ctx, bool blackText = false );
+	void PrintTestingTier(PatternCanvas* ctx, bool blackText = false);
+	static const wchar_t* GetTierName(TestingTier tier);
+
+	// Offscreen rendering, for PatternExport: the panel is modelled as exactly meeting the
+	// testing tier, and no time passes.  Images are left to the caller to load.
+	void InitializeOffscreen(TestingTier tier);
+	void RenderOffscreen(PatternCanvas& canvas);
+	int  GetSubtestCount();
+	void SetWhiteLevelBracket(int32_t bracket);
+	uint32_t GetWhiteLevelNits();
+	static bool UsesWhiteLevel(TestPattern test);
+
+private:
+	enum ColorGamut
+	{
+		GAMUT_Native = 0,
+		GAMUT_sRGB   = 1,
+		GAMUT_Adobe  = 2,
+		GAMUT_DCIP3  = 3,
+		GAMUT_BT2100 = 4,
+		GAMUT_ACES   = 5,
+	};
+
+	uint32_t WhiteLevelBrackets[NUM_WBRACKETS] = { 50, 100, 200, 250, 300, 500, 700, 1000 };
+
+	// What a test pattern's animated elements depend on, which decides how long a recording
+	// of it can be replayed.  See GetPatternAnimationKey.
+	enum PatternAnimation
+	{
+		AnimationNone,                  // Static, or its moving parts use DrawLive: recorded once.
+		AnimationLive,                  // Moves with the clock throughout: drawn every frame.
+		AnimationCountdown,             // A countdown in whole seconds.
+		AnimationFlash,                 // A countdown and a flash that turns on and off.
+	};
+
+	// Everything the app does with one test pattern.  Descriptors are kept in a flat array
+	// indexed by TestPattern (see RegisterTestPatterns), so the frame loop and the key handlers
+	// look the current pattern up rather than switch on it.  Null handlers do nothing.
+	struct TestPatternDesc
+	{
+		void (PatternGenerator::*generate)(PatternCanvas* ctx) = nullptr;       // Draws the pattern. Mandatory.
+		void (PatternGenerator::*update)(float elapsedSeconds) = nullptr;       // Per-frame animations and countdowns.
+		void (PatternGenerator::*changeSubtest)(int32_t increment) = nullptr;   // Up/down arrow keys.
+		int subtestCount = 1;                                                   // Steps of changeSubtest, see GetSubtestCount.
+		PatternAnimation animation = AnimationNone;
+		TestPatternResources resources;                                         // Image or effect the pattern loads, if any.
+	};
+
+	void InitEffectiveValues();
+	void SetMetadata(float max, float avg, ColorGamut gamut);
+	void RegisterTestPatterns();
+	TestPatternDesc& GetTestPatternDesc(TestPattern test);
+	void DrawStarfield(PatternCanvas* ctx, float maxNits);
+	void FillJitteredPatch(PatternCanvas* ctx, float2 center, float size, D2D1_COLOR_F color);
+	bool CheckHDR_On();
+	bool CheckForDefaults();
+	void DrawLogo(PatternCanvas* ctx, float c );
+	void DrawChecker6x4(  PatternCanvas* ctx, float colorL, float colorR );      // for displays > 20"
+	void DrawChecker4x3(  PatternCanvas* ctx, float colorL, float colorR );      // for smaller panels
+	void DrawChecker4x3n( PatternCanvas* ctx, float colorL, float colorR );      // nverse of above
+	TestingTier GetTestingTier();
+	float GetTierLuminance(TestingTier tier);
+
+	// Drawing code specific for each test pattern.
+	void GenerateTestPattern_StartOfTest(PatternCanvas* ctx);
+	void GenerateTestPattern_ConnectionProperties(PatternCanvas* ctx);
+	void GenerateTestPattern_PanelCharacteristics(PatternCanvas* ctx);
+	void GenerateTestPattern_ResetInstructions(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMaxEffectiveValue(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMaxFullFrameValue(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMinEffectiveValue(PatternCanvas* ctx);
+	void GenerateTestPattern_PQLevelsInNits(PatternCanvas* ctx);
+	void GenerateTestPattern_WarmUp(PatternCanvas* ctx);
+	void GenerateTestPattern_Cooldown(PatternCanvas* ctx);
+	void GenerateTestPattern_TenPercentPeak(PatternCanvas* ctx);						// 1
+	void GenerateTestPattern_TenPercentPeakMAX(PatternCanvas* ctx);					// 1.0b MAX
+	void GenerateTestPattern_FlashTest(PatternCanvas* ctx);							// 2
+	void GenerateTestPattern_FlashTestMAX(PatternCanvas* ctx);						// 2. Max
+	void GenerateTestPattern_LongDurationWhite(PatternCanvas* ctx);					// 3
+	void GenerateTestPattern_DualCornerBox(PatternCanvas* ctx);						// 4
+	void GenerateTestPattern_StaticContrastRatio(PatternCanvas* ctx);				// 5
+	void GenerateTestPattern_ActiveDimming(PatternCanvas* ctx);						// 5.1
+	void GenerateTestPattern_ActiveDimmingDark(PatternCanvas* ctx);					// 5.2
+	void GenerateTestPattern_ActiveDimmingSplit(PatternCanvas* ctx);					// 5.3
+	void GenerateTestPattern_ColorPatches(   PatternCanvas* ctx, bool full );			// 6
+	void GenerateTestPattern_ColorPatches(   PatternCanvas* ctx );						// 6. 10% screen coverage
+	void GenerateTestPattern_ColorPatchesFull(PatternCanvas* ctx);					// 6. 100% screen coverage
+	void GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx, float OPR );			// 6.b MAX legacy
+	void GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx);						// 6.b MAX at 100% OPR
+	void GenerateTestPattern_BitDepthPrecision(PatternCanvas* ctx);					// 7
+	void GenerateTestPattern_RiseFallTime(PatternCanvas* ctx);						// 8
+	void GenerateTestPattern_ProfileCurve(PatternCanvas* ctx);						// 9
+	void GenerateTestPattern_LocalDimmingContrast(PatternCanvas* ctx);				// v1.2
+	void GenerateTestPattern_BlackLevelHDRvsSDR(PatternCanvas* ctx);		    		// v1.2
+	void GenerateTestPattern_BlackLevelCrush(PatternCanvas* ctx);		        		// v1.2
+	void GenerateTestPattern_SubTitleFlicker(PatternCanvas* ctx);	        			// v1.2
+	void GenerateTestPattern_XRiteColors(PatternCanvas* ctx);                         // v1.2
+	void GenerateTestPattern_EndOfMandatoryTests(PatternCanvas* ctx);
+	void GenerateTestPattern_FullFramePeak(PatternCanvas* ctx);						// 3.b MAX legacy
+	void GenerateTestPattern_BlackLevelHdrCorners(PatternCanvas* ctx);				// 4 legacy
+	void GenerateTestPattern_SharpeningFilter(PatternCanvas* ctx);
+	void GenerateTestPattern_ToneMapSpike(PatternCanvas* ctx);
+	void GenerateTestPattern_FullFrameSDRWhite(PatternCanvas* ctx);
+	void GenerateTestPattern_FullFrameSDRWhiteWithHDR(PatternCanvas* ctx);
+	void GenerateTestPattern_ColorPatches709(PatternCanvas* ctx);
+	void GenerateTestPattern_StaticGradient(PatternCanvas* ctx);
+	void GenerateTestPattern_AnimatedGrayGradient(PatternCanvas* ctx);
+	void GenerateTestPattern_AnimatedColorGradient(PatternCanvas* ctx);
+	void GenerateTestPattern_BlackLevelSdrTunnel(PatternCanvas* ctx);
+	void GenerateTestPattern_BlackLevelSdrTunnelTrueBlack(PatternCanvas* ctx);
+	void GenerateTestPattern_EndOfTest(PatternCanvas* ctx);
+
+	// Generalized routine for all tests that involve loading an image.
+	void GenerateTestPattern_ImageCommon(PatternCanvas* ctx);
+
+	// Per-frame updates, shared by the test patterns that animate the same way.
+	void UpdateTestPattern_PanelCharacteristics(float elapsedSeconds);
+	void UpdateTestPattern_Countdown(float elapsedSeconds);				// 30 minutes
+	void UpdateTestPattern_Cooldown(float elapsedSeconds);
+	void UpdateTestPattern_FlashTest(float elapsedSeconds);
+	void UpdateTestPattern_RiseFallTime(float elapsedSeconds);
+	void UpdateTestPattern_XRiteColors(float elapsedSeconds);
+	void UpdateTestPattern_BitDepthPrecision(float elapsedSeconds);
+	void UpdateTestPattern_StaticGradient(float elapsedSeconds);
+	void UpdateTestPattern_AnimatedGrayGradient(float elapsedSeconds);
+	void UpdateTestPattern_AnimatedColorGradient(float elapsedSeconds);
+
+	// Up/down arrow key handling, shared by the test patterns that step the same value.
+	void ChangeSubtest_TestingTier(int32_t increment);
+	void ChangeSubtest_StaticContrastRatio(int32_t increment);
+	void ChangeSubtest_ActiveDimming(int32_t increment);
+	void ChangeSubtest_ActiveDimmingDark(int32_t increment);
+	void ChangeSubtest_MaxEffectiveValue(int32_t increment);
+	void ChangeSubtest_MaxFullFrameValue(int32_t increment);
+	void ChangeSubtest_MinEffectiveValue(int32_t increment);
+	void ChangeSubtest_Color(int32_t increment);								// R, G, B, W
+	void ChangeSubtest_ProfileCurve(int32_t increment);
+	void ChangeSubtest_LocalDimmingContrast(int32_t increment);
+	void ChangeSubtest_BlackLevelCrush(int32_t increment);
+	void ChangeSubtest_XRiteColors(int32_t increment);
+	void ChangeSubtest_StaticGradient(int32_t increment);
+
+	// Common rendering subroutines.
+	void RenderText(PatternCanvas* ctx, CanvasFont font, std::wstring text, D2D1_RECT_F textPos, bool useBlackText = false);
+
+	IPatternHost*                                           m_host;
+
+	// The display, see SetDisplay.
+	PatternOutputDesc                                       m_outputDesc;
+	rawOutputDesc                                           m_rawOutDesc;		// base values from OS before scaling due to brightness setting
+	std::wstring                                            m_adapterName;
+	std::wstring                                            m_monitorName;      // friendlier name
+	std::wstring                                            m_connectorName;    // Internal vs wired, HDMI vs DisplayPort
+	uint32_t                                                m_displayFrequency; // from EnumDisplaySettings -not precise
+
+	D2D1_GRADIENT_STOP                                      m_gradientStops[2];
+	D2D1_COLOR_F                                            m_whiteColor;
+	D2D1_COLOR_F                                            m_blackColor;
+	D2D1_COLOR_F                                            m_redColor;
+	std::map<StarfieldKey, std::unique_ptr<Starfield>>      m_starfields;       // by size, star level and APL
+
+	D2D1_RECT_F                                             m_testTitleRect;    // Where to draw each test's title
+	D2D1_RECT_F                                             m_largeTextRect;    // Where to draw large text for the test, if applicable
+	D2D1_RECT_F                                             m_MetadataTextRect; // where we display the metadata (lower right
+	D2D1_RECT_F                                             m_TestingTierTextRect;  // place to dislay the current tier (upper right)
+	TestingTier                                             m_testingTier;      // what tier we are testing for
+	TestPattern                                             m_currentTest;
+	TestPattern                                             m_cachedTest;
+	bool                                                    m_shiftKey;         // whether shift key is pressed
+	int32_t                                                 m_currentColor;
+	int32_t                                                 m_currentBlack;     // for black crush test
+	int32_t                                                 m_currentProfileTile;
+	int32_t                                                 m_modeWidth;        // resolution of current mode (actually native res now)
+	int32_t                                                 m_modeHeight;
+	float                                                   m_snoodDiam;        // outside diameter of sensor snood in mm
+
+	uint32_t                                                m_maxPQCode;		// PQ code of maxLuminance
+	int32_t                                                 m_maxProfileTile;	// highest tile worth testing on this panel
+	float                                                   m_flashOn;
+	Checkerboard                                            m_checkerboard;     // for tests        5.x
+	D2D1_COLOR_F                                            m_gradientColor;
+	int32_t                                                 m_LocalDimmingBars;                 // v1.2 Local Dimming Contrast Test
+	int32_t                                                 m_subtitleVisible;                  // v1.4 Subtitle Flicker Test
+	int32_t                                                 m_currentXRiteIndex;                // v1.5 XRite Color Patch
+	bool                                                    m_XRitePatchAutoMode;               // v1.5 flag for when it auto animates
+	float                                                   m_XRitePatchDisplayTime;            // how long to show XRite color patch in auto mode
+	int32_t                                                 m_whiteLevelBracket;                // what tier/level we should use
+	int32_t                                                 m_XRiteIntensity;                   // correction to X-Rite levels
+	float                                                   m_gradientAnimationBase;
+	bool                                                    m_bPaused;
+	bool                                                    m_showExplanatoryText;
+	float                                                   m_testTimeRemainingSec;
+	float                                                   m_gamutVolume;
+	bool                                                    m_gamutPending;                     // panel's gamut metrics still being computed
+	std::unique_ptr<GamutCache>                             m_gamutCache;                       // volume/coverage per set of primaries
+//TODO: these code values could all be INTs
+	float                                                   m_maxEffectivesRGBValue;		    // Code levels via manual test
+	float                                                   m_maxFullFramesRGBValue;
+	float                                                   m_minEffectivesRGBValue;
+	float                                                   m_maxEffectivePQValue;	            // PQ is using HDR10 10bit encoding
+	float                                                   m_maxFullFramePQValue;
+	float                                                   m_minEffectivePQValue;
+	float                                                   m_staticContrastPQValue;            // for test 5. static contrast
+	float                                                   m_staticContrastsRGBValue;
+	float                                                   m_activeDimming50PQValue;           // for tests 5.1, 5.2, 5.3 on Active Dimming
+	float                                                   m_activeDimming05PQValue;
+	float                                                   m_activeDimming50sRGBValue;         // probably no active dimming in sRGB mode
+	float                                                   m_activeDimming05sRGBValue;         // only in HDR mode
+
+	bool                                                    m_newTestSelected;  // Used for one-time initialization of test variables.
+	bool                                                    m_contentChanged;   // what the current pattern draws has changed, see TakeContentChanged
+	bool                                                    m_offscreen;        // rendering for PatternExport, no host
+	PatternMetadata                                         m_Metadata;
+	ColorGamut                                              m_MetadataGamut;
+
+	std::array<TestPatternDesc, NumTestPatterns>            m_testPatterns;     // indexed by TestPattern
+	std::wstring                                            m_hideTextString;
+	float                                                   m_totalTime;
+
+	std::wstring                                            m_appTitle;
+};
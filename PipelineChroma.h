@@ -0,0 +1,331 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "ColorSpaces.h"
+#include "SimdMath.h"
+#include "PipelineImage.h"
+#include "PipelineExecutor.h"
+#include "PipelineQuantize.h"
+
+// Chroma subsampling on the wire: R'G'B' -> Y'CbCr -> 4:2:2 or 4:2:0 -> back up -> R'G'B'.
+//
+// The image goes through three passes, each split by rows over the executor.  The first
+// converts to Y'CbCr in place and rounds it to link codes.  The second filters Cb and Cr
+// down into a quarter (or half) size buffer, one chroma row at a time, and rounds them
+// again.  The third interpolates them back up and converts to R'G'B', one row at a time.
+// The filters are set by the chroma siting:
+//
+//   cosited      down [1 2 1]/4 centred on the even sample, up: copy, then average of two
+//   interstitial down [1 1]/2,                             up: 3/4 nearest + 1/4 next
+//
+// All filtering is three-row (or three-tap) weighted sums done by one SIMD kernel; the
+// horizontal direction runs that kernel on shifted copies of a row, then picks or
+// interleaves samples.
+
+enum ChromaFormat
+{
+	Chroma444,
+	Chroma422,
+	Chroma420,
+};
+
+enum ChromaRange
+{
+	ChromaFull,
+	ChromaLimited,				// Y' 16..235, C 16..240 at 8 bits, scaled for the bit depth
+};
+
+enum ChromaSiting
+{
+	ChromaSitingLeft,			// horizontally cosited, vertically interstitial (MPEG-2, HEVC default)
+	ChromaSitingCenter,			// interstitial both ways (JPEG, MPEG-1)
+	ChromaSitingTopLeft,		// cosited both ways (BT.2020 "type 2")
+};
+
+enum ChromaUpsample
+{
+	ChromaUpNearest,
+	ChromaUpLinear,
+};
+
+struct ChromaParams
+{
+	ChromaFormat   format;
+	ChromaRange    range;
+	ChromaSiting   siting;
+	ChromaUpsample upsample;
+	uint32_t       bits;			// link depth: Y'CbCr codes and limited range levels, 0 stays float
+};
+
+// out[i] = w0 * a[i] + w1 * b[i] + w2 * c[i]
+template <class S>
+void ChromaBlend_Kernel(float* out, const float* a, const float* b, const float* c, size_t n, float w0, float w1, float w2)
+{
+	typedef typename S::V V;
+	const V k0 = S::Set1(w0), k1 = S::Set1(w1), k2 = S::Set1(w2);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+		S::Store(out + i, S::Add(S::Add(S::Mul(k0, S::Load(a + i)), S::Mul(k1, S::Load(b + i))), S::Mul(k2, S::Load(c + i))));
+	for (; i < n; i++)
+		out[i] = w0 * a[i] + w1 * b[i] + w2 * c[i];
+}
+
+// p = m * p + offset, in place on three planes
+template <class S>
+void ChromaAffine_Kernel(float* const p[ChannelCount], size_t n, const float3x3& m, const float3& offset)
+{
+	typedef typename S::V V;
+	const V m11 = S::Set1(m._11), m12 = S::Set1(m._12), m13 = S::Set1(m._13);
+	const V m21 = S::Set1(m._21), m22 = S::Set1(m._22), m23 = S::Set1(m._23);
+	const V m31 = S::Set1(m._31), m32 = S::Set1(m._32), m33 = S::Set1(m._33);
+	const V o1 = S::Set1(offset.x), o2 = S::Set1(offset.y), o3 = S::Set1(offset.z);
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		V a = S::Load(p[0] + i), b = S::Load(p[1] + i), c = S::Load(p[2] + i);
+		S::Store(p[0] + i, S::Add(S::Add(S::Add(S::Mul(m11, a), S::Mul(m12, b)), S::Mul(m13, c)), o1));
+		S::Store(p[1] + i, S::Add(S::Add(S::Add(S::Mul(m21, a), S::Mul(m22, b)), S::Mul(m23, c)), o2));
+		S::Store(p[2] + i, S::Add(S::Add(S::Add(S::Mul(m31, a), S::Mul(m32, b)), S::Mul(m33, c)), o3));
+	}
+	for (; i < n; i++)
+	{
+		float a = p[0][i], b = p[1][i], c = p[2][i];
+		p[0][i] = m._11 * a + m._12 * b + m._13 * c + offset.x;
+		p[1][i] = m._21 * a + m._22 * b + m._23 * c + offset.y;
+		p[2][i] = m._31 * a + m._32 * b + m._33 * c + offset.z;
+	}
+}
+
+class ChromaResampler
+{
+public:
+	// R'G'B' in, R'G'B' out, with the chroma detail a subsampled link would lose
+	void Run(ImageView image, const ChromaParams& params, PipelineExecutor* executor = nullptr)
+	{
+		if (params.format == Chroma444 || image.Empty())
+			return;
+
+		m_params = params;
+		m_vertical = params.format == Chroma420;
+		m_cositedX = params.siting != ChromaSitingCenter;
+		m_cositedY = params.siting == ChromaSitingTopLeft;
+
+		uint32_t cw = (image.width + 1) / 2;
+		uint32_t ch = m_vertical ? (image.height + 1) / 2 : image.height;
+		m_chroma.Resize(cw, ch);
+
+		// Y' = scaleY * Y + offsetY, C' = scaleC * C + offsetC.  Zero chroma is code 2^(b-1),
+		// which is a little over half of 2^b - 1.
+		float scaleY = 1.0f, offsetY = 0.0f, scaleC = 1.0f, offsetC = 0.5f;
+		if (params.bits)
+			offsetC = (float)(1u << (params.bits - 1)) / (float)((1u << params.bits) - 1);
+		if (params.range == ChromaLimited)
+		{
+			uint32_t bits = std::max(params.bits, 8u);
+			float unit = (float)(1u << (bits - 8)) / (float)((1u << bits) - 1);
+			scaleY = 219.0f * unit;
+			offsetY = 16.0f * unit;
+			scaleC = 224.0f * unit;
+		}
+		float3x3 toYCC = mul(float3x3(scaleY, 0.0f, 0.0f, 0.0f, scaleC, 0.0f, 0.0f, 0.0f, scaleC), matRGB2020toYCbCr);
+		float3 offsetYCC(offsetY, offsetC, offsetC);
+		m_toRGB = inv(toYCC);
+		m_offsetRGB = -mul(m_toRGB, offsetYCC);
+
+		uint32_t threads = executor ? executor->Threads() : 1;
+		m_scratch.resize(threads);
+		for (auto& s : m_scratch)
+			s.resize((size_t)image.width * 3 + 8);
+
+		// the link carries codes, both at full resolution and after subsampling
+		const QuantizeParams codes = { params.bits, QuantizeRound, 0 };
+
+		// 1: to Y'CbCr
+		ForEachRow(executor, image.height, [&](uint32_t y, uint32_t)
+		{
+			float* p[ChannelCount] = { image.Row(ChannelR, y), image.Row(ChannelG, y), image.Row(ChannelB, y) };
+			SimdDispatch([&](auto s) { ChromaAffine_Kernel<decltype(s)>(p, image.width, toYCC, offsetYCC); });
+			if (codes.bits)
+				for (int c = 0; c < ChannelCount; c++)
+					QuantizeRow(codes, p[c], image.width, 0, y);
+		});
+
+		// 2: Cb, Cr down into m_chroma planes G and B
+		ImageView chroma = m_chroma.View();
+		ForEachRow(executor, ch, [&](uint32_t j, uint32_t worker)
+		{
+			float* line = m_scratch[worker].data();
+			for (int c = ChannelG; c <= ChannelB; c++)
+			{
+				const float* rows[3];
+				float w[3];
+				VerticalTaps(image, c, j, rows, w);
+				SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(line + 1, rows[0], rows[1], rows[2], image.width, w[0], w[1], w[2]); });
+				DownRow(line, image.width, chroma.Row(c, j));
+				if (codes.bits)
+					QuantizeRow(codes, chroma.Row(c, j), cw, 0, j);
+			}
+		});
+
+		// 3: up, and back to R'G'B'
+		ForEachRow(executor, image.height, [&](uint32_t y, uint32_t worker)
+		{
+			float* line = m_scratch[worker].data();
+			for (int c = ChannelG; c <= ChannelB; c++)
+			{
+				const float* rows[2];
+				float w[2];
+				UpTaps(chroma, c, y, rows, w);
+				SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(line + 1, rows[0], rows[1], rows[1], cw, w[0], w[1], 0.0f); });
+				UpRow(line, cw, image.Row(c, y), image.width);
+			}
+			float* p[ChannelCount] = { image.Row(ChannelR, y), image.Row(ChannelG, y), image.Row(ChannelB, y) };
+			SimdDispatch([&](auto s) { ChromaAffine_Kernel<decltype(s)>(p, image.width, m_toRGB, m_offsetRGB); });
+		});
+	}
+
+private:
+	template <class F>
+	static void ForEachRow(PipelineExecutor* executor, uint32_t rows, F&& f)
+	{
+		if (executor)
+			executor->ForEach(rows, f);
+		else
+			for (uint32_t y = 0; y < rows; y++)
+				f(y, 0);
+	}
+
+	// source rows and weights for chroma row j
+	void VerticalTaps(ImageView image, int c, uint32_t j, const float* rows[3], float w[3]) const
+	{
+		if (!m_vertical)
+		{
+			rows[0] = rows[1] = rows[2] = image.Row(c, j);
+			w[0] = 1.0f; w[1] = 0.0f; w[2] = 0.0f;
+			return;
+		}
+		uint32_t last = image.height - 1;
+		uint32_t y = 2 * j;
+		if (m_cositedY)
+		{
+			rows[0] = image.Row(c, y > 0 ? y - 1 : 0);
+			rows[1] = image.Row(c, y);
+			rows[2] = image.Row(c, std::min(y + 1, last));
+			w[0] = 0.25f; w[1] = 0.5f; w[2] = 0.25f;
+		}
+		else
+		{
+			rows[0] = rows[2] = image.Row(c, y);
+			rows[1] = image.Row(c, std::min(y + 1, last));
+			w[0] = 0.5f; w[1] = 0.5f; w[2] = 0.0f;
+		}
+	}
+
+	// chroma rows and weights for full-resolution row y
+	void UpTaps(ImageView chroma, int c, uint32_t y, const float* rows[2], float w[2]) const
+	{
+		if (!m_vertical)
+		{
+			rows[0] = rows[1] = chroma.Row(c, y);
+			w[0] = 1.0f; w[1] = 0.0f;
+			return;
+		}
+		uint32_t j = y / 2;
+		uint32_t last = chroma.height - 1;
+		bool odd = (y & 1) != 0;
+		rows[0] = chroma.Row(c, j);
+		if (m_params.upsample == ChromaUpNearest)
+		{
+			rows[1] = rows[0];
+			w[0] = 1.0f; w[1] = 0.0f;
+		}
+		else if (m_cositedY)
+		{
+			rows[1] = chroma.Row(c, std::min(j + 1, last));
+			w[0] = odd ? 0.5f : 1.0f;
+			w[1] = odd ? 0.5f : 0.0f;
+		}
+		else
+		{
+			rows[1] = chroma.Row(c, odd ? std::min(j + 1, last) : (j > 0 ? j - 1 : 0));
+			w[0] = 0.75f; w[1] = 0.25f;
+		}
+	}
+
+	// line[1..n] holds the vertically filtered row; writes (n + 1) / 2 samples to out
+	void DownRow(float* line, uint32_t n, float* out) const
+	{
+		line[0] = line[1];
+		line[n + 1] = line[n];
+		float* taps = line + n + 2;
+		uint32_t cw = (n + 1) / 2;
+		const float* row = line + 1;
+
+		// filter at every position with the SIMD kernel, then keep the even ones
+		if (m_cositedX)
+			SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(taps, row - 1, row, row + 1, n, 0.25f, 0.5f, 0.25f); });
+		else
+			SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(taps, row, row + 1, row + 1, n, 0.5f, 0.5f, 0.0f); });
+		for (uint32_t i = 0; i < cw; i++)
+			out[i] = taps[2 * i];
+	}
+
+	// line[1..cw] holds the vertically interpolated chroma row; writes n samples to out
+	void UpRow(float* line, uint32_t cw, float* out, uint32_t n) const
+	{
+		line[0] = line[1];
+		line[cw + 1] = line[cw];
+		const float* row = line + 1;
+
+		if (m_params.upsample == ChromaUpNearest)
+		{
+			for (uint32_t x = 0; x < n; x++)
+				out[x] = row[x / 2];
+			return;
+		}
+
+		// the two phases are computed with the SIMD kernel and then interleaved
+		float* even = line + cw + 2;
+		float* odd = even + cw + 1;
+		if (m_cositedX)
+		{
+			SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(odd, row, row + 1, row + 1, cw, 0.5f, 0.5f, 0.0f); });
+			even = const_cast<float*>(row);
+		}
+		else
+		{
+			SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(even, row - 1, row, row, cw, 0.25f, 0.75f, 0.0f); });
+			SimdDispatch([&](auto s) { ChromaBlend_Kernel<decltype(s)>(odd, row, row + 1, row + 1, cw, 0.75f, 0.25f, 0.0f); });
+		}
+		for (uint32_t i = 0; i < n / 2; i++)
+		{
+			out[2 * i] = even[i];
+			out[2 * i + 1] = odd[i];
+		}
+		if (n & 1)
+			out[n - 1] = even[cw - 1];
+	}
+
+	ChromaParams                    m_params;
+	bool                            m_vertical;
+	bool                            m_cositedX;
+	bool                            m_cositedY;
+	float3x3                        m_toRGB;
+	float3                          m_offsetRGB;
+	PipelineImage                   m_chroma;			// planes G and B hold Cb and Cr
+	std::vector<std::vector<float>> m_scratch;			// one row buffer per worker
+};
@@ -0,0 +1,309 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PipelineImage.h"
+
+// Tiled, multithreaded execution of per-pixel pipeline stages.
+//
+// The frame is cut into tiles (64x64 by default: 3 planes x 16 KB, which sits in L2) and
+// each tile is taken through every stage before the next one is started, so a stage reads
+// what the previous stage just wrote from cache instead of from DRAM.  Stages must be
+// pixel-local: anything that needs the whole frame (Image_Average, Image_Peak) runs before.
+//
+// Every worker owns a contiguous run of tile indices, which keeps neighbouring tiles on the
+// same core.  A worker that runs dry steals the back half of the longest remaining run.
+
+// One stage of a tiled run.  fn is called from any worker thread, concurrently, on disjoint
+// tiles; it must not touch shared mutable state.
+struct ExecutorStage
+{
+	const char*                      name;
+	std::function<void(ImageView)>   fn;
+};
+
+struct StageTiming
+{
+	const char* name;
+	double      seconds;			// summed over threads
+	uint64_t    pixels;
+
+	// throughput of this stage alone on all threads
+	double MegapixelsPerSecond(uint32_t threads) const
+	{
+		return seconds > 0.0 ? pixels * 1e-6 * threads / seconds : 0.0;
+	}
+};
+
+class PipelineExecutor
+{
+public:
+	// threads == 0 uses every hardware thread; the calling thread is one of them
+	explicit PipelineExecutor(uint32_t threads = 0, uint32_t tileWidth = 64, uint32_t tileHeight = 64) :
+		m_tileWidth(std::max(tileWidth, 1u)), m_tileHeight(std::max(tileHeight, 1u)),
+		m_generation(0), m_busy(0), m_quit(false), m_job(nullptr)
+	{
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		m_queues.reset(new TileQueue[threads]);
+		m_threadCount = threads;
+		for (uint32_t t = 1; t < threads; t++)
+			m_threads.emplace_back([this, t] { WorkerLoop(t); });
+	}
+
+	~PipelineExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+		for (auto& th : m_threads)
+			th.join();
+	}
+
+	PipelineExecutor(const PipelineExecutor&) = delete;
+	PipelineExecutor& operator=(const PipelineExecutor&) = delete;
+
+	void SetTileSize(uint32_t width, uint32_t height)
+	{
+		m_tileWidth = std::max(width, 1u);
+		m_tileHeight = std::max(height, 1u);
+	}
+
+	uint32_t Threads() const    { return m_threadCount; }
+	uint32_t TileWidth() const  { return m_tileWidth; }
+	uint32_t TileHeight() const { return m_tileHeight; }
+
+	// Runs fn(index, worker) once for every index in [0, count) and returns when all are done.
+	void ForEach(uint32_t count, const std::function<void(uint32_t, uint32_t)>& fn)
+	{
+		if (count == 0)
+			return;
+
+		// contiguous runs, so a worker walks neighbouring items
+		uint32_t workers = std::min(m_threadCount, count);
+		for (uint32_t t = 0; t < m_threadCount; t++)
+		{
+			TileQueue& q = m_queues[t];
+			std::lock_guard<std::mutex> lock(q.lock);
+			q.begin = t < workers ? (uint32_t)((uint64_t)count * t / workers) : 0;
+			q.end   = t < workers ? (uint32_t)((uint64_t)count * (t + 1) / workers) : 0;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_job = &fn;
+			m_busy = m_threadCount - 1;
+			m_generation++;
+		}
+		m_wake.notify_all();
+
+		RunItems(0);
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_done.wait(lock, [&] { return m_busy == 0; });
+		m_job = nullptr;
+	}
+
+	// Runs fn(tile, worker) once for every tile of image, tiles numbered row-major.
+	void ForEachTile(ImageView image, const std::function<void(ImageView, uint32_t)>& fn)
+	{
+		if (image.Empty())
+			return;
+
+		uint32_t tilesX = (image.width + m_tileWidth - 1) / m_tileWidth;
+		uint32_t tilesY = (image.height + m_tileHeight - 1) / m_tileHeight;
+		uint32_t tileWidth = m_tileWidth, tileHeight = m_tileHeight;
+
+		ForEach(tilesX * tilesY, [&](uint32_t tile, uint32_t worker)
+		{
+			uint32_t x = (tile % tilesX) * tileWidth;
+			uint32_t y = (tile / tilesX) * tileHeight;
+			fn(image.Sub(x, y, std::min(tileWidth, image.width - x), std::min(tileHeight, image.height - y)), worker);
+		});
+	}
+
+	// Takes every tile through all stages in order.  Per-stage time is accumulated, by stage
+	// name, into Timings() until ResetTimings().
+	void Run(ImageView image, const std::vector<ExecutorStage>& stages)
+	{
+		size_t stageCount = stages.size();
+		std::vector<double> threadSeconds((size_t)m_threadCount * stageCount, 0.0);
+
+		ForEachTile(image, [&](ImageView tile, uint32_t worker)
+		{
+			double* seconds = &threadSeconds[(size_t)worker * stageCount];
+			auto t0 = std::chrono::steady_clock::now();
+			for (size_t s = 0; s < stageCount; s++)
+			{
+				stages[s].fn(tile);
+				auto t1 = std::chrono::steady_clock::now();
+				seconds[s] += std::chrono::duration<double>(t1 - t0).count();
+				t0 = t1;
+			}
+		});
+
+		for (size_t s = 0; s < stageCount; s++)
+		{
+			double seconds = 0.0;
+			for (uint32_t t = 0; t < m_threadCount; t++)
+				seconds += threadSeconds[t * stageCount + s];
+			AddTiming(stages[s].name, image.PixelCount(), seconds);
+		}
+	}
+
+	// For work that does not fit the tile model; seconds are summed over threads
+	void AddTiming(const char* name, uint64_t pixels, double seconds)
+	{
+		auto timing = std::find_if(m_timings.begin(), m_timings.end(),
+			[&](const StageTiming& t) { return strcmp(t.name, name) == 0; });
+		if (timing == m_timings.end())
+			timing = m_timings.insert(m_timings.end(), StageTiming{ name, 0.0, 0 });
+		timing->pixels += pixels;
+		timing->seconds += seconds;
+	}
+
+	const std::vector<StageTiming>& Timings() const { return m_timings; }
+	void ResetTimings() { m_timings.clear(); }
+
+	void PrintTimings() const
+	{
+		for (const StageTiming& timing : m_timings)
+			printf("%-24s %10.1f MP/s\n", timing.name, timing.MegapixelsPerSecond(m_threadCount));
+	}
+
+private:
+	typedef std::function<void(uint32_t, uint32_t)> Job;
+
+	struct TileQueue
+	{
+		std::mutex lock;
+		uint32_t   begin = 0;
+		uint32_t   end = 0;
+	};
+
+	bool PopOwn(uint32_t worker, uint32_t& item)
+	{
+		TileQueue& q = m_queues[worker];
+		std::lock_guard<std::mutex> lock(q.lock);
+		if (q.begin == q.end)
+			return false;
+		item = q.begin++;
+		return true;
+	}
+
+	// moves the back half of the fullest other run into this worker's queue
+	bool Steal(uint32_t worker)
+	{
+		for (;;)
+		{
+			uint32_t victim = worker, most = 0;
+			for (uint32_t t = 0; t < m_threadCount; t++)
+			{
+				if (t == worker)
+					continue;
+				TileQueue& q = m_queues[t];
+				std::lock_guard<std::mutex> lock(q.lock);
+				if (q.end - q.begin > most)
+				{
+					most = q.end - q.begin;
+					victim = t;
+				}
+			}
+			if (victim == worker)
+				return false;
+
+			uint32_t begin, end;
+			{
+				TileQueue& q = m_queues[victim];
+				std::lock_guard<std::mutex> lock(q.lock);
+				uint32_t left = q.end - q.begin;
+				if (left == 0)
+					continue;			// drained while we looked, try again
+				uint32_t take = (left + 1) / 2;
+				end = q.end;
+				begin = q.end - take;
+				q.end = begin;
+			}
+
+			TileQueue& own = m_queues[worker];
+			std::lock_guard<std::mutex> lock(own.lock);
+			own.begin = begin;
+			own.end = end;
+			return true;
+		}
+	}
+
+	void RunItems(uint32_t worker)
+	{
+		const Job& job = *m_job;
+		for (;;)
+		{
+			uint32_t item;
+			if (!PopOwn(worker, item))
+			{
+				if (!Steal(worker))
+					return;
+				continue;
+			}
+			job(item, worker);
+		}
+	}
+
+	void WorkerLoop(uint32_t worker)
+	{
+		uint64_t seen = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+				if (m_quit)
+					return;
+				seen = m_generation;
+			}
+
+			RunItems(worker);
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (--m_busy == 0)
+				m_done.notify_one();
+		}
+	}
+
+	uint32_t                      m_threadCount;
+	uint32_t                      m_tileWidth;
+	uint32_t                      m_tileHeight;
+	std::unique_ptr<TileQueue[]>  m_queues;
+	std::vector<std::thread>      m_threads;
+	std::vector<StageTiming>      m_timings;
+
+	std::mutex                    m_lock;
+	std::condition_variable       m_wake;
+	std::condition_variable       m_done;
+	uint64_t                      m_generation;
+	uint32_t                      m_busy;			// workers other than the caller still running the job
+	bool                          m_quit;
+	const Job*                    m_job;
+};
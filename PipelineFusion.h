@@ -0,0 +1,361 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "ColorSpaces.h"
+#include "PipelineImage.h"
+#include "SimdMath.h"
+#include "ToneMapLUT.h"
+
+// Stage fusion for the pipeline model.
+//
+// Chains like Linear709ToHDR10 are a handful of cheap per-pixel steps, and running each one
+// as its own full-frame pass makes every step a round trip to memory.  FusedStages collects
+// the steps instead, folds what can be folded as they are added:
+//
+//   - consecutive matrices and scales become one matrix
+//   - consecutive clamps become one clamp
+//   - a clamp no tighter than [0..1] in front of a stage that saturates its input anyway
+//     (the PQ curves and the tone map LUT) is dropped
+//
+// and then runs whatever is left over the frame one tile at a time, so the intermediates
+// never leave the cache.  Report() says how much frame traffic that saved.
+
+enum PipelineStageType
+{
+	StageMatrix,			// linear, includes scales
+	StageClamp,
+	StageApply2084,			// saturates input
+	StageRemove2084,		// saturates input
+	StageToneMap,			// saturates input
+	StagePow,				// negatives clip to 0
+};
+
+struct PipelineStage
+{
+	PipelineStageType type;
+	float3x3          m;			// StageMatrix
+	float             a;			// clamp low, pow exponent, tone map output scale
+	float             b;			// clamp high
+	std::shared_ptr<const ToneMapLUT> lut;	// StageToneMap, shared with whoever built it
+};
+
+struct FusionReport
+{
+	uint32_t stagesAdded;			// stages as requested, each one frame pass if run on its own
+	uint32_t stagesFused;			// stages left after folding, all run in a single pass
+	uint64_t bytesUnfused;			// frame read + write traffic of the separate passes
+	uint64_t bytesFused;			// frame read + write traffic of the fused pass
+
+	uint64_t BytesSaved() const { return bytesUnfused - bytesFused; }
+};
+
+// Per-plane pointers for one tile of a planar image
+struct PlanarSpan
+{
+	const float* in[ChannelCount];
+	float*       out[ChannelCount];
+	size_t       n;
+};
+
+template <class S>
+void FusedMatrix_Kernel(const PlanarSpan& s, const float3x3& m)
+{
+	typedef typename S::V V;
+	const V m11 = S::Set1(m._11), m12 = S::Set1(m._12), m13 = S::Set1(m._13);
+	const V m21 = S::Set1(m._21), m22 = S::Set1(m._22), m23 = S::Set1(m._23);
+	const V m31 = S::Set1(m._31), m32 = S::Set1(m._32), m33 = S::Set1(m._33);
+
+	size_t i = 0;
+	for (; i + S::Width <= s.n; i += S::Width)
+	{
+		V r = S::Load(s.in[ChannelR] + i);
+		V g = S::Load(s.in[ChannelG] + i);
+		V b = S::Load(s.in[ChannelB] + i);
+		S::Store(s.out[ChannelR] + i, S::Add(S::Add(S::Mul(m11, r), S::Mul(m12, g)), S::Mul(m13, b)));
+		S::Store(s.out[ChannelG] + i, S::Add(S::Add(S::Mul(m21, r), S::Mul(m22, g)), S::Mul(m23, b)));
+		S::Store(s.out[ChannelB] + i, S::Add(S::Add(S::Mul(m31, r), S::Mul(m32, g)), S::Mul(m33, b)));
+	}
+	for (; i < s.n; i++)
+	{
+		float r = s.in[ChannelR][i], g = s.in[ChannelG][i], b = s.in[ChannelB][i];
+		s.out[ChannelR][i] = m._11 * r + m._12 * g + m._13 * b;
+		s.out[ChannelG][i] = m._21 * r + m._22 * g + m._23 * b;
+		s.out[ChannelB][i] = m._31 * r + m._32 * g + m._33 * b;
+	}
+}
+
+// diagonal matrix: one multiply per sample
+template <class S>
+void FusedScale_Kernel(const PlanarSpan& s, const float3x3& m)
+{
+	const float scale[ChannelCount] = { m._11, m._22, m._33 };
+	for (int c = 0; c < ChannelCount; c++)
+	{
+		const typename S::V k = S::Set1(scale[c]);
+		const float* in = s.in[c];
+		float* out = s.out[c];
+		size_t i = 0;
+		for (; i + S::Width <= s.n; i += S::Width)
+			S::Store(out + i, S::Mul(S::Load(in + i), k));
+		for (; i < s.n; i++)
+			out[i] = in[i] * scale[c];
+	}
+}
+
+template <class S>
+void FusedClamp_Kernel(const PlanarSpan& s, float lo, float hi)
+{
+	const typename S::V vlo = S::Set1(lo), vhi = S::Set1(hi);
+	for (int c = 0; c < ChannelCount; c++)
+	{
+		const float* in = s.in[c];
+		float* out = s.out[c];
+		size_t i = 0;
+		for (; i + S::Width <= s.n; i += S::Width)
+			S::Store(out + i, S::Min(S::Max(S::Load(in + i), vlo), vhi));
+		for (; i < s.n; i++)
+			out[i] = std::min(std::max(in[i], lo), hi);
+	}
+}
+
+template <class S>
+void FusedPow_Kernel(S, const PlanarSpan& s, float exponent)
+{
+	const typename S::V e = S::Set1(exponent), zero = S::Set1(0.0f);
+	for (int c = 0; c < ChannelCount; c++)
+	{
+		const float* in = s.in[c];
+		float* out = s.out[c];
+		size_t i = 0;
+		for (; i + S::Width <= s.n; i += S::Width)
+			S::Store(out + i, SimdPow<S>(S::Max(S::Load(in + i), zero), e));
+		for (; i < s.n; i++)
+			out[i] = in[i] > 0.0f ? powf(in[i], exponent) : 0.0f;
+	}
+}
+
+inline void FusedPow_Kernel(SimdScalar, const PlanarSpan& s, float exponent)
+{
+	for (int c = 0; c < ChannelCount; c++)
+		for (size_t i = 0; i < s.n; i++)
+			s.out[c][i] = s.in[c][i] > 0.0f ? powf(s.in[c][i], exponent) : 0.0f;
+}
+
+class FusedStages
+{
+public:
+	static const uint32_t TileWidth = 1024;		// 3 planes x 4 KB per tile, stays in L1/L2
+
+	FusedStages() : m_added(0) {}
+
+	FusedStages& Matrix(const float3x3& m)
+	{
+		m_added++;
+		if (!m_stages.empty() && m_stages.back().type == StageMatrix)
+		{
+			m_stages.back().m = mul(m, m_stages.back().m);
+			if (IsIdentity(m_stages.back().m))
+				m_stages.pop_back();
+		}
+		else if (!IsIdentity(m))
+		{
+			PipelineStage stage = { StageMatrix, m, 0.0f, 0.0f, nullptr };
+			m_stages.push_back(stage);
+		}
+		return *this;
+	}
+
+	FusedStages& Scale(float s)
+	{
+		return Matrix(float3x3(s, 0.0f, 0.0f, 0.0f, s, 0.0f, 0.0f, 0.0f, s));
+	}
+
+	FusedStages& Clamp(float lo, float hi)
+	{
+		m_added++;
+		if (!m_stages.empty() && m_stages.back().type == StageClamp)
+		{
+			// clamp(clamp(x, a, b), lo, hi) == clamp(x, clamp(a, lo, hi), clamp(b, lo, hi)),
+			// which also holds when the ranges don't overlap (intersecting them doesn't)
+			PipelineStage& last = m_stages.back();
+			last.a = std::min(std::max(last.a, lo), hi);
+			last.b = std::min(std::max(last.b, lo), hi);
+		}
+		else
+		{
+			PipelineStage stage = { StageClamp, float3x3(), lo, hi, nullptr };
+			m_stages.push_back(stage);
+		}
+		return *this;
+	}
+
+	FusedStages& Saturate() { return Clamp(0.0f, 1.0f); }
+
+	FusedStages& Apply2084()  { return AddSaturating(StageApply2084, 0.0f, nullptr); }
+	FusedStages& Remove2084() { return AddSaturating(StageRemove2084, 0.0f, nullptr); }
+
+	// lut is PQ in; the result is multiplied by outScale
+	FusedStages& ToneMap(std::shared_ptr<const ToneMapLUT> lut, float outScale = 1.0f)
+	{
+		return AddSaturating(StageToneMap, outScale, std::move(lut));
+	}
+
+	FusedStages& Pow(float exponent)
+	{
+		m_added++;
+		PipelineStage stage = { StagePow, float3x3(), exponent, 0.0f, nullptr };
+		m_stages.push_back(stage);
+		return *this;
+	}
+
+	// In place
+	void Run(ImageView image) const
+	{
+		Run(image, image);
+	}
+
+	// src and dst must be the same size; they may be the same image
+	void Run(ImageView src, ImageView dst) const
+	{
+		SimdDispatch([&](auto s) { RunT(s, src, dst); });
+	}
+
+	FusionReport Report(size_t pixelCount) const
+	{
+		const uint64_t passBytes = (uint64_t)pixelCount * ChannelCount * sizeof(float) * 2;
+		FusionReport report;
+		report.stagesAdded = m_added;
+		report.stagesFused = (uint32_t)m_stages.size();
+		report.bytesUnfused = passBytes * m_added;
+		report.bytesFused = (m_added || !m_stages.empty()) ? passBytes : 0;
+		return report;
+	}
+
+	const std::vector<PipelineStage>& Stages() const { return m_stages; }
+
+private:
+	static bool IsIdentity(const float3x3& m)
+	{
+		return m._11 == 1.0f && m._12 == 0.0f && m._13 == 0.0f &&
+			   m._21 == 0.0f && m._22 == 1.0f && m._23 == 0.0f &&
+			   m._31 == 0.0f && m._32 == 0.0f && m._33 == 1.0f;
+	}
+
+	static bool IsDiagonal(const float3x3& m)
+	{
+		return m._12 == 0.0f && m._13 == 0.0f && m._21 == 0.0f &&
+			   m._23 == 0.0f && m._31 == 0.0f && m._32 == 0.0f;
+	}
+
+	FusedStages& AddSaturating(PipelineStageType type, float a, std::shared_ptr<const ToneMapLUT> lut)
+	{
+		m_added++;
+		if (!m_stages.empty() && m_stages.back().type == StageClamp &&
+			m_stages.back().a <= 0.0f && m_stages.back().b >= 1.0f)
+			m_stages.pop_back();
+		PipelineStage stage = { type, float3x3(), a, 0.0f, std::move(lut) };
+		m_stages.push_back(stage);
+		return *this;
+	}
+
+	template <class S>
+	static void RunStage(S s, const PipelineStage& stage, const PlanarSpan& span)
+	{
+		switch (stage.type)
+		{
+		case StageMatrix:
+			if (IsDiagonal(stage.m))
+				FusedScale_Kernel<S>(span, stage.m);
+			else
+				FusedMatrix_Kernel<S>(span, stage.m);
+			break;
+		case StageClamp:
+			FusedClamp_Kernel<S>(span, stage.a, stage.b);
+			break;
+		case StageApply2084:
+			for (int c = 0; c < ChannelCount; c++)
+				::Apply2084(span.in[c], span.out[c], span.n);
+			break;
+		case StageRemove2084:
+			for (int c = 0; c < ChannelCount; c++)
+				::Remove2084(span.in[c], span.out[c], span.n);
+			break;
+		case StageToneMap:
+			for (int c = 0; c < ChannelCount; c++)
+				stage.lut->Apply(span.in[c], span.out[c], span.n, stage.a);
+			break;
+		case StagePow:
+			FusedPow_Kernel(s, span, stage.a);
+			break;
+		}
+	}
+
+	template <class S>
+	void RunT(S s, ImageView src, ImageView dst) const
+	{
+		const uint32_t width = std::min(src.width, dst.width);
+		const uint32_t height = std::min(src.height, dst.height);
+
+		for (uint32_t y = 0; y < height; y++)
+			for (uint32_t x0 = 0; x0 < width; x0 += TileWidth)
+			{
+				PlanarSpan span;
+				span.n = std::min(TileWidth, width - x0);
+				for (int c = 0; c < ChannelCount; c++)
+				{
+					span.in[c] = src.Row(c, y) + x0;
+					span.out[c] = dst.Row(c, y) + x0;
+				}
+
+				if (m_stages.empty())
+				{
+					if (src.plane[0] != dst.plane[0])
+						for (int c = 0; c < ChannelCount; c++)
+							memcpy(span.out[c], span.in[c], span.n * sizeof(float));
+					continue;
+				}
+
+				// first stage reads the source, the rest work in place on the hot tile
+				for (const PipelineStage& stage : m_stages)
+				{
+					RunStage(s, stage, span);
+					for (int c = 0; c < ChannelCount; c++)
+						span.in[c] = span.out[c];
+				}
+			}
+	}
+
+	std::vector<PipelineStage> m_stages;
+	uint32_t                   m_added;
+};
+
+// The ColorSpaces.h conversions as fused frame stages
+inline FusedStages Linear709ToHDR10Stages()
+{
+	FusedStages stages;
+	stages.Matrix(mat709to2020).Scale(0.008f).Saturate().Apply2084();
+	return stages;
+}
+
+inline FusedStages HDR10ToLinear709Stages()
+{
+	FusedStages stages;
+	stages.Saturate().Remove2084().Scale(125.0f).Matrix(mat2020to709);
+	return stages;
+}
@@ -0,0 +1,195 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "BasicMath.h"
+
+// Frame buffer for the AdvancedColorPipeline model.
+//
+// Storage is planar: R, G and B each get their own plane, so a stage walks three
+// contiguous float streams instead of strided float3s, which is what the span kernels in
+// ColorSpaces.h and SimdMath.h want.  Every row starts on a 64-byte boundary (one cache
+// line, one AVX-512 register) and the stride is in floats, padded to a multiple of 16.
+// All three planes live in one allocation.
+
+const size_t PipelineImageAlignment = 64;
+const size_t PipelineImageStrideAlign = PipelineImageAlignment / sizeof(float);
+
+enum PipelineChannel
+{
+	ChannelR = 0,
+	ChannelG = 1,
+	ChannelB = 2,
+	ChannelCount = 3
+};
+
+inline void* PipelineImageAlloc(size_t bytes)
+{
+#if defined(_MSC_VER)
+	return _aligned_malloc(bytes, PipelineImageAlignment);
+#else
+	return aligned_alloc(PipelineImageAlignment, (bytes + PipelineImageAlignment - 1) & ~(PipelineImageAlignment - 1));
+#endif
+}
+
+inline void PipelineImageFree(void* p)
+{
+#if defined(_MSC_VER)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+// Non-owning window onto a PipelineImage (or any planar float buffer).  Views are cheap to
+// copy and are what the Image_* stages take; Sub() carves out a tile or a band of rows.
+struct ImageView
+{
+	float*   plane[ChannelCount];		// first pixel of the view in each plane
+	uint32_t width;
+	uint32_t height;
+	size_t   stride;					// in floats, same for all planes
+
+	ImageView() : plane{}, width(0), height(0), stride(0) {}
+
+	float* Row(int c, uint32_t y) const { return plane[c] + y * stride; }
+
+	float3 Get(uint32_t x, uint32_t y) const
+	{
+		size_t i = y * stride + x;
+		return float3(plane[ChannelR][i], plane[ChannelG][i], plane[ChannelB][i]);
+	}
+
+	void Set(uint32_t x, uint32_t y, const float3& c) const
+	{
+		size_t i = y * stride + x;
+		plane[ChannelR][i] = c.x;
+		plane[ChannelG][i] = c.y;
+		plane[ChannelB][i] = c.z;
+	}
+
+	ImageView Sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+	{
+		ImageView v = *this;
+		for (int c = 0; c < ChannelCount; c++)
+			v.plane[c] = plane[c] + y * stride + x;
+		v.width = w;
+		v.height = h;
+		return v;
+	}
+
+	ImageView Rows(uint32_t y, uint32_t h) const { return Sub(0, y, width, h); }
+
+	size_t PixelCount() const { return (size_t)width * height; }
+	bool   Empty() const { return width == 0 || height == 0; }
+};
+
+class PipelineImage
+{
+public:
+	PipelineImage() : m_data(nullptr), m_width(0), m_height(0), m_stride(0) {}
+
+	PipelineImage(uint32_t width, uint32_t height) : m_data(nullptr), m_width(0), m_height(0), m_stride(0)
+	{
+		Resize(width, height);
+	}
+
+	~PipelineImage()
+	{
+		PipelineImageFree(m_data);
+	}
+
+	PipelineImage(const PipelineImage& src) : m_data(nullptr), m_width(0), m_height(0), m_stride(0)
+	{
+		*this = src;
+	}
+
+	PipelineImage& operator=(const PipelineImage& src)
+	{
+		if (this != &src)
+		{
+			Resize(src.m_width, src.m_height);
+			if (m_data)
+				memcpy(m_data, src.m_data, PlaneSize() * ChannelCount * sizeof(float));
+		}
+		return *this;
+	}
+
+	PipelineImage(PipelineImage&& src) : m_data(src.m_data), m_width(src.m_width), m_height(src.m_height), m_stride(src.m_stride)
+	{
+		src.m_data = nullptr;
+		src.m_width = src.m_height = 0;
+		src.m_stride = 0;
+	}
+
+	PipelineImage& operator=(PipelineImage&& src)
+	{
+		if (this != &src)
+		{
+			PipelineImageFree(m_data);
+			m_data = src.m_data;
+			m_width = src.m_width;
+			m_height = src.m_height;
+			m_stride = src.m_stride;
+			src.m_data = nullptr;
+			src.m_width = src.m_height = 0;
+			src.m_stride = 0;
+		}
+		return *this;
+	}
+
+	// Contents are undefined after a size change.
+	void Resize(uint32_t width, uint32_t height)
+	{
+		if (width == m_width && height == m_height && m_data)
+			return;
+		PipelineImageFree(m_data);
+		m_data = nullptr;
+		m_width = width;
+		m_height = height;
+		m_stride = (width + PipelineImageStrideAlign - 1) & ~(PipelineImageStrideAlign - 1);
+		if (PlaneSize() == 0)
+			return;
+		m_data = static_cast<float*>(PipelineImageAlloc(PlaneSize() * ChannelCount * sizeof(float)));
+		if (!m_data)
+			throw std::bad_alloc();
+	}
+
+	ImageView View() const
+	{
+		ImageView v;
+		for (int c = 0; c < ChannelCount; c++)
+			v.plane[c] = m_data + c * PlaneSize();
+		v.width = m_width;
+		v.height = m_height;
+		v.stride = m_stride;
+		return v;
+	}
+
+	operator ImageView() const { return View(); }
+
+	uint32_t Width() const  { return m_width; }
+	uint32_t Height() const { return m_height; }
+	size_t   Stride() const { return m_stride; }
+
+private:
+	size_t PlaneSize() const { return m_stride * m_height; }
+
+	float*   m_data;
+	uint32_t m_width;
+	uint32_t m_height;
+	size_t   m_stride;
+};
@@ -0,0 +1,378 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "SimdMath.h"
+#include "PipelineImage.h"
+#include "PipelineExecutor.h"
+
+// Zone backlight model for a local-dimming LCD.
+//
+// Input is the light each pixel asks for, linear, 1.0 = panel peak.  Each zone of the grid
+// drives its LED to the max (or a percentile) of the pixels it covers.  The light reaching
+// each pixel is the zone levels spread by a Gaussian point-spread function, normalized so a
+// full-white field is 1.0 everywhere.  The LCD then transmits target / backlight, but can
+// neither exceed 1 nor go below 1 / nativeContrast, which is where blooming and clipping
+// come from.  Output is the light actually emitted.
+//
+// The PSF is separable, so the backlight is built in two passes: every zone row is spread
+// horizontally into a full-width line (one axpy per zone), then every pixel row is a
+// weighted sum of the few zone lines in reach.  Zone reduction, both blur passes and the
+// transmittance are SIMD row kernels split by rows over the executor, so the cost stays
+// proportional to the pixel count from 8 zones to thousands.
+
+enum DimmingDrive
+{
+	DimmingMax,
+	DimmingPercentile,
+};
+
+struct LocalDimmingParams
+{
+	uint32_t     zonesX;			// 0: no local dimming, the backlight is full on
+	uint32_t     zonesY;
+	DimmingDrive drive;
+	float        percentile;		// for DimmingPercentile, e.g. 0.99
+	float        psfSigma;			// PSF width in zones
+	float        nativeContrast;	// LCD alone, e.g. 1000 for IPS, 5000 for VA
+};
+
+struct LocalDimmingReport
+{
+	uint32_t zones;
+	float    peak;					// brightest emitted luminance
+	float    black;					// darkest emitted luminance
+	double   bloomingMean;			// mean emitted luminance over pixels that asked for black
+	float    bloomingMax;
+	uint64_t blackPixels;
+	uint64_t clippedPixels;			// pixels the backlight could not reach
+	uint64_t pixels;
+
+	// infinite when some zones are fully off
+	float  Contrast() const        { return black > 0.0f ? peak / black : (peak > 0.0f ? std::numeric_limits<float>::infinity() : 0.0f); }
+	double ClippedFraction() const { return pixels ? (double)clippedPixels / pixels : 0.0; }
+};
+
+// out[i] += w * in[i]
+template <class S>
+void Dimming_Axpy_Kernel(float* out, const float* in, size_t n, float w)
+{
+	const typename S::V k = S::Set1(w);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+		S::Store(out + i, S::Add(S::Load(out + i), S::Mul(k, S::Load(in + i))));
+	for (; i < n; i++)
+		out[i] += w * in[i];
+}
+
+// m[i] = max(r[i], g[i], b[i]); returns the max of m
+template <class S>
+float Dimming_RowMax_Kernel(const float* r, const float* g, const float* b, float* m, size_t n)
+{
+	typedef typename S::V V;
+	V peak = S::Set1(0.0f);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		V v = S::Max(S::Max(S::Load(r + i), S::Load(g + i)), S::Load(b + i));
+		S::Store(m + i, v);
+		peak = S::Max(peak, v);
+	}
+	float lanes[16];
+	S::Store(lanes, peak);
+	float result = 0.0f;
+	for (int k = 0; k < S::Width; k++)
+		result = std::max(result, lanes[k]);
+	for (; i < n; i++)
+	{
+		m[i] = std::max(std::max(r[i], g[i]), b[i]);
+		result = std::max(result, m[i]);
+	}
+	return result;
+}
+
+// emitted = clamp(target, backlight / contrast, backlight), on one channel row
+template <class S>
+void Dimming_Transmit_Kernel(float* p, const float* backlight, size_t n, float leak)
+{
+	typedef typename S::V V;
+	const V k = S::Set1(leak);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		V bl = S::Load(backlight + i);
+		S::Store(p + i, S::Min(S::Max(S::Load(p + i), S::Mul(bl, k)), bl));
+	}
+	for (; i < n; i++)
+		p[i] = std::min(std::max(p[i], backlight[i] * leak), backlight[i]);
+}
+
+class LocalDimmingSimulator
+{
+public:
+	static const int DriveBins = 256;		// percentile drive histogram, in value^(1/4)
+
+	LocalDimmingReport Run(ImageView image, const LocalDimmingParams& params, PipelineExecutor* executor = nullptr)
+	{
+		LocalDimmingReport report = {};
+		if (params.zonesX == 0 || params.zonesY == 0 || image.Empty())
+			return report;
+
+		m_params = params;
+		m_zonesX = std::min(params.zonesX, image.width);
+		m_zonesY = std::min(params.zonesY, image.height);
+		report.zones = m_zonesX * m_zonesY;
+
+		uint32_t threads = executor ? executor->Threads() : 1;
+		m_scratch.resize(threads);
+		for (auto& s : m_scratch)
+			s.resize((size_t)image.width * 2);
+
+		BuildProfiles(image.width, image.height);
+
+		// 1: zone levels
+		m_levels.assign(report.zones, 0.0f);
+		ForEachRow(executor, m_zonesY, [&](uint32_t j, uint32_t worker) { ReduceZoneRow(image, j, m_scratch[worker].data()); });
+
+		// 2: horizontal spread of each zone row
+		m_lines.assign((size_t)m_zonesY * image.width, 0.0f);
+		ForEachRow(executor, m_zonesY, [&](uint32_t j, uint32_t)
+		{
+			float* line = &m_lines[(size_t)j * image.width];
+			for (uint32_t i = 0; i < m_zonesX; i++)
+			{
+				const Profile& p = m_profileX[i];
+				float level = m_levels[(size_t)j * m_zonesX + i];
+				if (level > 0.0f)
+					SimdDispatch([&](auto s) { Dimming_Axpy_Kernel<decltype(s)>(line + p.start, &m_weightsX[p.offset], p.count, level); });
+			}
+		});
+
+		// 3: vertical spread, transmittance and the report, per pixel row
+		std::vector<LocalDimmingReport> partial(threads, report);
+		for (auto& r : partial)
+		{
+			r.peak = 0.0f;
+			r.black = 1e30f;
+		}
+		const float leak = 1.0f / std::max(params.nativeContrast, 1.0f);
+
+		ForEachRow(executor, image.height, [&](uint32_t y, uint32_t worker)
+		{
+			float* backlight = m_scratch[worker].data();
+			std::fill(backlight, backlight + image.width, 0.0f);
+			for (uint32_t j = 0; j < m_zonesY; j++)
+			{
+				const Profile& p = m_profileY[j];
+				if (y >= p.start && y < p.start + p.count)
+				{
+					const float* line = &m_lines[(size_t)j * image.width];
+					float w = m_weightsY[p.offset + (y - p.start)];
+					SimdDispatch([&](auto s) { Dimming_Axpy_Kernel<decltype(s)>(backlight, line, image.width, w); });
+				}
+			}
+
+			float* r = image.Row(ChannelR, y);
+			float* g = image.Row(ChannelG, y);
+			float* b = image.Row(ChannelB, y);
+			LocalDimmingReport& rep = partial[worker];
+
+			// what the row asked for, before transmittance changes it
+			float* wanted = backlight + image.width;
+			for (uint32_t x = 0; x < image.width; x++)
+			{
+				wanted[x] = std::max(std::max(r[x], g[x]), b[x]);
+				if (wanted[x] > backlight[x] * 1.0001f)
+					rep.clippedPixels++;
+			}
+
+			for (int c = 0; c < ChannelCount; c++)
+				SimdDispatch([&](auto s) { Dimming_Transmit_Kernel<decltype(s)>(image.Row(c, y), backlight, image.width, leak); });
+
+			for (uint32_t x = 0; x < image.width; x++)
+			{
+				float Y = 0.2290f * r[x] + 0.6917f * g[x] + 0.0793f * b[x];		// P3-D65 panel primaries
+				rep.peak = std::max(rep.peak, Y);
+				rep.black = std::min(rep.black, Y);
+				if (wanted[x] <= BlackLevel)
+				{
+					rep.blackPixels++;
+					rep.bloomingMean += Y;
+					rep.bloomingMax = std::max(rep.bloomingMax, Y);
+				}
+			}
+			rep.pixels += image.width;
+		});
+
+		report.black = 1e30f;
+		for (const LocalDimmingReport& r : partial)
+		{
+			report.peak = std::max(report.peak, r.peak);
+			report.black = std::min(report.black, r.black);
+			report.bloomingMean += r.bloomingMean;
+			report.bloomingMax = std::max(report.bloomingMax, r.bloomingMax);
+			report.blackPixels += r.blackPixels;
+			report.clippedPixels += r.clippedPixels;
+			report.pixels += r.pixels;
+		}
+		if (report.blackPixels)
+			report.bloomingMean /= report.blackPixels;
+		return report;
+	}
+
+	// LED levels of the last run, row-major
+	const std::vector<float>& ZoneLevels() const { return m_levels; }
+
+private:
+	static constexpr float BlackLevel = 1e-5f;		// requests at or below this count as black
+
+	// a zone's PSF along one axis: weights for pixels [start, start + count)
+	struct Profile
+	{
+		uint32_t start;
+		uint32_t count;
+		size_t   offset;			// into the weight array
+	};
+
+	template <class F>
+	static void ForEachRow(PipelineExecutor* executor, uint32_t rows, F&& f)
+	{
+		if (executor)
+			executor->ForEach(rows, f);
+		else
+			for (uint32_t y = 0; y < rows; y++)
+				f(y, 0);
+	}
+
+	// Gaussian PSF per zone, truncated at 3 sigma and normalized so the zones sum to 1 at
+	// every pixel
+	void BuildAxis(uint32_t pixels, uint32_t zones, std::vector<Profile>& profiles, std::vector<float>& weights) const
+	{
+		float zoneSize = (float)pixels / zones;
+		float sigma = std::max(m_params.psfSigma, 0.05f) * zoneSize;
+		float reach = 3.0f * sigma + 0.5f * zoneSize;
+
+		profiles.resize(zones);
+		weights.clear();
+		std::vector<float> total(pixels, 0.0f);
+		for (uint32_t i = 0; i < zones; i++)
+		{
+			float center = (i + 0.5f) * zoneSize;
+			int start = std::max((int)floorf(center - reach), 0);
+			int end = std::min((int)ceilf(center + reach), (int)pixels);
+			profiles[i] = { (uint32_t)start, (uint32_t)(end - start), weights.size() };
+			for (int x = start; x < end; x++)
+			{
+				float d = (x + 0.5f - center) / sigma;
+				float w = expf(-0.5f * d * d);
+				weights.push_back(w);
+				total[x] += w;
+			}
+		}
+		for (uint32_t i = 0; i < zones; i++)
+			for (uint32_t k = 0; k < profiles[i].count; k++)
+			{
+				float t = total[profiles[i].start + k];
+				weights[profiles[i].offset + k] /= t > 0.0f ? t : 1.0f;
+			}
+	}
+
+	void BuildProfiles(uint32_t width, uint32_t height)
+	{
+		if (width == m_width && height == m_height && m_zonesX == m_builtX && m_zonesY == m_builtY && m_params.psfSigma == m_builtSigma)
+			return;
+		BuildAxis(width, m_zonesX, m_profileX, m_weightsX);
+		BuildAxis(height, m_zonesY, m_profileY, m_weightsY);
+		m_width = width;
+		m_height = height;
+		m_builtX = m_zonesX;
+		m_builtY = m_zonesY;
+		m_builtSigma = m_params.psfSigma;
+	}
+
+	void ReduceZoneRow(ImageView image, uint32_t j, float* m)
+	{
+		uint32_t y0 = (uint32_t)((uint64_t)image.height * j / m_zonesY);
+		uint32_t y1 = (uint32_t)((uint64_t)image.height * (j + 1) / m_zonesY);
+		float* levels = &m_levels[(size_t)j * m_zonesX];
+
+		std::vector<uint32_t> histogram;
+		if (m_params.drive == DimmingPercentile)
+			histogram.assign((size_t)m_zonesX * DriveBins, 0);
+
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			const float* r = image.Row(ChannelR, y);
+			const float* g = image.Row(ChannelG, y);
+			const float* b = image.Row(ChannelB, y);
+			for (uint32_t i = 0; i < m_zonesX; i++)
+			{
+				uint32_t x0 = (uint32_t)((uint64_t)image.width * i / m_zonesX);
+				uint32_t x1 = (uint32_t)((uint64_t)image.width * (i + 1) / m_zonesX);
+				float peak = SimdDispatch([&](auto s) { return Dimming_RowMax_Kernel<decltype(s)>(r + x0, g + x0, b + x0, m, x1 - x0); });
+				levels[i] = std::max(levels[i], peak);
+
+				if (!histogram.empty())
+				{
+					uint32_t* h = &histogram[(size_t)i * DriveBins];
+					for (uint32_t x = 0; x < x1 - x0; x++)
+					{
+						float v = std::min(std::max(m[x], 0.0f), 1.0f);
+						h[std::min((int)(sqrtf(sqrtf(v)) * DriveBins), DriveBins - 1)]++;
+					}
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < m_zonesX; i++)
+		{
+			if (!histogram.empty())
+			{
+				// top of the bin the percentile falls in, never above the true max
+				const uint32_t* h = &histogram[(size_t)i * DriveBins];
+				uint64_t count = 0;
+				for (int k = 0; k < DriveBins; k++)
+					count += h[k];
+				uint64_t target = (uint64_t)ceil(m_params.percentile * count);
+				uint64_t below = 0;
+				for (int k = 0; k < DriveBins; k++)
+				{
+					below += h[k];
+					if (below >= target && below > 0)
+					{
+						float v = (k + 1.0f) / DriveBins;
+						levels[i] = std::min(levels[i], v * v * v * v);
+						break;
+					}
+				}
+			}
+			levels[i] = std::min(std::max(levels[i], 0.0f), 1.0f);
+		}
+	}
+
+	LocalDimmingParams              m_params = {};
+	uint32_t                        m_zonesX = 0;
+	uint32_t                        m_zonesY = 0;
+	std::vector<float>              m_levels;			// zonesY x zonesX
+	std::vector<float>              m_lines;			// zonesY x width, horizontally spread
+	std::vector<std::vector<float>> m_scratch;			// per worker, two rows
+
+	std::vector<Profile>            m_profileX, m_profileY;
+	std::vector<float>              m_weightsX, m_weightsY;
+	uint32_t                        m_width = 0, m_height = 0, m_builtX = 0, m_builtY = 0;
+	float                           m_builtSigma = 0.0f;
+};
@@ -0,0 +1,333 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "PipelineImage.h"
+#include "PipelineExecutor.h"
+
+// Quantization of the wire signal to 8/10/12-bit codes.
+//
+// The image is [0..1] (e.g. PQ) on the way in and holds code / (2^bits - 1) on the way out,
+// so the code is exactly round(value * maxCode) and the stages after it keep working in
+// float.  Truncate, round and the two ordered dithers are pixel-local and run per tile;
+// Floyd-Steinberg carries error to the next row, so it runs as a wavefront: row y may
+// process column x once row y-1 is past x+1, with every worker taking the next row.
+
+enum QuantizeMode
+{
+	QuantizeTruncate,
+	QuantizeRound,
+	QuantizeBayer,				// 8x8 ordered dither
+	QuantizeBlueNoise,			// 64x64 void-and-cluster mask, shifted every frame
+	QuantizeFloydSteinberg,		// error diffusion
+};
+
+struct QuantizeParams
+{
+	uint32_t     bits;			// 0 leaves the signal in float
+	QuantizeMode mode;
+	uint32_t     frame;			// moves the blue-noise mask so the pattern does not sit still
+};
+
+inline bool QuantizeIsPixelLocal(QuantizeMode mode)
+{
+	return mode != QuantizeFloydSteinberg;
+}
+
+// 8x8 Bayer thresholds in (0..1)
+inline const float* BayerThresholds()
+{
+	static const float table[64] =
+	{
+#define BAYER(v) ((v) + 0.5f) / 64.0f
+		BAYER( 0), BAYER(32), BAYER( 8), BAYER(40), BAYER( 2), BAYER(34), BAYER(10), BAYER(42),
+		BAYER(48), BAYER(16), BAYER(56), BAYER(24), BAYER(50), BAYER(18), BAYER(58), BAYER(26),
+		BAYER(12), BAYER(44), BAYER( 4), BAYER(36), BAYER(14), BAYER(46), BAYER( 6), BAYER(38),
+		BAYER(60), BAYER(28), BAYER(52), BAYER(20), BAYER(62), BAYER(30), BAYER(54), BAYER(22),
+		BAYER( 3), BAYER(35), BAYER(11), BAYER(43), BAYER( 1), BAYER(33), BAYER( 9), BAYER(41),
+		BAYER(51), BAYER(19), BAYER(59), BAYER(27), BAYER(49), BAYER(17), BAYER(57), BAYER(25),
+		BAYER(15), BAYER(47), BAYER( 7), BAYER(39), BAYER(13), BAYER(45), BAYER( 5), BAYER(37),
+		BAYER(63), BAYER(31), BAYER(55), BAYER(23), BAYER(61), BAYER(29), BAYER(53), BAYER(21),
+#undef BAYER
+	};
+	return table;
+}
+
+const int BlueNoiseSize = 64;
+
+// Ulichney's void-and-cluster on a 64x64 torus.  The energy of every cell is kept up to
+// date as points are toggled, so each step is one 4096-cell update and one scan.  Built
+// once, on first use; the result is a rank per cell, returned as thresholds in (0..1).
+class BlueNoiseMask
+{
+public:
+	static const BlueNoiseMask& Get()
+	{
+		static const BlueNoiseMask mask;
+		return mask;
+	}
+
+	float Threshold(uint32_t x, uint32_t y) const
+	{
+		return m_threshold[(y % BlueNoiseSize) * BlueNoiseSize + (x % BlueNoiseSize)];
+	}
+
+	const float* Row(uint32_t y) const { return m_threshold + (y % BlueNoiseSize) * BlueNoiseSize; }
+
+private:
+	static const int N = BlueNoiseSize * BlueNoiseSize;
+
+	BlueNoiseMask()
+	{
+		const float sigma = 1.5f;
+		float kernel[N];
+		for (int y = 0; y < BlueNoiseSize; y++)
+			for (int x = 0; x < BlueNoiseSize; x++)
+			{
+				int dx = std::min(x, BlueNoiseSize - x);
+				int dy = std::min(y, BlueNoiseSize - y);
+				kernel[y * BlueNoiseSize + x] = expf(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+			}
+
+		// initial pattern: 10% of the cells, from a fixed seed so the mask never changes
+		std::vector<bool> pattern(N, false);
+		std::vector<float> energy(N, 0.0f);
+		uint32_t seed = 0x2545F491;
+		int ones = 0;
+		while (ones < N / 10)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			int i = (seed >> 8) % N;
+			if (!pattern[i])
+			{
+				Toggle(pattern, energy, kernel, i);
+				ones++;
+			}
+		}
+
+		// relax: move the tightest cluster into the largest void until that is a no-op
+		for (;;)
+		{
+			int cluster = Extreme(pattern, energy, true);
+			Toggle(pattern, energy, kernel, cluster);
+			int hole = Extreme(pattern, energy, false);
+			if (hole == cluster)
+			{
+				Toggle(pattern, energy, kernel, cluster);
+				break;
+			}
+			Toggle(pattern, energy, kernel, hole);
+		}
+
+		int rank[N];
+		std::vector<bool> prototype = pattern;
+		std::vector<float> protoEnergy = energy;
+
+		// ranks below the prototype: remove clusters
+		for (int r = ones - 1; r >= 0; r--)
+		{
+			int cluster = Extreme(pattern, energy, true);
+			Toggle(pattern, energy, kernel, cluster);
+			rank[cluster] = r;
+		}
+
+		// ranks above: fill voids.  Past half full the tightest cluster of zeros is the zero
+		// with the least energy from the ones, so the same search covers both phases.
+		pattern = prototype;
+		energy = protoEnergy;
+		for (int r = ones; r < N; r++)
+		{
+			int hole = Extreme(pattern, energy, false);
+			Toggle(pattern, energy, kernel, hole);
+			rank[hole] = r;
+		}
+
+		for (int i = 0; i < N; i++)
+			m_threshold[i] = (rank[i] + 0.5f) / N;
+	}
+
+	static void Toggle(std::vector<bool>& pattern, std::vector<float>& energy, const float* kernel, int i)
+	{
+		float sign = pattern[i] ? -1.0f : 1.0f;
+		pattern[i] = !pattern[i];
+		int px = i % BlueNoiseSize, py = i / BlueNoiseSize;
+		for (int y = 0; y < BlueNoiseSize; y++)
+		{
+			const float* k = kernel + ((y - py + BlueNoiseSize) % BlueNoiseSize) * BlueNoiseSize;
+			float* e = &energy[y * BlueNoiseSize];
+			for (int x = 0; x < BlueNoiseSize; x++)
+				e[x] += sign * k[(x - px + BlueNoiseSize) % BlueNoiseSize];
+		}
+	}
+
+	// highest-energy one (cluster) or lowest-energy zero (void)
+	static int Extreme(const std::vector<bool>& pattern, const std::vector<float>& energy, bool cluster)
+	{
+		int best = -1;
+		for (int i = 0; i < N; i++)
+		{
+			if (pattern[i] != cluster)
+				continue;
+			if (best < 0 || (cluster ? energy[i] > energy[best] : energy[i] < energy[best]))
+				best = i;
+		}
+		return best;
+	}
+
+	float m_threshold[N];
+};
+
+// One row of one plane, pixel-local modes.  x0/y0 place the row in the frame so tiles see
+// the same dither pattern as a whole-frame pass.
+inline void QuantizeRow(const QuantizeParams& params, float* row, uint32_t n, uint32_t x0, uint32_t y0)
+{
+	const float maxCode = (float)((1u << params.bits) - 1);
+	const float invMax = 1.0f / maxCode;
+
+	float offset = 0.0f;
+	const float* thresholds = nullptr;
+	uint32_t mask = 0, shift = x0;
+	switch (params.mode)
+	{
+	case QuantizeRound:
+		offset = 0.5f;
+		break;
+	case QuantizeBayer:
+		thresholds = BayerThresholds() + (y0 & 7) * 8;
+		mask = 7;
+		break;
+	case QuantizeBlueNoise:
+		// each frame moves the mask by a step coprime with its size
+		thresholds = BlueNoiseMask::Get().Row(y0 + params.frame * 41);
+		mask = BlueNoiseSize - 1;
+		shift = x0 + params.frame * 23;
+		break;
+	default:
+		break;
+	}
+
+	if (!thresholds)
+	{
+		for (uint32_t x = 0; x < n; x++)
+		{
+			float v = std::min(std::max(row[x], 0.0f), 1.0f) * maxCode + offset;
+			row[x] = std::min(floorf(v), maxCode) * invMax;
+		}
+		return;
+	}
+
+	for (uint32_t x = 0; x < n; x++)
+	{
+		float v = std::min(std::max(row[x], 0.0f), 1.0f) * maxCode + thresholds[(shift + x) & mask];
+		row[x] = std::min(floorf(v), maxCode) * invMax;
+	}
+}
+
+// Pixel-local quantization of a view whose top-left pixel sits at (x0, y0) in the frame
+inline void QuantizeImage(ImageView image, const QuantizeParams& params, uint32_t x0 = 0, uint32_t y0 = 0)
+{
+	if (params.bits == 0)
+		return;
+	for (int c = 0; c < ChannelCount; c++)
+		for (uint32_t y = 0; y < image.height; y++)
+			QuantizeRow(params, image.Row(c, y), image.width, x0, y0 + y);
+}
+
+// Floyd-Steinberg, left to right, 7/16 right, 3/16 down-left, 5/16 down, 1/16 down-right.
+// Error to the right is carried in a register and error to the row below is added straight
+// into the image, so a row only ever writes its own pixels and the row under it.
+inline void DiffuseRow(const QuantizeParams& params, ImageView image, uint32_t y, uint32_t x0, uint32_t x1, float carry[ChannelCount])
+{
+	const float maxCode = (float)((1u << params.bits) - 1);
+	const float invMax = 1.0f / maxCode;
+	bool below = y + 1 < image.height;
+
+	for (int c = 0; c < ChannelCount; c++)
+	{
+		float* row = image.Row(c, y);
+		float* next = below ? image.Row(c, y + 1) : nullptr;
+		float err = carry[c];
+		for (uint32_t x = x0; x < x1; x++)
+		{
+			float v = std::min(std::max(row[x] + err, 0.0f), 1.0f) * maxCode;
+			float code = std::min(floorf(v + 0.5f), maxCode);
+			float e = (v - code) * invMax;
+			row[x] = code * invMax;
+			err = e * (7.0f / 16.0f);
+			if (next)
+			{
+				if (x > 0)
+					next[x - 1] += e * (3.0f / 16.0f);
+				next[x] += e * (5.0f / 16.0f);
+				if (x + 1 < image.width)
+					next[x + 1] += e * (1.0f / 16.0f);
+			}
+		}
+		carry[c] = err;
+	}
+}
+
+// Wavefront error diffusion.  Workers take rows in order from a shared counter and publish
+// how far along their row they are; a row waits until the one above is two pixels ahead.
+// Rows are taken in order, so the row being waited on always belongs to a running worker.
+inline void DiffuseImage(ImageView image, const QuantizeParams& params, PipelineExecutor* executor = nullptr)
+{
+	if (params.bits == 0 || image.Empty())
+		return;
+
+	if (!executor || executor->Threads() == 1 || image.height == 1)
+	{
+		for (uint32_t y = 0; y < image.height; y++)
+		{
+			float carry[ChannelCount] = {};
+			DiffuseRow(params, image, y, 0, image.width, carry);
+		}
+		return;
+	}
+
+	const uint32_t Chunk = 64;
+	std::unique_ptr<std::atomic<uint32_t>[]> progress(new std::atomic<uint32_t>[image.height]);
+	for (uint32_t y = 0; y < image.height; y++)
+		progress[y].store(0, std::memory_order_relaxed);
+	std::atomic<uint32_t> nextRow(0);
+
+	executor->ForEach(executor->Threads(), [&](uint32_t, uint32_t)
+	{
+		for (;;)
+		{
+			uint32_t y = nextRow.fetch_add(1);
+			if (y >= image.height)
+				return;
+
+			float carry[ChannelCount] = {};
+			for (uint32_t x0 = 0; x0 < image.width; x0 += Chunk)
+			{
+				uint32_t x1 = std::min(x0 + Chunk, image.width);
+				if (y > 0)
+				{
+					uint32_t need = std::min(x1 + 1, image.width);
+					while (progress[y - 1].load(std::memory_order_acquire) < need)
+						std::this_thread::yield();
+				}
+				DiffuseRow(params, image, y, x0, x1, carry);
+				progress[y].store(x1, std::memory_order_release);
+			}
+		}
+	});
+}
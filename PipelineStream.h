@@ -0,0 +1,512 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PipelineImage.h"
+
+// Streams a headerless raw frame sequence through the pipeline model.
+//
+// A fixed pool of slots (raw input bytes, one PipelineImage, raw output bytes) cycles
+// reader -> processing -> writer -> reader through bounded queues, so a clip of any length
+// never has more than Depth frames in memory.  The reader thread decodes while the caller
+// processes the previous frame and the writer thread encodes and writes the one before
+// that.  Frames are read and written whole with large sequential I/O.
+
+enum FrameFormat
+{
+	FrameRGB32F,			// interleaved float RGB, 12 bytes/pixel
+	FrameRGBA16F,			// interleaved half RGBA (scRGB swap chain layout), 8 bytes/pixel, alpha ignored
+	FrameP010,				// 10-bit 4:2:0 BT.2020 NCL limited range: Y plane then interleaved CbCr, msb aligned
+};
+
+inline size_t FrameBytes(FrameFormat format, uint32_t width, uint32_t height)
+{
+	size_t pixels = (size_t)width * height;
+	switch (format)
+	{
+	case FrameRGB32F:  return pixels * 3 * sizeof(float);
+	case FrameRGBA16F: return pixels * 4 * sizeof(uint16_t);
+	case FrameP010:    return pixels * sizeof(uint16_t) + (size_t)((width + 1) / 2) * ((height + 1) / 2) * 2 * sizeof(uint16_t);
+	}
+	return 0;
+}
+
+inline float HalfToFloat(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+	uint32_t bits;
+
+	if (exponent == 0x1f)
+		bits = sign | 0x7f800000 | (mantissa << 13);			// inf/NaN
+	else if (exponent != 0)
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else if (mantissa == 0)
+		bits = sign;
+	else
+	{
+		float f = mantissa * (1.0f / 16777216.0f);				// denormal: mantissa * 2^-24
+		return sign ? -f : f;
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// Round to nearest even, overflow goes to inf
+inline uint16_t FloatToHalf(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	uint32_t abs = bits & 0x7fffffff;
+
+	if (abs >= 0x7f800000)
+		return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+	if (abs >= 0x477ff000)										// rounds past HALF_MAX
+		return sign | 0x7c00;
+	if (abs < 0x38800000)										// half denormal or zero
+	{
+		float a;
+		memcpy(&a, &abs, sizeof(a));
+		return sign | (uint16_t)(a * 16777216.0f + 0.5f);
+	}
+
+	uint32_t h = ((abs - 0x38000000) >> 13);
+	uint32_t rest = abs & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+		h++;
+	return sign | (uint16_t)h;
+}
+
+// BT.2020 non-constant luminance, 10-bit limited range, Y'CbCr <-> R'G'B'
+const float P010_Kr = 0.2627f;
+const float P010_Kb = 0.0593f;
+
+inline float3 P010_DecodePixel(uint16_t y, uint16_t cb, uint16_t cr)
+{
+	float Y  = ((y >> 6) - 64.0f) / 876.0f;
+	float Cb = ((cb >> 6) - 512.0f) / 896.0f;
+	float Cr = ((cr >> 6) - 512.0f) / 896.0f;
+	float R = Y + 2.0f * (1.0f - P010_Kr) * Cr;
+	float B = Y + 2.0f * (1.0f - P010_Kb) * Cb;
+	float G = (Y - P010_Kr * R - P010_Kb * B) / (1.0f - P010_Kr - P010_Kb);
+	return float3(R, G, B);
+}
+
+inline uint16_t P010_Code(float v, float scale, float offset)
+{
+	float code = v * scale + offset + 0.5f;
+	code = code < 0.0f ? 0.0f : (code > 1023.0f ? 1023.0f : code);
+	return (uint16_t)((uint32_t)code << 6);
+}
+
+// raw bytes -> planar float.  Pixel values are copied as stored: P010 comes out as
+// PQ-encoded BT.2020 R'G'B', the float formats as whatever the source wrote.
+inline void FrameUnpack(FrameFormat format, const uint8_t* src, ImageView dst)
+{
+	uint32_t w = dst.width;
+	for (uint32_t y = 0; y < dst.height; y++)
+	{
+		float* r = dst.Row(ChannelR, y);
+		float* g = dst.Row(ChannelG, y);
+		float* b = dst.Row(ChannelB, y);
+
+		if (format == FrameRGB32F)
+		{
+			const float* p = reinterpret_cast<const float*>(src) + (size_t)y * w * 3;
+			for (uint32_t x = 0; x < w; x++, p += 3)
+			{
+				r[x] = p[0];
+				g[x] = p[1];
+				b[x] = p[2];
+			}
+		}
+		else if (format == FrameRGBA16F)
+		{
+			const uint16_t* p = reinterpret_cast<const uint16_t*>(src) + (size_t)y * w * 4;
+			for (uint32_t x = 0; x < w; x++, p += 4)
+			{
+				r[x] = HalfToFloat(p[0]);
+				g[x] = HalfToFloat(p[1]);
+				b[x] = HalfToFloat(p[2]);
+			}
+		}
+		else
+		{
+			// chroma is nearest-neighbor upsampled; the wire stage does the proper filtering
+			const uint16_t* luma = reinterpret_cast<const uint16_t*>(src) + (size_t)y * w;
+			const uint16_t* chroma = reinterpret_cast<const uint16_t*>(src) + (size_t)w * dst.height + (size_t)(y / 2) * ((w + 1) / 2) * 2;
+			for (uint32_t x = 0; x < w; x++)
+			{
+				const uint16_t* c = chroma + (x / 2) * 2;
+				float3 rgb = P010_DecodePixel(luma[x], c[0], c[1]);
+				r[x] = rgb.r;
+				g[x] = rgb.g;
+				b[x] = rgb.b;
+			}
+		}
+	}
+}
+
+// planar float -> raw bytes.  P010 chroma is the 2x2 box average.
+inline void FramePack(FrameFormat format, ImageView src, uint8_t* dst)
+{
+	uint32_t w = src.width;
+	uint32_t h = src.height;
+
+	if (format == FrameRGB32F || format == FrameRGBA16F)
+	{
+		for (uint32_t y = 0; y < h; y++)
+		{
+			const float* r = src.Row(ChannelR, y);
+			const float* g = src.Row(ChannelG, y);
+			const float* b = src.Row(ChannelB, y);
+
+			if (format == FrameRGB32F)
+			{
+				float* p = reinterpret_cast<float*>(dst) + (size_t)y * w * 3;
+				for (uint32_t x = 0; x < w; x++, p += 3)
+				{
+					p[0] = r[x];
+					p[1] = g[x];
+					p[2] = b[x];
+				}
+			}
+			else
+			{
+				uint16_t* p = reinterpret_cast<uint16_t*>(dst) + (size_t)y * w * 4;
+				for (uint32_t x = 0; x < w; x++, p += 4)
+				{
+					p[0] = FloatToHalf(r[x]);
+					p[1] = FloatToHalf(g[x]);
+					p[2] = FloatToHalf(b[x]);
+					p[3] = 0x3c00;				// 1.0
+				}
+			}
+		}
+		return;
+	}
+
+	const float Kg = 1.0f - P010_Kr - P010_Kb;
+	uint16_t* luma = reinterpret_cast<uint16_t*>(dst);
+	uint16_t* chroma = luma + (size_t)w * h;
+	uint32_t cw = (w + 1) / 2;
+
+	for (uint32_t y = 0; y < h; y += 2)
+	{
+		for (uint32_t x = 0; x < w; x += 2)
+		{
+			float cb = 0.0f, cr = 0.0f;
+			int count = 0;
+			for (uint32_t j = y; j < y + 2 && j < h; j++)
+			{
+				for (uint32_t i = x; i < x + 2 && i < w; i++)
+				{
+					float3 rgb = src.Get(i, j);
+					float Y = P010_Kr * rgb.r + Kg * rgb.g + P010_Kb * rgb.b;
+					luma[(size_t)j * w + i] = P010_Code(Y, 876.0f, 64.0f);
+					cb += (rgb.b - Y) / (2.0f * (1.0f - P010_Kb));
+					cr += (rgb.r - Y) / (2.0f * (1.0f - P010_Kr));
+					count++;
+				}
+			}
+			uint16_t* c = chroma + (size_t)(y / 2) * cw * 2 + (x / 2) * 2;
+			c[0] = P010_Code(cb / count, 896.0f, 512.0f);
+			c[1] = P010_Code(cr / count, 896.0f, 512.0f);
+		}
+	}
+}
+
+// Blocking FIFO with a fixed capacity.  Close() wakes every waiter; Pop() then drains what
+// is left and returns false once the queue is empty.
+template <class T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity) : m_capacity(capacity), m_closed(false) {}
+
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_notFull.wait(lock, [&] { return m_items.size() < m_capacity || m_closed; });
+		if (m_closed)
+			return false;
+		m_items.push_back(std::move(item));
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_notEmpty.wait(lock, [&] { return !m_items.empty() || m_closed; });
+		if (m_items.empty())
+			return false;
+		item = std::move(m_items.front());
+		m_items.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_closed = true;
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+private:
+	size_t                  m_capacity;
+	bool                    m_closed;
+	std::deque<T>           m_items;
+	std::mutex              m_lock;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+};
+
+// Whole-frame sequential file I/O.  On Windows this bypasses the CRT buffer and hints the
+// cache manager with FILE_FLAG_SEQUENTIAL_SCAN; elsewhere it is plain stdio with a large buffer.
+class FrameFile
+{
+public:
+	FrameFile() : m_file(nullptr) {}
+	~FrameFile() { Close(); }
+
+	FrameFile(const FrameFile&) = delete;
+	FrameFile& operator=(const FrameFile&) = delete;
+
+	bool Open(const char* path, bool write)
+	{
+		Close();
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path, write ? GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+			write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		m_file = file;
+#else
+		FILE* file = fopen(path, write ? "wb" : "rb");
+		if (!file)
+			return false;
+		setvbuf(file, nullptr, _IOFBF, 1 << 22);
+		m_file = file;
+#endif
+		return true;
+	}
+
+	void Close()
+	{
+		if (!m_file)
+			return;
+#if defined(_WIN32)
+		CloseHandle(m_file);
+#else
+		fclose(static_cast<FILE*>(m_file));
+#endif
+		m_file = nullptr;
+	}
+
+	bool Seek(uint64_t offset)
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER pos;
+		pos.QuadPart = (LONGLONG)offset;
+		return SetFilePointerEx(m_file, pos, nullptr, FILE_BEGIN) != 0;
+#else
+		return fseeko(static_cast<FILE*>(m_file), (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+
+	// false on a short read, i.e. a truncated last frame or the end of the clip
+	bool Read(void* data, size_t bytes)
+	{
+		uint8_t* p = static_cast<uint8_t*>(data);
+		while (bytes)
+		{
+			size_t chunk = bytes < ChunkBytes ? bytes : ChunkBytes;
+#if defined(_WIN32)
+			DWORD done = 0;
+			if (!ReadFile(m_file, p, (DWORD)chunk, &done, nullptr) || done != chunk)
+				return false;
+#else
+			if (fread(p, 1, chunk, static_cast<FILE*>(m_file)) != chunk)
+				return false;
+#endif
+			p += chunk;
+			bytes -= chunk;
+		}
+		return true;
+	}
+
+	bool Write(const void* data, size_t bytes)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (bytes)
+		{
+			size_t chunk = bytes < ChunkBytes ? bytes : ChunkBytes;
+#if defined(_WIN32)
+			DWORD done = 0;
+			if (!WriteFile(m_file, p, (DWORD)chunk, &done, nullptr) || done != chunk)
+				return false;
+#else
+			if (fwrite(p, 1, chunk, static_cast<FILE*>(m_file)) != chunk)
+				return false;
+#endif
+			p += chunk;
+			bytes -= chunk;
+		}
+		return true;
+	}
+
+private:
+	static const size_t ChunkBytes = 1 << 30;		// ReadFile/WriteFile take a DWORD
+
+	void* m_file;			// HANDLE or FILE*
+};
+
+struct FrameStreamOptions
+{
+	const char* inPath;
+	const char* outPath;		// nullptr: process only, e.g. to collect statistics
+	uint32_t    width;
+	uint32_t    height;
+	FrameFormat inFormat;
+	FrameFormat outFormat;
+	uint64_t    firstFrame;
+	uint64_t    frameCount;		// 0: until the end of the file
+	uint32_t    depth;			// frames in flight, at least 2
+
+	FrameStreamOptions() : inPath(nullptr), outPath(nullptr), width(0), height(0),
+		inFormat(FrameRGBA16F), outFormat(FrameRGBA16F), firstFrame(0), frameCount(0), depth(3) {}
+};
+
+struct FrameStreamStats
+{
+	uint64_t frames;
+	uint64_t bytesRead;
+	uint64_t bytesWritten;
+	double   seconds;
+	bool     ok;				// false if a file could not be opened or a write failed
+
+	double FramesPerSecond() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+};
+
+// Calls process(ImageView frame, uint64_t index) on the caller's thread for every frame, in
+// order; the frame is modified in place and then written out.
+template <class F>
+FrameStreamStats RunFrameStream(const FrameStreamOptions& options, F&& process)
+{
+	struct Slot
+	{
+		std::vector<uint8_t> raw;		// read buffer, reused as the write buffer when the sizes allow
+		std::vector<uint8_t> out;
+		PipelineImage        image;
+		uint64_t             index;
+	};
+
+	FrameStreamStats stats = {};
+	auto start = std::chrono::steady_clock::now();
+
+	size_t inBytes = FrameBytes(options.inFormat, options.width, options.height);
+	size_t outBytes = FrameBytes(options.outFormat, options.width, options.height);
+	if (inBytes == 0)
+		return stats;
+
+	FrameFile input, output;
+	if (!input.Open(options.inPath, false) || !input.Seek(options.firstFrame * inBytes))
+		return stats;
+	if (options.outPath && !output.Open(options.outPath, true))
+		return stats;
+
+	uint32_t depth = options.depth < 2 ? 2 : options.depth;
+	std::vector<Slot> slots(depth);
+	for (Slot& slot : slots)
+	{
+		slot.raw.resize(inBytes);
+		if (outBytes > inBytes)
+			slot.out.resize(outBytes);
+		slot.image.Resize(options.width, options.height);
+	}
+
+	BoundedQueue<Slot*> freeSlots(depth), decoded(depth), processed(depth);
+	for (Slot& slot : slots)
+		freeSlots.Push(&slot);
+
+	bool writeFailed = false;
+
+	std::thread reader([&]
+	{
+		Slot* slot;
+		for (uint64_t i = 0; options.frameCount == 0 || i < options.frameCount; i++)
+		{
+			if (!freeSlots.Pop(slot))
+				break;
+			if (!input.Read(slot->raw.data(), inBytes))
+				break;
+			stats.bytesRead += inBytes;
+			FrameUnpack(options.inFormat, slot->raw.data(), slot->image);
+			slot->index = options.firstFrame + i;
+			decoded.Push(slot);
+		}
+		decoded.Close();
+	});
+
+	std::thread writer([&]
+	{
+		Slot* slot;
+		while (processed.Pop(slot))
+		{
+			if (options.outPath && !writeFailed)
+			{
+				uint8_t* bytes = outBytes > inBytes ? slot->out.data() : slot->raw.data();
+				FramePack(options.outFormat, slot->image, bytes);
+				if (output.Write(bytes, outBytes))
+					stats.bytesWritten += outBytes;
+				else
+				{
+					writeFailed = true;
+					freeSlots.Close();		// stop the reader, drain what is in flight
+				}
+			}
+			stats.frames++;
+			freeSlots.Push(slot);
+		}
+	});
+
+	Slot* slot;
+	while (decoded.Pop(slot))
+	{
+		process(slot->image.View(), slot->index);
+		processed.Push(slot);
+	}
+	processed.Close();
+
+	reader.join();
+	writer.join();
+
+	stats.ok = !writeFailed;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
@@ -0,0 +1,267 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "PatternCanvas.h"
+
+// Retained display list: records a pattern's draw calls once and replays them onto another
+// canvas every frame, so a static pattern costs no layout, math or string formatting per frame.
+// What a pattern hands to DrawLive is kept as a callback and drawn anew on every replay.
+//
+// Sizes are those of the target the recording is made for; record again when it changes.
+// Effect values are recorded in order with the draws, so a replay leaves the effects set as
+// the pattern left them.
+class RecordingPatternCanvas : public PatternCanvas
+{
+public:
+	explicit RecordingPatternCanvas(PatternCanvas* target) :
+		m_target(target)
+	{
+	}
+
+	D2D1_RECT_F GetLogicalSize() const override { return m_target->GetLogicalSize(); }
+	D2D1_RECT_F GetOutputSize() const override  { return m_target->GetOutputSize(); }
+	float       GetDpi() const override         { return m_target->GetDpi(); }
+
+	using PatternCanvas::FillRectangle;
+	using PatternCanvas::DrawRectangle;
+	using PatternCanvas::FillEllipse;
+	using PatternCanvas::DrawEllipse;
+
+	// Everything drawn before a Clear is covered by it, so drop it
+	void Clear(const D2D1_COLOR_F& color) override
+	{
+		Reset();
+		Add(CommandClear).color = color;
+	}
+
+	void FillRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) override
+	{
+		Command& cmd = Add(CommandFillRect);
+		cmd.rect = rect;
+		cmd.color = color;
+	}
+
+	void DrawRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		Command& cmd = Add(CommandStrokeRect);
+		cmd.rect = rect;
+		cmd.color = color;
+		cmd.width = strokeWidth;
+	}
+
+	void FillEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color) override
+	{
+		Command& cmd = Add(CommandFillEllipse);
+		cmd.ellipse = ellipse;
+		cmd.color = color;
+	}
+
+	void DrawEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		Command& cmd = Add(CommandStrokeEllipse);
+		cmd.ellipse = ellipse;
+		cmd.color = color;
+		cmd.width = strokeWidth;
+	}
+
+	void FillEllipses(uint64_t batch, const D2D1_ELLIPSE* ellipses, const D2D1_COLOR_F* colors, uint32_t count) override
+	{
+		Command& cmd = Add(CommandEllipses);
+		cmd.batch = batch;
+		cmd.first = (uint32_t)m_ellipses.size();
+		cmd.count = count;
+		m_ellipses.insert(m_ellipses.end(), ellipses, ellipses + count);
+		m_colors.insert(m_colors.end(), colors, colors + count);
+	}
+
+	void DrawLine(D2D1_POINT_2F p0, D2D1_POINT_2F p1, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		Command& cmd = Add(CommandLine);
+		cmd.p0 = p0;
+		cmd.p1 = p1;
+		cmd.color = color;
+		cmd.width = strokeWidth;
+	}
+
+	void FillLinearGradient(const D2D1_RECT_F& rect, D2D1_POINT_2F start, D2D1_POINT_2F end,
+		const D2D1_GRADIENT_STOP* stops, uint32_t stopCount) override
+	{
+		Command& cmd = Add(CommandGradient);
+		cmd.rect = rect;
+		cmd.p0 = start;
+		cmd.p1 = end;
+		cmd.first = (uint32_t)m_stops.size();
+		cmd.count = stopCount;
+		m_stops.insert(m_stops.end(), stops, stops + stopCount);
+	}
+
+	void DrawString(CanvasFont font, const std::wstring& text, const D2D1_RECT_F& textBox, const D2D1_COLOR_F& color) override
+	{
+		Command& cmd = Add(CommandText);
+		cmd.id = (uint32_t)font;
+		cmd.rect = textBox;
+		cmd.color = color;
+		cmd.first = (uint32_t)m_strings.size();
+		m_strings.push_back(text);
+	}
+
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, float value) override
+	{
+		Command& cmd = Add(CommandEffectFloat);
+		cmd.id = (uint32_t)effect;
+		cmd.width = value;
+		cmd.first = (uint32_t)m_strings.size();
+		m_strings.push_back(name);
+	}
+
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, D2D1_POINT_2F value) override
+	{
+		Command& cmd = Add(CommandEffectPoint);
+		cmd.id = (uint32_t)effect;
+		cmd.p0 = value;
+		cmd.first = (uint32_t)m_strings.size();
+		m_strings.push_back(name);
+	}
+
+	void DrawEffect(CanvasEffect effect) override
+	{
+		Add(CommandEffect).id = (uint32_t)effect;
+	}
+
+	void DrawImage(CanvasImage image, D2D1_POINT_2F offset) override
+	{
+		Command& cmd = Add(CommandImage);
+		cmd.id = image;
+		cmd.p0 = offset;
+	}
+
+	void DrawLive(const std::function<void(PatternCanvas*)>& draw) override
+	{
+		Add(CommandLive).first = (uint32_t)m_live.size();
+		m_live.push_back(draw);
+	}
+
+	void Reset()
+	{
+		m_commands.clear();
+		m_stops.clear();
+		m_strings.clear();
+		m_ellipses.clear();
+		m_colors.clear();
+		m_live.clear();
+	}
+
+	size_t CommandCount() const { return m_commands.size(); }
+
+	void Replay(PatternCanvas* ctx) const
+	{
+		for (const Command& cmd : m_commands)
+		{
+			switch (cmd.type)
+			{
+			case CommandClear:
+				ctx->Clear(cmd.color);
+				break;
+			case CommandFillRect:
+				ctx->FillRectangle(cmd.rect, cmd.color);
+				break;
+			case CommandStrokeRect:
+				ctx->DrawRectangle(cmd.rect, cmd.color, cmd.width);
+				break;
+			case CommandFillEllipse:
+				ctx->FillEllipse(cmd.ellipse, cmd.color);
+				break;
+			case CommandStrokeEllipse:
+				ctx->DrawEllipse(cmd.ellipse, cmd.color, cmd.width);
+				break;
+			case CommandEllipses:
+				ctx->FillEllipses(cmd.batch, &m_ellipses[cmd.first], &m_colors[cmd.first], cmd.count);
+				break;
+			case CommandLine:
+				ctx->DrawLine(cmd.p0, cmd.p1, cmd.color, cmd.width);
+				break;
+			case CommandGradient:
+				ctx->FillLinearGradient(cmd.rect, cmd.p0, cmd.p1, &m_stops[cmd.first], cmd.count);
+				break;
+			case CommandText:
+				ctx->DrawString((CanvasFont)cmd.id, m_strings[cmd.first], cmd.rect, cmd.color);
+				break;
+			case CommandEffectFloat:
+				ctx->SetEffectValue((CanvasEffect)cmd.id, m_strings[cmd.first].c_str(), cmd.width);
+				break;
+			case CommandEffectPoint:
+				ctx->SetEffectValue((CanvasEffect)cmd.id, m_strings[cmd.first].c_str(), cmd.p0);
+				break;
+			case CommandEffect:
+				ctx->DrawEffect((CanvasEffect)cmd.id);
+				break;
+			case CommandImage:
+				ctx->DrawImage((CanvasImage)cmd.id, cmd.p0);
+				break;
+			case CommandLive:
+				m_live[cmd.first](ctx);
+				break;
+			}
+		}
+	}
+
+private:
+	enum CommandType
+	{
+		CommandClear,
+		CommandFillRect,
+		CommandStrokeRect,
+		CommandFillEllipse,
+		CommandStrokeEllipse,
+		CommandEllipses,
+		CommandLine,
+		CommandGradient,
+		CommandText,
+		CommandEffectFloat,
+		CommandEffectPoint,
+		CommandEffect,
+		CommandImage,
+		CommandLive,
+	};
+
+	struct Command
+	{
+		CommandType     type;
+		D2D1_COLOR_F    color;
+		D2D1_RECT_F     rect;				// also the text box
+		D2D1_ELLIPSE    ellipse;
+		D2D1_POINT_2F   p0, p1;				// line ends, gradient ends, image offset, effect value
+		float           width;				// stroke width, effect value
+		uint32_t        id;					// font, effect or image
+		uint32_t        first, count;		// into m_stops, m_strings, m_live, or m_ellipses and m_colors
+		uint64_t        batch;
+	};
+
+	Command& Add(CommandType type)
+	{
+		m_commands.push_back({});
+		m_commands.back().type = type;
+		return m_commands.back();
+	}
+
+	PatternCanvas*                      m_target;
+	std::vector<Command>                m_commands;
+	std::vector<D2D1_GRADIENT_STOP>     m_stops;
+	std::vector<std::wstring>           m_strings;		// text and effect property names
+	std::vector<D2D1_ELLIPSE>           m_ellipses;
+	std::vector<D2D1_COLOR_F>           m_colors;
+	std::vector<std::function<void(PatternCanvas*)>> m_live;
+};
@@ -0,0 +1,443 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// This header defines thin wrappers over the SIMD instruction sets we care about
+// so that a batch kernel can be written once as a template and instantiated for
+// each of them.  Each wrapper exposes the same small set of static functions:
+//
+//   V  - vector of Width floats
+//   VI - vector of Width int32s
+//   M  - lane mask returned by the compares (a vector for SSE/AVX2/NEON, a k-mask for AVX-512)
+//
+// Only the operations actually used by the kernels are provided.
+//
+// Min(a, b) and Max(a, b) return b when either is NaN, as minps/maxps do, on every backend,
+// so Max(x, 0) turns a NaN x into 0.
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// MSVC lets any intrinsic be used regardless of /arch, other compilers only
+// expose the wider instruction sets when the matching -m flag is set.
+#if defined(SIMD_X86) && (defined(_MSC_VER) || defined(__SSE4_1__))
+#define SIMD_HAS_SSE41 1
+#endif
+#if defined(SIMD_X86) && (defined(_MSC_VER) || (defined(__AVX2__) && defined(__FMA__)))
+#define SIMD_HAS_AVX2 1
+#endif
+#if defined(SIMD_X86) && (defined(_MSC_VER) || defined(__AVX512F__))
+#define SIMD_HAS_AVX512 1
+#endif
+
+enum class SimdLevel
+{
+	Scalar = 0,
+	SSE41  = 1,
+	AVX2   = 2,
+	AVX512 = 3,
+	NEON   = 4,
+};
+
+// Returns the widest instruction set that both the CPU and OS support.
+// Evaluated once; the result is cached for the life of the process.
+inline SimdLevel DetectSimdLevel()
+{
+#if defined(SIMD_NEON)
+	return SimdLevel::NEON;				// NEON is mandatory on ARM64
+#elif defined(SIMD_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse41   = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx     = (info[2] & (1 << 28)) != 0;
+	bool fma     = (info[2] & (1 << 12)) != 0;
+
+	bool avx2 = false, avx512 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2   = (info[1] & (1 << 5))  != 0;
+		avx512 = (info[1] & (1 << 16)) != 0;
+	}
+
+	// The OS must also save the wider registers on a context switch
+	unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	bool ymmSaved = (xcr0 & 0x06) == 0x06;
+	bool zmmSaved = (xcr0 & 0xE6) == 0xE6;
+
+	if (avx512 && zmmSaved)
+		return SimdLevel::AVX512;
+	if (avx && avx2 && fma && ymmSaved)
+		return SimdLevel::AVX2;
+	if (sse41)
+		return SimdLevel::SSE41;
+	return SimdLevel::Scalar;
+#elif defined(SIMD_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+#if defined(SIMD_HAS_AVX512)
+	if (__builtin_cpu_supports("avx512f"))
+		return SimdLevel::AVX512;
+#endif
+#if defined(SIMD_HAS_AVX2)
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SimdLevel::AVX2;
+#endif
+#if defined(SIMD_HAS_SSE41)
+	if (__builtin_cpu_supports("sse4.1"))
+		return SimdLevel::SSE41;
+#endif
+	return SimdLevel::Scalar;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+inline SimdLevel GetSimdLevel()
+{
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+// Bit count for lane masks.  POPCNT is not guaranteed on every SSE4.1 part.
+inline int SimdPopCount(unsigned v)
+{
+	v = v - ((v >> 1) & 0x55555555);
+	v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+	return (int)((((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+}
+
+#if defined(SIMD_HAS_SSE41)
+struct SimdSSE41
+{
+	typedef __m128  V;
+	typedef __m128i VI;
+	typedef __m128  M;
+	static const int Width = 4;
+
+	static V    Load(const float* p)           { return _mm_loadu_ps(p); }
+	static void Store(float* p, V a)           { _mm_storeu_ps(p, a); }
+	static V    Set1(float a)                  { return _mm_set1_ps(a); }
+	static V    Add(V a, V b)                  { return _mm_add_ps(a, b); }
+	static V    Sub(V a, V b)                  { return _mm_sub_ps(a, b); }
+	static V    Mul(V a, V b)                  { return _mm_mul_ps(a, b); }
+	static V    Div(V a, V b)                  { return _mm_div_ps(a, b); }
+	static V    Sqrt(V a)                      { return _mm_sqrt_ps(a); }
+	static V    Min(V a, V b)                  { return _mm_min_ps(a, b); }
+	static V    Max(V a, V b)                  { return _mm_max_ps(a, b); }
+	static V    Round(V a)                     { return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static M    CmpGT(V a, V b)                { return _mm_cmpgt_ps(a, b); }
+	static M    CmpLT(V a, V b)                { return _mm_cmplt_ps(a, b); }
+	static M    CmpLE(V a, V b)                { return _mm_cmple_ps(a, b); }
+	static M    CmpEQ(V a, V b)                { return _mm_cmpeq_ps(a, b); }
+	static M    MaskOr(M a, M b)               { return _mm_or_ps(a, b); }
+	static M    MaskAnd(M a, M b)              { return _mm_and_ps(a, b); }
+	static M    MaskAndNot(M a, M b)           { return _mm_andnot_ps(b, a); }		// a & ~b
+	static V    Select(M m, V a, V b)          { return _mm_blendv_ps(b, a, m); }		// m ? a : b
+	static int  MaskCount(M m)                 { return SimdPopCount((unsigned)_mm_movemask_ps(m)); }
+
+	static VI   SetI(int32_t a)                { return _mm_set1_epi32(a); }
+	static VI   AddI(VI a, VI b)               { return _mm_add_epi32(a, b); }
+	static VI   SubI(VI a, VI b)               { return _mm_sub_epi32(a, b); }
+	static VI   AndI(VI a, VI b)               { return _mm_and_si128(a, b); }
+	static VI   OrI(VI a, VI b)                { return _mm_or_si128(a, b); }
+	static VI   ShiftLeft23(VI a)              { return _mm_slli_epi32(a, 23); }
+	static VI   ShiftRight23(VI a)             { return _mm_srli_epi32(a, 23); }
+	static VI   ToInt(V a)                     { return _mm_cvtps_epi32(a); }		// round to nearest
+	static VI   TruncInt(V a)                  { return _mm_cvttps_epi32(a); }		// round toward zero
+	static V    ToFloat(VI a)                  { return _mm_cvtepi32_ps(a); }
+	static V    AsFloat(VI a)                  { return _mm_castsi128_ps(a); }
+	static VI   AsInt(V a)                     { return _mm_castps_si128(a); }
+	static V    Gather(const float* p, VI i)   { return _mm_setr_ps(p[_mm_extract_epi32(i, 0)], p[_mm_extract_epi32(i, 1)], p[_mm_extract_epi32(i, 2)], p[_mm_extract_epi32(i, 3)]); }
+};
+#endif
+
+#if defined(SIMD_HAS_AVX2)
+struct SimdAVX2
+{
+	typedef __m256  V;
+	typedef __m256i VI;
+	typedef __m256  M;
+	static const int Width = 8;
+
+	static V    Load(const float* p)           { return _mm256_loadu_ps(p); }
+	static void Store(float* p, V a)           { _mm256_storeu_ps(p, a); }
+	static V    Set1(float a)                  { return _mm256_set1_ps(a); }
+	static V    Add(V a, V b)                  { return _mm256_add_ps(a, b); }
+	static V    Sub(V a, V b)                  { return _mm256_sub_ps(a, b); }
+	static V    Mul(V a, V b)                  { return _mm256_mul_ps(a, b); }
+	static V    Div(V a, V b)                  { return _mm256_div_ps(a, b); }
+	static V    Sqrt(V a)                      { return _mm256_sqrt_ps(a); }
+	static V    Min(V a, V b)                  { return _mm256_min_ps(a, b); }
+	static V    Max(V a, V b)                  { return _mm256_max_ps(a, b); }
+	static V    Round(V a)                     { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static M    CmpGT(V a, V b)                { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static M    CmpLT(V a, V b)                { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static M    CmpLE(V a, V b)                { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static M    CmpEQ(V a, V b)                { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static M    MaskOr(M a, M b)               { return _mm256_or_ps(a, b); }
+	static M    MaskAnd(M a, M b)              { return _mm256_and_ps(a, b); }
+	static M    MaskAndNot(M a, M b)           { return _mm256_andnot_ps(b, a); }
+	static V    Select(M m, V a, V b)          { return _mm256_blendv_ps(b, a, m); }
+	static int  MaskCount(M m)                 { return SimdPopCount((unsigned)_mm256_movemask_ps(m)); }
+
+	static VI   SetI(int32_t a)                { return _mm256_set1_epi32(a); }
+	static VI   AddI(VI a, VI b)               { return _mm256_add_epi32(a, b); }
+	static VI   SubI(VI a, VI b)               { return _mm256_sub_epi32(a, b); }
+	static VI   AndI(VI a, VI b)               { return _mm256_and_si256(a, b); }
+	static VI   OrI(VI a, VI b)                { return _mm256_or_si256(a, b); }
+	static VI   ShiftLeft23(VI a)              { return _mm256_slli_epi32(a, 23); }
+	static VI   ShiftRight23(VI a)             { return _mm256_srli_epi32(a, 23); }
+	static VI   ToInt(V a)                     { return _mm256_cvtps_epi32(a); }
+	static VI   TruncInt(V a)                  { return _mm256_cvttps_epi32(a); }
+	static V    ToFloat(VI a)                  { return _mm256_cvtepi32_ps(a); }
+	static V    AsFloat(VI a)                  { return _mm256_castsi256_ps(a); }
+	static VI   AsInt(V a)                     { return _mm256_castps_si256(a); }
+	static V    Gather(const float* p, VI i)   { return _mm256_i32gather_ps(p, i, 4); }
+};
+#endif
+
+#if defined(SIMD_HAS_AVX512)
+struct SimdAVX512
+{
+	typedef __m512    V;
+	typedef __m512i   VI;
+	typedef __mmask16 M;
+	static const int Width = 16;
+
+	static V    Load(const float* p)           { return _mm512_loadu_ps(p); }
+	static void Store(float* p, V a)           { _mm512_storeu_ps(p, a); }
+	static V    Set1(float a)                  { return _mm512_set1_ps(a); }
+	static V    Add(V a, V b)                  { return _mm512_add_ps(a, b); }
+	static V    Sub(V a, V b)                  { return _mm512_sub_ps(a, b); }
+	static V    Mul(V a, V b)                  { return _mm512_mul_ps(a, b); }
+	static V    Div(V a, V b)                  { return _mm512_div_ps(a, b); }
+	static V    Sqrt(V a)                      { return _mm512_sqrt_ps(a); }
+	static V    Min(V a, V b)                  { return _mm512_min_ps(a, b); }
+	static V    Max(V a, V b)                  { return _mm512_max_ps(a, b); }
+	static V    Round(V a)                     { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static M    CmpGT(V a, V b)                { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+	static M    CmpLT(V a, V b)                { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static M    CmpLE(V a, V b)                { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+	static M    CmpEQ(V a, V b)                { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+	static M    MaskOr(M a, M b)               { return (M)(a | b); }
+	static M    MaskAnd(M a, M b)              { return (M)(a & b); }
+	static M    MaskAndNot(M a, M b)           { return (M)(a & ~b); }
+	static V    Select(M m, V a, V b)          { return _mm512_mask_blend_ps(m, b, a); }
+	static int  MaskCount(M m)                 { return SimdPopCount((unsigned)m); }
+
+	static VI   SetI(int32_t a)                { return _mm512_set1_epi32(a); }
+	static VI   AddI(VI a, VI b)               { return _mm512_add_epi32(a, b); }
+	static VI   SubI(VI a, VI b)               { return _mm512_sub_epi32(a, b); }
+	static VI   AndI(VI a, VI b)               { return _mm512_and_si512(a, b); }
+	static VI   OrI(VI a, VI b)                { return _mm512_or_si512(a, b); }
+	static VI   ShiftLeft23(VI a)              { return _mm512_slli_epi32(a, 23); }
+	static VI   ShiftRight23(VI a)             { return _mm512_srli_epi32(a, 23); }
+	static VI   ToInt(V a)                     { return _mm512_cvtps_epi32(a); }
+	static VI   TruncInt(V a)                  { return _mm512_cvttps_epi32(a); }
+	static V    ToFloat(VI a)                  { return _mm512_cvtepi32_ps(a); }
+	static V    AsFloat(VI a)                  { return _mm512_castsi512_ps(a); }
+	static VI   AsInt(V a)                     { return _mm512_castps_si512(a); }
+	static V    Gather(const float* p, VI i)   { return _mm512_i32gather_ps(i, p, 4); }
+};
+#endif
+
+#if defined(SIMD_NEON)
+struct SimdNEON
+{
+	typedef float32x4_t V;
+	typedef int32x4_t   VI;
+	typedef uint32x4_t  M;
+	static const int Width = 4;
+
+	static V    Load(const float* p)           { return vld1q_f32(p); }
+	static void Store(float* p, V a)           { vst1q_f32(p, a); }
+	static V    Set1(float a)                  { return vdupq_n_f32(a); }
+	static V    Add(V a, V b)                  { return vaddq_f32(a, b); }
+	static V    Sub(V a, V b)                  { return vsubq_f32(a, b); }
+	static V    Mul(V a, V b)                  { return vmulq_f32(a, b); }
+	static V    Div(V a, V b)                  { return vdivq_f32(a, b); }
+	static V    Sqrt(V a)                      { return vsqrtq_f32(a); }
+	static V    Min(V a, V b)                  { return vbslq_f32(vcltq_f32(a, b), a, b); }		// vminq propagates NaN
+	static V    Max(V a, V b)                  { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+	static V    Round(V a)                     { return vrndnq_f32(a); }
+	static M    CmpGT(V a, V b)                { return vcgtq_f32(a, b); }
+	static M    CmpLT(V a, V b)                { return vcltq_f32(a, b); }
+	static M    CmpLE(V a, V b)                { return vcleq_f32(a, b); }
+	static M    CmpEQ(V a, V b)                { return vceqq_f32(a, b); }
+	static M    MaskOr(M a, M b)               { return vorrq_u32(a, b); }
+	static M    MaskAnd(M a, M b)              { return vandq_u32(a, b); }
+	static M    MaskAndNot(M a, M b)           { return vbicq_u32(a, b); }
+	static V    Select(M m, V a, V b)          { return vbslq_f32(m, a, b); }
+	static int  MaskCount(M m)                 { return (int)vaddvq_u32(vshrq_n_u32(m, 31)); }
+
+	static VI   SetI(int32_t a)                { return vdupq_n_s32(a); }
+	static VI   AddI(VI a, VI b)               { return vaddq_s32(a, b); }
+	static VI   SubI(VI a, VI b)               { return vsubq_s32(a, b); }
+	static VI   AndI(VI a, VI b)               { return vandq_s32(a, b); }
+	static VI   OrI(VI a, VI b)                { return vorrq_s32(a, b); }
+	static VI   ShiftLeft23(VI a)              { return vshlq_n_s32(a, 23); }
+	static VI   ShiftRight23(VI a)             { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), 23)); }
+	static VI   ToInt(V a)                     { return vcvtnq_s32_f32(a); }
+	static VI   TruncInt(V a)                  { return vcvtq_s32_f32(a); }
+	static V    ToFloat(VI a)                  { return vcvtq_f32_s32(a); }
+	static V    AsFloat(VI a)                  { return vreinterpretq_f32_s32(a); }
+	static VI   AsInt(V a)                     { return vreinterpretq_s32_f32(a); }
+	static V    Gather(const float* p, VI i)
+	{
+		float v[4] = { p[vgetq_lane_s32(i, 0)], p[vgetq_lane_s32(i, 1)], p[vgetq_lane_s32(i, 2)], p[vgetq_lane_s32(i, 3)] };
+		return vld1q_f32(v);
+	}
+};
+#endif
+
+// Single-lane stand-in so a kernel can also be instantiated without any vector unit.
+// Only the float and mask operations are provided.
+struct SimdScalar
+{
+	typedef float V;
+	typedef bool  M;
+	static const int Width = 1;
+
+	static V    Load(const float* p)           { return *p; }
+	static void Store(float* p, V a)           { *p = a; }
+	static V    Set1(float a)                  { return a; }
+	static V    Add(V a, V b)                  { return a + b; }
+	static V    Sub(V a, V b)                  { return a - b; }
+	static V    Mul(V a, V b)                  { return a * b; }
+	static V    Div(V a, V b)                  { return a / b; }
+	static V    Sqrt(V a)                      { return sqrtf(a); }
+	static V    Min(V a, V b)                  { return a < b ? a : b; }
+	static V    Max(V a, V b)                  { return a > b ? a : b; }
+	static M    CmpGT(V a, V b)                { return a > b; }
+	static M    CmpLT(V a, V b)                { return a < b; }
+	static M    CmpLE(V a, V b)                { return a <= b; }
+	static M    CmpEQ(V a, V b)                { return a == b; }
+	static M    MaskOr(M a, M b)               { return a || b; }
+	static M    MaskAnd(M a, M b)              { return a && b; }
+	static M    MaskAndNot(M a, M b)           { return a && !b; }
+	static V    Select(M m, V a, V b)          { return m ? a : b; }
+	static int  MaskCount(M m)                 { return m ? 1 : 0; }
+};
+
+// Calls f with a default-constructed trait object for the widest instruction set
+// available, e.g.  SimdDispatch([&](auto s) { return Kernel<decltype(s)>(args); });
+template <class F>
+inline auto SimdDispatch(F&& f) -> decltype(f(SimdScalar()))
+{
+	switch (GetSimdLevel())
+	{
+#if defined(SIMD_HAS_AVX512)
+	case SimdLevel::AVX512: return f(SimdAVX512());
+#endif
+#if defined(SIMD_HAS_AVX2)
+	case SimdLevel::AVX2:   return f(SimdAVX2());
+#endif
+#if defined(SIMD_HAS_SSE41)
+	case SimdLevel::SSE41:  return f(SimdSSE41());
+#endif
+#if defined(SIMD_NEON)
+	case SimdLevel::NEON:   return f(SimdNEON());
+#endif
+	default:                return f(SimdScalar());
+	}
+}
+
+// Polynomial approximations (Cephes coefficients) for use inside the batch kernels.
+// Callers are expected to keep the arguments in range; no NaN/Inf handling is done.
+
+// log2(x) for positive, normal x.  Max error about 1.5e-7 absolute over [2^-126, 2^128).
+template <class S>
+inline typename S::V SimdLog2(typename S::V x)
+{
+	typedef typename S::V  V;
+	typedef typename S::VI VI;
+	typedef typename S::M  M;
+
+	// split into exponent and mantissa in [1, 2)
+	VI xi = S::AsInt(x);
+	V  e  = S::ToFloat(S::SubI(S::ShiftRight23(xi), S::SetI(127)));
+	V  m  = S::AsFloat(S::OrI(S::AndI(xi, S::SetI(0x007FFFFF)), S::SetI(0x3F800000)));
+
+	// recenter the mantissa on 1.0 so that t stays in [sqrt(0.5)-1, sqrt(2)-1]
+	M big = S::CmpGT(m, S::Set1(1.41421356f));
+	m = S::Select(big, S::Mul(m, S::Set1(0.5f)), m);
+	e = S::Select(big, S::Add(e, S::Set1(1.0f)), e);
+
+	V t = S::Sub(m, S::Set1(1.0f));
+	V z = S::Mul(t, t);
+
+	V y = S::Set1(7.0376836292E-2f);
+	y = S::Add(S::Mul(y, t), S::Set1(-1.1514610310E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1( 1.1676998740E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1(-1.2420140846E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1( 1.4249322787E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1(-1.6668057665E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1( 2.0000714765E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1(-2.4999993993E-1f));
+	y = S::Add(S::Mul(y, t), S::Set1( 3.3333331174E-1f));
+	y = S::Mul(S::Mul(y, t), z);
+	y = S::Sub(y, S::Mul(z, S::Set1(0.5f)));
+
+	V ln = S::Add(t, y);										// ln(m)
+	return S::Add(S::Mul(ln, S::Set1(1.44269504089f)), e);		// log2(m) + e
+}
+
+// 2^x for x in [-126, 127].  Max relative error about 2e-7.
+template <class S>
+inline typename S::V SimdExp2(typename S::V x)
+{
+	typedef typename S::V  V;
+	typedef typename S::VI VI;
+
+	x = S::Min(S::Max(x, S::Set1(-126.0f)), S::Set1(127.0f));
+
+	V  n = S::Round(x);
+	V  f = S::Sub(x, n);										// [-0.5, 0.5]
+
+	V p = S::Set1(1.535336188319500E-4f);
+	p = S::Add(S::Mul(p, f), S::Set1(1.339887440266574E-3f));
+	p = S::Add(S::Mul(p, f), S::Set1(9.618437357674640E-3f));
+	p = S::Add(S::Mul(p, f), S::Set1(5.550332471162809E-2f));
+	p = S::Add(S::Mul(p, f), S::Set1(2.402264791363012E-1f));
+	p = S::Add(S::Mul(p, f), S::Set1(6.931472028550421E-1f));
+	p = S::Add(S::Mul(p, f), S::Set1(1.0f));
+
+	// scale by 2^n by building the float exponent directly
+	VI bits = S::ShiftLeft23(S::AddI(S::ToInt(n), S::SetI(127)));
+	return S::Mul(p, S::AsFloat(bits));
+}
+
+// x^y for x >= 0.  Returns exactly 0 for x == 0 (y is assumed positive).
+template <class S>
+inline typename S::V SimdPow(typename S::V x, typename S::V y)
+{
+	typedef typename S::V V;
+
+	V r = SimdExp2<S>(S::Mul(y, SimdLog2<S>(x)));
+	return S::Select(S::CmpGT(x, S::Set1(0.0f)), r, S::Set1(0.0f));
+}
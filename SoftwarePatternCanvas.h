@@ -0,0 +1,759 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "PatternCanvas.h"
+#include "PipelineExecutor.h"
+#include "PipelineStream.h"
+
+// Headless PatternCanvas: rasterizes on the CPU into an FP16 scRGB RGBA buffer, the format
+// of the HDR swap chain, so patterns can be rendered and compared without a GPU or a window.
+//
+// Draw calls are only recorded, with their pixel bounds; Render() cuts the target into 64x64
+// tiles and rasterizes them in parallel on the executor, each tile replaying just the
+// commands that touch it into a float scratch tile before it is packed to half.
+//
+// Edges are anti-aliased by area (rectangles) or by distance to the edge (ellipses, lines),
+// which is close to, but not bit-exact with, D2D's rasterizer.  The four pattern effects are
+// C++ ports of their pixel shaders.  Text is drawn in a 5x7 bitmap font rather than the
+// DirectWrite fonts: it wraps and lines up roughly as on screen, but it is not glyph-exact, and
+// characters outside printable ASCII show as '?'.  TextRuns() keeps what was asked for.
+
+struct CanvasTextRun
+{
+	CanvasFont      font;
+	std::wstring    text;
+	D2D1_RECT_F     textBox;			// { left, top, width, height } in DIPs
+	D2D1_COLOR_F    color;
+};
+
+// The shader constants of the pattern effects, by the property names they are set with
+struct CanvasEffectValues
+{
+	float           apl = 0.0f;						// BackgroundNoise, nits
+	float           clamp = 10000.0f;
+	float           iTime = 0.0f;
+	D2D1_POINT_2F   center = { 0.0f, 0.0f };		// SineSweep, ToneSpike, pixels
+	float           initialWavelength = 30.0f;
+	float           wavelengthHalvingDistance = 1.0f;
+	float           whiteLevelMultiplier = 1.0f;
+	D2D1_POINT_2F   outputSize = { 1.0f, 1.0f };	// BandedGradient, pixels
+
+	bool Set(const wchar_t* name, float value)
+	{
+		if (!wcscmp(name, L"APL"))                       apl = value;
+		else if (!wcscmp(name, L"Clamp"))                clamp = value;
+		else if (!wcscmp(name, L"iTime"))                iTime = value;
+		else if (!wcscmp(name, L"InitialWavelength"))    initialWavelength = value;
+		else if (!wcscmp(name, L"WavelengthHalvingDistance")) wavelengthHalvingDistance = value;
+		else if (!wcscmp(name, L"WhiteLevelMultiplier")) whiteLevelMultiplier = value;
+		else return false;
+		return true;
+	}
+
+	bool Set(const wchar_t* name, D2D1_POINT_2F value)
+	{
+		if (!wcscmp(name, L"Center"))                    center = value;
+		else if (!wcscmp(name, L"OutputSize"))           outputSize = value;
+		else return false;
+		return true;
+	}
+};
+
+// Effect shader ports.  x, y are the scene position: pixel centers, in pixels.
+
+inline uint32_t Effect_Pcg(uint32_t v)
+{
+	uint32_t state = v * 747796405u + 2891336453u;
+	uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+inline float Effect_BackgroundNoise(const CanvasEffectValues& v, float x, float y)
+{
+	float px = x - v.iTime * 60.0f;						// animate
+	float py = y + v.iTime * 60.0f;
+
+	float u = 0.0f;
+	float c = 10000.0f;
+	for (int i = 0; c > v.clamp; i++)
+	{
+		if (i == 256)									// the shader would spin forever
+			return std::max(v.clamp, 0.0f) / 80.0f;
+		int ix = (int)(px + u * i);
+		int iy = (int)(py + u * i);
+		u = (float)(Effect_Pcg(Effect_Pcg((uint32_t)ix) + (uint32_t)iy)) / (float)0xFFFFFFFFu;
+		c = -logf(1.0f - u) * v.apl;					// exponential distribution about APL
+	}
+	return c / 80.0f;
+}
+
+inline float Effect_BandedGradient(const CanvasEffectValues& v, float x, float y)
+{
+	float px = x / v.outputSize.x;
+	float py = y / v.outputSize.y;
+
+	float c = powf(px, 0.45454f) * 0.25f;
+	if (py < 0.2f)
+		c = truncf(c * 64.0f) / 64.0f;					// 6-bit
+	if (py > 0.4f && py < 0.6f)
+		c = truncf(c * 256.0f) / 256.0f;				// 8-bit
+	if (py > 0.8f)
+		c = truncf(c * 1024.0f) / 1024.0f;				// 10-bit
+	return powf(c, 2.2f);
+}
+
+inline float Effect_SineSweep(const CanvasEffectValues& v, float x, float y)
+{
+	const float PI = 3.141592653589f;
+	float dist = sqrtf((x - v.center.x) * (x - v.center.x) + (y - v.center.y) * (y - v.center.y));
+
+	float multiplier = powf(2.0f, dist / v.wavelengthHalvingDistance);
+	float val = sinf(1.0f / v.initialWavelength * dist * 2.0f * PI * multiplier);
+
+	val = (val + 1.0f) / 2.0f;
+	return powf(val, 2.2f) * v.whiteLevelMultiplier;
+}
+
+inline float Effect_Remove2084(float N)
+{
+	const float m1 = 2610.0f / 4096.0f / 4;
+	const float m2 = 2523.0f / 4096.0f * 128;
+	const float c1 = 3424.0f / 4096.0f;
+	const float c2 = 2413.0f / 4096.0f * 32;
+	const float c3 = 2392.0f / 4096.0f * 32;
+	float Np = powf(N, 1 / m2);
+	float num = std::max(Np - c1, 0.0f);
+	return powf(num / (c2 - c3 * Np), 1 / m1);
+}
+
+// ToneSpikeEffect.hlsl profile(): p = contentMax/panelCapability
+inline float Effect_ToneProfile(float p, float input)
+{
+	if (input > p)
+		return 1.0f;									// hard clip
+
+	float s = 1 - logf(p) * 0.165f;
+	if (p < 1)
+		s = p * 0.7f;
+
+	float m = 1.0f / (p - s);
+	if (input <= s)
+		return input;
+
+	float q = (p - s) / (1.f - s);
+	float x = m * (input - s);
+	float k = 1.0f / (q - 1.0f);
+	return x * (k + 1.0f) / (k + x) * (1.f - s) + s;	// shoulder
+}
+
+inline D2D1_COLOR_F Effect_ToneSpike(const CanvasEffectValues& v, float x, float y)
+{
+	const float PI = 3.141592653589f;
+	float rArea = sqrtf(v.center.x * v.center.y * 4.0f / PI);
+
+	float dx = x - v.center.x;
+	float dy = y - v.center.y;
+	float r = sqrtf(dx * dx + dy * dy);
+	float theta = atan2f(dy, -dx) + PI;
+
+	float t = 1.12f * (rArea - r) / rArea;				// from perimeter to center
+	if (sinf(theta * 48.f) > 0.0f)
+		t -= 10.f / 255.0f;
+
+	float val = Effect_Remove2084(std::min(std::max(t, 0.0f), 1.0f));
+
+	if (y > v.center.y)									// tone mapped on the bottom half
+	{
+		float p = 10000.f / v.whiteLevelMultiplier;
+		val = Effect_ToneProfile(p, val * p) / p;
+	}
+
+	float c = val * 10000.0f / 80.0f;
+	return { c, c * 0.5f, 0.0f, 1.0f };
+}
+
+inline D2D1_COLOR_F Effect_Shade(CanvasEffect effect, const CanvasEffectValues& v, float x, float y)
+{
+	float c = 0.0f;
+	switch (effect)
+	{
+	case CanvasEffectBackgroundNoise: c = Effect_BackgroundNoise(v, x, y); break;
+	case CanvasEffectBandedGradient:  c = Effect_BandedGradient(v, x, y); break;
+	case CanvasEffectSineSweep:       c = Effect_SineSweep(v, x, y); break;
+	case CanvasEffectToneSpike:       return Effect_ToneSpike(v, x, y);
+	default:                          break;
+	}
+	return { c, c, c, 1.0f };
+}
+
+// The 5x7 font text is drawn in: five columns per character, top row in the low bit.
+// Printable ASCII only; anything else is drawn as '?'.
+inline const uint8_t* Canvas_Glyph(wchar_t c)
+{
+	static const uint8_t glyphs[95 * 5] =
+	{
+	0x00,0x00,0x00,0x00,0x00, 0x00,0x00,0x5F,0x00,0x00, 0x00,0x07,0x00,0x07,0x00, 0x14,0x7F,0x14,0x7F,0x14,	//   ! " #
+	0x24,0x2A,0x7F,0x2A,0x12, 0x23,0x13,0x08,0x64,0x62, 0x36,0x49,0x55,0x22,0x50, 0x00,0x05,0x03,0x00,0x00,	// $ % & '
+	0x00,0x1C,0x22,0x41,0x00, 0x00,0x41,0x22,0x1C,0x00, 0x14,0x08,0x3E,0x08,0x14, 0x08,0x08,0x3E,0x08,0x08,	// ( ) * +
+	0x00,0x50,0x30,0x00,0x00, 0x08,0x08,0x08,0x08,0x08, 0x00,0x60,0x60,0x00,0x00, 0x20,0x10,0x08,0x04,0x02,	// , - . /
+	0x3E,0x51,0x49,0x45,0x3E, 0x00,0x42,0x7F,0x40,0x00, 0x42,0x61,0x51,0x49,0x46, 0x21,0x41,0x45,0x4B,0x31,	// 0 1 2 3
+	0x18,0x14,0x12,0x7F,0x10, 0x27,0x45,0x45,0x45,0x39, 0x3C,0x4A,0x49,0x49,0x30, 0x01,0x71,0x09,0x05,0x03,	// 4 5 6 7
+	0x36,0x49,0x49,0x49,0x36, 0x06,0x49,0x49,0x29,0x1E, 0x00,0x36,0x36,0x00,0x00, 0x00,0x56,0x36,0x00,0x00,	// 8 9 : ;
+	0x08,0x14,0x22,0x41,0x00, 0x14,0x14,0x14,0x14,0x14, 0x00,0x41,0x22,0x14,0x08, 0x02,0x01,0x51,0x09,0x06,	// < = > ?
+	0x32,0x49,0x79,0x41,0x3E, 0x7E,0x11,0x11,0x11,0x7E, 0x7F,0x49,0x49,0x49,0x36, 0x3E,0x41,0x41,0x41,0x22,	// @ A B C
+	0x7F,0x41,0x41,0x22,0x1C, 0x7F,0x49,0x49,0x49,0x41, 0x7F,0x09,0x09,0x09,0x01, 0x3E,0x41,0x49,0x49,0x7A,	// D E F G
+	0x7F,0x08,0x08,0x08,0x7F, 0x00,0x41,0x7F,0x41,0x00, 0x20,0x40,0x41,0x3F,0x01, 0x7F,0x08,0x14,0x22,0x41,	// H I J K
+	0x7F,0x40,0x40,0x40,0x40, 0x7F,0x02,0x0C,0x02,0x7F, 0x7F,0x04,0x08,0x10,0x7F, 0x3E,0x41,0x41,0x41,0x3E,	// L M N O
+	0x7F,0x09,0x09,0x09,0x06, 0x3E,0x41,0x51,0x21,0x5E, 0x7F,0x09,0x19,0x29,0x46, 0x46,0x49,0x49,0x49,0x31,	// P Q R S
+	0x01,0x01,0x7F,0x01,0x01, 0x3F,0x40,0x40,0x40,0x3F, 0x1F,0x20,0x40,0x20,0x1F, 0x3F,0x40,0x38,0x40,0x3F,	// T U V W
+	0x63,0x14,0x08,0x14,0x63, 0x07,0x08,0x70,0x08,0x07, 0x61,0x51,0x49,0x45,0x43, 0x00,0x7F,0x41,0x41,0x00,	// X Y Z [
+	0x02,0x04,0x08,0x10,0x20, 0x00,0x41,0x41,0x7F,0x00, 0x04,0x02,0x01,0x02,0x04, 0x40,0x40,0x40,0x40,0x40,	// \ ] ^ _
+	0x00,0x01,0x02,0x04,0x00, 0x20,0x54,0x54,0x54,0x78, 0x7F,0x48,0x44,0x44,0x38, 0x38,0x44,0x44,0x44,0x20,	// ` a b c
+	0x38,0x44,0x44,0x48,0x7F, 0x38,0x54,0x54,0x54,0x18, 0x08,0x7E,0x09,0x01,0x02, 0x0C,0x52,0x52,0x52,0x3E,	// d e f g
+	0x7F,0x08,0x04,0x04,0x78, 0x00,0x44,0x7D,0x40,0x00, 0x20,0x40,0x44,0x3D,0x00, 0x7F,0x10,0x28,0x44,0x00,	// h i j k
+	0x00,0x41,0x7F,0x40,0x00, 0x7C,0x04,0x18,0x04,0x78, 0x7C,0x08,0x04,0x04,0x78, 0x38,0x44,0x44,0x44,0x38,	// l m n o
+	0x7C,0x14,0x14,0x14,0x08, 0x08,0x14,0x14,0x18,0x7C, 0x7C,0x08,0x04,0x04,0x08, 0x48,0x54,0x54,0x54,0x20,	// p q r s
+	0x04,0x3F,0x44,0x40,0x20, 0x3C,0x40,0x40,0x20,0x7C, 0x1C,0x20,0x40,0x20,0x1C, 0x3C,0x40,0x30,0x40,0x3C,	// t u v w
+	0x44,0x28,0x10,0x28,0x44, 0x0C,0x50,0x50,0x50,0x3C, 0x44,0x64,0x54,0x4C,0x44, 0x00,0x08,0x36,0x41,0x00,	// x y z {
+	0x00,0x00,0x7F,0x00,0x00, 0x00,0x41,0x36,0x08,0x00, 0x08,0x04,0x08,0x10,0x08,							// | } ~
+	};
+	if (c < 0x20 || c > 0x7E)
+		c = L'?';
+	return &glyphs[(c - 0x20) * 5];
+}
+
+// sRGB EOTF, as the D2D stop collection applies it going from sRGB to scRGB
+inline float Canvas_SRGBToLinear(float c)
+{
+	float a = fabsf(c);
+	float l = a <= 0.04045f ? a / 12.92f : powf((a + 0.055f) / 1.055f, 2.4f);
+	return c < 0.0f ? -l : l;
+}
+
+class SoftwarePatternCanvas : public PatternCanvas
+{
+public:
+	static const uint32_t TileSize = 64;
+
+	SoftwarePatternCanvas(uint32_t width, uint32_t height, float dpi = 96.0f, PipelineExecutor* executor = nullptr) :
+		m_width(width), m_height(height), m_dpi(dpi), m_scale(dpi / 96.0f), m_executor(executor),
+		m_pixels((size_t)width * height * 4, 0)
+	{
+	}
+
+	// Images are straight-alpha scRGB RGBA, drawn 1:1 onto target pixels
+	void SetImage(CanvasImage image, uint32_t width, uint32_t height, std::vector<float> rgba)
+	{
+		Bitmap& bitmap = m_images[image];
+		bitmap.width = width;
+		bitmap.height = height;
+		bitmap.rgba = std::move(rgba);
+	}
+
+	D2D1_RECT_F GetLogicalSize() const override { return { 0.0f, 0.0f, m_width / m_scale, m_height / m_scale }; }
+	D2D1_RECT_F GetOutputSize() const override  { return { 0.0f, 0.0f, (float)m_width, (float)m_height }; }
+	float       GetDpi() const override         { return m_dpi; }
+
+	using PatternCanvas::FillRectangle;
+	using PatternCanvas::DrawRectangle;
+	using PatternCanvas::FillEllipse;
+	using PatternCanvas::DrawEllipse;
+
+	// Everything drawn before a Clear is covered by it, so drop it
+	void Clear(const D2D1_COLOR_F& color) override
+	{
+		m_commands.clear();
+		m_text.clear();
+		Command& cmd = Add(CommandFillRect, color, { 0.0f, 0.0f, (float)m_width, (float)m_height });
+		cmd.rect = cmd.bounds;
+	}
+
+	void FillRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) override
+	{
+		D2D1_RECT_F r = ToPixels(rect);
+		Command& cmd = Add(CommandFillRect, color, r);
+		cmd.rect = r;
+	}
+
+	// D2D strokes straddle the geometry
+	void DrawRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		D2D1_RECT_F r = ToPixels(rect);
+		float half = strokeWidth * m_scale * 0.5f;
+		Command& cmd = Add(CommandStrokeRect, color, { r.left - half, r.top - half, r.right + half, r.bottom + half });
+		cmd.rect = r;
+		cmd.stroke = half * 2.0f;
+	}
+
+	void FillEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color) override
+	{
+		D2D1_ELLIPSE e = ToPixels(ellipse);
+		Command& cmd = Add(CommandFillEllipse, color, EllipseBounds(e, 0.0f));
+		cmd.ellipse = e;
+	}
+
+	void DrawEllipse(const D2D1_ELLIPSE& ellipse, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		D2D1_ELLIPSE e = ToPixels(ellipse);
+		Command& cmd = Add(CommandStrokeEllipse, color, EllipseBounds(e, strokeWidth * m_scale * 0.5f));
+		cmd.ellipse = e;
+		cmd.stroke = strokeWidth * m_scale;
+	}
+
+	// Flat caps, the D2D default
+	void DrawLine(D2D1_POINT_2F p0, D2D1_POINT_2F p1, const D2D1_COLOR_F& color, float strokeWidth) override
+	{
+		D2D1_POINT_2F a = { p0.x * m_scale, p0.y * m_scale };
+		D2D1_POINT_2F b = { p1.x * m_scale, p1.y * m_scale };
+		float half = strokeWidth * m_scale * 0.5f;
+		Command& cmd = Add(CommandLine, color,
+			{ std::min(a.x, b.x) - half, std::min(a.y, b.y) - half, std::max(a.x, b.x) + half, std::max(a.y, b.y) + half });
+		cmd.p0 = a;
+		cmd.p1 = b;
+		cmd.stroke = half * 2.0f;
+	}
+
+	void FillLinearGradient(const D2D1_RECT_F& rect, D2D1_POINT_2F start, D2D1_POINT_2F end,
+		const D2D1_GRADIENT_STOP* stops, uint32_t stopCount) override
+	{
+		if (stopCount == 0)
+			return;
+		D2D1_RECT_F r = ToPixels(rect);
+		Command& cmd = Add(CommandGradient, stops[0].color, r);
+		cmd.rect = r;
+		cmd.p0 = { start.x * m_scale, start.y * m_scale };
+		cmd.p1 = { end.x * m_scale, end.y * m_scale };
+		cmd.stops.assign(stops, stops + stopCount);
+		std::stable_sort(cmd.stops.begin(), cmd.stops.end(),
+			[](const D2D1_GRADIENT_STOP& a, const D2D1_GRADIENT_STOP& b) { return a.position < b.position; });
+	}
+
+	// textBox is { left, top, width, height }, as the patterns pass it.  Lines wrap between
+	// words at the box width, and glyph pixels are snapped to target pixels so text stays sharp.
+	void DrawString(CanvasFont font, const std::wstring& text, const D2D1_RECT_F& textBox, const D2D1_COLOR_F& color) override
+	{
+		m_text.push_back({ font, text, textBox, color });
+
+		static const float fontSizes[CanvasFontCount] = { 14.0f, 24.0f, 18.0f, 64.0f };	// DIPs, see CanvasFont
+		float size = fontSizes[font] * m_scale;
+		float unit = std::max(roundf(size / 10.0f), 1.0f);		// target pixels per font pixel
+		float advance = 6.0f * unit;
+		float lineHeight = roundf(size * 1.33f);
+		float left = roundf(textBox.left * m_scale);
+		float top = roundf(textBox.top * m_scale + (lineHeight - 7.0f * unit) * 0.5f);
+		size_t columns = std::max((size_t)(textBox.right * m_scale / advance), (size_t)1);
+
+		std::vector<std::wstring> lines = WrapText(text, columns);
+		for (size_t line = 0; line < lines.size(); line++)
+		{
+			float y = top + line * lineHeight;
+			for (size_t i = 0; i < lines[line].size(); i++)
+			{
+				if (lines[line][i] == L' ')
+					continue;
+
+				// one rectangle per run of set pixels in a row
+				const uint8_t* glyph = Canvas_Glyph(lines[line][i]);
+				float x = left + i * advance;
+				for (int row = 0; row < 7; row++)
+					for (int c0 = 0; c0 < 5; c0++)
+					{
+						if (!(glyph[c0] >> row & 1))
+							continue;
+						int c1 = c0 + 1;
+						while (c1 < 5 && (glyph[c1] >> row & 1))
+							c1++;
+						D2D1_RECT_F r = { x + c0 * unit, y + row * unit, x + c1 * unit, y + (row + 1) * unit };
+						Command& cmd = Add(CommandFillRect, color, r);
+						cmd.rect = r;
+						c0 = c1;
+					}
+			}
+		}
+	}
+
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, float value) override
+	{
+		if (effect != CanvasEffectNone)
+			m_effectValues[effect].Set(name, value);
+	}
+
+	void SetEffectValue(CanvasEffect effect, const wchar_t* name, D2D1_POINT_2F value) override
+	{
+		if (effect != CanvasEffectNone)
+			m_effectValues[effect].Set(name, value);
+	}
+
+	// Values are captured now, as the effect would be evaluated at this point in the frame
+	void DrawEffect(CanvasEffect effect) override
+	{
+		if (effect == CanvasEffectNone)
+			return;
+		Command& cmd = Add(CommandEffect, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, (float)m_width, (float)m_height });
+		cmd.effect = effect;
+		cmd.effectValues = m_effectValues[effect];
+	}
+
+	void DrawImage(CanvasImage image, D2D1_POINT_2F offset) override
+	{
+		auto it = m_images.find(image);
+		if (it == m_images.end())
+			return;
+		float x = roundf(offset.x * m_scale);
+		float y = roundf(offset.y * m_scale);
+		Command& cmd = Add(CommandImage, { 1.0f, 1.0f, 1.0f, 1.0f },
+			{ x, y, x + it->second.width, y + it->second.height });
+		cmd.image = &it->second;
+	}
+
+	// Forget the recorded frame without rasterizing it
+	void Reset()
+	{
+		m_commands.clear();
+		m_text.clear();
+	}
+
+	// Rasterize everything recorded since the last Clear or Reset.  The recording is kept, so
+	// Render can be called again after SetImage or on another canvas size.
+	void Render()
+	{
+		uint32_t tilesX = (m_width + TileSize - 1) / TileSize;
+		uint32_t tilesY = (m_height + TileSize - 1) / TileSize;
+		uint32_t workers = m_executor ? m_executor->Threads() : 1;
+		m_scratch.resize(workers);
+		for (auto& scratch : m_scratch)
+			scratch.resize(TileSize * TileSize * 4);
+
+		if (m_executor)
+			m_executor->ForEach(tilesX * tilesY, [&](uint32_t tile, uint32_t worker)
+			{
+				RenderTile(tile % tilesX, tile / tilesX, m_scratch[worker].data());
+			});
+		else
+			for (uint32_t tile = 0; tile < tilesX * tilesY; tile++)
+				RenderTile(tile % tilesX, tile / tilesX, m_scratch[0].data());
+	}
+
+	uint32_t Width() const  { return m_width; }
+	uint32_t Height() const { return m_height; }
+
+	// FP16 RGBA, rows packed, the layout of a DXGI_FORMAT_R16G16B16A16_FLOAT surface
+	const uint16_t* Data() const { return m_pixels.data(); }
+
+	D2D1_COLOR_F Pixel(uint32_t x, uint32_t y) const
+	{
+		const uint16_t* p = &m_pixels[((size_t)y * m_width + x) * 4];
+		return { HalfToFloat(p[0]), HalfToFloat(p[1]), HalfToFloat(p[2]), HalfToFloat(p[3]) };
+	}
+
+	const std::vector<CanvasTextRun>& TextRuns() const { return m_text; }
+
+private:
+	enum CommandType
+	{
+		CommandFillRect,
+		CommandStrokeRect,
+		CommandFillEllipse,
+		CommandStrokeEllipse,
+		CommandLine,
+		CommandGradient,
+		CommandEffect,
+		CommandImage,
+	};
+
+	struct Bitmap
+	{
+		uint32_t            width = 0;
+		uint32_t            height = 0;
+		std::vector<float>  rgba;
+	};
+
+	struct Command
+	{
+		CommandType                      type;
+		D2D1_COLOR_F                     color;
+		D2D1_RECT_F                      bounds;			// pixels, what the command can touch
+		D2D1_RECT_F                      rect;
+		D2D1_ELLIPSE                     ellipse;
+		D2D1_POINT_2F                    p0, p1;
+		float                            stroke;
+		std::vector<D2D1_GRADIENT_STOP>  stops;
+		CanvasEffect                     effect;
+		CanvasEffectValues               effectValues;
+		const Bitmap*                    image;
+	};
+
+	Command& Add(CommandType type, const D2D1_COLOR_F& color, const D2D1_RECT_F& bounds)
+	{
+		m_commands.emplace_back();
+		Command& cmd = m_commands.back();
+		cmd.type = type;
+		cmd.color = color;
+		cmd.bounds = bounds;
+		cmd.rect = bounds;
+		cmd.ellipse = {};
+		cmd.p0 = cmd.p1 = { 0.0f, 0.0f };
+		cmd.stroke = 0.0f;
+		cmd.effect = CanvasEffectNone;
+		cmd.image = nullptr;
+		return cmd;
+	}
+
+	// Breaks text into lines at '\n' and, between words, before a line would pass columns
+	// characters.  A word longer than a line is split.  Tabs stop every four characters.
+	static std::vector<std::wstring> WrapText(const std::wstring& text, size_t columns)
+	{
+		std::vector<std::wstring> lines;
+		std::wstring line;
+		for (size_t i = 0; i <= text.size(); i++)
+		{
+			wchar_t c = i < text.size() ? text[i] : L'\n';
+			if (c == L'\n')
+			{
+				lines.push_back(line);
+				line.clear();
+				continue;
+			}
+			if (c == L'\r')
+				continue;
+			if (c == L'\t')
+				line.append(4 - line.size() % 4, L' ');
+			else
+				line += c;
+
+			while (line.size() > columns)
+			{
+				size_t space = line.rfind(L' ', columns);
+				size_t split = space != std::wstring::npos && space > 0 ? space : columns;
+				lines.push_back(line.substr(0, split));
+				line.erase(0, space == split ? split + 1 : split);
+			}
+		}
+		return lines;
+	}
+
+	D2D1_RECT_F ToPixels(const D2D1_RECT_F& r) const
+	{
+		return { r.left * m_scale, r.top * m_scale, r.right * m_scale, r.bottom * m_scale };
+	}
+
+	D2D1_ELLIPSE ToPixels(const D2D1_ELLIPSE& e) const
+	{
+		return { { e.point.x * m_scale, e.point.y * m_scale }, e.radiusX * m_scale, e.radiusY * m_scale };
+	}
+
+	static D2D1_RECT_F EllipseBounds(const D2D1_ELLIPSE& e, float grow)
+	{
+		float rx = fabsf(e.radiusX) + grow + 1.0f;
+		float ry = fabsf(e.radiusY) + grow + 1.0f;
+		return { e.point.x - rx, e.point.y - ry, e.point.x + rx, e.point.y + ry };
+	}
+
+	// Length of [x, x+1] inside [lo, hi]
+	static float Overlap(float x, float lo, float hi)
+	{
+		return std::max(0.0f, std::min(x + 1.0f, hi) - std::max(x, lo));
+	}
+
+	static float RectCoverage(const D2D1_RECT_F& r, float x, float y)
+	{
+		return Overlap(x, std::min(r.left, r.right), std::max(r.left, r.right)) *
+			Overlap(y, std::min(r.top, r.bottom), std::max(r.top, r.bottom));
+	}
+
+	// Distance to the ellipse outline from its implicit function and gradient, in pixels;
+	// negative inside
+	static float EllipseDistance(const D2D1_ELLIPSE& e, float x, float y)
+	{
+		float rx = std::max(fabsf(e.radiusX), 1e-6f);
+		float ry = std::max(fabsf(e.radiusY), 1e-6f);
+		float dx = x - e.point.x;
+		float dy = y - e.point.y;
+		float f = (dx * dx) / (rx * rx) + (dy * dy) / (ry * ry) - 1.0f;
+		float gx = 2.0f * dx / (rx * rx);
+		float gy = 2.0f * dy / (ry * ry);
+		float g = sqrtf(gx * gx + gy * gy);
+		return g > 1e-12f ? f / g : -std::min(rx, ry);
+	}
+
+	// Coverage of a band of the given width centered on the zero distance
+	static float StrokeCoverage(float distance, float width)
+	{
+		return std::min(std::max(width * 0.5f + 0.5f - fabsf(distance), 0.0f), std::min(width, 1.0f));
+	}
+
+	static float LineCoverage(const Command& cmd, float x, float y)
+	{
+		float dx = cmd.p1.x - cmd.p0.x;
+		float dy = cmd.p1.y - cmd.p0.y;
+		float len = sqrtf(dx * dx + dy * dy);
+		if (len <= 0.0f)
+			return 0.0f;
+		float px = x - cmd.p0.x;
+		float py = y - cmd.p0.y;
+		float along = (px * dx + py * dy) / len;
+		float across = (px * dy - py * dx) / len;
+		float caps = std::min(std::max(along + 0.5f, 0.0f), 1.0f) * std::min(std::max(len - along + 0.5f, 0.0f), 1.0f);
+		return StrokeCoverage(across, cmd.stroke) * caps;
+	}
+
+	static D2D1_COLOR_F GradientColor(const Command& cmd, float x, float y)
+	{
+		float dx = cmd.p1.x - cmd.p0.x;
+		float dy = cmd.p1.y - cmd.p0.y;
+		float len2 = dx * dx + dy * dy;
+		float t = len2 > 0.0f ? ((x - cmd.p0.x) * dx + (y - cmd.p0.y) * dy) / len2 : 0.0f;
+
+		const auto& stops = cmd.stops;
+		D2D1_COLOR_F c = stops.back().color;
+		if (t <= stops.front().position)
+			c = stops.front().color;
+		else
+			for (size_t i = 1; i < stops.size(); i++)
+				if (t < stops[i].position)
+				{
+					const D2D1_GRADIENT_STOP& a = stops[i - 1];
+					const D2D1_GRADIENT_STOP& b = stops[i];
+					float f = (t - a.position) / (b.position - a.position);
+					c.r = a.color.r + (b.color.r - a.color.r) * f;
+					c.g = a.color.g + (b.color.g - a.color.g) * f;
+					c.b = a.color.b + (b.color.b - a.color.b) * f;
+					c.a = a.color.a + (b.color.a - a.color.a) * f;
+					break;
+				}
+
+		return { Canvas_SRGBToLinear(c.r), Canvas_SRGBToLinear(c.g), Canvas_SRGBToLinear(c.b), c.a };
+	}
+
+	// Straight-alpha source over
+	static void Blend(float* dst, const D2D1_COLOR_F& src, float coverage)
+	{
+		float a = src.a * coverage;
+		if (a <= 0.0f)
+			return;
+		dst[0] += (src.r - dst[0]) * a;
+		dst[1] += (src.g - dst[1]) * a;
+		dst[2] += (src.b - dst[2]) * a;
+		dst[3] += (1.0f - dst[3]) * a;
+	}
+
+	void RenderTile(uint32_t tx, uint32_t ty, float* scratch)
+	{
+		uint32_t x0 = tx * TileSize;
+		uint32_t y0 = ty * TileSize;
+		uint32_t x1 = std::min(x0 + TileSize, m_width);
+		uint32_t y1 = std::min(y0 + TileSize, m_height);
+		uint32_t w = x1 - x0;
+
+		std::fill(scratch, scratch + TileSize * TileSize * 4, 0.0f);
+
+		for (const Command& cmd : m_commands)
+		{
+			// clip to the tile
+			int cx0 = std::max((int)x0, (int)floorf(cmd.bounds.left));
+			int cy0 = std::max((int)y0, (int)floorf(cmd.bounds.top));
+			int cx1 = std::min((int)x1, (int)ceilf(cmd.bounds.right));
+			int cy1 = std::min((int)y1, (int)ceilf(cmd.bounds.bottom));
+			if (cx0 >= cx1 || cy0 >= cy1)
+				continue;
+
+			for (int y = cy0; y < cy1; y++)
+			{
+				float* row = scratch + ((size_t)(y - y0) * TileSize) * 4;
+				float fy = (float)y;
+				float cy = fy + 0.5f;
+
+				for (int x = cx0; x < cx1; x++)
+				{
+					float* dst = row + (x - x0) * 4;
+					float fx = (float)x;
+					float cx = fx + 0.5f;
+
+					switch (cmd.type)
+					{
+					case CommandFillRect:
+						Blend(dst, cmd.color, RectCoverage(cmd.rect, fx, fy));
+						break;
+
+					case CommandStrokeRect:
+					{
+						float h = cmd.stroke * 0.5f;
+						D2D1_RECT_F inner = { cmd.rect.left + h, cmd.rect.top + h, cmd.rect.right - h, cmd.rect.bottom - h };
+						float coverage = RectCoverage(cmd.bounds, fx, fy);
+						if (inner.left < inner.right && inner.top < inner.bottom)
+							coverage -= RectCoverage(inner, fx, fy);
+						Blend(dst, cmd.color, coverage);
+						break;
+					}
+
+					case CommandFillEllipse:
+						Blend(dst, cmd.color, std::min(std::max(0.5f - EllipseDistance(cmd.ellipse, cx, cy), 0.0f), 1.0f));
+						break;
+
+					case CommandStrokeEllipse:
+						Blend(dst, cmd.color, StrokeCoverage(EllipseDistance(cmd.ellipse, cx, cy), cmd.stroke));
+						break;
+
+					case CommandLine:
+						Blend(dst, cmd.color, LineCoverage(cmd, cx, cy));
+						break;
+
+					case CommandGradient:
+						Blend(dst, GradientColor(cmd, cx, cy), RectCoverage(cmd.rect, fx, fy));
+						break;
+
+					case CommandEffect:
+						Blend(dst, Effect_Shade(cmd.effect, cmd.effectValues, cx, cy), 1.0f);
+						break;
+
+					case CommandImage:
+					{
+						const Bitmap& bitmap = *cmd.image;
+						const float* p = &bitmap.rgba[((size_t)(y - (int)cmd.bounds.top) * bitmap.width + (x - (int)cmd.bounds.left)) * 4];
+						Blend(dst, { p[0], p[1], p[2], p[3] }, 1.0f);
+						break;
+					}
+					}
+				}
+			}
+		}
+
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			const float* src = scratch + (size_t)(y - y0) * TileSize * 4;
+			uint16_t* dst = &m_pixels[((size_t)y * m_width + x0) * 4];
+			for (uint32_t i = 0; i < w * 4; i++)
+				dst[i] = FloatToHalf(src[i]);
+		}
+	}
+
+	uint32_t                                 m_width;
+	uint32_t                                 m_height;
+	float                                    m_dpi;
+	float                                    m_scale;			// pixels per DIP
+	PipelineExecutor*                        m_executor;
+	std::vector<uint16_t>                    m_pixels;
+	std::vector<Command>                     m_commands;
+	std::vector<CanvasTextRun>               m_text;
+	CanvasEffectValues                       m_effectValues[CanvasEffectCount];
+	std::map<CanvasImage, Bitmap>            m_images;
+	std::vector<std::vector<float>>          m_scratch;
+};
@@ -0,0 +1,183 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <tuple>
+#include <vector>
+#include "PatternCanvas.h"
+
+// The starfield background of the patch tests: random round stars of random brightness,
+// added until their mean light over the area reaches a target APL.
+//
+// Stars do not overlap (a spatial hash finds the neighbours, and a star that would is
+// shrunk into the gap) and stay inside the area, so the light each adds is exactly its disk
+// times its level, and the last star is dimmed to land on the target.  With dim stars the
+// area would fill up long before the target, so placing stops once the stars cover enough
+// of it to carry the target at up to full level, and every star is then brightened by the
+// same fraction of its headroom.  Levels are CCCS, linear light with 1.0 = 80 nits, so the
+// APL is too.  The stars depend only on the key, and are generated once for it.
+
+struct StarfieldKey
+{
+	float   width, height;			// DIPs
+	float   maxNits;				// brightest star
+	float   apl;					// CCCS, mean over width x height
+
+	bool operator<(const StarfieldKey& k) const
+	{
+		return std::tie(width, height, maxNits, apl) < std::tie(k.width, k.height, k.maxNits, k.apl);
+	}
+};
+
+class Starfield
+{
+public:
+	static constexpr float MinRadius = 1.0f;
+	static constexpr float MaxRadius = 20.0f;
+
+	explicit Starfield(const StarfieldKey& key) :
+		m_key(key),
+		m_apl(0.0f),
+		m_reachable(false)
+	{
+		static std::atomic<uint64_t> nextId(1);
+		m_id = nextId++;
+		Generate();
+	}
+
+	const StarfieldKey&                 Key() const      { return m_key; }
+	uint64_t                            Id() const       { return m_id; }		// a PatternCanvas batch
+	float                               APL() const      { return m_apl; }		// as achieved, CCCS
+	bool                                Reached() const  { return !m_reachable || m_apl >= 0.999f * m_key.apl; }
+	uint32_t                            Count() const    { return (uint32_t)m_stars.size(); }
+	const std::vector<D2D1_ELLIPSE>&    Stars() const    { return m_stars; }
+	const std::vector<D2D1_COLOR_F>&    Colors() const   { return m_colors; }
+
+	void Draw(PatternCanvas* ctx) const
+	{
+		ctx->FillEllipses(m_id, m_stars.data(), m_colors.data(), Count());
+	}
+
+private:
+	static constexpr float FillHeadroom = 1.5f;		// stop placing at 1.5x the cover needed at full level
+	static constexpr float MaxFill = 0.40f;			// well short of where random placement jams
+	static constexpr float MaxFailures = 0.05f;		// misses per DIP^2, bounds the time if the area jams anyway
+
+	struct Placed
+	{
+		float x, y, r;
+	};
+
+	void Generate()
+	{
+		float width = m_key.width, height = m_key.height;
+		if (!(width > 2.0f * MaxRadius && height > 2.0f * MaxRadius) || m_key.maxNits <= 0.0f)
+			return;
+
+		// A star of radius r can only overlap stars whose centers are within r + MaxRadius, so
+		// only the cells under that box need testing; most stars are small, so with cells of
+		// MaxRadius that is a few lightly filled cells.  The cells keep copies of the stars so
+		// the test does not chase indices.
+		const float cell = MaxRadius;
+		int cols = (int)ceilf(width / cell), rows = (int)ceilf(height / cell);
+		std::vector<std::vector<Placed>> cells((size_t)cols * rows);
+
+		std::mt19937 rng(314159);
+		auto randf = [&]() { return (rng() >> 8) * (1.0f / 16777216.0f); };
+
+		const float maxLevel = m_key.maxNits / 80.0f;
+		const double area = (double)width * height;
+		const double target = (double)m_key.apl * area;
+		const double enoughCover = std::min(FillHeadroom * target / maxLevel, MaxFill * area);
+		const uint32_t maxFailures = (uint32_t)(MaxFailures * area);
+		double light = 0.0, cover = 0.0;
+		uint32_t failures = 0;
+
+		while (light < target && cover < enoughCover && failures < maxFailures)
+		{
+			float level = randf() * maxLevel;
+			float r = randf() * randf() * randf() * (MaxRadius - MinRadius) + MinRadius;
+			float x = r + randf() * (width - 2.0f * r);
+			float y = r + randf() * (height - 2.0f * r);
+
+			float reach = r + MaxRadius;
+			int i0 = std::max((int)((x - reach) / cell), 0), i1 = std::min((int)((x + reach) / cell), cols - 1);
+			int j0 = std::max((int)((y - reach) / cell), 0), j1 = std::min((int)((y + reach) / cell), rows - 1);
+
+			// a star that would overlap is shrunk to fit the gap, and dropped if that leaves
+			// less than MinRadius; in a sparse field that hardly ever happens
+			bool clear = true;
+			for (int j = j0; clear && j <= j1; j++)
+				for (int i = i0; clear && i <= i1; i++)
+					for (const Placed& star : cells[(size_t)j * cols + i])
+					{
+						float dx = star.x - x, dy = star.y - y, d = star.r + r;
+						float dd = dx * dx + dy * dy;
+						if (dd < d * d)
+						{
+							r = sqrtf(dd) - star.r;
+							if (r < MinRadius)
+							{
+								clear = false;
+								break;
+							}
+						}
+					}
+			if (!clear)
+			{
+				failures++;
+				continue;
+			}
+
+			double disk = 3.14159265358979 * r * r;
+			if (light + disk * level >= target)
+				level = (float)((target - light) / disk);
+
+			int cx = std::min((int)(x / cell), cols - 1), cy = std::min((int)(y / cell), rows - 1);
+			cells[(size_t)cy * cols + cx].push_back({ x, y, r });
+			m_stars.push_back({ { x, y }, r, r });
+			m_colors.push_back({ level, level, level, 1.0f });
+			light += disk * level;
+			cover += disk;
+		}
+
+		// Short of the target: raise every star by the same fraction of its headroom, which
+		// keeps their order and spread.  Falls short only if even full level is not enough.
+		if (light < target)
+		{
+			double headroom = cover * maxLevel - light;
+			float t = headroom > 0.0 ? (float)std::min((target - light) / headroom, 1.0) : 0.0f;
+			light = 0.0;
+			for (size_t n = 0; n < m_stars.size(); n++)
+			{
+				float r = m_stars[n].radiusX;
+				float level = m_colors[n].r + t * (maxLevel - m_colors[n].r);
+				m_colors[n] = { level, level, level, 1.0f };
+				light += 3.14159265358979 * r * r * level;
+			}
+		}
+		m_apl = (float)(light / area);
+		m_reachable = target <= enoughCover * maxLevel;
+	}
+
+	StarfieldKey                m_key;
+	uint64_t                    m_id;
+	float                       m_apl;
+	bool                        m_reachable;		// target fits under MaxFill at full level
+	std::vector<D2D1_ELLIPSE>   m_stars;
+	std::vector<D2D1_COLOR_F>   m_colors;
+};
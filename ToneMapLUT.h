@@ -0,0 +1,266 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <math.h>
+#include <algorithm>
+#include "ColorSpaces.h"
+#include "SimdMath.h"
+
+// Tone mapping through a 1D LUT indexed in the PQ domain.
+//
+// The curve is evaluated once per entry when the LUT is built, so applying it to a frame
+// costs one gather and one lerp per channel whatever the curve is.  Indexing by PQ code
+// spreads the entries perceptually, which keeps the lerp error flat from the black level
+// to 10000 nits.  The LUT can produce PQ (ToneMapOutPQ) or linear light (ToneMapOutLinear,
+// 1.0 = 10000 nits), so a PQ decode can be folded into the same pass.
+//
+// For linear input the PQ encode can be folded in as well: a ToneMapInLinear LUT spaces its
+// entries by the square root of linear light, which costs one sqrt per sample instead of the
+// PQ curve.  Below the knee the curve is the identity, where the lerp error of that spacing
+// stays under 2e-4 nits.
+
+enum ToneMapCurve
+{
+	ToneMapBT2390,			// ITU-R BT.2390 EETF, hermite knee in PQ
+	ToneMapShoulder,		// profile()/shoulder() from ToneSpikeEffect.hlsl, in linear
+};
+
+enum ToneMapOutput
+{
+	ToneMapOutPQ,
+	ToneMapOutLinear,
+};
+
+enum ToneMapInput
+{
+	ToneMapInPQ,
+	ToneMapInLinear,		// indexed by sqrt(linear), 1.0 = 10000 nits
+};
+
+struct ToneMapParams
+{
+	float        srcPeakNits;		// content peak (e.g. MaxCLL or mastering peak)
+	float        dstPeakNits;		// display peak
+	float        srcMinNits;
+	float        dstMinNits;
+	ToneMapCurve curve;
+
+	bool operator==(const ToneMapParams& p) const
+	{
+		return srcPeakNits == p.srcPeakNits && dstPeakNits == p.dstPeakNits &&
+			srcMinNits == p.srcMinNits && dstMinNits == p.dstMinNits && curve == p.curve;
+	}
+};
+
+// BT.2390-5 section 5.4 EETF.  All values are PQ, [0..1].
+inline float EETF_BT2390(float E, float srcMin, float srcMax, float dstMin, float dstMax)
+{
+	float range = srcMax - srcMin;
+	if (range <= 0.0f)
+		return E;
+
+	float minLum = (dstMin - srcMin) / range;
+	float maxLum = (dstMax - srcMin) / range;
+
+	// the display covers the content range: nothing to do
+	if (maxLum >= 1.0f && minLum <= 0.0f)
+		return E;
+
+	float E1 = std::min(std::max((E - srcMin) / range, 0.0f), 1.0f);		// content is clipped to its own range
+
+	// knee start
+	float KS = 1.5f * maxLum - 0.5f;
+	float E2 = E1;
+	if (maxLum < 1.0f && E1 >= KS)
+	{
+		float T = (E1 - KS) / (1.0f - KS);
+		float T2 = T * T;
+		float T3 = T2 * T;
+		E2 = (2.0f * T3 - 3.0f * T2 + 1.0f) * KS + (T3 - 2.0f * T2 + T) * (1.0f - KS) + (-2.0f * T3 + 3.0f * T2) * maxLum;
+	}
+
+	// black level lift
+	if (minLum > 0.0f)
+	{
+		float t = 1.0f - E2;
+		E2 = E2 + minLum * t * t * t * t;
+	}
+
+	return E2 * range + srcMin;
+}
+
+// Same as ToneSpikeEffect.hlsl.  x is linear normalized by the display peak.
+inline float ToneMapShoulderCurve(float p, float x)
+{
+	float k = 1.0f / (p - 1.0f);
+	return x * (k + 1.0f) / (k + x);
+}
+
+// p = contentMax/panelCapability
+inline float ToneMapProfile(float p, float input)
+{
+	if (input > p)
+		return 1.0f;					// hard clip
+
+	// get shift s from excel curve fit
+	float s = 1.0f - logf(p) * 0.165f;
+
+	// for inverse tone mapping use different shift
+	if (p < 1.0f)
+		s = p * 0.7f;
+
+	// compute tone curve linear slope
+	float m = 1.0f / (p - s);
+
+	if (input <= s)
+		return input;					// do nothing
+	return ToneMapShoulderCurve((p - s) / (1.0f - s), m * (input - s)) * (1.0f - s) + s;
+}
+
+// One LUT entry: PQ in, PQ out
+inline float ToneMapEvaluatePQ(const ToneMapParams& params, float E)
+{
+	float srcPeak = std::min(params.srcPeakNits, 10000.0f);
+	float dstPeak = std::min(params.dstPeakNits, 10000.0f);
+
+	if (params.curve == ToneMapShoulder)
+	{
+		float p = srcPeak / dstPeak;
+		if (fabsf(p - 1.0f) < 1e-4f)
+			return E;
+		float x = Remove2084(E) * 10000.0f / dstPeak;
+		return Apply2084(ToneMapProfile(p, x) * dstPeak / 10000.0f);
+	}
+
+	return EETF_BT2390(E,
+		Apply2084(params.srcMinNits / 10000.0f), Apply2084(srcPeak / 10000.0f),
+		Apply2084(params.dstMinNits / 10000.0f), Apply2084(dstPeak / 10000.0f));
+}
+
+// lut has size + 1 entries, the last repeating the one before
+// linear to the index domain of a ToneMapInLinear LUT
+inline float ToneMapLUT_Shape(float x)
+{
+	return x > 0.0f ? sqrtf(std::min(x, 1.0f)) : 0.0f;
+}
+
+inline float ToneMapLUT_Lerp(const float* lut, int size, float E)
+{
+	float x = E > 0.0f ? std::min(E, 1.0f) * (size - 1) : 0.0f;
+	int j = (int)x;
+	float f = x - j;
+	return lut[j] + f * (lut[j + 1] - lut[j]);
+}
+
+// in is PQ, or linear times inScale when Linear is set
+template <class S, bool Linear>
+void ToneMapLUT_Kernel(const float* lut, int size, const float* in, float* out, size_t n, float inScale, float outScale)
+{
+	typedef typename S::V  V;
+	typedef typename S::VI VI;
+
+	const V zero = S::Set1(0.0f);
+	const V one = S::Set1(1.0f);
+	const V last = S::Set1((float)(size - 1));
+	const V inK = S::Set1(inScale);
+	const V scale = S::Set1(outScale);
+
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width)
+	{
+		V x = S::Load(in + i);
+		if (Linear)
+			x = S::Sqrt(S::Min(S::Max(S::Mul(x, inK), zero), one));		// Max first so NaN becomes 0
+		x = S::Mul(S::Min(S::Max(x, zero), one), last);
+		VI idx = S::TruncInt(x);
+		V f = S::Sub(x, S::ToFloat(idx));
+		V a = S::Gather(lut, idx);
+		V b = S::Gather(lut + 1, idx);
+		S::Store(out + i, S::Mul(S::Add(a, S::Mul(f, S::Sub(b, a))), scale));
+	}
+	for (; i < n; i++)
+		out[i] = ToneMapLUT_Lerp(lut, size, Linear ? ToneMapLUT_Shape(in[i] * inScale) : in[i]) * outScale;
+}
+
+class ToneMapLUT
+{
+public:
+	static const int Size = 4096;
+
+	ToneMapLUT() : m_params{}, m_output(ToneMapOutPQ), m_input(ToneMapInPQ), m_identity(true), m_valid(false) {}
+
+	void Build(const ToneMapParams& params, ToneMapOutput output, ToneMapInput input = ToneMapInPQ)
+	{
+		m_params = params;
+		m_output = output;
+		m_input = input;
+		m_identity = true;
+		for (int i = 0; i < Size; i++)
+		{
+			float u = (float)i / (Size - 1);
+			float E = input == ToneMapInLinear ? Apply2084(u * u) : u;
+			float mapped = ToneMapEvaluatePQ(params, E);
+			if (fabsf(mapped - E) > 1e-6f)
+				m_identity = false;
+			m_lut[i] = output == ToneMapOutLinear ? Remove2084(mapped) : mapped;
+		}
+		m_lut[Size] = m_lut[Size - 1];		// so the top entry can lerp with f == 0
+		m_valid = true;
+	}
+
+	bool Matches(const ToneMapParams& params, ToneMapOutput output, ToneMapInput input = ToneMapInPQ) const
+	{
+		return m_valid && m_output == output && m_input == input && m_params == params;
+	}
+
+	ToneMapInput Input() const { return m_input; }
+
+	// true when the curve does not change any PQ value, e.g. the display exceeds the content
+	bool IsIdentity() const { return m_identity; }
+
+	// in is PQ [0..1], out is PQ or linear depending on Build(), times outScale.
+	// in and out may point to the same buffer.
+	void Apply(const float* in, float* out, size_t n, float outScale = 1.0f) const
+	{
+		const float* lut = m_lut;
+		SimdDispatch([&](auto s) { ToneMapLUT_Apply<false>(s, lut, in, out, n, 1.0f, outScale); });
+	}
+
+	// For a ToneMapInLinear LUT: in times inScale is linear, 1.0 = 10000 nits
+	void ApplyLinear(const float* in, float* out, size_t n, float inScale, float outScale = 1.0f) const
+	{
+		const float* lut = m_lut;
+		SimdDispatch([&](auto s) { ToneMapLUT_Apply<true>(s, lut, in, out, n, inScale, outScale); });
+	}
+
+private:
+	template <bool Linear, class S>
+	static void ToneMapLUT_Apply(S, const float* lut, const float* in, float* out, size_t n, float inScale, float outScale)
+	{
+		ToneMapLUT_Kernel<S, Linear>(lut, Size, in, out, n, inScale, outScale);
+	}
+
+	template <bool Linear>
+	static void ToneMapLUT_Apply(SimdScalar, const float* lut, const float* in, float* out, size_t n, float inScale, float outScale)
+	{
+		for (size_t i = 0; i < n; i++)
+			out[i] = ToneMapLUT_Lerp(lut, Size, Linear ? ToneMapLUT_Shape(in[i] * inScale) : in[i]) * outScale;
+	}
+
+	ToneMapParams m_params;
+	ToneMapOutput m_output;
+	ToneMapInput  m_input;
+	bool          m_identity;
+	bool          m_valid;
+	float         m_lut[Size + 1];
+};